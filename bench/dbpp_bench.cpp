@@ -0,0 +1,536 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp_bench -- microbenchmarks for the SQLite3 hot paths.
+//
+// Design:
+//   - Every API path is paired with the equivalent raw sqlite3 calls, so
+//     the facade overhead can be read straight off the report
+//   - Each case runs against a fresh database, in-memory and on-disk, at
+//     several row counts; inserts run inside one transaction so the disk
+//     numbers measure dbpp rather than fsync
+//   - Latency is sampled per operation (or per batch of rows for row
+//     iteration, where one row is below clock resolution); p50/p99 are
+//     nearest-rank over the per-op sample values
+//   - Deterministic data and access order: runs are comparable across
+//     builds; one untimed warm-up run precedes each case
+//   - Machine-readable JSON on stdout (or --out), human summary on stderr
+//
+// Usage:
+//   ./dbpp_bench [--rows=1000,10000,100000] [--reps=3]
+//                [--storage=all|memory|disk] [--dir=.] [--filter=insert]
+//                [--out=result.json]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "dbpp/db.hpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t kIterBatch = 64;  // rows per latency sample (iteration)
+
+// ---------------------------------------------------------------------------
+// Recorder -- latency samples of one case
+// ---------------------------------------------------------------------------
+
+class Recorder {
+ public:
+  void Reserve(size_t n) { samples_.reserve(n); }
+
+  /// Time fn(), which performs `ops` operations.
+  template <typename Fn>
+  void Time(uint32_t ops, Fn&& fn) {
+    Clock::time_point t0 = Clock::now();
+    fn();
+    uint64_t ns = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now() - t0).count());
+    if (ops == 0) { return; }
+    samples_.push_back(Sample{ns, ops});
+    total_ns_ += ns;
+    total_ops_ += ops;
+  }
+
+  void Clear() {
+    samples_.clear();
+    total_ns_ = 0;
+    total_ops_ = 0;
+  }
+
+  uint64_t TotalOps() const { return total_ops_; }
+  uint64_t TotalNs() const { return total_ns_; }
+
+  /// Nearest-rank percentile of the per-op latency, p in (0, 100].
+  double PercentileNs(double p) const {
+    if (samples_.empty()) { return 0.0; }
+    std::vector<double> per_op;
+    per_op.reserve(samples_.size());
+    for (const Sample& s : samples_) {
+      per_op.push_back(static_cast<double>(s.ns) / s.ops);
+    }
+    std::sort(per_op.begin(), per_op.end());
+    size_t rank = static_cast<size_t>(p / 100.0 * per_op.size() + 0.5);
+    if (rank > 0) { --rank; }
+    return per_op[std::min(rank, per_op.size() - 1)];
+  }
+
+ private:
+  struct Sample {
+    uint64_t ns;
+    uint32_t ops;
+  };
+
+  std::vector<Sample> samples_;
+  uint64_t total_ns_ = 0;
+  uint64_t total_ops_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Fixture -- one fresh database per case run
+// ---------------------------------------------------------------------------
+
+struct Fixture {
+  dbpp::Db db;
+  uint32_t rows = 0;
+  uint32_t reps = 1;
+
+  sqlite3* Raw() { return db.Impl().Handle(); }
+};
+
+const char* const kSchema =
+    "CREATE TABLE t(id INTEGER PRIMARY KEY, name TEXT, score REAL);";
+const char* const kInsertSql = "INSERT INTO t VALUES(?, ?, ?);";
+const char* const kSelectAllSql = "SELECT id, name, score FROM t;";
+const char* const kSelectOneSql =
+    "SELECT id, name, score FROM t WHERE id = ?;";
+
+/// Deterministic row payload.
+void RowName(uint32_t i, char* buf, size_t size) {
+  std::snprintf(buf, size, "name-%08u", i);
+}
+
+double RowScore(uint32_t i) { return static_cast<double>(i % 1000) * 0.5; }
+
+/// Deterministic pseudo-random id in [0, rows) (LCG, fixed seed).
+struct IdSequence {
+  explicit IdSequence(uint32_t n) : rows(n) {}
+  uint32_t Next() {
+    state = state * 1664525u + 1013904223u;
+    return state % rows;
+  }
+  uint32_t rows;
+  uint32_t state = 12345u;
+};
+
+void Populate(Fixture& f) {
+  f.db.ExecDml("BEGIN;");
+  auto stmt = f.db.CompileStatement(kInsertSql);
+  char name[32];
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    stmt.Exec(i, name, RowScore(i));
+  }
+  f.db.ExecDml("COMMIT;");
+}
+
+// Sink so the compiler cannot drop column reads.
+volatile int64_t g_sink = 0;
+
+// --- Insert paths ---
+
+void BenchExecDml(Fixture& f, Recorder& rec) {
+  char sql[128];
+  char name[32];
+  f.db.ExecDml("BEGIN;");
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    std::snprintf(sql, sizeof(sql), "INSERT INTO t VALUES(%u, '%s', %.1f);",
+                  i, name, RowScore(i));
+    rec.Time(1, [&] { f.db.ExecDml(sql); });
+  }
+  f.db.ExecDml("COMMIT;");
+}
+
+void BenchRawExec(Fixture& f, Recorder& rec) {
+  char sql[128];
+  char name[32];
+  sqlite3_exec(f.Raw(), "BEGIN;", nullptr, nullptr, nullptr);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    std::snprintf(sql, sizeof(sql), "INSERT INTO t VALUES(%u, '%s', %.1f);",
+                  i, name, RowScore(i));
+    rec.Time(1, [&] {
+      sqlite3_exec(f.Raw(), sql, nullptr, nullptr, nullptr);
+    });
+  }
+  sqlite3_exec(f.Raw(), "COMMIT;", nullptr, nullptr, nullptr);
+}
+
+void BenchStmtInsert(Fixture& f, Recorder& rec) {
+  char name[32];
+  f.db.ExecDml("BEGIN;");
+  auto stmt = f.db.CompileStatement(kInsertSql);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    rec.Time(1, [&] {
+      stmt.Bind(1, static_cast<int32_t>(i));
+      stmt.Bind(2, name);
+      stmt.Bind(3, RowScore(i));
+      stmt.ExecDml();
+    });
+  }
+  f.db.ExecDml("COMMIT;");
+}
+
+void BenchStmtInsertBindAll(Fixture& f, Recorder& rec) {
+  char name[32];
+  f.db.ExecDml("BEGIN;");
+  auto stmt = f.db.CompileStatement(kInsertSql);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    dbpp::TextView view(name, static_cast<int32_t>(std::strlen(name)));
+    rec.Time(1, [&] {
+      stmt.BindAllNoCopy(i, view, RowScore(i));
+      stmt.ExecDml();
+    });
+  }
+  f.db.ExecDml("COMMIT;");
+}
+
+void BenchRawStmtInsert(Fixture& f, Recorder& rec) {
+  char name[32];
+  sqlite3* db = f.Raw();
+  sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(db, kInsertSql, -1, &stmt, nullptr);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    RowName(i, name, sizeof(name));
+    rec.Time(1, [&] {
+      sqlite3_bind_int(stmt, 1, static_cast<int32_t>(i));
+      sqlite3_bind_text(stmt, 2, name, -1, SQLITE_TRANSIENT);
+      sqlite3_bind_double(stmt, 3, RowScore(i));
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    });
+  }
+  sqlite3_finalize(stmt);
+  sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+}
+
+// --- Read paths ---
+
+void BenchQueryIterate(Fixture& f, Recorder& rec) {
+  for (uint32_t r = 0; r < f.reps; ++r) {
+    auto q = f.db.ExecQuery(kSelectAllSql);
+    for (uint32_t left = f.rows; left > 0 && !q.Eof();) {
+      uint32_t batch = std::min(kIterBatch, left);
+      left -= batch;
+      rec.Time(batch, [&] {
+        for (uint32_t n = 0; n < batch; ++n) {
+          g_sink = q.GetInt64(0) + static_cast<int64_t>(q.GetDouble(2)) +
+                   q.GetString(1)[0];
+          q.NextRow();
+        }
+      });
+    }
+  }
+}
+
+void BenchRawQueryIterate(Fixture& f, Recorder& rec) {
+  sqlite3* db = f.Raw();
+  for (uint32_t r = 0; r < f.reps; ++r) {
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, kSelectAllSql, -1, &stmt, nullptr);
+    int32_t rc = sqlite3_step(stmt);
+    for (uint32_t left = f.rows; left > 0 && rc == SQLITE_ROW;) {
+      uint32_t batch = std::min(kIterBatch, left);
+      left -= batch;
+      rec.Time(batch, [&] {
+        for (uint32_t n = 0; n < batch; ++n) {
+          g_sink = sqlite3_column_int64(stmt, 0) +
+                   static_cast<int64_t>(sqlite3_column_double(stmt, 2)) +
+                   sqlite3_column_text(stmt, 1)[0];
+          rc = sqlite3_step(stmt);
+        }
+      });
+    }
+    sqlite3_finalize(stmt);
+  }
+}
+
+void BenchResultSet(Fixture& f, Recorder& rec) {
+  for (uint32_t r = 0; r < f.reps; ++r) {
+    rec.Time(f.rows, [&] {
+      auto rs = f.db.GetResultSet(kSelectAllSql);
+      for (; !rs.Eof(); rs.NextRow()) {
+        g_sink = std::atoll(rs.FieldValue(0)) + rs.FieldValue(1)[0];
+      }
+    });
+  }
+}
+
+void BenchTypedResultSet(Fixture& f, Recorder& rec) {
+  for (uint32_t r = 0; r < f.reps; ++r) {
+    rec.Time(f.rows, [&] {
+      auto rs = f.db.Impl().GetTypedResultSet(kSelectAllSql);
+      for (; !rs.Eof(); rs.NextRow()) {
+        g_sink = rs.GetInt64(0) + rs.GetString(1)[0];
+      }
+    });
+  }
+}
+
+// Point lookups including sqlite3_prepare per op: Sqlite3Statement hands
+// its handle to the Sqlite3Query it returns, so the facade cannot re-step
+// one statement. The raw side prepares per op too, so the pair measures
+// facade overhead, not prepare cost.
+void BenchStmtCompileSelectPoint(Fixture& f, Recorder& rec) {
+  IdSequence ids(f.rows);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    uint32_t id = ids.Next();
+    rec.Time(1, [&] {
+      auto stmt = f.db.CompileStatement(kSelectOneSql);
+      stmt.Bind(1, static_cast<int32_t>(id));
+      auto q = stmt.ExecQuery();
+      if (!q.Eof()) { g_sink = q.GetInt64(0); }
+    });
+  }
+}
+
+void BenchRawCompileSelectPoint(Fixture& f, Recorder& rec) {
+  IdSequence ids(f.rows);
+  for (uint32_t i = 0; i < f.rows; ++i) {
+    uint32_t id = ids.Next();
+    rec.Time(1, [&] {
+      sqlite3_stmt* stmt = nullptr;
+      sqlite3_prepare_v2(f.Raw(), kSelectOneSql, -1, &stmt, nullptr);
+      sqlite3_bind_int(stmt, 1, static_cast<int32_t>(id));
+      if (sqlite3_step(stmt) == SQLITE_ROW) {
+        g_sink = sqlite3_column_int64(stmt, 0);
+      }
+      sqlite3_finalize(stmt);
+    });
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Case table
+// ---------------------------------------------------------------------------
+
+struct Case {
+  const char* name;  // operation, shared by the dbpp/raw pair
+  const char* impl;  // "dbpp" or "raw"
+  bool populate;     // run against a table holding `rows` rows
+  void (*run)(Fixture&, Recorder&);
+};
+
+const Case kCases[] = {
+    {"exec_dml_insert", "dbpp", false, BenchExecDml},
+    {"exec_dml_insert", "raw", false, BenchRawExec},
+    {"stmt_insert", "dbpp", false, BenchStmtInsert},
+    {"stmt_insert_bindall", "dbpp", false, BenchStmtInsertBindAll},
+    {"stmt_insert", "raw", false, BenchRawStmtInsert},
+    {"query_iterate", "dbpp", true, BenchQueryIterate},
+    {"query_iterate", "raw", true, BenchRawQueryIterate},
+    {"result_set", "dbpp", true, BenchResultSet},
+    {"typed_result_set", "dbpp", true, BenchTypedResultSet},
+    {"stmt_compile_select_point", "dbpp", true, BenchStmtCompileSelectPoint},
+    {"stmt_compile_select_point", "raw", true, BenchRawCompileSelectPoint},
+};
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+
+struct Options {
+  std::vector<uint32_t> rows{1000, 10000, 100000};
+  uint32_t reps = 3;
+  bool memory = true;
+  bool disk = true;
+  std::string dir = ".";
+  const char* filter = nullptr;
+  const char* out = nullptr;
+};
+
+bool ParseRows(const char* s, std::vector<uint32_t>* out) {
+  out->clear();
+  while (*s != '\0') {
+    char* end = nullptr;
+    unsigned long v = std::strtoul(s, &end, 10);
+    if (end == s || v == 0) { return false; }
+    if (*end != ',' && *end != '\0') { return false; }
+    out->push_back(static_cast<uint32_t>(v));
+    s = (*end == ',') ? end + 1 : end;
+  }
+  return !out->empty();
+}
+
+bool ParseArgs(int argc, char** argv, Options* opts) {
+  for (int i = 1; i < argc; ++i) {
+    const char* a = argv[i];
+    if (std::strncmp(a, "--rows=", 7) == 0) {
+      if (!ParseRows(a + 7, &opts->rows)) { return false; }
+    } else if (std::strncmp(a, "--reps=", 7) == 0) {
+      opts->reps = static_cast<uint32_t>(std::strtoul(a + 7, nullptr, 10));
+      if (opts->reps == 0) { return false; }
+    } else if (std::strncmp(a, "--storage=", 10) == 0) {
+      const char* v = a + 10;
+      opts->memory = std::strcmp(v, "memory") == 0 || std::strcmp(v, "all") == 0;
+      opts->disk = std::strcmp(v, "disk") == 0 || std::strcmp(v, "all") == 0;
+      if (!opts->memory && !opts->disk) { return false; }
+    } else if (std::strncmp(a, "--dir=", 6) == 0) {
+      opts->dir = a + 6;
+    } else if (std::strncmp(a, "--filter=", 9) == 0) {
+      opts->filter = a + 9;
+    } else if (std::strncmp(a, "--out=", 6) == 0) {
+      opts->out = a + 6;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+void RemoveDbFiles(const std::string& path) {
+  std::remove(path.c_str());
+  std::remove((path + "-journal").c_str());
+  std::remove((path + "-wal").c_str());
+  std::remove((path + "-shm").c_str());
+}
+
+/// Open a fresh database with the schema (and data, if the case needs it).
+bool Setup(Fixture& f, const std::string& path, const Case& c) {
+  if (path != ":memory:") { RemoveDbFiles(path); }
+  dbpp::Error err = f.db.Open(path.c_str());
+  if (!err.ok()) {
+    std::fprintf(stderr, "open %s failed: %s\n", path.c_str(), err.message);
+    return false;
+  }
+  f.db.ExecDml(kSchema);
+  if (c.populate) { Populate(f); }
+  return true;
+}
+
+void Teardown(Fixture& f, const std::string& path) {
+  f.db.Close();
+  if (path != ":memory:") { RemoveDbFiles(path); }
+}
+
+void WriteResult(FILE* out, bool first, const Case& c, const char* storage,
+                 uint32_t rows, const Recorder& rec) {
+  double ns_per_op = rec.TotalOps() > 0
+      ? static_cast<double>(rec.TotalNs()) / rec.TotalOps() : 0.0;
+  double ops_per_sec = ns_per_op > 0.0 ? 1e9 / ns_per_op : 0.0;
+  std::fprintf(out,
+               "%s    {\"name\": \"%s\", \"impl\": \"%s\", \"storage\": \"%s\", "
+               "\"rows\": %u, \"ops\": %llu, \"ns_per_op\": %.1f, "
+               "\"ops_per_sec\": %.0f, \"p50_ns\": %.1f, \"p99_ns\": %.1f}",
+               first ? "" : ",\n", c.name, c.impl, storage, rows,
+               static_cast<unsigned long long>(rec.TotalOps()), ns_per_op,
+               ops_per_sec, rec.PercentileNs(50.0), rec.PercentileNs(99.0));
+  std::fprintf(stderr, "%-20s %-5s %-7s %8u  %10.1f ns/op  %12.0f ops/s  "
+               "p50 %9.1f  p99 %9.1f\n",
+               c.name, c.impl, storage, rows, ns_per_op, ops_per_sec,
+               rec.PercentileNs(50.0), rec.PercentileNs(99.0));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options opts;
+  if (!ParseArgs(argc, argv, &opts)) {
+    std::fprintf(stderr,
+                 "usage: %s [--rows=N,N,...] [--reps=N] "
+                 "[--storage=all|memory|disk] [--dir=PATH] "
+                 "[--filter=SUBSTR] [--out=FILE]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* out = stdout;
+  if (opts.out != nullptr) {
+    out = std::fopen(opts.out, "w");
+    if (out == nullptr) {
+      std::fprintf(stderr, "cannot open %s\n", opts.out);
+      return 1;
+    }
+  }
+
+#ifdef NDEBUG
+  const char* build = "release";
+#else
+  const char* build = "debug";
+#endif
+#ifdef __VERSION__
+  const char* compiler = __VERSION__;
+#else
+  const char* compiler = "unknown";
+#endif
+  std::fprintf(out,
+               "{\n  \"benchmark\": \"dbpp_bench\",\n"
+               "  \"sqlite_version\": \"%s\",\n  \"build\": \"%s\",\n"
+               "  \"compiler\": \"%s\",\n  \"reps\": %u,\n"
+               "  \"results\": [\n",
+               sqlite3_libversion(), build, compiler, opts.reps);
+
+  struct Storage {
+    const char* name;
+    bool enabled;
+    std::string path;
+  };
+  const Storage storages[] = {
+      {"memory", opts.memory, ":memory:"},
+      {"disk", opts.disk, opts.dir + "/dbpp_bench.db"},
+  };
+
+  bool first = true;
+  int32_t failures = 0;
+  for (const Storage& st : storages) {
+    if (!st.enabled) { continue; }
+    for (uint32_t rows : opts.rows) {
+      for (const Case& c : kCases) {
+        if (opts.filter != nullptr &&
+            std::strstr(c.name, opts.filter) == nullptr) {
+          continue;
+        }
+        Fixture f;
+        f.rows = rows;
+        f.reps = opts.reps;
+        Recorder rec;
+        rec.Reserve(rows);
+
+        // Warm-up run, discarded.
+        if (!Setup(f, st.path, c)) {
+          ++failures;
+          continue;
+        }
+        c.run(f, rec);
+        Teardown(f, st.path);
+        rec.Clear();
+
+        if (!Setup(f, st.path, c)) {
+          ++failures;
+          continue;
+        }
+        c.run(f, rec);
+        Teardown(f, st.path);
+
+        WriteResult(out, first, c, st.name, rows, rec);
+        first = false;
+      }
+    }
+  }
+
+  std::fprintf(out, "\n  ]\n}\n");
+  if (out != stdout) { std::fclose(out); }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::detail::BindArgs -- compile-time dispatch for variadic binding.
+//
+// Design:
+//   - Maps each C++ argument type to one backend Bind*() call at compile
+//     time; backends only implement the primitive overloads
+//   - Integral types up to int32 bind as int32_t, wider ones as int64_t,
+//     floating point as double
+//   - Text/blob arguments go through TextView/BlobView, so the length is
+//     known and no strlen() is repeated in the backend
+//   - kNoCopy selects the backend's BindNoCopy() for text/blob: the caller
+//     guarantees the data outlives statement execution
+//
+//   - CallWithOutError() peels a trailing Error* off a variadic argument
+//     list, so one-shot Exec(sql, args..., &err) can report failures
+//
+// Supported argument types: integral, floating point, const char*,
+// std::string, TextView, BlobView, std::nullptr_t (NULL), Nullable<T>,
+// ZeroBlob (backends with BindZeroBlob) and std::string_view with C++17.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "dbpp/error.hpp"
+#include "dbpp/value_types.hpp"
+
+namespace dbpp {
+namespace detail {
+
+template <bool kNoCopy, typename Stmt>
+struct ArgBinder {
+  static Status Text(Stmt& s, int32_t p, TextView v) {
+    return kNoCopy ? s.BindNoCopy(p, v) : s.Bind(p, v);
+  }
+
+  static Status One(Stmt& s, int32_t p, const char* v) {
+    return (v != nullptr) ? Text(s, p, TextView(v)) : s.BindNull(p);
+  }
+
+  static Status One(Stmt& s, int32_t p, const std::string& v) {
+    return Text(s, p, TextView(v.data(), static_cast<int32_t>(v.size())));
+  }
+
+  static Status One(Stmt& s, int32_t p, TextView v) { return Text(s, p, v); }
+
+#if __cplusplus >= 201703L
+  static Status One(Stmt& s, int32_t p, std::string_view v) {
+    return Text(s, p, TextView(v.data(), static_cast<int32_t>(v.size())));
+  }
+#endif
+
+  static Status One(Stmt& s, int32_t p, BlobView v) {
+    return kNoCopy ? s.BindNoCopy(p, v) : s.Bind(p, v);
+  }
+
+  static Status One(Stmt& s, int32_t p, ZeroBlob v) {
+    return s.BindZeroBlob(p, v.size);
+  }
+
+  static Status One(Stmt& s, int32_t p, std::nullptr_t) {
+    return s.BindNull(p);
+  }
+
+  template <typename T>
+  static Status One(Stmt& s, int32_t p, const Nullable<T>& v) {
+    return v.is_null ? s.BindNull(p) : One(s, p, v.value);
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value,
+                                 Status>::type
+  One(Stmt& s, int32_t p, T v) {
+    return s.Bind(p, static_cast<double>(v));
+  }
+
+  template <typename T>
+  static typename std::enable_if<
+      std::is_integral<T>::value &&
+          (sizeof(T) < sizeof(int32_t) ||
+           (sizeof(T) == sizeof(int32_t) && std::is_signed<T>::value)),
+      Status>::type
+  One(Stmt& s, int32_t p, T v) {
+    return s.Bind(p, static_cast<int32_t>(v));
+  }
+
+  template <typename T>
+  static typename std::enable_if<
+      std::is_integral<T>::value &&
+          !(sizeof(T) < sizeof(int32_t) ||
+            (sizeof(T) == sizeof(int32_t) && std::is_signed<T>::value)),
+      Status>::type
+  One(Stmt& s, int32_t p, T v) {
+    return s.Bind(p, static_cast<int64_t>(v));
+  }
+
+  static Status All(Stmt&, int32_t) { return Status::Ok(); }
+
+  template <typename T, typename... Rest>
+  static Status All(Stmt& s, int32_t p, const T& v, const Rest&... rest) {
+    Status st = One(s, p, v);
+    if (!st.ok()) { return st; }
+    return All(s, p + 1, rest...);
+  }
+};
+
+/// Bind args to parameters 1..N. Stops at the first failure.
+template <bool kNoCopy, typename Stmt, typename... Args>
+Status BindArgs(Stmt& stmt, const Args&... args) {
+  return ArgBinder<kNoCopy, Stmt>::All(stmt, 1, args...);
+}
+
+// --- Trailing Error* out-parameter ---
+
+/// True if the last of Args is Error* (an out-parameter, never a value).
+template <typename... Args>
+struct LastIsError : std::false_type {};
+
+template <typename T>
+struct LastIsError<T>
+    : std::is_same<typename std::decay<T>::type, Error*> {};
+
+template <typename T, typename... Rest>
+struct LastIsError<T, Rest...> : LastIsError<Rest...> {};
+
+template <typename Fn, typename Tuple, size_t... I>
+auto CallSplit(Fn& fn, const Tuple& args, std::index_sequence<I...>) {
+  return fn(static_cast<Error*>(std::get<sizeof...(I)>(args)),
+            std::get<I>(args)...);
+}
+
+template <typename Fn, typename... Args>
+auto CallWithOutError(std::true_type, Fn& fn, const Args&... args) {
+  return CallSplit(fn, std::tie(args...),
+                   std::make_index_sequence<sizeof...(Args) - 1>{});
+}
+
+template <typename Fn, typename... Args>
+auto CallWithOutError(std::false_type, Fn& fn, const Args&... args) {
+  return fn(static_cast<Error*>(nullptr), args...);
+}
+
+/// fn(out_error, values...): a trailing Error* in `args` becomes
+/// out_error, otherwise out_error is nullptr and all args are values.
+template <typename Fn, typename... Args>
+auto CallWithOutError(Fn& fn, const Args&... args) {
+  return CallWithOutError(LastIsError<Args...>{}, fn, args...);
+}
+
+}  // namespace detail
+}  // namespace dbpp
@@ -0,0 +1,160 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::ColumnIndex / dbpp::ColumnRef -- name-to-column lookup for results.
+//
+// Design:
+//   - Open-addressing table of (FNV-1a hash, column) built lazily on the
+//     first named access, so results only read by position pay nothing
+//   - Results up to kLinearMax columns keep the plain strcmp scan: cheaper
+//     than hashing and no allocation
+//   - Names are not copied; a hit is confirmed with one strcmp against the
+//     owner's current name (sqlite3_column_name pointers can move)
+//   - Duplicate names resolve to the first column, like the linear scan
+//   - ColumnRef is a column resolved once (Column(name)) and passed to the
+//     positional accessors in the row loop
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// ColumnRef
+// ---------------------------------------------------------------------------
+
+/// Resolved column handle, e.g.
+///   ColumnRef price = q.Column("price");
+///   for (; !q.Eof(); q.NextRow()) { sum += q.GetDouble(price); }
+/// Converts to the column index, so every positional accessor takes it.
+struct ColumnRef {
+  int32_t index = -1;
+
+  constexpr ColumnRef() = default;
+  constexpr explicit ColumnRef(int32_t col) : index(col) {}
+
+  constexpr bool valid() const { return index >= 0; }
+  constexpr operator int32_t() const { return index; }
+};
+
+// ---------------------------------------------------------------------------
+// ColumnIndex
+// ---------------------------------------------------------------------------
+
+class ColumnIndex {
+ public:
+  static constexpr int32_t kLinearMax = 8;
+
+  ColumnIndex() = default;
+
+  ~ColumnIndex() { Clear(); }
+
+  // Move
+  ColumnIndex(ColumnIndex&& other) noexcept
+      : slots_(other.slots_), mask_(other.mask_) {
+    other.slots_ = nullptr;
+    other.mask_ = 0;
+  }
+
+  ColumnIndex& operator=(ColumnIndex&& other) noexcept {
+    if (this != &other) {
+      Clear();
+      slots_ = other.slots_;
+      mask_ = other.mask_;
+      other.slots_ = nullptr;
+      other.mask_ = 0;
+    }
+    return *this;
+  }
+
+  // No copy
+  ColumnIndex(const ColumnIndex&) = delete;
+  ColumnIndex& operator=(const ColumnIndex&) = delete;
+
+  /// Index of the first of `count` columns called `name`, or -1.
+  /// `name_of(col)` returns the name of column col (may be nullptr).
+  template <typename NameOf>
+  int32_t Find(const char* name, int32_t count, NameOf name_of) {
+    if (name == nullptr || count <= 0) { return -1; }
+    if (count <= kLinearMax) {
+      for (int32_t i = 0; i < count; ++i) {
+        const char* col_name = name_of(i);
+        if (col_name != nullptr && std::strcmp(name, col_name) == 0) {
+          return i;
+        }
+      }
+      return -1;
+    }
+
+    if (slots_ == nullptr) { Build(count, name_of); }
+    uint32_t hash = Hash(name);
+    for (uint32_t i = hash & mask_; slots_[i].col != kEmpty;
+         i = (i + 1) & mask_) {
+      if (slots_[i].hash != hash) { continue; }
+      const char* col_name = name_of(slots_[i].col);
+      if (col_name != nullptr && std::strcmp(name, col_name) == 0) {
+        return slots_[i].col;
+      }
+    }
+    return -1;
+  }
+
+  bool Built() const { return slots_ != nullptr; }
+
+  void Clear() {
+    delete[] slots_;
+    slots_ = nullptr;
+    mask_ = 0;
+  }
+
+ private:
+  static constexpr int32_t kEmpty = -1;
+
+  struct Slot {
+    uint32_t hash;
+    int32_t col;
+  };
+
+  // FNV-1a, 32-bit
+  static uint32_t Hash(const char* s) {
+    uint32_t h = 2166136261u;
+    while (*s != '\0') {
+      h ^= static_cast<uint8_t>(*s++);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  /// Load factor <= 1/2. Columns are inserted in order and a name already
+  /// present is skipped, so lookups return the first duplicate.
+  template <typename NameOf>
+  void Build(int32_t count, NameOf name_of) {
+    uint32_t capacity = 16;
+    while (capacity < static_cast<uint32_t>(count) * 2) { capacity <<= 1; }
+    slots_ = new Slot[capacity];
+    mask_ = capacity - 1;
+    for (uint32_t i = 0; i < capacity; ++i) { slots_[i] = Slot{0, kEmpty}; }
+
+    for (int32_t col = 0; col < count; ++col) {
+      const char* col_name = name_of(col);
+      if (col_name == nullptr) { continue; }
+      uint32_t hash = Hash(col_name);
+      uint32_t i = hash & mask_;
+      bool duplicate = false;
+      for (; slots_[i].col != kEmpty; i = (i + 1) & mask_) {
+        if (slots_[i].hash == hash &&
+            std::strcmp(col_name, name_of(slots_[i].col)) == 0) {
+          duplicate = true;
+          break;
+        }
+      }
+      if (!duplicate) { slots_[i] = Slot{hash, col}; }
+    }
+  }
+
+  Slot* slots_ = nullptr;
+  uint32_t mask_ = 0;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,454 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::ConnectionPool<Backend> -- thread-safe pool of Database<Backend>.
+//
+// Design:
+//   - Fixed slot array sized to max_size, allocated once in Init()
+//   - min_size connections opened eagerly, more opened on demand up to
+//     max_size (outside the pool lock, so opening never blocks checkouts)
+//   - RAII checkout: PooledConnection returns itself on destruction
+//   - Acquire() waits on a condition variable with a timeout when exhausted
+//   - Idle connections above min_size are closed after idle_timeout_ms
+//   - LIFO idle stack: hot connections are reused, cold ones age out
+//   - Works with any backend (Sqlite3Backend, MariaBackend)
+//
+// Usage:
+//   dbpp::ConnectionPool<> pool;
+//   dbpp::ConnectionPoolOptions opts;
+//   opts.dsn = "app.db";
+//   opts.max_size = 8;
+//   pool.Init(opts);
+//   auto conn = pool.Acquire(100);
+//   if (conn) { conn->ExecDml("..."); }
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+#include "dbpp/db.hpp"
+#include "dbpp/error.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// ConnectionPoolOptions
+// ---------------------------------------------------------------------------
+
+template <typename Backend>
+struct BasicConnectionPoolOptions {
+  /// Path (SQLite3) or DSN (MariaDB) passed to Database::Open().
+  const char* dsn = nullptr;
+  uint32_t min_size = 1;
+  uint32_t max_size = 8;
+  /// Close idle connections above min_size after this long. 0 = never.
+  uint32_t idle_timeout_ms = 60000;
+  /// Optional per-connection setup run after each Open() (pragmas,
+  /// busy timeout, statement cache...). A non-ok Error discards the
+  /// connection.
+  std::function<Error(Database<Backend>&)> on_open;
+};
+
+using ConnectionPoolOptions = BasicConnectionPoolOptions<Sqlite3Backend>;
+
+// ---------------------------------------------------------------------------
+// ConnectionPoolStats
+// ---------------------------------------------------------------------------
+
+struct ConnectionPoolStats {
+  uint32_t max_size = 0;
+  uint32_t open = 0;           // Open connections (idle + in use)
+  uint32_t in_use = 0;
+  uint32_t peak_in_use = 0;
+  uint64_t acquires = 0;       // Successful checkouts
+  uint64_t waits = 0;          // Checkouts that had to block
+  uint64_t timeouts = 0;       // Checkouts that gave up
+  uint64_t opens = 0;          // Connections opened
+  uint64_t evictions = 0;      // Idle connections closed
+  uint64_t total_wait_us = 0;  // Time spent blocked in Acquire()
+  uint64_t max_wait_us = 0;
+
+  /// Fraction of max_size currently checked out.
+  double Utilization() const {
+    return (max_size > 0) ? static_cast<double>(in_use) / max_size : 0.0;
+  }
+
+  double AvgWaitUs() const {
+    return (acquires > 0) ? static_cast<double>(total_wait_us) / acquires
+                          : 0.0;
+  }
+};
+
+template <typename Backend>
+class ConnectionPool;
+
+// ---------------------------------------------------------------------------
+// PooledConnection -- RAII checkout handle
+// ---------------------------------------------------------------------------
+
+template <typename Backend>
+class PooledConnection {
+ public:
+  using DbType = Database<Backend>;
+
+  PooledConnection() = default;
+
+  ~PooledConnection() { Release(); }
+
+  // Move
+  PooledConnection(PooledConnection&& other) noexcept
+      : pool_(other.pool_), slot_(other.slot_), db_(other.db_) {
+    other.pool_ = nullptr;
+    other.db_ = nullptr;
+  }
+
+  PooledConnection& operator=(PooledConnection&& other) noexcept {
+    if (this != &other) {
+      Release();
+      pool_ = other.pool_;
+      slot_ = other.slot_;
+      db_ = other.db_;
+      other.pool_ = nullptr;
+      other.db_ = nullptr;
+    }
+    return *this;
+  }
+
+  // No copy
+  PooledConnection(const PooledConnection&) = delete;
+  PooledConnection& operator=(const PooledConnection&) = delete;
+
+  bool Valid() const { return db_ != nullptr; }
+  explicit operator bool() const { return Valid(); }
+
+  DbType* operator->() const { return db_; }
+  DbType& operator*() const { return *db_; }
+  DbType* Get() const { return db_; }
+
+  /// Return the connection to the pool early.
+  void Release() {
+    if (pool_ != nullptr) {
+      pool_->Return(slot_);
+      pool_ = nullptr;
+      db_ = nullptr;
+    }
+  }
+
+ private:
+  friend class ConnectionPool<Backend>;
+
+  PooledConnection(ConnectionPool<Backend>* pool, uint32_t slot, DbType* db)
+      : pool_(pool), slot_(slot), db_(db) {}
+
+  ConnectionPool<Backend>* pool_ = nullptr;
+  uint32_t slot_ = 0;
+  DbType* db_ = nullptr;
+};
+
+// ---------------------------------------------------------------------------
+// ConnectionPool<Backend>
+// ---------------------------------------------------------------------------
+
+template <typename Backend = Sqlite3Backend>
+class ConnectionPool {
+ public:
+  using DbType = Database<Backend>;
+  using Options = BasicConnectionPoolOptions<Backend>;
+  using Handle = PooledConnection<Backend>;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr uint32_t kMaxDsnLen = 512;
+
+  ConnectionPool() = default;
+
+  /// All handles must have been returned before the pool is destroyed.
+  ~ConnectionPool() {
+    Shutdown();
+    delete[] slots_;
+    delete[] idle_;
+  }
+
+  // No copy, no move (handles keep a pointer to the pool)
+  ConnectionPool(const ConnectionPool&) = delete;
+  ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+  // --- Setup ---
+
+  /// Allocate slots and open min_size connections.
+  Error Init(const Options& opts) {
+    if (opts.dsn == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "dsn is null");
+    }
+    if (opts.max_size == 0 || opts.min_size > opts.max_size) {
+      return Error::Make(ErrorCode::kRange, "invalid pool size");
+    }
+    if (std::strlen(opts.dsn) >= kMaxDsnLen) {
+      return Error::Make(ErrorCode::kRange, "dsn too long");
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (slots_ != nullptr) {
+        return Error::Make(ErrorCode::kMisuse, "pool already initialized");
+      }
+      std::strncpy(dsn_, opts.dsn, kMaxDsnLen - 1);
+      dsn_[kMaxDsnLen - 1] = '\0';
+      min_size_ = opts.min_size;
+      max_size_ = opts.max_size;
+      idle_timeout_ = std::chrono::milliseconds(opts.idle_timeout_ms);
+      on_open_ = opts.on_open;
+      slots_ = new Slot[max_size_];
+      idle_ = new uint32_t[max_size_];
+      num_idle_ = 0;
+      num_open_ = 0;
+      shutdown_ = false;
+      last_evict_scan_ = Clock::now();
+      stats_ = ConnectionPoolStats{};
+      stats_.max_size = max_size_;
+    }
+
+    for (uint32_t i = 0; i < min_size_; ++i) {
+      Error err = OpenSlot(i);
+      if (!err.ok()) {
+        Shutdown();
+        std::lock_guard<std::mutex> lock(mutex_);
+        delete[] slots_;
+        delete[] idle_;
+        slots_ = nullptr;
+        idle_ = nullptr;
+        return err;
+      }
+      std::lock_guard<std::mutex> lock(mutex_);
+      slots_[i].state = SlotState::kIdle;
+      slots_[i].last_used = Clock::now();
+      idle_[num_idle_++] = i;
+      ++num_open_;
+      ++stats_.opens;
+    }
+    return Error::Ok();
+  }
+
+  /// Close all idle connections and refuse new checkouts. Connections
+  /// still checked out are closed when they are returned.
+  void Shutdown() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (slots_ == nullptr) { return; }
+    shutdown_ = true;
+    while (num_idle_ > 0) {
+      uint32_t slot = idle_[--num_idle_];
+      slots_[slot].db.Close();
+      slots_[slot].state = SlotState::kFree;
+      --num_open_;
+    }
+    cv_.notify_all();
+  }
+
+  // --- Checkout ---
+
+  /// Check out a connection, waiting up to timeout_ms when the pool is
+  /// exhausted. Returns an invalid handle on timeout (kBusy) or failure.
+  Handle Acquire(uint32_t timeout_ms, Error* out_error = nullptr) {
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + std::chrono::milliseconds(timeout_ms);
+    bool waited = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (slots_ == nullptr || shutdown_) {
+        if (out_error != nullptr) {
+          out_error->Set(ErrorCode::kNotOpen, "Pool not open");
+        }
+        return Handle{};
+      }
+
+      if (num_idle_ > 0) {
+        uint32_t slot = idle_[--num_idle_];
+        return CheckOut(slot, start, waited);
+      }
+
+      if (num_open_ < max_size_) {
+        uint32_t slot = FindFreeSlot();
+        slots_[slot].state = SlotState::kOpening;
+        ++num_open_;
+        lock.unlock();
+        Error err = OpenSlot(slot);
+        lock.lock();
+        if (!err.ok()) {
+          slots_[slot].state = SlotState::kFree;
+          --num_open_;
+          cv_.notify_one();
+          if (out_error != nullptr) { *out_error = err; }
+          return Handle{};
+        }
+        ++stats_.opens;
+        return CheckOut(slot, start, waited);
+      }
+
+      waited = true;
+      if (cv_.wait_until(lock, deadline) == std::cv_status::timeout &&
+          num_idle_ == 0 && num_open_ >= max_size_ && !shutdown_) {
+        ++stats_.timeouts;
+        if (out_error != nullptr) {
+          out_error->Set(ErrorCode::kBusy, "Connection pool exhausted");
+        }
+        return Handle{};
+      }
+    }
+  }
+
+  /// Non-blocking checkout.
+  Handle TryAcquire(Error* out_error = nullptr) {
+    return Acquire(0, out_error);
+  }
+
+  // --- Maintenance ---
+
+  /// Close connections idle longer than idle_timeout_ms, keeping at least
+  /// min_size open. Also runs automatically as connections are returned.
+  /// Returns the number of connections closed.
+  uint32_t EvictIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return EvictIdleLocked(lock, Clock::now());
+  }
+
+  // --- Stats ---
+
+  ConnectionPoolStats Stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ConnectionPoolStats s = stats_;
+    s.open = num_open_;
+    return s;
+  }
+
+  void ResetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t in_use = stats_.in_use;
+    stats_ = ConnectionPoolStats{};
+    stats_.max_size = max_size_;
+    stats_.in_use = in_use;
+    stats_.peak_in_use = in_use;
+  }
+
+  uint32_t MaxSize() const { return max_size_; }
+
+ private:
+  friend class PooledConnection<Backend>;
+
+  enum class SlotState : uint8_t { kFree, kOpening, kIdle, kInUse };
+
+  struct Slot {
+    DbType db;
+    SlotState state = SlotState::kFree;
+    Clock::time_point last_used;
+  };
+
+  /// Open slot's connection; called without the lock held.
+  Error OpenSlot(uint32_t slot) {
+    DbType& db = slots_[slot].db;
+    Error err = db.Open(dsn_);
+    if (err.ok() && on_open_) {
+      err = on_open_(db);
+    }
+    if (!err.ok()) { db.Close(); }
+    return err;
+  }
+
+  uint32_t FindFreeSlot() const {
+    for (uint32_t i = 0; i < max_size_; ++i) {
+      if (slots_[i].state == SlotState::kFree) { return i; }
+    }
+    return 0;  // Unreachable: caller checked num_open_ < max_size_
+  }
+
+  Handle CheckOut(uint32_t slot, Clock::time_point start, bool waited) {
+    slots_[slot].state = SlotState::kInUse;
+    uint64_t wait_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - start).count());
+    ++stats_.acquires;
+    if (waited) { ++stats_.waits; }
+    stats_.total_wait_us += wait_us;
+    if (wait_us > stats_.max_wait_us) { stats_.max_wait_us = wait_us; }
+    ++stats_.in_use;
+    if (stats_.in_use > stats_.peak_in_use) {
+      stats_.peak_in_use = stats_.in_use;
+    }
+    return Handle(this, slot, &slots_[slot].db);
+  }
+
+  void Return(uint32_t slot) {
+    Clock::time_point now = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    --stats_.in_use;
+    Slot& s = slots_[slot];
+    if (shutdown_ || !s.db.IsOpen()) {
+      s.db.Close();
+      s.state = SlotState::kFree;
+      --num_open_;
+    } else {
+      // Never hand back a connection with a dangling transaction
+      if (s.db.InTransaction()) { s.db.Rollback(); }
+      s.state = SlotState::kIdle;
+      s.last_used = now;
+      idle_[num_idle_++] = slot;
+    }
+    cv_.notify_one();
+
+    if (idle_timeout_.count() > 0 && now - last_evict_scan_ >= idle_timeout_) {
+      EvictIdleLocked(lock, now);
+    }
+  }
+
+  uint32_t EvictIdleLocked(std::unique_lock<std::mutex>& lock,
+                           Clock::time_point now) {
+    last_evict_scan_ = now;
+    if (idle_timeout_.count() == 0 || slots_ == nullptr) { return 0; }
+
+    // Oldest idle connections sit at the bottom of the LIFO stack.
+    DbType victims[kMaxEvictBatch];
+    uint32_t num_victims = 0;
+    uint32_t keep = 0;
+    for (uint32_t i = 0; i < num_idle_; ++i) {
+      uint32_t slot = idle_[i];
+      Slot& s = slots_[slot];
+      if (num_victims < kMaxEvictBatch && num_open_ > min_size_ &&
+          now - s.last_used >= idle_timeout_) {
+        victims[num_victims++] = std::move(s.db);
+        s.state = SlotState::kFree;
+        --num_open_;
+      } else {
+        idle_[keep++] = slot;
+      }
+    }
+    num_idle_ = keep;
+    stats_.evictions += num_victims;
+
+    // Close outside the lock (network round trip for MariaDB)
+    lock.unlock();
+    for (uint32_t i = 0; i < num_victims; ++i) { victims[i].Close(); }
+    lock.lock();
+    return num_victims;
+  }
+
+  static constexpr uint32_t kMaxEvictBatch = 16;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  Slot* slots_ = nullptr;
+  uint32_t* idle_ = nullptr;  // LIFO stack of idle slot indices
+  uint32_t num_idle_ = 0;
+  uint32_t num_open_ = 0;     // Includes slots being opened
+  uint32_t min_size_ = 0;
+  uint32_t max_size_ = 0;
+  bool shutdown_ = false;
+  std::chrono::milliseconds idle_timeout_{0};
+  Clock::time_point last_evict_scan_;
+  std::function<Error(DbType&)> on_open_;
+  char dsn_[kMaxDsnLen] = {};
+  ConnectionPoolStats stats_;
+};
+
+}  // namespace dbpp
@@ -23,7 +23,9 @@
 #pragma once
 
 #include "dbpp/error.hpp"
+#include "dbpp/schema_catalog.hpp"
 #include "dbpp/sqlite3_backend.hpp"
+#include "dbpp/transaction.hpp"
 
 #if defined(DBPP_HAS_MARIADB) && DBPP_HAS_MARIADB
 #include "dbpp/maria_backend.hpp"
@@ -64,6 +66,12 @@ class Database {
   // --- Open / Close ---
 
   Error Open(const char* path) { return impl_.Open(path); }
+
+  /// Open with backend-specific options (e.g. Sqlite3OpenOptions).
+  template <typename Options>
+  Error Open(const char* path, const Options& opts) {
+    return impl_.Open(path, opts);
+  }
   void Close() { impl_.Close(); }
   bool IsOpen() const { return impl_.IsOpen(); }
 
@@ -73,6 +81,14 @@ class Database {
     return impl_.ExecDml(sql, out_error);
   }
 
+  /// Execute one parameterized statement, e.g.
+  ///   db.Exec("INSERT INTO t VALUES(?, ?);", 42, TextView(p, n));
+  /// Returns affected row count, or -1 on error.
+  template <typename... Args>
+  int32_t Exec(const char* sql, const Args&... args) {
+    return impl_.Exec(sql, args...);
+  }
+
   // --- Scalar ---
 
   int32_t ExecScalar(const char* sql, int32_t null_value = 0,
@@ -86,6 +102,14 @@ class Database {
     return impl_.ExecQuery(sql, out_error);
   }
 
+  /// Execute a query and return a typed cursor that owns it, e.g.
+  ///   for (auto row : db.QueryAs<int64_t, TextView>("SELECT ...")) {}
+  template <typename... Ts>
+  TypedCursor<QueryType, Ts...> QueryAs(const char* sql,
+                                        Error* out_error = nullptr) {
+    return impl_.ExecQuery(sql, out_error).template As<Ts...>(out_error);
+  }
+
   // --- ResultSet ---
 
   ResultSetType GetResultSet(const char* sql,
@@ -100,19 +124,40 @@ class Database {
     return impl_.CompileStatement(sql, out_error);
   }
 
-  // --- Table exists ---
+  // --- Schema catalog ---
 
-  bool TableExists(const char* table) {
-    return impl_.TableExists(table);
+  bool TableExists(const char* table, Error* out_error = nullptr) {
+    return impl_.TableExists(table, out_error);
   }
+  bool ColumnExists(const char* table, const char* column,
+                    Error* out_error = nullptr) {
+    return impl_.ColumnExists(table, column, out_error);
+  }
+  const SchemaTable* GetTable(const char* table,
+                              Error* out_error = nullptr) {
+    return impl_.GetTable(table, out_error);
+  }
+  const std::vector<SchemaColumn>* GetColumns(const char* table,
+                                              Error* out_error = nullptr) {
+    return impl_.GetColumns(table, out_error);
+  }
+  void InvalidateSchema() { impl_.InvalidateSchema(); }
 
   // --- Transaction ---
 
   Error BeginTransaction() { return impl_.BeginTransaction(); }
+  Error BeginTransaction(TxnMode mode) {
+    return impl_.BeginTransaction(mode);
+  }
   Error Commit() { return impl_.Commit(); }
   Error Rollback() { return impl_.Rollback(); }
   bool InTransaction() const { return impl_.InTransaction(); }
 
+  Error Savepoint() { return impl_.Savepoint(); }
+  Error ReleaseSavepoint() { return impl_.ReleaseSavepoint(); }
+  Error RollbackToSavepoint() { return impl_.RollbackToSavepoint(); }
+  uint32_t SavepointDepth() const { return impl_.SavepointDepth(); }
+
   // --- Misc ---
 
   void SetBusyTimeout(int32_t ms) { impl_.SetBusyTimeout(ms); }
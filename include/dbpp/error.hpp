@@ -5,6 +5,8 @@
 // Design:
 //   - ErrorCode enum class with fixed-width underlying type
 //   - Error struct: code + fixed-size message buffer
+//   - Status: code-only, register-sized result for hot-path calls
+//     (Bind*/Reset); converts to Error, formatting a message only then
 //   - Compatible with -fno-exceptions
 //   - Maps SQLite3 error codes to dbpp error codes
 
@@ -52,8 +54,11 @@ struct Error {
   void Set(ErrorCode c, const char* msg) {
     code = c;
     if (msg != nullptr) {
-      std::strncpy(message, msg, kMaxMessageLen - 1);
-      message[kMaxMessageLen - 1] = '\0';
+      // Copy only the text: strncpy would also zero-fill the whole buffer.
+      uint32_t len = 0;
+      while (len < kMaxMessageLen - 1 && msg[len] != '\0') { ++len; }
+      std::memcpy(message, msg, len);
+      message[len] = '\0';
     } else {
       message[0] = '\0';
     }
@@ -85,4 +90,56 @@ struct Error {
   }
 };
 
+inline const char* ErrorCodeName(ErrorCode c) {
+  switch (c) {
+    case ErrorCode::kOk:         return "ok";
+    case ErrorCode::kError:      return "error";
+    case ErrorCode::kNotOpen:    return "not open";
+    case ErrorCode::kBusy:       return "busy";
+    case ErrorCode::kNotFound:   return "not found";
+    case ErrorCode::kConstraint: return "constraint violation";
+    case ErrorCode::kMismatch:   return "type mismatch";
+    case ErrorCode::kMisuse:     return "misuse";
+    case ErrorCode::kRange:      return "out of range";
+    case ErrorCode::kNullParam:  return "null parameter";
+    case ErrorCode::kIoError:    return "I/O error";
+    case ErrorCode::kFull:       return "full";
+    default:                     return "unknown error";
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Status
+// ---------------------------------------------------------------------------
+
+/// Result of the per-row calls (Bind*, BindNull, BindAll, Reset): 8 bytes,
+/// returned in a register, with no message buffer to clear or copy.
+/// Converting to Error formats a generic message from the codes; for the
+/// backend's own text ask the statement (ErrorMessage() / ToError()).
+struct Status {
+  ErrorCode code = ErrorCode::kOk;
+  int32_t native = 0;  // Backend result code (SQLITE_*, mysql errno), 0 = none
+
+  constexpr Status() = default;
+  constexpr explicit Status(ErrorCode c, int32_t native_code = 0)
+      : code(c), native(native_code) {}
+
+  bool ok() const { return code == ErrorCode::kOk; }
+  explicit operator bool() const { return ok(); }
+
+  static constexpr Status Ok() { return Status{}; }
+
+  /// Source compatibility: `Error err = stmt.Bind(...)` keeps working.
+  operator Error() const {
+    Error e;
+    if (ok()) { return e; }
+    if (native != 0) {
+      e.SetFormat(code, "%s (native code %d)", ErrorCodeName(code), native);
+    } else {
+      e.Set(code, ErrorCodeName(code));
+    }
+    return e;
+  }
+};
+
 }  // namespace dbpp
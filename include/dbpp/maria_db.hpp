@@ -6,9 +6,18 @@
 //   - Wraps MYSQL* with RAII
 //   - Move-only (no copy)
 //   - Error reporting via Error* output parameter (no exceptions)
-//   - Transaction support (Begin/Commit/Rollback)
+//   - Transaction support (Begin/Commit/Rollback), START TRANSACTION
+//     READ ONLY / READ WRITE modes and a savepoint stack for
+//     Transaction<Db> guards
 //   - Zero global state, thread-safe per connection
 //   - API-compatible with Sqlite3Db for Database<Backend> template
+//   - TableExists/ColumnExists/GetColumns answer from a SchemaCatalog
+//     (information_schema, loaded on first use). DDL or USE through this
+//     connection invalidates it. DDL from other connections, processes or
+//     pool members is caught by a checksum over information_schema
+//     COLUMNS + STATISTICS (one round trip that scans the schema's rows),
+//     run at most once per check interval (1 s by default): hits inside
+//     the interval make no SQL. See SetSchemaCheckInterval()
 //
 // Open() format: "host:port:user:password:database"
 //   e.g. "localhost:3306:root:pass:testdb"
@@ -16,10 +25,14 @@
 
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <mysql.h>
 
@@ -27,6 +40,8 @@
 #include "dbpp/maria_query.hpp"
 #include "dbpp/maria_result_set.hpp"
 #include "dbpp/maria_statement.hpp"
+#include "dbpp/schema_catalog.hpp"
+#include "dbpp/transaction.hpp"
 
 namespace dbpp {
 
@@ -38,22 +53,43 @@ class MariaDb {
  public:
   MariaDb() = default;
 
-  ~MariaDb() { Close(); }
+  ~MariaDb() {
+    Close();
+    delete catalog_;
+  }
 
   // Move
   MariaDb(MariaDb&& other) noexcept
-      : conn_(other.conn_), in_transaction_(other.in_transaction_) {
+      : conn_(other.conn_),
+        in_transaction_(other.in_transaction_),
+        savepoint_depth_(other.savepoint_depth_),
+        catalog_(other.catalog_),
+        schema_generation_(other.schema_generation_),
+        schema_signature_(std::move(other.schema_signature_)),
+        schema_checked_(other.schema_checked_),
+        schema_check_ms_(other.schema_check_ms_) {
     other.conn_ = nullptr;
     other.in_transaction_ = false;
+    other.savepoint_depth_ = 0;
+    other.catalog_ = nullptr;
   }
 
   MariaDb& operator=(MariaDb&& other) noexcept {
     if (this != &other) {
       Close();
+      delete catalog_;
       conn_ = other.conn_;
       in_transaction_ = other.in_transaction_;
+      savepoint_depth_ = other.savepoint_depth_;
+      catalog_ = other.catalog_;
+      schema_generation_ = other.schema_generation_;
+      schema_signature_ = std::move(other.schema_signature_);
+      schema_checked_ = other.schema_checked_;
+      schema_check_ms_ = other.schema_check_ms_;
       other.conn_ = nullptr;
       other.in_transaction_ = false;
+      other.savepoint_depth_ = 0;
+      other.catalog_ = nullptr;
     }
     return *this;
   }
@@ -129,6 +165,8 @@ class MariaDb {
       conn_ = nullptr;
     }
     in_transaction_ = false;
+    savepoint_depth_ = 0;
+    ++schema_generation_;
   }
 
   bool IsOpen() const { return conn_ != nullptr; }
@@ -149,6 +187,7 @@ class MariaDb {
       return -1;
     }
 
+    NoteSchemaChange(sql);
     if (mysql_query(conn_, sql) != 0) {
       if (out_error != nullptr) {
         out_error->Set(ErrorCode::kError, mysql_error(conn_));
@@ -187,6 +226,7 @@ class MariaDb {
       return MariaQuery{};
     }
 
+    NoteSchemaChange(sql);
     if (mysql_query(conn_, sql) != 0) {
       if (out_error != nullptr) {
         out_error->Set(ErrorCode::kError, mysql_error(conn_));
@@ -226,6 +266,7 @@ class MariaDb {
       return MariaResultSet{};
     }
 
+    NoteSchemaChange(sql);
     if (mysql_query(conn_, sql) != 0) {
       if (out_error != nullptr) {
         out_error->Set(ErrorCode::kError, mysql_error(conn_));
@@ -246,6 +287,25 @@ class MariaDb {
     return MariaResultSet(res);
   }
 
+  /// Execute one parameterized statement: prepare, bind args to ?1..?N,
+  /// execute. Text/blob args are borrowed, not copied -- they outlive the
+  /// call. A trailing Error* receives the failure. Returns affected row
+  /// count, or -1 on error.
+  template <typename... Args>
+  int32_t Exec(const char* sql, const Args&... args) {
+    auto run = [this, sql](Error* out_error, const auto&... values) {
+      MariaStatement stmt = CompileStatement(sql, out_error);
+      if (!stmt.Valid()) { return -1; }
+      Status st = stmt.BindAllNoCopy(values...);
+      if (!st.ok()) {
+        if (out_error != nullptr) { *out_error = stmt.ToError(st); }
+        return -1;
+      }
+      return stmt.ExecDml(out_error);
+    };
+    return detail::CallWithOutError(run, args...);
+  }
+
   // --- Statement ---
 
   MariaStatement CompileStatement(const char* sql,
@@ -263,6 +323,9 @@ class MariaDb {
       return MariaStatement{};
     }
 
+    // A prepared DDL statement changes the schema when executed; it is
+    // counted here, so lookups made before that reload once more.
+    NoteSchemaChange(sql);
     MYSQL_STMT* stmt = mysql_stmt_init(conn_);
     if (stmt == nullptr) {
       if (out_error != nullptr) {
@@ -283,23 +346,68 @@ class MariaDb {
     return MariaStatement(conn_, stmt);
   }
 
-  // --- Table exists ---
+  // --- Schema catalog ---
 
-  bool TableExists(const char* table) {
-    if (conn_ == nullptr || table == nullptr) { return false; }
-    char sql[256];
-    std::snprintf(sql, sizeof(sql),
-        "SELECT COUNT(*) FROM information_schema.tables "
-        "WHERE table_schema = DATABASE() AND table_name = '%s'", table);
-    return ExecScalar(sql) > 0;
+  /// Table lookups below cover the current database. Table names compare
+  /// as the server does (@@lower_case_table_names), column names
+  /// case-insensitively. The catalog is reloaded after DDL or USE through
+  /// this connection, and when the schema checksum read before a lookup
+  /// (one single-row round trip) differs: DDL from anywhere else. Returned
+  /// pointers stay valid until the next reload, InvalidateSchema() or
+  /// Close().
+
+  bool TableExists(const char* table, Error* out_error = nullptr) {
+    return GetTable(table, out_error) != nullptr;
   }
 
+  bool ColumnExists(const char* table, const char* column,
+                    Error* out_error = nullptr) {
+    const SchemaCatalog* catalog = Catalog(out_error);
+    return catalog != nullptr &&
+           catalog->FindColumn(table, column) != nullptr;
+  }
+
+  /// Table `table` with its columns and indexes, or nullptr.
+  const SchemaTable* GetTable(const char* table, Error* out_error = nullptr) {
+    const SchemaCatalog* catalog = Catalog(out_error);
+    return catalog != nullptr ? catalog->FindTable(table) : nullptr;
+  }
+
+  /// Columns of `table` in declaration order, or nullptr.
+  const std::vector<SchemaColumn>* GetColumns(const char* table,
+                                              Error* out_error = nullptr) {
+    const SchemaTable* t = GetTable(table, out_error);
+    return t != nullptr ? &t->columns : nullptr;
+  }
+
+  /// Reload the catalog on the next lookup.
+  void InvalidateSchema() { ++schema_generation_; }
+
+  /// Trust the catalog for `ms` after a checksum matched: lookups in that
+  /// window make no round trip, DDL from elsewhere is seen up to `ms`
+  /// late. 0 checks before every lookup (a schema scan each time).
+  void SetSchemaCheckInterval(uint32_t ms) { schema_check_ms_ = ms; }
+
   // --- Transaction ---
 
-  Error BeginTransaction() {
+  Error BeginTransaction() { return BeginTransaction(TxnMode::kDeferred); }
+
+  /// START TRANSACTION; kReadOnly adds READ ONLY (InnoDB skips
+  /// transaction-id and undo bookkeeping), kImmediate/kExclusive add READ
+  /// WRITE.
+  Error BeginTransaction(TxnMode mode) {
+    const char* sql = "START TRANSACTION;";
+    if (mode == TxnMode::kReadOnly) {
+      sql = "START TRANSACTION READ ONLY;";
+    } else if (mode != TxnMode::kDeferred) {
+      sql = "START TRANSACTION READ WRITE;";
+    }
     Error err;
-    ExecDml("START TRANSACTION;", &err);
-    if (err.ok()) { in_transaction_ = true; }
+    ExecDml(sql, &err);
+    if (err.ok()) {
+      in_transaction_ = true;
+      savepoint_depth_ = 0;
+    }
     return err;
   }
 
@@ -307,6 +415,7 @@ class MariaDb {
     Error err;
     ExecDml("COMMIT;", &err);
     in_transaction_ = false;
+    savepoint_depth_ = 0;
     return err;
   }
 
@@ -314,9 +423,50 @@ class MariaDb {
     Error err;
     ExecDml("ROLLBACK;", &err);
     in_transaction_ = false;
+    savepoint_depth_ = 0;
+    return err;
+  }
+
+  // --- Savepoints (a stack, used by Transaction<Db> for nesting) ---
+
+  /// Push SAVEPOINT dbpp_sp<depth>; requires an open transaction.
+  Error Savepoint() {
+    if (!in_transaction_) {
+      return Error::Make(ErrorCode::kMisuse, "no open transaction");
+    }
+    Error err = RunSavepoint("SAVEPOINT dbpp_sp%u;", savepoint_depth_);
+    if (err.ok()) { ++savepoint_depth_; }
+    return err;
+  }
+
+  /// Pop the innermost savepoint, keeping its changes.
+  Error ReleaseSavepoint() {
+    if (savepoint_depth_ == 0) {
+      return Error::Make(ErrorCode::kMisuse, "no open savepoint");
+    }
+    Error err = RunSavepoint("RELEASE SAVEPOINT dbpp_sp%u;",
+                             savepoint_depth_ - 1);
+    if (err.ok()) { --savepoint_depth_; }
+    return err;
+  }
+
+  /// Pop the innermost savepoint, undoing its changes.
+  Error RollbackToSavepoint() {
+    if (savepoint_depth_ == 0) {
+      return Error::Make(ErrorCode::kMisuse, "no open savepoint");
+    }
+    Error err = RunSavepoint("ROLLBACK TO SAVEPOINT dbpp_sp%u;",
+                             savepoint_depth_ - 1);
+    if (err.ok()) {
+      err = RunSavepoint("RELEASE SAVEPOINT dbpp_sp%u;",
+                         savepoint_depth_ - 1);
+    }
+    if (err.ok()) { --savepoint_depth_; }
     return err;
   }
 
+  uint32_t SavepointDepth() const { return savepoint_depth_; }
+
   bool InTransaction() const { return in_transaction_; }
 
   // --- Misc ---
@@ -333,8 +483,118 @@ class MariaDb {
   MYSQL* Handle() const { return conn_; }
 
  private:
+  Error RunSavepoint(const char* format, uint32_t level) {
+    char sql[64];
+    std::snprintf(sql, sizeof(sql), format, level);
+    Error err;
+    ExecDml(sql, &err);
+    return err;
+  }
+
+  void NoteSchemaChange(const char* sql) {
+    if (detail::IsSchemaStatement(sql)) { ++schema_generation_; }
+  }
+
+  /// The schema catalog, (re)loaded if the generation moved since the
+  /// last load. nullptr on error.
+  const SchemaCatalog* Catalog(Error* out_error) {
+    if (conn_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return nullptr;
+    }
+    if (catalog_ == nullptr) { catalog_ = new SchemaCatalog(); }
+    bool current =
+        catalog_->Loaded() && catalog_->Version() == schema_generation_;
+    auto now = std::chrono::steady_clock::now();
+    if (current &&
+        now - schema_checked_ < std::chrono::milliseconds(schema_check_ms_)) {
+      return catalog_;  // Hit: no SQL
+    }
+    // Read before loading: DDL landing in between only costs a reload
+    std::string signature;
+    Error err = ReadSchemaSignature(&signature);
+    if (err.ok() && !(current && signature == schema_signature_)) {
+      err = LoadCatalog();
+    }
+    if (!err.ok()) {
+      catalog_->Invalidate();
+      if (out_error != nullptr) { *out_error = err; }
+      return nullptr;
+    }
+    schema_signature_ = std::move(signature);
+    schema_checked_ = now;
+    return catalog_;
+  }
+
+  /// Row count and CRC32 sum of exactly what LoadCatalog() reads, so any
+  /// DDL on the current database changes it, whoever issued it.
+  Error ReadSchemaSignature(std::string* out) {
+    Error err;
+    MariaQuery q = ExecQuery(
+        "SELECT CONCAT_WS(':', c.n, c.h, s.n, s.h) FROM "
+        "(SELECT COUNT(*) AS n, COALESCE(SUM(CRC32(CONCAT_WS(',', "
+        "TABLE_NAME, ORDINAL_POSITION, COLUMN_NAME, COLUMN_TYPE, "
+        "IS_NULLABLE, COLUMN_KEY))), 0) AS h "
+        "FROM information_schema.COLUMNS "
+        "WHERE TABLE_SCHEMA = DATABASE()) AS c, "
+        "(SELECT COUNT(*) AS n, COALESCE(SUM(CRC32(CONCAT_WS(',', "
+        "TABLE_NAME, INDEX_NAME, NON_UNIQUE, SEQ_IN_INDEX, "
+        "COLUMN_NAME))), 0) AS h "
+        "FROM information_schema.STATISTICS "
+        "WHERE TABLE_SCHEMA = DATABASE()) AS s;", &err);
+    if (!err.ok()) { return err; }
+    out->assign(q.Eof() ? "" : q.GetString(0));
+    return Error::Ok();
+  }
+
+  /// Fill catalog_ from information_schema: three round trips, whatever
+  /// the table count.
+  Error LoadCatalog() {
+    Error err;
+    // 0: names stored as given, compared case-sensitively
+    int32_t lower_case = ExecScalar("SELECT @@lower_case_table_names;", 0,
+                                    &err);
+    if (!err.ok()) { return err; }
+    catalog_->BeginLoad(schema_generation_, lower_case != 0);
+
+    MariaQuery cols = ExecQuery(
+        "SELECT TABLE_NAME, COLUMN_NAME, COLUMN_TYPE, IS_NULLABLE, "
+        "COLUMN_KEY FROM information_schema.COLUMNS "
+        "WHERE TABLE_SCHEMA = DATABASE() "
+        "ORDER BY TABLE_NAME, ORDINAL_POSITION;", &err);
+    if (!err.ok()) { return err; }
+    for (; !cols.Eof(); cols.NextRow()) {
+      int32_t t = catalog_->AddTable(cols.GetString(0));
+      catalog_->AddColumn(t, cols.GetString(1), cols.GetString(2),
+                          std::strcmp(cols.GetString(3), "NO") == 0,
+                          std::strcmp(cols.GetString(4), "PRI") == 0);
+    }
+
+    MariaQuery idx = ExecQuery(
+        "SELECT TABLE_NAME, INDEX_NAME, NON_UNIQUE, COLUMN_NAME "
+        "FROM information_schema.STATISTICS "
+        "WHERE TABLE_SCHEMA = DATABASE() "
+        "ORDER BY TABLE_NAME, INDEX_NAME, SEQ_IN_INDEX;", &err);
+    if (!err.ok()) { return err; }
+    for (; !idx.Eof(); idx.NextRow()) {
+      int32_t t = catalog_->AddTable(idx.GetString(0));
+      catalog_->AddIndexColumn(t, idx.GetString(1), idx.GetInt(2) == 0,
+                               idx.GetString(3));
+    }
+    catalog_->EndLoad();
+    return Error::Ok();
+  }
+
   MYSQL* conn_ = nullptr;
   bool in_transaction_ = false;
+  uint32_t savepoint_depth_ = 0;
+  SchemaCatalog* catalog_ = nullptr;  // Created on first lookup
+  uint64_t schema_generation_ = 0;    // Bumped by DDL through this conn
+  std::string schema_signature_;      // ReadSchemaSignature() at load
+  std::chrono::steady_clock::time_point schema_checked_;
+  uint32_t schema_check_ms_ = 1000;   // SetSchemaCheckInterval()
 };
 
 }  // namespace dbpp
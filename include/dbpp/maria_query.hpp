@@ -5,19 +5,26 @@
 // Design:
 //   - Wraps MYSQL_RES* (mysql_store_result) with RAII
 //   - Move-only (no copy)
-//   - Forward iteration via Eof()/NextRow()
+//   - Forward iteration via Eof()/NextRow(); rows are buffered by
+//     mysql_store_result(), so StepStatus() is always ok (same API as
+//     Sqlite3Query)
 //   - Type-safe field accessors with null defaults
 //   - API-compatible with Sqlite3Query for Database<Backend> template
+//   - As<Ts...>() gives a compile-time typed row cursor
+//   - Named access through a lazily built ColumnIndex / ColumnRef
 
 #pragma once
 
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include <mysql.h>
 
+#include "dbpp/column_index.hpp"
 #include "dbpp/error.hpp"
+#include "dbpp/typed_cursor.hpp"
 
 namespace dbpp {
 
@@ -42,7 +49,8 @@ class MariaQuery {
         fields_(other.fields_),
         eof_(other.eof_),
         num_fields_(other.num_fields_),
-        num_rows_(other.num_rows_) {
+        num_rows_(other.num_rows_),
+        name_index_(std::move(other.name_index_)) {
     other.res_ = nullptr;
     other.row_ = nullptr;
     other.lengths_ = nullptr;
@@ -62,6 +70,7 @@ class MariaQuery {
       eof_ = other.eof_;
       num_fields_ = other.num_fields_;
       num_rows_ = other.num_rows_;
+      name_index_ = std::move(other.name_index_);
       other.res_ = nullptr;
       other.row_ = nullptr;
       other.lengths_ = nullptr;
@@ -82,14 +91,15 @@ class MariaQuery {
   int32_t NumFields() const { return num_fields_; }
 
   int32_t FieldIndex(const char* name) const {
-    if (fields_ == nullptr || name == nullptr) { return -1; }
-    for (int32_t i = 0; i < num_fields_; ++i) {
-      if (fields_[i].name != nullptr &&
-          std::strcmp(name, fields_[i].name) == 0) {
-        return i;
-      }
-    }
-    return -1;
+    if (fields_ == nullptr) { return -1; }
+    MYSQL_FIELD* fields = fields_;
+    return name_index_.Find(name, num_fields_,
+                            [fields](int32_t i) { return fields[i].name; });
+  }
+
+  /// Resolve `name` once, for positional access inside a row loop.
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
   }
 
   const char* FieldName(int32_t col) const {
@@ -99,6 +109,64 @@ class MariaQuery {
     return fields_[col].name;
   }
 
+  /// Numeric column (integer, decimal, floating point): the text value is
+  /// a number as formatted by the server.
+  bool FieldIsNumeric(int32_t col) const {
+    if (fields_ == nullptr || col < 0 || col >= num_fields_) { return false; }
+    return IS_NUM(fields_[col].type);
+  }
+
+  /// Integer column (TINYINT..BIGINT, YEAR).
+  bool FieldIsInteger(int32_t col) const {
+    if (fields_ == nullptr || col < 0 || col >= num_fields_) { return false; }
+    switch (fields_[col].type) {
+      case MYSQL_TYPE_TINY:
+      case MYSQL_TYPE_SHORT:
+      case MYSQL_TYPE_LONG:
+      case MYSQL_TYPE_INT24:
+      case MYSQL_TYPE_LONGLONG:
+      case MYSQL_TYPE_YEAR:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  /// Integer column whose values all fit int64_t: every integer type but
+  /// BIGINT UNSIGNED, which reaches 2^64 - 1.
+  bool FieldFitsInt64(int32_t col) const {
+    if (!FieldIsInteger(col)) { return false; }
+    return fields_[col].type != MYSQL_TYPE_LONGLONG ||
+           (fields_[col].flags & UNSIGNED_FLAG) == 0;
+  }
+
+  /// FLOAT / DOUBLE column (DECIMAL is numeric but neither).
+  bool FieldIsReal(int32_t col) const {
+    if (fields_ == nullptr || col < 0 || col >= num_fields_) { return false; }
+    return fields_[col].type == MYSQL_TYPE_FLOAT ||
+           fields_[col].type == MYSQL_TYPE_DOUBLE;
+  }
+
+  /// Binary string/blob column: BINARY, VARBINARY or *BLOB in the binary
+  /// character set. Numeric and temporal fields report that charset too
+  /// but their values are text.
+  bool FieldIsBinary(int32_t col) const {
+    if (fields_ == nullptr || col < 0 || col >= num_fields_) { return false; }
+    if (fields_[col].charsetnr != 63) { return false; }
+    switch (fields_[col].type) {
+      case MYSQL_TYPE_STRING:
+      case MYSQL_TYPE_VAR_STRING:
+      case MYSQL_TYPE_VARCHAR:
+      case MYSQL_TYPE_TINY_BLOB:
+      case MYSQL_TYPE_MEDIUM_BLOB:
+      case MYSQL_TYPE_LONG_BLOB:
+      case MYSQL_TYPE_BLOB:
+        return true;
+      default:
+        return false;
+    }
+  }
+
   // --- Field values ---
 
   const char* FieldValue(int32_t col) const {
@@ -183,6 +251,24 @@ class MariaQuery {
     }
   }
 
+  /// Always ok: every row was fetched before the query was returned.
+  Status StepStatus() const { return Status::Ok(); }
+  Error ToError() const { return Error::Ok(); }
+
+  // --- Typed cursor ---
+
+  /// Typed view of the remaining rows (column count validated once).
+  template <typename... Ts>
+  TypedCursor<MariaQuery, Ts...> As(Error* out_error = nullptr) & {
+    return TypedCursor<MariaQuery, Ts...>(*this, out_error);
+  }
+
+  /// Same, taking ownership of a temporary query.
+  template <typename... Ts>
+  TypedCursor<MariaQuery, Ts...> As(Error* out_error = nullptr) && {
+    return TypedCursor<MariaQuery, Ts...>(std::move(*this), out_error);
+  }
+
   void Finalize() {
     if (res_ != nullptr) {
       mysql_free_result(res_);
@@ -194,6 +280,7 @@ class MariaQuery {
     eof_ = true;
     num_fields_ = 0;
     num_rows_ = 0;
+    name_index_.Clear();
   }
 
  private:
@@ -224,6 +311,7 @@ class MariaQuery {
   bool eof_ = true;
   int32_t num_fields_ = 0;
   uint64_t num_rows_ = 0;
+  mutable ColumnIndex name_index_;  // Built on first FieldIndex()
 };
 
 }  // namespace dbpp
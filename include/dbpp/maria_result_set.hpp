@@ -7,14 +7,17 @@
 //   - Move-only (no copy)
 //   - Supports SeekRow() via mysql_data_seek()
 //   - API-compatible with Sqlite3ResultSet for Database<Backend> template
+//   - Named access through a lazily built ColumnIndex / ColumnRef
 
 #pragma once
 
 #include <cstdint>
 #include <cstring>
+#include <utility>
 
 #include <mysql.h>
 
+#include "dbpp/column_index.hpp"
 #include "dbpp/error.hpp"
 
 namespace dbpp {
@@ -38,7 +41,8 @@ class MariaResultSet {
         fields_(other.fields_),
         num_rows_(other.num_rows_),
         num_cols_(other.num_cols_),
-        current_row_(other.current_row_) {
+        current_row_(other.current_row_),
+        name_index_(std::move(other.name_index_)) {
     other.res_ = nullptr;
     other.row_ = nullptr;
     other.fields_ = nullptr;
@@ -56,6 +60,7 @@ class MariaResultSet {
       num_rows_ = other.num_rows_;
       num_cols_ = other.num_cols_;
       current_row_ = other.current_row_;
+      name_index_ = std::move(other.name_index_);
       other.res_ = nullptr;
       other.row_ = nullptr;
       other.fields_ = nullptr;
@@ -76,14 +81,15 @@ class MariaResultSet {
   uint32_t NumRows() const { return static_cast<uint32_t>(num_rows_); }
 
   int32_t FieldIndex(const char* name) const {
-    if (fields_ == nullptr || name == nullptr) { return -1; }
-    for (int32_t i = 0; i < num_cols_; ++i) {
-      if (fields_[i].name != nullptr &&
-          std::strcmp(name, fields_[i].name) == 0) {
-        return i;
-      }
-    }
-    return -1;
+    if (fields_ == nullptr) { return -1; }
+    MYSQL_FIELD* fields = fields_;
+    return name_index_.Find(name, num_cols_,
+                            [fields](int32_t i) { return fields[i].name; });
+  }
+
+  /// Resolve `name` once, for positional access inside a row loop.
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
   }
 
   const char* FieldName(int32_t col) const {
@@ -151,6 +157,7 @@ class MariaResultSet {
     num_rows_ = 0;
     num_cols_ = 0;
     current_row_ = 0;
+    name_index_.Clear();
   }
 
  private:
@@ -174,6 +181,7 @@ class MariaResultSet {
   uint64_t num_rows_ = 0;
   int32_t num_cols_ = 0;
   uint64_t current_row_ = 0;
+  mutable ColumnIndex name_index_;  // Built on first FieldIndex()
 };
 
 }  // namespace dbpp
@@ -8,6 +8,14 @@
 //   - 1-based parameter binding (consistent with Sqlite3Statement)
 //   - ExecDml() for INSERT/UPDATE/DELETE, ExecQuery() for SELECT
 //   - API-compatible with Sqlite3Statement for Database<Backend> template
+//   - Bind(TextView/BlobView) and BindAll() copy into per-parameter buffers
+//     that are reused across rows; BindNoCopy()/BindAllNoCopy() and the
+//     legacy Bind(const char*)/Bind(blob, len) borrow the caller's buffer,
+//     which must stay valid until ExecDml()
+//   - Bind*/Reset return a code-only Status; ErrorMessage()/ToError() read
+//     mysql_stmt_error() only when asked
+//   - Execute failures are classified by MariaErrorCode(), so Exec(...,
+//     &err) tells kConstraint and kBusy apart from other errors
 
 #pragma once
 
@@ -16,13 +24,33 @@
 
 #include <mysql.h>
 
+#include "dbpp/bind_args.hpp"
 #include "dbpp/error.hpp"
 #include "dbpp/maria_query.hpp"
+#include "dbpp/value_types.hpp"
 
 namespace dbpp {
 
 class MariaDb;
 
+/// ErrorCode for a server error number (mysql_errno / mysql_stmt_errno):
+/// duplicate key and foreign key violations are kConstraint, lock wait
+/// timeouts and deadlocks kBusy.
+inline ErrorCode MariaErrorCode(uint32_t err) {
+  switch (err) {
+    case 0:    return ErrorCode::kOk;
+    case 1048:  // ER_BAD_NULL_ERROR
+    case 1062:  // ER_DUP_ENTRY
+    case 1451:  // ER_ROW_IS_REFERENCED_2
+    case 1452:  // ER_NO_REFERENCED_ROW_2
+               return ErrorCode::kConstraint;
+    case 1205:  // ER_LOCK_WAIT_TIMEOUT
+    case 1213:  // ER_LOCK_DEADLOCK
+               return ErrorCode::kBusy;
+    default:   return ErrorCode::kError;
+  }
+}
+
 // ---------------------------------------------------------------------------
 // MariaStatement
 // ---------------------------------------------------------------------------
@@ -34,28 +62,12 @@ class MariaStatement {
   ~MariaStatement() { Finalize(); }
 
   // Move
-  MariaStatement(MariaStatement&& other) noexcept
-      : conn_(other.conn_),
-        stmt_(other.stmt_),
-        binds_(other.binds_),
-        num_params_(other.num_params_) {
-    other.conn_ = nullptr;
-    other.stmt_ = nullptr;
-    other.binds_ = nullptr;
-    other.num_params_ = 0;
-  }
+  MariaStatement(MariaStatement&& other) noexcept { MoveFrom(other); }
 
   MariaStatement& operator=(MariaStatement&& other) noexcept {
     if (this != &other) {
       Finalize();
-      conn_ = other.conn_;
-      stmt_ = other.stmt_;
-      binds_ = other.binds_;
-      num_params_ = other.num_params_;
-      other.conn_ = nullptr;
-      other.stmt_ = nullptr;
-      other.binds_ = nullptr;
-      other.num_params_ = 0;
+      MoveFrom(other);
     }
     return *this;
   }
@@ -86,7 +98,8 @@ class MariaStatement {
 
     if (mysql_stmt_execute(stmt_) != 0) {
       if (out_error != nullptr) {
-        out_error->Set(ErrorCode::kError, mysql_stmt_error(stmt_));
+        out_error->Set(MariaErrorCode(mysql_stmt_errno(stmt_)),
+                       mysql_stmt_error(stmt_));
       }
       return -1;
     }
@@ -160,12 +173,35 @@ class MariaStatement {
     return MariaQuery{};
   }
 
+  /// Bind args to parameters 1..N and execute DML in one call. A trailing
+  /// Error* receives the failure. Returns affected row count, or -1 on
+  /// bind/execute failure.
+  template <typename... Args>
+  int32_t Exec(const Args&... args) {
+    auto run = [this](Error* out_error, const auto&... values) {
+      return ExecBound(out_error, values...);
+    };
+    return detail::CallWithOutError(run, args...);
+  }
+
   // --- Bind (1-based index, converted to 0-based for MySQL API) ---
 
-  Error Bind(int32_t param, const char* value) {
+  /// Bind args to parameters 1..N; text/blob are copied.
+  template <typename... Args>
+  Status BindAll(const Args&... args) {
+    return detail::BindArgs<false>(*this, args...);
+  }
+
+  /// Bind args to parameters 1..N, borrowing text/blob buffers.
+  template <typename... Args>
+  Status BindAllNoCopy(const Args&... args) {
+    return detail::BindArgs<true>(*this, args...);
+  }
+
+  Status Bind(int32_t param, const char* value) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     binds_[idx].buffer_type = MYSQL_TYPE_STRING;
@@ -173,77 +209,96 @@ class MariaStatement {
     binds_[idx].buffer_length =
         (value != nullptr) ? static_cast<unsigned long>(std::strlen(value)) : 0;
     binds_[idx].is_null_value = (value == nullptr) ? 1 : 0;
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, int32_t value) {
+  Status Bind(int32_t param, int32_t value) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     // Store value in buffer_length field (reused as storage for small types)
     StoreInt32(idx, value);
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, int64_t value) {
+  Status Bind(int32_t param, int64_t value) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     StoreInt64(idx, value);
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, double value) {
+  Status Bind(int32_t param, double value) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     StoreDouble(idx, value);
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, const uint8_t* blob, int32_t len) {
+  Status Bind(int32_t param, const uint8_t* blob, int32_t len) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     binds_[idx].buffer_type = MYSQL_TYPE_BLOB;
     binds_[idx].buffer = const_cast<uint8_t*>(blob);
     binds_[idx].buffer_length = static_cast<unsigned long>(len);
-    return Error::Ok();
+    return Status::Ok();
+  }
+
+  Status Bind(int32_t param, TextView value) {
+    return BindBytes(param, MYSQL_TYPE_STRING, value.data, value.size, true);
+  }
+
+  Status Bind(int32_t param, BlobView value) {
+    return BindBytes(param, MYSQL_TYPE_BLOB, value.data, value.size, true);
+  }
+
+  /// Zero-copy text bind: `value` must stay valid until ExecDml().
+  Status BindNoCopy(int32_t param, TextView value) {
+    return BindBytes(param, MYSQL_TYPE_STRING, value.data, value.size, false);
+  }
+
+  /// Zero-copy blob bind, same lifetime rule as BindNoCopy(TextView).
+  Status BindNoCopy(int32_t param, BlobView value) {
+    return BindBytes(param, MYSQL_TYPE_BLOB, value.data, value.size, false);
   }
 
-  Error BindNull(int32_t param) {
+  Status BindNull(int32_t param) {
     int32_t idx = param - 1;
     if (!ValidParam(idx)) {
-      return Error::Make(ErrorCode::kRange, "param out of range");
+      return Status(ErrorCode::kRange);
     }
     std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
     binds_[idx].buffer_type = MYSQL_TYPE_NULL;
-    return Error::Ok();
+    return Status::Ok();
   }
 
   // --- Reset ---
 
-  Error Reset() {
+  Status Reset() {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     if (mysql_stmt_reset(stmt_) != 0) {
-      return Error::Make(ErrorCode::kError, mysql_stmt_error(stmt_));
+      return Status(ErrorCode::kError,
+                    static_cast<int32_t>(mysql_stmt_errno(stmt_)));
     }
     // Clear bind buffers
     if (binds_ != nullptr) {
       std::memset(binds_, 0,
                   static_cast<uint32_t>(num_params_) * sizeof(MYSQL_BIND));
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
   void Finalize() {
@@ -259,14 +314,49 @@ class MariaStatement {
     int64_storage_ = nullptr;
     delete[] double_storage_;
     double_storage_ = nullptr;
+    if (byte_storage_ != nullptr) {
+      for (int32_t i = 0; i < num_params_; ++i) { delete[] byte_storage_[i]; }
+    }
+    delete[] byte_storage_;
+    byte_storage_ = nullptr;
+    delete[] byte_capacity_;
+    byte_capacity_ = nullptr;
     num_params_ = 0;
   }
 
   bool Valid() const { return stmt_ != nullptr; }
 
+  // --- Error detail (read right after the failing call) ---
+
+  /// The statement's message for the last failed call.
+  const char* ErrorMessage() const {
+    return stmt_ != nullptr ? mysql_stmt_error(stmt_)
+                            : "Statement not initialized";
+  }
+
+  /// Expand a Status into an Error carrying the statement's message.
+  Error ToError(Status status) const {
+    Error e;
+    if (!status.ok()) {
+      e.Set(status.code, status.native != 0 ? ErrorMessage()
+                                            : ErrorCodeName(status.code));
+    }
+    return e;
+  }
+
  private:
   friend class MariaDb;
 
+  template <typename... Args>
+  int32_t ExecBound(Error* out_error, const Args&... args) {
+    Status st = BindAll(args...);
+    if (!st.ok()) {
+      if (out_error != nullptr) { *out_error = ToError(st); }
+      return -1;
+    }
+    return ExecDml(out_error);
+  }
+
   MariaStatement(MYSQL* conn, MYSQL_STMT* stmt)
       : conn_(conn), stmt_(stmt) {
     if (stmt_ != nullptr) {
@@ -278,8 +368,63 @@ class MariaStatement {
         int_storage_ = new int32_t[static_cast<uint32_t>(num_params_)]();
         int64_storage_ = new int64_t[static_cast<uint32_t>(num_params_)]();
         double_storage_ = new double[static_cast<uint32_t>(num_params_)]();
+        byte_storage_ = new char*[static_cast<uint32_t>(num_params_)]();
+        byte_capacity_ = new uint32_t[static_cast<uint32_t>(num_params_)]();
+      }
+    }
+  }
+
+  void MoveFrom(MariaStatement& other) {
+    conn_ = other.conn_;
+    stmt_ = other.stmt_;
+    binds_ = other.binds_;
+    int_storage_ = other.int_storage_;
+    int64_storage_ = other.int64_storage_;
+    double_storage_ = other.double_storage_;
+    byte_storage_ = other.byte_storage_;
+    byte_capacity_ = other.byte_capacity_;
+    num_params_ = other.num_params_;
+    other.conn_ = nullptr;
+    other.stmt_ = nullptr;
+    other.binds_ = nullptr;
+    other.int_storage_ = nullptr;
+    other.int64_storage_ = nullptr;
+    other.double_storage_ = nullptr;
+    other.byte_storage_ = nullptr;
+    other.byte_capacity_ = nullptr;
+    other.num_params_ = 0;
+  }
+
+  /// Bind a text/blob buffer. With `copy`, the bytes go to the parameter's
+  /// own buffer (grown on demand, reused across rows). Null data is NULL.
+  Status BindBytes(int32_t param, enum_field_types type, const void* data,
+                   int32_t len, bool copy) {
+    int32_t idx = param - 1;
+    if (!ValidParam(idx)) {
+      return Status(ErrorCode::kRange);
+    }
+    if (len < 0) {
+      return Status(ErrorCode::kRange);
+    }
+    std::memset(&binds_[idx], 0, sizeof(MYSQL_BIND));
+    if (data == nullptr) {
+      binds_[idx].buffer_type = MYSQL_TYPE_NULL;
+      return Status::Ok();
+    }
+    const uint32_t n = static_cast<uint32_t>(len);
+    if (copy && n > 0) {
+      if (n > byte_capacity_[idx]) {
+        delete[] byte_storage_[idx];
+        byte_storage_[idx] = new char[n];
+        byte_capacity_[idx] = n;
       }
+      std::memcpy(byte_storage_[idx], data, n);
+      data = byte_storage_[idx];
     }
+    binds_[idx].buffer_type = type;
+    binds_[idx].buffer = const_cast<void*>(data);
+    binds_[idx].buffer_length = static_cast<unsigned long>(n);
+    return Status::Ok();
   }
 
   bool ValidParam(int32_t idx) const {
@@ -313,6 +458,8 @@ class MariaStatement {
   int32_t* int_storage_ = nullptr;
   int64_t* int64_storage_ = nullptr;
   double* double_storage_ = nullptr;
+  char** byte_storage_ = nullptr;
+  uint32_t* byte_capacity_ = nullptr;
   int32_t num_params_ = 0;
 };
 
@@ -0,0 +1,862 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::RecordBatch / dbpp::FetchBatch -- columnar fetch in Arrow layout.
+//
+// Design:
+//   - FetchBatch(query, max_rows, &batch) reads up to max_rows rows from
+//     the query's current row into one contiguous buffer per column, so
+//     aggregations run over plain arrays instead of per-row getters
+//   - Buffers follow the Arrow C Data Interface: LSB-first validity bitmap,
+//     int64 / double value arrays, int32 offsets + data for utf8 / binary.
+//     64-byte aligned, no Arrow dependency
+//   - Buffers are reused: a batch refilled with the same column names
+//     keeps its capacity, so steady-state fetches do not allocate
+//   - Column types are set on every fetch: SQLite uses the declared type
+//     (INTEGER, REAL, TEXT or BLOB affinity), else the first row's storage
+//     class; MariaDB the field type (BIGINT UNSIGNED and DECIMAL as utf8,
+//     so no value is clamped). A later cell that does not fit widens
+//     the column (int64 -> double, utf8 -> binary); text or a blob in a
+//     numeric column is kMismatch. Values are never silently truncated
+//   - ExportArrow() hands the rows to an Arrow consumer without copying;
+//     the batch allocates fresh buffers on the next fetch
+//   - Cells are read through BatchAccess<Query>, same split as
+//     ExportAccess: generic public getters (MariaQuery), Sqlite3Query
+//     specialization on the raw statement
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#include "sqlite3.h"
+
+#include "dbpp/column_index.hpp"
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_query.hpp"
+#include "dbpp/value_types.hpp"
+
+// ---------------------------------------------------------------------------
+// Arrow C Data Interface (ABI-stable, copied from the specification)
+// ---------------------------------------------------------------------------
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+  const char* format;
+  const char* name;
+  const char* metadata;
+  int64_t flags;
+  int64_t n_children;
+  struct ArrowSchema** children;
+  struct ArrowSchema* dictionary;
+  void (*release)(struct ArrowSchema*);
+  void* private_data;
+};
+
+struct ArrowArray {
+  int64_t length;
+  int64_t null_count;
+  int64_t offset;
+  int64_t n_buffers;
+  int64_t n_children;
+  const void** buffers;
+  struct ArrowArray** children;
+  struct ArrowArray* dictionary;
+  void (*release)(struct ArrowArray*);
+  void* private_data;
+};
+
+#endif  // ARROW_C_DATA_INTERFACE
+
+namespace dbpp {
+
+enum class BatchType : uint8_t {
+  kInt64 = 0,  // Arrow "l"
+  kDouble,     // Arrow "g"
+  kUtf8,       // Arrow "u"
+  kBinary      // Arrow "z"
+};
+
+// ---------------------------------------------------------------------------
+// BatchAccess<Query>
+// ---------------------------------------------------------------------------
+
+/// Generic cell reader over the public query API (MariaQuery): column
+/// types come from the result metadata, values from the text protocol.
+template <typename Query>
+struct BatchAccess {
+  static BatchType Type(const Query& q, int32_t col) {
+    if (q.FieldIsBinary(col)) { return BatchType::kBinary; }
+    if (q.FieldFitsInt64(col)) { return BatchType::kInt64; }
+    if (q.FieldIsReal(col)) { return BatchType::kDouble; }
+    return BatchType::kUtf8;  // DECIMAL, BIGINT UNSIGNED: exact digits
+  }
+  /// Type a non-null cell needs; the field type holds every row.
+  static BatchType CellType(const Query& q, int32_t col) {
+    return Type(q, col);
+  }
+  static bool IsNull(const Query& q, int32_t col) {
+    return q.FieldIsNull(col);
+  }
+  static int64_t Int64(const Query& q, int32_t col) {
+    return q.GetInt64(col);
+  }
+  static double Double(const Query& q, int32_t col) {
+    return q.GetDouble(col);
+  }
+  static const void* Bytes(const Query& q, int32_t col, int32_t* out_len) {
+    return q.GetBlob(col, *out_len);
+  }
+};
+
+template <>
+struct BatchAccess<Sqlite3Query> {
+  /// Declared type's affinity when it is INTEGER, REAL, TEXT or BLOB;
+  /// otherwise (NUMERIC, expressions) the current row's storage class, and
+  /// for a NULL there the declared type's guess (utf8 without one).
+  static BatchType Type(const Sqlite3Query& q, int32_t col) {
+    sqlite3_stmt* stmt = q.Handle();
+    const char* decl = sqlite3_column_decltype(stmt, col);
+    BatchType type = FromDeclType(decl);
+    if (decl != nullptr && *decl != '\0' && !IsNumericAffinity(decl)) {
+      return type;
+    }
+    return IsNull(q, col) ? type : CellType(q, col);
+  }
+  /// Storage class of a non-null cell.
+  static BatchType CellType(const Sqlite3Query& q, int32_t col) {
+    switch (sqlite3_column_type(q.Handle(), col)) {
+      case SQLITE_INTEGER: return BatchType::kInt64;
+      case SQLITE_FLOAT:   return BatchType::kDouble;
+      case SQLITE_BLOB:    return BatchType::kBinary;
+      default:             return BatchType::kUtf8;
+    }
+  }
+  static bool IsNull(const Sqlite3Query& q, int32_t col) {
+    return sqlite3_column_type(q.Handle(), col) == SQLITE_NULL;
+  }
+  static int64_t Int64(const Sqlite3Query& q, int32_t col) {
+    return sqlite3_column_int64(q.Handle(), col);
+  }
+  static double Double(const Sqlite3Query& q, int32_t col) {
+    return sqlite3_column_double(q.Handle(), col);
+  }
+  static const void* Bytes(const Sqlite3Query& q, int32_t col,
+                           int32_t* out_len) {
+    // Pointer first, then length (sqlite3 docs ordering rule)
+    const void* p = sqlite3_column_blob(q.Handle(), col);
+    *out_len = sqlite3_column_bytes(q.Handle(), col);
+    return p;
+  }
+
+ private:
+  static bool Contains(const char* s, const char* word) {
+    size_t n = std::strlen(word);
+    for (; *s != '\0'; ++s) {
+      size_t i = 0;
+      while (i < n && s[i] != '\0' &&
+             (s[i] & ~0x20) == word[i]) {  // ASCII upper-case compare
+        ++i;
+      }
+      if (i == n) { return true; }
+    }
+    return false;
+  }
+
+  /// Column affinity rules of https://sqlite.org/datatype3.html (3.1).
+  static BatchType FromDeclType(const char* decl) {
+    if (decl == nullptr) { return BatchType::kUtf8; }
+    if (Contains(decl, "INT")) { return BatchType::kInt64; }
+    if (Contains(decl, "CHAR") || Contains(decl, "CLOB") ||
+        Contains(decl, "TEXT")) {
+      return BatchType::kUtf8;
+    }
+    if (Contains(decl, "BLOB")) { return BatchType::kBinary; }
+    if (*decl == '\0') { return BatchType::kUtf8; }
+    return BatchType::kDouble;  // REAL / FLOA / DOUB / NUMERIC
+  }
+
+  /// NUMERIC affinity stores integers and reals alike, so the declared
+  /// type does not settle the column type.
+  static bool IsNumericAffinity(const char* decl) {
+    return !Contains(decl, "INT") && !Contains(decl, "CHAR") &&
+           !Contains(decl, "CLOB") && !Contains(decl, "TEXT") &&
+           !Contains(decl, "BLOB") && !Contains(decl, "REAL") &&
+           !Contains(decl, "FLOA") && !Contains(decl, "DOUB");
+  }
+};
+
+class RecordBatch;
+
+template <typename Query>
+uint32_t FetchBatch(Query& query, uint32_t max_rows, RecordBatch* batch,
+                    Error* out_error = nullptr);
+
+// ---------------------------------------------------------------------------
+// RecordBatch
+// ---------------------------------------------------------------------------
+
+class RecordBatch {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  RecordBatch() = default;
+
+  ~RecordBatch() { Clear(); }
+
+  // Move
+  RecordBatch(RecordBatch&& other) noexcept { MoveFrom(other); }
+
+  RecordBatch& operator=(RecordBatch&& other) noexcept {
+    if (this != &other) {
+      Clear();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  RecordBatch(const RecordBatch&) = delete;
+  RecordBatch& operator=(const RecordBatch&) = delete;
+
+  // --- Schema ---
+
+  int32_t NumColumns() const { return num_cols_; }
+  uint32_t NumRows() const { return num_rows_; }
+
+  const char* ColumnName(int32_t col) const {
+    if (col < 0 || col >= num_cols_) { return nullptr; }
+    return names_ + cols_[col].name_offset;
+  }
+
+  BatchType ColumnType(int32_t col) const {
+    if (col < 0 || col >= num_cols_) { return BatchType::kUtf8; }
+    return cols_[col].type;
+  }
+
+  int32_t FieldIndex(const char* name) const {
+    return name_index_.Find(name, num_cols_, [this](int32_t i) {
+      return names_ + cols_[i].name_offset;
+    });
+  }
+
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
+  }
+
+  // --- Column buffers (valid until the next fetch) ---
+
+  int64_t NullCount(int32_t col) const {
+    return (col >= 0 && col < num_cols_) ? cols_[col].null_count : 0;
+  }
+
+  /// Arrow validity bitmap: bit (row % 8) of byte (row / 8), 1 = not null.
+  const uint8_t* Validity(int32_t col) const {
+    return (col >= 0 && col < num_cols_) ? cols_[col].validity : nullptr;
+  }
+
+  /// kInt64 values, NumRows() entries (0 in null slots); else nullptr.
+  const int64_t* Int64Values(int32_t col) const {
+    if (col < 0 || col >= num_cols_ || cols_[col].type != BatchType::kInt64) {
+      return nullptr;
+    }
+    return reinterpret_cast<const int64_t*>(cols_[col].values);
+  }
+
+  /// kDouble values, NumRows() entries (0.0 in null slots); else nullptr.
+  const double* DoubleValues(int32_t col) const {
+    if (col < 0 || col >= num_cols_ ||
+        cols_[col].type != BatchType::kDouble) {
+      return nullptr;
+    }
+    return reinterpret_cast<const double*>(cols_[col].values);
+  }
+
+  /// kUtf8 / kBinary: NumRows() + 1 offsets into Data(); else nullptr.
+  const int32_t* Offsets(int32_t col) const {
+    if (col < 0 || col >= num_cols_ || !IsVarWidth(cols_[col].type)) {
+      return nullptr;
+    }
+    return reinterpret_cast<const int32_t*>(cols_[col].values);
+  }
+
+  const uint8_t* Data(int32_t col) const {
+    if (col < 0 || col >= num_cols_ || !IsVarWidth(cols_[col].type)) {
+      return nullptr;
+    }
+    return cols_[col].data;
+  }
+
+  // --- Cell access ---
+
+  bool IsNull(int32_t col, uint32_t row) const {
+    if (col < 0 || col >= num_cols_ || row >= num_rows_) { return true; }
+    return (cols_[col].validity[row >> 3] & (1u << (row & 7))) == 0;
+  }
+
+  /// Utf8/binary cell (not NUL-terminated); empty view when null.
+  TextView GetText(int32_t col, uint32_t row) const {
+    const int32_t* offsets = Offsets(col);
+    if (offsets == nullptr || row >= num_rows_) { return TextView(); }
+    return TextView(reinterpret_cast<const char*>(cols_[col].data) +
+                        offsets[row],
+                    offsets[row + 1] - offsets[row]);
+  }
+
+  BlobView GetBlob(int32_t col, uint32_t row) const {
+    TextView t = GetText(col, row);
+    return BlobView(t.data, t.size);
+  }
+
+  /// Bytes held by the column buffers.
+  size_t MemoryBytes() const {
+    size_t total = 0;
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      total += cols_[c].validity_cap + cols_[c].values_cap +
+               cols_[c].data_cap;
+    }
+    return total;
+  }
+
+  // --- Arrow export ---
+
+  /// Move the current rows into `out_array` (a struct array with one child
+  /// per column) and describe them in `out_schema`, without copying. Both
+  /// are owned by the caller and freed through their release callbacks.
+  /// The batch keeps its schema and is empty afterwards.
+  Error ExportArrow(ArrowArray* out_array, ArrowSchema* out_schema) {
+    if (out_array == nullptr || out_schema == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "output is null");
+    }
+    ExportSchema(out_schema);
+
+    StructArrayData* parent = new StructArrayData;
+    parent->children = new ArrowArray[num_cols_];
+    parent->child_ptrs = new ArrowArray*[num_cols_];
+    parent->buffers[0] = nullptr;
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      ColumnBuffers& col = cols_[c];
+      ColumnArrayData* data = new ColumnArrayData;
+      data->validity = col.validity;
+      data->values = col.values;
+      data->data = col.data;
+      // Empty columns still need non-null value/offset/data buffers.
+      data->buffers[0] = col.validity;
+      data->buffers[1] = (col.values != nullptr) ? col.values : EmptyBuffer();
+      data->buffers[2] = (col.data != nullptr) ? col.data : EmptyBuffer();
+
+      ArrowArray& child = parent->children[c];
+      child.length = num_rows_;
+      child.null_count = col.null_count;
+      child.offset = 0;
+      child.n_buffers = IsVarWidth(col.type) ? 3 : 2;
+      child.n_children = 0;
+      child.buffers = data->buffers;
+      child.children = nullptr;
+      child.dictionary = nullptr;
+      child.release = &ReleaseColumnArray;
+      child.private_data = data;
+      parent->child_ptrs[c] = &child;
+
+      // Ownership moved to the array; the next fetch allocates again.
+      col.validity = nullptr;
+      col.values = nullptr;
+      col.data = nullptr;
+      col.validity_cap = 0;
+      col.values_cap = 0;
+      col.data_cap = 0;
+      col.null_count = 0;
+    }
+
+    out_array->length = num_rows_;
+    out_array->null_count = 0;
+    out_array->offset = 0;
+    out_array->n_buffers = 1;
+    out_array->n_children = num_cols_;
+    out_array->buffers = parent->buffers;
+    out_array->children = parent->child_ptrs;
+    out_array->dictionary = nullptr;
+    out_array->release = &ReleaseStructArray;
+    out_array->private_data = parent;
+
+    num_rows_ = 0;
+    row_cap_ = 0;
+    return Error::Ok();
+  }
+
+  /// Release buffers and schema.
+  void Clear() {
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      AlignedFree(cols_[c].validity);
+      AlignedFree(cols_[c].values);
+      AlignedFree(cols_[c].data);
+    }
+    delete[] cols_;
+    delete[] names_;
+    cols_ = nullptr;
+    names_ = nullptr;
+    num_cols_ = 0;
+    num_rows_ = 0;
+    row_cap_ = 0;
+    name_index_.Clear();
+  }
+
+ private:
+  template <typename Query>
+  friend uint32_t FetchBatch(Query& query, uint32_t max_rows,
+                             RecordBatch* batch, Error* out_error);
+
+  struct ColumnBuffers {
+    BatchType type = BatchType::kUtf8;
+    uint32_t name_offset = 0;  // Into names_
+    uint8_t* validity = nullptr;
+    uint8_t* values = nullptr;  // int64 / double values or int32 offsets
+    uint8_t* data = nullptr;    // utf8 / binary bytes
+    size_t validity_cap = 0;
+    size_t values_cap = 0;
+    size_t data_cap = 0;
+    uint32_t data_len = 0;
+    int64_t null_count = 0;
+  };
+
+  // --- Arrow release callbacks ---
+
+  struct ColumnArrayData {
+    uint8_t* validity;
+    uint8_t* values;
+    uint8_t* data;
+    const void* buffers[3];
+  };
+
+  struct StructArrayData {
+    ArrowArray* children;
+    ArrowArray** child_ptrs;
+    const void* buffers[1];
+  };
+
+  struct StructSchemaData {
+    ArrowSchema* children;
+    ArrowSchema** child_ptrs;
+  };
+
+  static void ReleaseColumnArray(ArrowArray* array) {
+    ColumnArrayData* data = static_cast<ColumnArrayData*>(array->private_data);
+    AlignedFree(data->validity);
+    AlignedFree(data->values);
+    AlignedFree(data->data);
+    delete data;
+    array->release = nullptr;
+  }
+
+  static void ReleaseStructArray(ArrowArray* array) {
+    StructArrayData* data = static_cast<StructArrayData*>(array->private_data);
+    for (int64_t c = 0; c < array->n_children; ++c) {
+      // A consumer may have moved a child out and released it already.
+      if (data->children[c].release != nullptr) {
+        data->children[c].release(&data->children[c]);
+      }
+    }
+    delete[] data->children;
+    delete[] data->child_ptrs;
+    delete data;
+    array->release = nullptr;
+  }
+
+  static void ReleaseColumnSchema(ArrowSchema* schema) {
+    delete[] static_cast<char*>(schema->private_data);  // The name
+    schema->release = nullptr;
+  }
+
+  static void ReleaseStructSchema(ArrowSchema* schema) {
+    StructSchemaData* data = static_cast<StructSchemaData*>(
+        schema->private_data);
+    for (int64_t c = 0; c < schema->n_children; ++c) {
+      if (data->children[c].release != nullptr) {
+        data->children[c].release(&data->children[c]);
+      }
+    }
+    delete[] data->children;
+    delete[] data->child_ptrs;
+    delete data;
+    schema->release = nullptr;
+  }
+
+  static const char* ArrowFormat(BatchType type) {
+    switch (type) {
+      case BatchType::kInt64:  return "l";
+      case BatchType::kDouble: return "g";
+      case BatchType::kBinary: return "z";
+      default:                 return "u";
+    }
+  }
+
+  void ExportSchema(ArrowSchema* out) const {
+    StructSchemaData* parent = new StructSchemaData;
+    parent->children = new ArrowSchema[num_cols_];
+    parent->child_ptrs = new ArrowSchema*[num_cols_];
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      const char* name = ColumnName(c);
+      size_t len = std::strlen(name);
+      char* copy = new char[len + 1];
+      std::memcpy(copy, name, len + 1);
+
+      ArrowSchema& child = parent->children[c];
+      child.format = ArrowFormat(cols_[c].type);
+      child.name = copy;
+      child.metadata = nullptr;
+      child.flags = ARROW_FLAG_NULLABLE;
+      child.n_children = 0;
+      child.children = nullptr;
+      child.dictionary = nullptr;
+      child.release = &ReleaseColumnSchema;
+      child.private_data = copy;
+      parent->child_ptrs[c] = &child;
+    }
+    out->format = "+s";
+    out->name = "";
+    out->metadata = nullptr;
+    out->flags = 0;
+    out->n_children = num_cols_;
+    out->children = parent->child_ptrs;
+    out->dictionary = nullptr;
+    out->release = &ReleaseStructSchema;
+    out->private_data = parent;
+  }
+
+  /// Zeroed, aligned bytes: a valid offsets[0] / empty data buffer.
+  static const void* EmptyBuffer() {
+    alignas(8) static const uint8_t empty[8] = {0};
+    return empty;
+  }
+
+  // --- Allocation ---
+
+  static bool IsVarWidth(BatchType type) {
+    return type == BatchType::kUtf8 || type == BatchType::kBinary;
+  }
+
+  static uint8_t* AlignedAlloc(size_t bytes) {
+#if defined(_WIN32)
+    return static_cast<uint8_t*>(_aligned_malloc(bytes, kAlignment));
+#else
+    void* p = nullptr;
+    if (posix_memalign(&p, kAlignment, bytes) != 0) { return nullptr; }
+    return static_cast<uint8_t*>(p);
+#endif
+  }
+
+  static void AlignedFree(void* p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+  }
+
+  /// Grow `*buf` to at least `need` bytes, keeping the first `used`.
+  static bool Grow(uint8_t** buf, size_t* cap, size_t used, size_t need) {
+    if (need <= *cap) { return true; }
+    size_t new_cap = (*cap > 0) ? *cap * 2 : kAlignment;
+    while (new_cap < need) { new_cap *= 2; }
+    uint8_t* p = AlignedAlloc(new_cap);
+    if (p == nullptr) { return false; }
+    if (used > 0 && *buf != nullptr) { std::memcpy(p, *buf, used); }
+    AlignedFree(*buf);
+    *buf = p;
+    *cap = new_cap;
+    return true;
+  }
+
+  // --- Filling (FetchBatch) ---
+
+  /// True if the batch's columns have the query's names, in order.
+  template <typename Query>
+  bool SameColumns(const Query& query) const {
+    if (num_cols_ != query.NumFields()) { return false; }
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      const char* name = query.FieldName(c);
+      if (std::strcmp(ColumnName(c), name != nullptr ? name : "") != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// Rebuild the column names from the query. Buffers of the previous
+  /// schema are dropped.
+  template <typename Query>
+  void BuildSchema(const Query& query) {
+    Clear();
+    num_cols_ = query.NumFields();
+    if (num_cols_ <= 0) {
+      num_cols_ = 0;
+      return;
+    }
+    cols_ = new ColumnBuffers[num_cols_];
+    size_t names_len = 0;
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      const char* name = query.FieldName(c);
+      names_len += std::strlen(name != nullptr ? name : "") + 1;
+    }
+    names_ = new char[names_len];
+    uint32_t off = 0;
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      const char* name = query.FieldName(c);
+      if (name == nullptr) { name = ""; }
+      size_t len = std::strlen(name);
+      std::memcpy(names_ + off, name, len + 1);
+      cols_[c].name_offset = off;
+      off += static_cast<uint32_t>(len + 1);
+    }
+  }
+
+  /// Make room for more rows (at most `max_rows`) in every fixed-width
+  /// buffer. Only called while row_cap_ < max_rows.
+  bool GrowRows(uint32_t max_rows) {
+    uint32_t cap = (row_cap_ > 0) ? row_cap_ * 2 : 1024;
+    if (cap <= row_cap_ || cap > max_rows) { cap = max_rows; }
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      ColumnBuffers& col = cols_[c];
+      size_t width = IsVarWidth(col.type) ? sizeof(int32_t) : sizeof(int64_t);
+      size_t used = IsVarWidth(col.type)
+          ? (static_cast<size_t>(num_rows_) + 1) * width
+          : static_cast<size_t>(num_rows_) * width;
+      if (!Grow(&col.validity, &col.validity_cap, (num_rows_ + 7) / 8,
+                (static_cast<size_t>(cap) + 7) / 8) ||
+          !Grow(&col.values, &col.values_cap, used,
+                (static_cast<size_t>(cap) + 1) * width)) {
+        return false;
+      }
+    }
+    row_cap_ = cap;
+    return true;
+  }
+
+  /// Change `col` so it holds a `cell` value too, keeping the rows so
+  /// far: int64 -> double, utf8 -> binary. False if no type holds both.
+  bool Widen(ColumnBuffers* col, BatchType cell) const {
+    if (col->type == BatchType::kDouble && cell == BatchType::kInt64) {
+      return true;  // Read as double
+    }
+    if (IsVarWidth(col->type)) {
+      if (cell == BatchType::kBinary) { col->type = BatchType::kBinary; }
+      return true;  // Numbers go in as their text
+    }
+    if (col->type != BatchType::kInt64 || cell != BatchType::kDouble) {
+      return false;
+    }
+    for (uint32_t r = 0; r < num_rows_; ++r) {  // Same width, in place
+      int64_t i = 0;
+      std::memcpy(&i, col->values + r * sizeof(int64_t), sizeof(i));
+      double d = static_cast<double>(i);
+      std::memcpy(col->values + r * sizeof(double), &d, sizeof(d));
+    }
+    col->type = BatchType::kDouble;
+    return true;
+  }
+
+  /// Append the query's current row. False on allocation failure, or
+  /// with `*out_mismatch` set to the column a cell does not fit.
+  template <typename Query>
+  bool AppendRow(const Query& query, int32_t* out_mismatch) {
+    using Access = BatchAccess<Query>;
+    uint32_t row = num_rows_;
+    uint32_t byte = row >> 3;
+    uint8_t bit = static_cast<uint8_t>(1u << (row & 7));
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      ColumnBuffers& col = cols_[c];
+      if ((row & 7) == 0) { col.validity[byte] = 0; }
+      bool is_null = Access::IsNull(query, c);
+      if (is_null) {
+        ++col.null_count;
+      } else {
+        col.validity[byte] |= bit;
+        BatchType cell = Access::CellType(query, c);
+        if (cell != col.type && !Widen(&col, cell)) {
+          *out_mismatch = c;
+          return DropRow(row, c);
+        }
+      }
+      switch (col.type) {
+        case BatchType::kInt64: {
+          int64_t v = is_null ? 0 : Access::Int64(query, c);
+          std::memcpy(col.values + row * sizeof(int64_t), &v, sizeof(v));
+          break;
+        }
+        case BatchType::kDouble: {
+          double v = is_null ? 0.0 : Access::Double(query, c);
+          std::memcpy(col.values + row * sizeof(double), &v, sizeof(v));
+          break;
+        }
+        default: {
+          int32_t len = 0;
+          const void* p = is_null ? nullptr : Access::Bytes(query, c, &len);
+          if (len < 0 || p == nullptr) { len = 0; }
+          uint64_t end = uint64_t{col.data_len} + static_cast<uint32_t>(len);
+          if (end > INT32_MAX ||
+              !Grow(&col.data, &col.data_cap, col.data_len,
+                    static_cast<size_t>(end))) {
+            return DropRow(row, c);
+          }
+          if (len > 0) { std::memcpy(col.data + col.data_len, p, len); }
+          col.data_len = static_cast<uint32_t>(end);
+          int32_t off = static_cast<int32_t>(end);
+          std::memcpy(col.values + (row + 1) * sizeof(int32_t), &off,
+                      sizeof(off));
+          break;
+        }
+      }
+    }
+    ++num_rows_;
+    return true;
+  }
+
+  /// Undo the cells of `row` written to columns 0..last, so the batch
+  /// ends at the previous row. Returns false.
+  bool DropRow(uint32_t row, int32_t last) {
+    uint8_t bit = static_cast<uint8_t>(1u << (row & 7));
+    for (int32_t c = 0; c <= last; ++c) {
+      ColumnBuffers& col = cols_[c];
+      if ((col.validity[row >> 3] & bit) == 0) { --col.null_count; }
+      col.validity[row >> 3] &= static_cast<uint8_t>(~bit);
+      if (IsVarWidth(col.type)) {
+        int32_t off = 0;
+        std::memcpy(&off, col.values + row * sizeof(int32_t), sizeof(off));
+        col.data_len = static_cast<uint32_t>(off);
+      }
+    }
+    return false;
+  }
+
+  template <typename Query>
+  uint32_t Fill(Query& query, uint32_t max_rows, Error* out_error) {
+    num_rows_ = 0;
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      cols_[c].null_count = 0;
+      cols_[c].data_len = 0;
+    }
+    if (max_rows == 0 || query.Eof()) { return Ended(query, 0, out_error); }
+
+    if (!SameColumns(query)) { BuildSchema(query); }
+    if (!SetTypes(query) || (row_cap_ == 0 && !GrowRows(max_rows))) {
+      return Fail(out_error);
+    }
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      if (IsVarWidth(cols_[c].type)) {
+        std::memset(cols_[c].values, 0, sizeof(int32_t));  // offsets[0]
+      }
+    }
+
+    while (num_rows_ < max_rows && !query.Eof()) {
+      if (num_rows_ == row_cap_ && !GrowRows(max_rows)) {
+        return Fail(out_error);
+      }
+      int32_t mismatch = -1;
+      if (!AppendRow(query, &mismatch)) { return Fail(out_error, mismatch); }
+      query.NextRow();
+    }
+    return Ended(query, num_rows_, out_error);
+  }
+
+  /// `rows`, with the query's step error in `out_error` when its rows
+  /// ended on a failed step (kBusy, kIoError, ...) instead of the end.
+  template <typename Query>
+  static uint32_t Ended(const Query& query, uint32_t rows,
+                        Error* out_error) {
+    if (out_error != nullptr && !query.StepStatus().ok()) {
+      *out_error = query.ToError();
+    }
+    return rows;
+  }
+
+  /// Type every column from the query's current row. A utf8/binary column
+  /// turning fixed-width needs 8-byte value slots for the rows it holds.
+  template <typename Query>
+  bool SetTypes(const Query& query) {
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      ColumnBuffers& col = cols_[c];
+      BatchType type = BatchAccess<Query>::Type(query, c);
+      if (row_cap_ > 0 && IsVarWidth(col.type) && !IsVarWidth(type) &&
+          !Grow(&col.values, &col.values_cap, 0,
+                (static_cast<size_t>(row_cap_) + 1) * sizeof(int64_t))) {
+        return false;
+      }
+      col.type = type;
+    }
+    return true;
+  }
+
+  /// Allocation failure or a column over 2 GiB in one batch (kFull), or
+  /// a cell column `mismatch` cannot hold (kMismatch): the rows read so
+  /// far are kept and counted, and the query stays on the row that did
+  /// not fit.
+  uint32_t Fail(Error* out_error, int32_t mismatch = -1) {
+    if (out_error != nullptr && mismatch >= 0) {
+      out_error->SetFormat(ErrorCode::kMismatch,
+                           "column %s is numeric, a row holds text or a blob",
+                           ColumnName(mismatch));
+    } else if (out_error != nullptr) {
+      *out_error = Error::Make(ErrorCode::kFull,
+                               "batch buffer exhausted, fetch fewer rows");
+    }
+    return num_rows_;
+  }
+
+  void MoveFrom(RecordBatch& other) {
+    cols_ = other.cols_;
+    names_ = other.names_;
+    num_cols_ = other.num_cols_;
+    num_rows_ = other.num_rows_;
+    row_cap_ = other.row_cap_;
+    name_index_ = std::move(other.name_index_);
+    other.cols_ = nullptr;
+    other.names_ = nullptr;
+    other.num_cols_ = 0;
+    other.num_rows_ = 0;
+    other.row_cap_ = 0;
+  }
+
+  ColumnBuffers* cols_ = nullptr;
+  char* names_ = nullptr;  // Column names, NUL-separated
+  int32_t num_cols_ = 0;
+  uint32_t num_rows_ = 0;
+  uint32_t row_cap_ = 0;   // Rows the fixed-width buffers hold
+  mutable ColumnIndex name_index_;
+};
+
+// ---------------------------------------------------------------------------
+// FetchBatch
+// ---------------------------------------------------------------------------
+
+/// Read up to `max_rows` rows, starting at the query's current row, into
+/// `batch` (replacing its previous rows). Returns the number of rows read;
+/// 0 at end of results. On an error (a failed step, kFull, kMismatch)
+/// `out_error` is set and the rows read before it are still returned.
+/// The query is left on the first row not read, so repeated calls walk
+/// the whole result:
+///   RecordBatch batch;
+///   while (FetchBatch(q, 65536, &batch) > 0) { Sum(batch.Int64Values(0)); }
+template <typename Query>
+uint32_t FetchBatch(Query& query, uint32_t max_rows, RecordBatch* batch,
+                    Error* out_error) {
+  if (batch == nullptr) {
+    if (out_error != nullptr) {
+      *out_error = Error::Make(ErrorCode::kNullParam, "batch is null");
+    }
+    return 0;
+  }
+  return batch->Fill(query, max_rows, out_error);
+}
+
+}  // namespace dbpp
@@ -0,0 +1,658 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::ResultExporter -- stream query results to CSV or JSON Lines.
+//
+// Design:
+//   - Rows are formatted straight into one reusable output buffer (1 MiB
+//     by default) that is flushed with write(2); no per-field printf or
+//     allocation
+//   - Integers use a digit-pair table; doubles use std::to_chars when the
+//     library has it, else the shortest of %.15g / %.17g that round-trips
+//   - CSV follows RFC 4180 quoting; JSONL writes one object per row with
+//     the column names escaped once per export
+//   - Cells are read through ExportAccess<Query>: the generic version uses
+//     the query's public getters (MariaQuery), Sqlite3Query specializes it
+//     to keep SQLite's native types
+//   - Optional row limit and progress callback (which may stop the export)
+//   - Move-only; Open() owns the file, Attach() borrows a descriptor
+//
+// Cell encoding:
+//   NULL    CSV: empty field          JSON: null
+//   number  CSV: as is                JSON: number (NaN/Inf -> null)
+//   text    CSV: quoted when needed   JSON: escaped string (UTF-8 as is)
+//   blob    lowercase hex (quoted in JSON)
+
+#pragma once
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#if __cplusplus >= 201703L
+#include <charconv>
+#endif
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_query.hpp"
+
+namespace dbpp {
+
+enum class ExportFormat : uint8_t {
+  kCsv = 0,
+  kJsonLines
+};
+
+struct ExportOptions {
+  ExportFormat format = ExportFormat::kCsv;
+  bool header = true;        // CSV: column names once per output
+  char delimiter = ',';      // CSV field separator
+  uint32_t buffer_size = 1u << 20;
+  uint64_t max_rows = 0;     // Per Export() call; 0 = all rows
+
+  /// Called every `progress_interval` rows with the rows and bytes written
+  /// so far by this Export() call. Returning false stops the export.
+  std::function<bool(uint64_t rows, uint64_t bytes)> progress;
+  uint64_t progress_interval = 100000;
+};
+
+struct ExportStats {
+  uint64_t rows = 0;
+  uint64_t bytes = 0;
+  bool stopped = false;  // Progress callback returned false
+};
+
+// ---------------------------------------------------------------------------
+// ExportCell / ExportAccess<Query>
+// ---------------------------------------------------------------------------
+
+enum class ExportCellKind : uint8_t {
+  kNull = 0,
+  kInt,         // i
+  kReal,        // d
+  kNumberText,  // data/size: a number already formatted by the server
+  kText,        // data/size
+  kBinary       // data/size, written as hex
+};
+
+struct ExportCell {
+  ExportCellKind kind = ExportCellKind::kNull;
+  int64_t i = 0;
+  double d = 0.0;
+  const char* data = nullptr;
+  int32_t size = 0;
+};
+
+/// Generic cell reader over the public query API. Everything arrives as
+/// text; FieldIsNumeric()/FieldIsBinary() pick the encoding.
+template <typename Query>
+struct ExportAccess {
+  static void Read(const Query& q, int32_t col, ExportCell* out) {
+    if (q.FieldIsNull(col)) {
+      out->kind = ExportCellKind::kNull;
+      return;
+    }
+    int32_t len = 0;
+    out->data = reinterpret_cast<const char*>(q.GetBlob(col, len));
+    out->size = len;
+    if (q.FieldIsBinary(col)) {
+      out->kind = ExportCellKind::kBinary;
+    } else if (q.FieldIsNumeric(col)) {
+      out->kind = ExportCellKind::kNumberText;
+    } else {
+      out->kind = ExportCellKind::kText;
+    }
+  }
+};
+
+template <>
+struct ExportAccess<Sqlite3Query> {
+  static void Read(const Sqlite3Query& q, int32_t col, ExportCell* out) {
+    sqlite3_stmt* stmt = q.Handle();
+    switch (sqlite3_column_type(stmt, col)) {
+      case SQLITE_INTEGER:
+        out->kind = ExportCellKind::kInt;
+        out->i = sqlite3_column_int64(stmt, col);
+        break;
+      case SQLITE_FLOAT:
+        out->kind = ExportCellKind::kReal;
+        out->d = sqlite3_column_double(stmt, col);
+        break;
+      case SQLITE_TEXT:
+        out->kind = ExportCellKind::kText;
+        out->data = reinterpret_cast<const char*>(
+            sqlite3_column_text(stmt, col));
+        out->size = sqlite3_column_bytes(stmt, col);
+        break;
+      case SQLITE_BLOB:
+        out->kind = ExportCellKind::kBinary;
+        out->data = static_cast<const char*>(sqlite3_column_blob(stmt, col));
+        out->size = sqlite3_column_bytes(stmt, col);
+        break;
+      default:
+        out->kind = ExportCellKind::kNull;
+        break;
+    }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// ResultExporter
+// ---------------------------------------------------------------------------
+
+class ResultExporter {
+ public:
+  explicit ResultExporter(const ExportOptions& opts = ExportOptions{})
+      : opts_(opts) {
+    cap_ = opts_.buffer_size < kMinBuffer ? kMinBuffer : opts_.buffer_size;
+    buf_ = new char[cap_];
+  }
+
+  ~ResultExporter() {
+    Close();
+    delete[] buf_;
+    delete[] keys_;
+    delete[] key_offsets_;
+  }
+
+  // Move
+  ResultExporter(ResultExporter&& other) noexcept
+      : opts_(std::move(other.opts_)) {
+    MoveFrom(other);
+  }
+
+  ResultExporter& operator=(ResultExporter&& other) noexcept {
+    if (this != &other) {
+      Close();
+      delete[] buf_;
+      delete[] keys_;
+      delete[] key_offsets_;
+      opts_ = std::move(other.opts_);
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  ResultExporter(const ResultExporter&) = delete;
+  ResultExporter& operator=(const ResultExporter&) = delete;
+
+  // --- Output ---
+
+  /// Create (or truncate) `path` and write to it; closed by Close().
+  Error Open(const char* path) {
+    if (path == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "path is null");
+    }
+    Close();
+#if defined(_WIN32)
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                   _S_IREAD | _S_IWRITE);
+#else
+    int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (fd < 0) {
+      Error err;
+      err.SetFormat(ErrorCode::kIoError, "open %s: %s", path,
+                    std::strerror(errno));
+      return err;
+    }
+    fd_ = fd;
+    owns_fd_ = true;
+    header_written_ = false;
+    write_error_.Clear();
+    return Error::Ok();
+  }
+
+  /// Write to an already open descriptor (e.g. STDOUT_FILENO). The caller
+  /// keeps ownership; Close() only flushes.
+  Error Attach(int fd) {
+    if (fd < 0) { return Error::Make(ErrorCode::kRange, "invalid fd"); }
+    Close();
+    fd_ = fd;
+    owns_fd_ = false;
+    header_written_ = false;
+    write_error_.Clear();
+    return Error::Ok();
+  }
+
+  /// Push buffered bytes to the descriptor.
+  Error Flush() {
+    if (fd_ < 0) {
+      return Error::Make(ErrorCode::kNotOpen, "no output");
+    }
+    WriteOut(buf_, len_);
+    len_ = 0;
+    return write_error_;
+  }
+
+  /// Flush, then close the file if Open() created it.
+  Error Close() {
+    if (fd_ < 0) { return Error::Ok(); }
+    Error err = Flush();
+    if (owns_fd_) {
+#if defined(_WIN32)
+      _close(fd_);
+#else
+      ::close(fd_);
+#endif
+    }
+    fd_ = -1;
+    owns_fd_ = false;
+    return err;
+  }
+
+  bool IsOpen() const { return fd_ >= 0; }
+
+  /// Bytes written to the descriptor plus those still buffered.
+  uint64_t BytesWritten() const { return flushed_ + len_; }
+
+  // --- Export ---
+
+  /// Write the remaining rows of `query` (from its current row). Data is
+  /// buffered; call Flush() or Close() to push the tail out. The CSV
+  /// header goes out with the first Export() after Open()/Attach(), so a
+  /// result exported in max_rows chunks has it once.
+  template <typename Query>
+  Error Export(Query& query, ExportStats* out_stats = nullptr) {
+    if (fd_ < 0) {
+      return Error::Make(ErrorCode::kNotOpen, "no output");
+    }
+    const int32_t cols = query.NumFields();
+    const uint64_t start_bytes = BytesWritten();
+    ExportStats stats;
+
+    if (opts_.format == ExportFormat::kCsv) {
+      if (opts_.header && cols > 0 && !header_written_) {
+        WriteCsvHeader(query, cols);
+        header_written_ = true;
+      }
+    } else {
+      BuildJsonKeys(query, cols);
+    }
+
+    ExportCell cell;
+    const uint64_t interval =
+        opts_.progress_interval == 0 ? 1 : opts_.progress_interval;
+    while (!query.Eof() && write_error_.ok() &&
+           (opts_.max_rows == 0 || stats.rows < opts_.max_rows)) {
+      if (opts_.format == ExportFormat::kCsv) {
+        for (int32_t c = 0; c < cols; ++c) {
+          if (c > 0) { Put(opts_.delimiter); }
+          ExportAccess<Query>::Read(query, c, &cell);
+          WriteCsvCell(cell);
+        }
+      } else {
+        Put('{');
+        for (int32_t c = 0; c < cols; ++c) {
+          if (c > 0) { Put(','); }
+          Append(keys_ + key_offsets_[c],
+                 key_offsets_[c + 1] - key_offsets_[c]);
+          ExportAccess<Query>::Read(query, c, &cell);
+          WriteJsonCell(cell);
+        }
+        Put('}');
+      }
+      Put('\n');
+      ++stats.rows;
+      query.NextRow();
+
+      if (opts_.progress && stats.rows % interval == 0 &&
+          !opts_.progress(stats.rows, BytesWritten() - start_bytes)) {
+        stats.stopped = true;
+        break;
+      }
+    }
+
+    stats.bytes = BytesWritten() - start_bytes;
+    if (out_stats != nullptr) { *out_stats = stats; }
+    if (write_error_.ok() && !query.StepStatus().ok()) {
+      return query.ToError();  // Rows ended on a failed step
+    }
+    return write_error_;
+  }
+
+  /// Run `sql` on `db` (any type with ExecQuery(sql, Error*)) and export
+  /// the result.
+  template <typename Db>
+  Error ExportSql(Db& db, const char* sql, ExportStats* out_stats = nullptr) {
+    Error err;
+    auto query = db.ExecQuery(sql, &err);
+    if (!err.ok()) { return err; }
+    return Export(query, out_stats);
+  }
+
+ private:
+  static constexpr uint32_t kMinBuffer = 4096;
+
+  void MoveFrom(ResultExporter& other) {
+    buf_ = other.buf_;
+    cap_ = other.cap_;
+    len_ = other.len_;
+    flushed_ = other.flushed_;
+    fd_ = other.fd_;
+    owns_fd_ = other.owns_fd_;
+    header_written_ = other.header_written_;
+    write_error_ = other.write_error_;
+    keys_ = other.keys_;
+    keys_cap_ = other.keys_cap_;
+    key_offsets_ = other.key_offsets_;
+    key_offsets_cap_ = other.key_offsets_cap_;
+    other.buf_ = nullptr;
+    other.cap_ = 0;
+    other.len_ = 0;
+    other.flushed_ = 0;
+    other.fd_ = -1;
+    other.owns_fd_ = false;
+    other.header_written_ = false;
+    other.keys_ = nullptr;
+    other.keys_cap_ = 0;
+    other.key_offsets_ = nullptr;
+    other.key_offsets_cap_ = 0;
+  }
+
+  // --- Buffer ---
+
+  void WriteOut(const char* data, uint32_t n) {
+    while (n > 0 && write_error_.ok()) {
+#if defined(_WIN32)
+      int w = _write(fd_, data, n);
+#else
+      ssize_t w = ::write(fd_, data, n);
+#endif
+      if (w < 0) {
+        if (errno == EINTR) { continue; }
+        write_error_.SetFormat(ErrorCode::kIoError, "write: %s",
+                               std::strerror(errno));
+        return;
+      }
+      data += w;
+      n -= static_cast<uint32_t>(w);
+      flushed_ += static_cast<uint64_t>(w);
+    }
+  }
+
+  void Put(char c) {
+    if (len_ == cap_) { Flush(); }
+    buf_[len_++] = c;
+  }
+
+  void Append(const char* data, uint32_t n) {
+    if (n > cap_ - len_) {
+      Flush();
+      if (n > cap_) {
+        WriteOut(data, n);  // Larger than the buffer: bypass it
+        return;
+      }
+    }
+    std::memcpy(buf_ + len_, data, n);
+    len_ += n;
+  }
+
+  /// Make room for `n` bytes (n <= kMinBuffer) and return the write head.
+  char* Reserve(uint32_t n) {
+    if (n > cap_ - len_) { Flush(); }
+    return buf_ + len_;
+  }
+
+  // --- Number formatting ---
+
+  void WriteInt(int64_t v) {
+    static const char kPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233"
+        "34353637383940414243444546474849505152535455565758596061626364656667"
+        "6869707172737475767778798081828384858687888990919293949596979899";
+    char tmp[24];
+    char* end = tmp + sizeof(tmp);
+    char* p = end;
+    uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v)
+                       : static_cast<uint64_t>(v);
+    while (u >= 100) {
+      uint32_t pair = static_cast<uint32_t>(u % 100) * 2;
+      u /= 100;
+      *--p = kPairs[pair + 1];
+      *--p = kPairs[pair];
+    }
+    if (u >= 10) {
+      uint32_t pair = static_cast<uint32_t>(u) * 2;
+      *--p = kPairs[pair + 1];
+      *--p = kPairs[pair];
+    } else {
+      *--p = static_cast<char>('0' + u);
+    }
+    if (v < 0) { *--p = '-'; }
+    Append(p, static_cast<uint32_t>(end - p));
+  }
+
+  /// Shortest text that reads back as the same double.
+  void WriteReal(double v, bool json) {
+    if (!std::isfinite(v)) {
+      const char* text = json ? "null"
+                              : (std::isnan(v) ? "nan" : (v < 0 ? "-inf"
+                                                                 : "inf"));
+      Append(text, static_cast<uint32_t>(std::strlen(text)));
+      return;
+    }
+    char* p = Reserve(32);
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    std::to_chars_result r = std::to_chars(p, p + 32, v);
+    len_ += static_cast<uint32_t>(r.ptr - p);
+#else
+    int n = std::snprintf(p, 32, "%.15g", v);
+    if (std::strtod(p, nullptr) != v) {
+      n = std::snprintf(p, 32, "%.17g", v);
+    }
+    len_ += static_cast<uint32_t>(n);
+#endif
+  }
+
+  void WriteHex(const char* data, int32_t size) {
+    static const char kDigits[] = "0123456789abcdef";
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+    for (int32_t i = 0; i < size; ++i) {
+      char* out = Reserve(2);
+      out[0] = kDigits[p[i] >> 4];
+      out[1] = kDigits[p[i] & 0x0f];
+      len_ += 2;
+    }
+  }
+
+  // --- CSV ---
+
+  /// RFC 4180: quote when the field holds the delimiter, a quote or a line
+  /// break; double the quotes inside.
+  void WriteCsvText(const char* s, int32_t size) {
+    bool quote = false;
+    for (int32_t i = 0; i < size; ++i) {
+      char c = s[i];
+      if (c == opts_.delimiter || c == '"' || c == '\n' || c == '\r') {
+        quote = true;
+        break;
+      }
+    }
+    if (!quote) {
+      Append(s, static_cast<uint32_t>(size));
+      return;
+    }
+    Put('"');
+    int32_t run = 0;
+    for (int32_t i = 0; i < size; ++i) {
+      if (s[i] == '"') {
+        Append(s + run, static_cast<uint32_t>(i + 1 - run));  // Keep this '"'
+        run = i;                                            // and repeat it
+      }
+    }
+    Append(s + run, static_cast<uint32_t>(size - run));
+    Put('"');
+  }
+
+  void WriteCsvCell(const ExportCell& cell) {
+    switch (cell.kind) {
+      case ExportCellKind::kInt:
+        WriteInt(cell.i);
+        break;
+      case ExportCellKind::kReal:
+        WriteReal(cell.d, false);
+        break;
+      case ExportCellKind::kNumberText:
+      case ExportCellKind::kText:
+        WriteCsvText(cell.data, cell.size);
+        break;
+      case ExportCellKind::kBinary:
+        WriteHex(cell.data, cell.size);
+        break;
+      default:  // NULL: empty field
+        break;
+    }
+  }
+
+  template <typename Query>
+  void WriteCsvHeader(const Query& query, int32_t cols) {
+    for (int32_t c = 0; c < cols; ++c) {
+      if (c > 0) { Put(opts_.delimiter); }
+      const char* name = query.FieldName(c);
+      if (name != nullptr) {
+        WriteCsvText(name, static_cast<int32_t>(std::strlen(name)));
+      }
+    }
+    Put('\n');
+  }
+
+  // --- JSON ---
+
+  /// Escape `s` as a JSON string body through the append/put callables.
+  template <typename AppendFn, typename PutFn>
+  static void EscapeJson(const char* s, int32_t size, AppendFn append,
+                         PutFn put) {
+    static const char kDigits[] = "0123456789abcdef";
+    int32_t run = 0;
+    for (int32_t i = 0; i < size; ++i) {
+      uint8_t c = static_cast<uint8_t>(s[i]);
+      if (c >= 0x20 && c != '"' && c != '\\') { continue; }
+      append(s + run, static_cast<uint32_t>(i - run));
+      run = i + 1;
+      put('\\');
+      switch (c) {
+        case '"':  put('"'); break;
+        case '\\': put('\\'); break;
+        case '\n': put('n'); break;
+        case '\r': put('r'); break;
+        case '\t': put('t'); break;
+        case '\b': put('b'); break;
+        case '\f': put('f'); break;
+        default:
+          put('u');
+          put('0');
+          put('0');
+          put(kDigits[c >> 4]);
+          put(kDigits[c & 0x0f]);
+          break;
+      }
+    }
+    append(s + run, static_cast<uint32_t>(size - run));
+  }
+
+  void WriteJsonString(const char* s, int32_t size) {
+    Put('"');
+    EscapeJson(s, size,
+               [this](const char* p, uint32_t n) { Append(p, n); },
+               [this](char c) { Put(c); });
+    Put('"');
+  }
+
+  void WriteJsonCell(const ExportCell& cell) {
+    switch (cell.kind) {
+      case ExportCellKind::kInt:
+        WriteInt(cell.i);
+        break;
+      case ExportCellKind::kReal:
+        WriteReal(cell.d, true);
+        break;
+      case ExportCellKind::kNumberText:
+        Append(cell.data, static_cast<uint32_t>(cell.size));
+        break;
+      case ExportCellKind::kText:
+        WriteJsonString(cell.data, cell.size);
+        break;
+      case ExportCellKind::kBinary:
+        Put('"');
+        WriteHex(cell.data, cell.size);
+        Put('"');
+        break;
+      default:
+        Append("null", 4);
+        break;
+    }
+  }
+
+  /// Pre-render `"name":` for every column into keys_, so rows only copy.
+  template <typename Query>
+  void BuildJsonKeys(const Query& query, int32_t cols) {
+    if (static_cast<uint32_t>(cols) + 1 > key_offsets_cap_) {
+      delete[] key_offsets_;
+      key_offsets_cap_ = static_cast<uint32_t>(cols) + 1;
+      key_offsets_ = new uint32_t[key_offsets_cap_];
+    }
+    uint32_t used = 0;
+    auto put = [this, &used](char c) {
+      GrowKeys(used + 1);
+      keys_[used++] = c;
+    };
+    auto append = [this, &used](const char* p, uint32_t n) {
+      GrowKeys(used + n);
+      std::memcpy(keys_ + used, p, n);
+      used += n;
+    };
+    for (int32_t c = 0; c < cols; ++c) {
+      key_offsets_[c] = used;
+      const char* name = query.FieldName(c);
+      if (name == nullptr) { name = ""; }
+      put('"');
+      EscapeJson(name, static_cast<int32_t>(std::strlen(name)), append, put);
+      put('"');
+      put(':');
+    }
+    key_offsets_[cols] = used;
+  }
+
+  void GrowKeys(uint32_t need) {
+    if (need <= keys_cap_) { return; }
+    uint32_t cap = keys_cap_ == 0 ? 256 : keys_cap_;
+    while (cap < need) { cap *= 2; }
+    char* grown = new char[cap];
+    if (keys_ != nullptr) { std::memcpy(grown, keys_, keys_cap_); }
+    delete[] keys_;
+    keys_ = grown;
+    keys_cap_ = cap;
+  }
+
+  ExportOptions opts_;
+  char* buf_ = nullptr;
+  uint32_t cap_ = 0;
+  uint32_t len_ = 0;
+  uint64_t flushed_ = 0;
+  int fd_ = -1;
+  bool owns_fd_ = false;
+  bool header_written_ = false;  // CSV header already sent to fd_
+  Error write_error_;  // Sticky: set by the first failed write
+
+  char* keys_ = nullptr;  // JSONL: rendered `"name":` prefixes
+  uint32_t keys_cap_ = 0;
+  uint32_t* key_offsets_ = nullptr;  // cols + 1 offsets into keys_
+  uint32_t key_offsets_cap_ = 0;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,289 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::SchemaCatalog -- per-connection cache of tables, columns, indexes.
+//
+// Design:
+//   - Filled in one pass by the owning connection (Sqlite3Db, MariaDb)
+//     and tagged with a schema version; the connection reloads it when
+//     its version check no longer matches (SQLite: PRAGMA schema_version,
+//     MariaDB: DDL on the connection or an information_schema checksum)
+//   - Open-addressing FNV-1a name maps (load <= 1/2) for tables and, per
+//     table, columns: a hit is one hash and one compare, with no SQL and
+//     no length limit on names
+//   - Column names compare ASCII case-insensitively; table names too
+//     unless the backend says they are case-sensitive
+//   - Pointers returned by lookups stay valid until the next reload
+//   - Backend-neutral; not thread-safe (same rule as the connection)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace dbpp {
+
+struct SchemaColumn {
+  std::string name;
+  std::string type;  // As declared, e.g. "INTEGER", "varchar(64)"
+  bool not_null = false;
+  bool primary_key = false;
+};
+
+struct SchemaIndex {
+  std::string name;
+  bool unique = false;
+  std::vector<std::string> columns;  // Key order; "" for an expression
+};
+
+struct SchemaTable {
+  std::string name;
+  std::vector<SchemaColumn> columns;  // Declaration order
+  std::vector<SchemaIndex> indexes;
+};
+
+namespace detail {
+
+inline char FoldAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool NamesEqual(const char* a, const char* b, bool fold) {
+  if (!fold) { return std::strcmp(a, b) == 0; }
+  for (; *a != '\0' && FoldAscii(*a) == FoldAscii(*b); ++a, ++b) {}
+  return FoldAscii(*a) == FoldAscii(*b);
+}
+
+/// Name -> index map; names live in the owner and are read through
+/// `name_of(index)`, so nothing is copied.
+class NameMap {
+ public:
+  template <typename NameOf>
+  int32_t Find(const char* name, bool fold, NameOf name_of) const {
+    if (slots_.empty()) { return -1; }
+    uint32_t hash = Hash(name, fold);
+    for (uint32_t i = hash & mask_; slots_[i].value != kEmpty;
+         i = (i + 1) & mask_) {
+      if (slots_[i].hash == hash &&
+          NamesEqual(name, name_of(slots_[i].value), fold)) {
+        return slots_[i].value;
+      }
+    }
+    return -1;
+  }
+
+  /// Map `name` to `value` unless it is already present (first wins).
+  template <typename NameOf>
+  void Insert(const char* name, int32_t value, bool fold, NameOf name_of) {
+    if ((size_ + 1) * 2 > slots_.size()) { Grow(); }
+    uint32_t hash = Hash(name, fold);
+    uint32_t i = hash & mask_;
+    for (; slots_[i].value != kEmpty; i = (i + 1) & mask_) {
+      if (slots_[i].hash == hash &&
+          NamesEqual(name, name_of(slots_[i].value), fold)) {
+        return;
+      }
+    }
+    slots_[i] = Slot{hash, value};
+    ++size_;
+  }
+
+  void Clear() {
+    slots_.clear();
+    mask_ = 0;
+    size_ = 0;
+  }
+
+ private:
+  static constexpr int32_t kEmpty = -1;
+
+  struct Slot {
+    uint32_t hash;
+    int32_t value;
+  };
+
+  // FNV-1a, 32-bit, over the folded bytes
+  static uint32_t Hash(const char* s, bool fold) {
+    uint32_t h = 2166136261u;
+    for (; *s != '\0'; ++s) {
+      h ^= static_cast<uint8_t>(fold ? FoldAscii(*s) : *s);
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  void Grow() {
+    std::vector<Slot> old;
+    old.swap(slots_);
+    uint32_t capacity =
+        old.empty() ? 16 : static_cast<uint32_t>(old.size()) * 2;
+    slots_.assign(capacity, Slot{0, kEmpty});
+    mask_ = capacity - 1;
+    for (const Slot& s : old) {
+      if (s.value == kEmpty) { continue; }
+      uint32_t i = s.hash & mask_;
+      while (slots_[i].value != kEmpty) { i = (i + 1) & mask_; }
+      slots_[i] = s;
+    }
+  }
+
+  std::vector<Slot> slots_;
+  uint32_t mask_ = 0;
+  uint32_t size_ = 0;
+};
+
+/// True if `sql` starts (after blanks and comments) with a statement that
+/// can change the schema or the current database: CREATE, ALTER, DROP,
+/// RENAME, TRUNCATE or USE. Backends without a schema cookie use it to
+/// invalidate their catalog.
+inline bool IsSchemaStatement(const char* sql) {
+  if (sql == nullptr) { return false; }
+  const char* p = sql;
+  for (;;) {
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' ||
+           *p == ';' || *p == '(') {
+      ++p;
+    }
+    if ((p[0] == '-' && p[1] == '-') || p[0] == '#') {
+      while (*p != '\0' && *p != '\n') { ++p; }
+    } else if (p[0] == '/' && p[1] == '*') {
+      const char* end = std::strstr(p + 2, "*/");
+      if (end == nullptr) { return false; }
+      p = end + 2;
+    } else {
+      break;
+    }
+  }
+  static const char* const kVerbs[] = {"create", "alter", "drop",
+                                       "rename", "truncate", "use"};
+  for (const char* verb : kVerbs) {
+    size_t i = 0;
+    while (verb[i] != '\0' && FoldAscii(p[i]) == verb[i]) { ++i; }
+    if (verb[i] != '\0') { continue; }
+    char next = p[i];
+    bool word = (next >= 'a' && next <= 'z') || (next >= 'A' && next <= 'Z') ||
+                (next >= '0' && next <= '9') || next == '_';
+    if (!word) { return true; }
+  }
+  return false;
+}
+
+}  // namespace detail
+
+// ---------------------------------------------------------------------------
+// SchemaCatalog
+// ---------------------------------------------------------------------------
+
+class SchemaCatalog {
+ public:
+  SchemaCatalog() = default;
+
+  // --- Lookup ---
+
+  const SchemaTable* FindTable(const char* name) const {
+    int32_t t = TableIndex(name);
+    return t >= 0 ? &tables_[t] : nullptr;
+  }
+
+  const SchemaColumn* FindColumn(const char* table, const char* column) const {
+    int32_t t = TableIndex(table);
+    if (t < 0 || column == nullptr) { return nullptr; }
+    const SchemaTable& tab = tables_[t];
+    int32_t c = column_maps_[t].Find(column, true, [&tab](int32_t i) {
+      return tab.columns[i].name.c_str();
+    });
+    return c >= 0 ? &tab.columns[c] : nullptr;
+  }
+
+  uint32_t TableCount() const { return static_cast<uint32_t>(tables_.size()); }
+  const SchemaTable& Table(uint32_t i) const { return tables_[i]; }
+
+  // --- State ---
+
+  bool Loaded() const { return loaded_; }
+  uint64_t Version() const { return version_; }
+
+  /// Force a reload on the next lookup.
+  void Invalidate() { loaded_ = false; }
+
+  // --- Loading (by the owning connection) ---
+
+  /// Drop everything and start a load for schema `version`.
+  void BeginLoad(uint64_t version, bool fold_table_case) {
+    tables_.clear();
+    column_maps_.clear();
+    table_map_.Clear();
+    version_ = version;
+    fold_tables_ = fold_table_case;
+    loaded_ = false;
+  }
+
+  /// Index of table `name`, added if new.
+  int32_t AddTable(const char* name) {
+    int32_t t = TableIndex(name);
+    if (t >= 0) { return t; }
+    t = static_cast<int32_t>(tables_.size());
+    tables_.push_back(SchemaTable{});
+    tables_.back().name = name;
+    column_maps_.push_back(detail::NameMap{});
+    table_map_.Insert(name, t, fold_tables_, TableNameOf());
+    return t;
+  }
+
+  void AddColumn(int32_t table, const char* name, const char* type,
+                 bool not_null, bool primary_key) {
+    SchemaTable& tab = tables_[table];
+    int32_t c = static_cast<int32_t>(tab.columns.size());
+    tab.columns.push_back(SchemaColumn{});
+    SchemaColumn& col = tab.columns.back();
+    col.name = name;
+    col.type = type != nullptr ? type : "";
+    col.not_null = not_null;
+    col.primary_key = primary_key;
+    column_maps_[table].Insert(col.name.c_str(), c, true,
+                               [&tab](int32_t i) {
+                                 return tab.columns[i].name.c_str();
+                               });
+  }
+
+  /// Append key column `column` to index `index` of `table`. Rows must
+  /// arrive grouped by index, in key order.
+  void AddIndexColumn(int32_t table, const char* index, bool unique,
+                      const char* column) {
+    std::vector<SchemaIndex>& indexes = tables_[table].indexes;
+    if (indexes.empty() || indexes.back().name != index) {
+      indexes.push_back(SchemaIndex{});
+      indexes.back().name = index;
+      indexes.back().unique = unique;
+    }
+    indexes.back().columns.push_back(column != nullptr ? column : "");
+  }
+
+  void EndLoad() { loaded_ = true; }
+
+ private:
+  struct TableNameOfFn {
+    const std::vector<SchemaTable>* tables;
+    const char* operator()(int32_t i) const {
+      return (*tables)[i].name.c_str();
+    }
+  };
+
+  TableNameOfFn TableNameOf() const { return TableNameOfFn{&tables_}; }
+
+  int32_t TableIndex(const char* name) const {
+    if (name == nullptr) { return -1; }
+    return table_map_.Find(name, fold_tables_, TableNameOf());
+  }
+
+  std::vector<SchemaTable> tables_;
+  std::vector<detail::NameMap> column_maps_;  // Parallel to tables_
+  detail::NameMap table_map_;
+  uint64_t version_ = 0;
+  bool fold_tables_ = true;
+  bool loaded_ = false;
+};
+
+}  // namespace dbpp
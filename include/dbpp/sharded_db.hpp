@@ -0,0 +1,700 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::ShardedDb -- hash-partitioned SQLite across N database files.
+//
+// Design:
+//   - N independent database files, each with its own Sqlite3Writer
+//     (writer thread + group commit) and a small pool of query_only reader
+//     connections: writes to different shards never share a lock, so
+//     write throughput scales with the number of shards
+//   - Keys are routed with a 64-bit mix of the key reduced by
+//     multiply-shift; the shard count is part of the data layout and must
+//     not change for existing files
+//   - Point operations go to the owning shard only: Submit(key, job) for
+//     writes, AcquireReader(ShardOf(key)) for reads
+//   - Gather() runs one read query on every shard in parallel (one thread
+//     per shard, caller runs shard 0) into per-shard Sqlite3TypedResultSet
+//     arenas, then merges without copying rows: concatenation, or a k-way
+//     merge on SortKeys when each shard's SQL is already ORDER BY'd, with
+//     OFFSET/LIMIT applied to the merged stream
+//   - GatherAggregate() folds partial count/sum/min/max rows from every
+//     shard into one value per column
+//
+// Usage:
+//   dbpp::ShardedDbOptions opts;
+//   opts.path_format = "data/orders-%u.db";
+//   opts.shards = 8;
+//   dbpp::ShardedDb db;
+//   db.Open(opts);
+//   db.ExecAll("CREATE TABLE IF NOT EXISTS o(id INTEGER PRIMARY KEY, v);");
+//   db.Submit(id, [id](dbpp::Sqlite3Db& s, dbpp::Error*) {
+//     return s.Exec("INSERT INTO o VALUES(?, 1);", id);
+//   });
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <thread>
+#include <utility>
+
+#include "sqlite3.h"
+
+#include "dbpp/column_index.hpp"
+#include "dbpp/connection_pool.hpp"
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_typed_result_set.hpp"
+#include "dbpp/sqlite3_writer.hpp"
+#include "dbpp/value_types.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// ShardedDbOptions
+// ---------------------------------------------------------------------------
+
+struct ShardedDbOptions {
+  /// printf pattern with one %u for the shard number, e.g. "db/t-%u.db".
+  const char* path_format = nullptr;
+  uint32_t shards = 4;
+  /// Per-shard writer; `writer.path` is ignored.
+  Sqlite3WriterOptions writer;
+  /// Reader connections per shard (opened lazily above the first).
+  uint32_t readers_per_shard = 4;
+  /// Busy timeout of reader connections and wait for a free reader.
+  int32_t reader_timeout_ms = 5000;
+};
+
+// ---------------------------------------------------------------------------
+// Gather options / aggregate merge
+// ---------------------------------------------------------------------------
+
+struct SortKey {
+  int32_t column = 0;
+  bool descending = false;
+};
+
+struct GatherOptions {
+  /// Merge order. Each shard's SQL must already ORDER BY the same keys;
+  /// SQLite's cross-type order applies (NULL < numbers < text < blob,
+  /// text compared bytewise). No keys: shard results are concatenated.
+  const SortKey* order_by = nullptr;
+  int32_t num_keys = 0;
+  /// Applied to the merged rows. Shard SQL should use LIMIT offset+limit.
+  uint64_t offset = 0;
+  uint64_t limit = 0;  // 0 = all
+};
+
+enum class MergeOp : uint8_t {
+  kSum = 0,  // SUM(): NULL when every partial is NULL
+  kCount,    // COUNT(): sum of partial counts, never NULL
+  kMin,
+  kMax
+};
+
+struct AggregateValue {
+  int32_t type = SQLITE_NULL;  // SQLITE_INTEGER, SQLITE_FLOAT or SQLITE_NULL
+  int64_t i = 0;
+  double d = 0.0;
+
+  bool IsNull() const { return type == SQLITE_NULL; }
+  int64_t AsInt64() const {
+    return type == SQLITE_FLOAT ? static_cast<int64_t>(d) : i;
+  }
+  double AsDouble() const {
+    return type == SQLITE_INTEGER ? static_cast<double>(i) : d;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// ShardedResult
+// ---------------------------------------------------------------------------
+
+/// Merged scatter-gather result. Rows stay in the per-shard arenas; the
+/// result is an ordered list of (shard, row) positions over them.
+class ShardedResult {
+ public:
+  ShardedResult() = default;
+
+  ~ShardedResult() { Finalize(); }
+
+  // Move
+  ShardedResult(ShardedResult&& other) noexcept { MoveFrom(other); }
+
+  ShardedResult& operator=(ShardedResult&& other) noexcept {
+    if (this != &other) {
+      Finalize();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  ShardedResult(const ShardedResult&) = delete;
+  ShardedResult& operator=(const ShardedResult&) = delete;
+
+  // --- Field info ---
+
+  int32_t NumFields() const {
+    return num_parts_ > 0 ? parts_[0].NumFields() : 0;
+  }
+  uint64_t NumRows() const { return num_rows_; }
+
+  const char* FieldName(int32_t col) const {
+    return num_parts_ > 0 ? parts_[0].FieldName(col) : nullptr;
+  }
+
+  int32_t FieldIndex(const char* name) const {
+    return num_parts_ > 0 ? parts_[0].FieldIndex(name) : -1;
+  }
+
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
+  }
+
+  /// Shard the current row came from.
+  uint32_t RowShard() const { return Eof() ? 0 : rows_[current_].shard; }
+
+  // --- Current row ---
+
+  int32_t FieldDataType(int32_t col) const {
+    return Eof() ? -1 : Current().FieldDataType(col);
+  }
+
+  bool FieldIsNull(int32_t col) const {
+    return Eof() || Current().FieldIsNull(col);
+  }
+
+  int64_t GetInt64(int32_t col, int64_t null_value = 0) const {
+    return Eof() ? null_value : Current().GetInt64(col, null_value);
+  }
+
+  int32_t GetInt(int32_t col, int32_t null_value = 0) const {
+    return Eof() ? null_value : Current().GetInt(col, null_value);
+  }
+
+  double GetDouble(int32_t col, double null_value = 0.0) const {
+    return Eof() ? null_value : Current().GetDouble(col, null_value);
+  }
+
+  const char* GetString(int32_t col, const char* null_value = "") const {
+    return Eof() ? null_value : Current().GetString(col, null_value);
+  }
+
+  const uint8_t* GetBlob(int32_t col, int32_t& out_len) const {
+    out_len = 0;
+    return Eof() ? nullptr : Current().GetBlob(col, out_len);
+  }
+
+  // --- Navigation ---
+
+  bool Eof() const { return current_ >= num_rows_; }
+
+  void NextRow() {
+    if (current_ < num_rows_) { SeekRow(current_ + 1); }
+  }
+
+  void SeekRow(uint64_t row) {
+    current_ = row;
+    if (current_ < num_rows_) {
+      parts_[rows_[current_].shard].SeekRow(rows_[current_].row);
+    }
+  }
+
+  void Finalize() {
+    delete[] parts_;
+    delete[] rows_;
+    parts_ = nullptr;
+    rows_ = nullptr;
+    num_parts_ = 0;
+    num_rows_ = 0;
+    current_ = 0;
+  }
+
+ private:
+  friend class ShardedDb;
+
+  struct RowRef {
+    uint32_t shard;
+    uint32_t row;
+  };
+
+  const Sqlite3TypedResultSet& Current() const {
+    return parts_[rows_[current_].shard];
+  }
+
+  void Reset(uint32_t num_parts) {
+    Finalize();
+    parts_ = new Sqlite3TypedResultSet[num_parts];
+    num_parts_ = num_parts;
+  }
+
+  /// SQLite ordering of two cells: NULL < INTEGER/FLOAT < TEXT < BLOB.
+  static int32_t CompareCells(const Sqlite3TypedResultSet& a,
+                              const Sqlite3TypedResultSet& b, int32_t col) {
+    int32_t ta = a.FieldDataType(col);
+    int32_t tb = b.FieldDataType(col);
+    int32_t ca = TypeClass(ta);
+    int32_t cb = TypeClass(tb);
+    if (ca != cb) { return ca < cb ? -1 : 1; }
+    switch (ca) {
+      case 0:
+        return 0;
+      case 1: {
+        if (ta == SQLITE_INTEGER && tb == SQLITE_INTEGER) {
+          int64_t x = a.GetInt64(col);
+          int64_t y = b.GetInt64(col);
+          return (x < y) ? -1 : (x > y ? 1 : 0);
+        }
+        double x = a.GetDouble(col);
+        double y = b.GetDouble(col);
+        return (x < y) ? -1 : (x > y ? 1 : 0);
+      }
+      default: {
+        int32_t la = 0;
+        int32_t lb = 0;
+        const uint8_t* pa = a.GetBlob(col, la);
+        const uint8_t* pb = b.GetBlob(col, lb);
+        int32_t n = la < lb ? la : lb;
+        int32_t c = (n > 0) ? std::memcmp(pa, pb, static_cast<size_t>(n)) : 0;
+        if (c != 0) { return c < 0 ? -1 : 1; }
+        return (la < lb) ? -1 : (la > lb ? 1 : 0);
+      }
+    }
+  }
+
+  static int32_t TypeClass(int32_t type) {
+    switch (type) {
+      case SQLITE_INTEGER:
+      case SQLITE_FLOAT:   return 1;
+      case SQLITE_TEXT:    return 2;
+      case SQLITE_BLOB:    return 3;
+      default:             return 0;
+    }
+  }
+
+  static bool Less(const Sqlite3TypedResultSet& a,
+                   const Sqlite3TypedResultSet& b, const GatherOptions& opts) {
+    for (int32_t k = 0; k < opts.num_keys; ++k) {
+      int32_t c = CompareCells(a, b, opts.order_by[k].column);
+      if (c != 0) { return opts.order_by[k].descending ? c > 0 : c < 0; }
+    }
+    return false;
+  }
+
+  /// Build rows_ from the loaded parts. With sort keys each part's cursor
+  /// is its merge head; a linear scan over the heads picks the next row
+  /// (shard counts are small, so this beats a heap). Ties keep shard order.
+  void Merge(const GatherOptions& opts) {
+    uint64_t total = 0;
+    for (uint32_t s = 0; s < num_parts_; ++s) { total += parts_[s].NumRows(); }
+    uint64_t skip = opts.offset < total ? opts.offset : total;
+    uint64_t take = total - skip;
+    if (opts.limit > 0 && opts.limit < take) { take = opts.limit; }
+    rows_ = new RowRef[take > 0 ? take : 1];
+    num_rows_ = 0;
+
+    if (opts.num_keys <= 0) {
+      for (uint32_t s = 0; s < num_parts_ && num_rows_ < take; ++s) {
+        for (uint32_t r = 0; r < parts_[s].NumRows() && num_rows_ < take;
+             ++r) {
+          if (skip > 0) {
+            --skip;
+            continue;
+          }
+          rows_[num_rows_++] = RowRef{s, r};
+        }
+      }
+      SeekRow(0);
+      return;
+    }
+
+    for (uint32_t s = 0; s < num_parts_; ++s) { parts_[s].SeekRow(0); }
+    while (num_rows_ < take) {
+      uint32_t best = num_parts_;
+      for (uint32_t s = 0; s < num_parts_; ++s) {
+        if (parts_[s].Eof()) { continue; }
+        if (best == num_parts_ || Less(parts_[s], parts_[best], opts)) {
+          best = s;
+        }
+      }
+      if (best == num_parts_) { break; }
+      if (skip > 0) {
+        --skip;
+      } else {
+        rows_[num_rows_++] = RowRef{best, parts_[best].CurrentRow()};
+      }
+      parts_[best].NextRow();
+    }
+    SeekRow(0);
+  }
+
+  void MoveFrom(ShardedResult& other) {
+    parts_ = other.parts_;
+    rows_ = other.rows_;
+    num_parts_ = other.num_parts_;
+    num_rows_ = other.num_rows_;
+    current_ = other.current_;
+    other.parts_ = nullptr;
+    other.rows_ = nullptr;
+    other.num_parts_ = 0;
+    other.num_rows_ = 0;
+    other.current_ = 0;
+  }
+
+  Sqlite3TypedResultSet* parts_ = nullptr;  // One per shard
+  RowRef* rows_ = nullptr;                  // Merged order
+  uint32_t num_parts_ = 0;
+  uint64_t num_rows_ = 0;
+  uint64_t current_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// ShardedDb
+// ---------------------------------------------------------------------------
+
+class ShardedDb {
+ public:
+  using Job = Sqlite3Writer::Job;
+  using Reader = PooledConnection<Sqlite3Backend>;
+
+  static constexpr uint32_t kMaxShards = 1024;
+  static constexpr uint32_t kMaxPathLen = 512;
+
+  ShardedDb() = default;
+  ~ShardedDb() { Close(); }
+
+  // No copy, no move (writer threads hold their shard)
+  ShardedDb(const ShardedDb&) = delete;
+  ShardedDb& operator=(const ShardedDb&) = delete;
+
+  /// Open (creating if needed) every shard file and start its writer.
+  Error Open(const ShardedDbOptions& opts) {
+    if (shards_ != nullptr) {
+      return Error::Make(ErrorCode::kMisuse, "already open");
+    }
+    if (opts.path_format == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "path_format is null");
+    }
+    if (opts.shards == 0 || opts.shards > kMaxShards ||
+        opts.readers_per_shard == 0) {
+      return Error::Make(ErrorCode::kRange, "invalid shard/reader count");
+    }
+
+    shards_ = new Shard[opts.shards];
+    num_shards_ = opts.shards;
+    reader_timeout_ms_ = opts.reader_timeout_ms;
+    for (uint32_t s = 0; s < num_shards_; ++s) {
+      Shard& shard = shards_[s];
+      int n = std::snprintf(shard.path, kMaxPathLen, opts.path_format, s);
+      if (n <= 0 || static_cast<uint32_t>(n) >= kMaxPathLen) {
+        Close();
+        return Error::Make(ErrorCode::kRange, "bad shard path");
+      }
+
+      // The writer creates the file and sets WAL before readers attach.
+      Sqlite3WriterOptions wopts = opts.writer;
+      wopts.path = shard.path;
+      Error err = shard.writer.Start(wopts);
+      if (err.ok()) {
+        ConnectionPoolOptions popts;
+        popts.dsn = shard.path;
+        popts.min_size = 1;
+        popts.max_size = opts.readers_per_shard;
+        int32_t timeout_ms = opts.reader_timeout_ms;
+        popts.on_open = [timeout_ms](Database<Sqlite3Backend>& db) {
+          db.SetBusyTimeout(timeout_ms);
+          Error e;
+          db.ExecDml("PRAGMA query_only = ON;", &e);
+          return e;
+        };
+        err = shard.readers.Init(popts);
+      }
+      if (!err.ok()) {
+        Close();
+        return err;
+      }
+    }
+    return Error::Ok();
+  }
+
+  /// Drain and stop every writer, close the readers. Reader handles must
+  /// have been released.
+  void Close() {
+    if (shards_ == nullptr) { return; }
+    for (uint32_t s = 0; s < num_shards_; ++s) {
+      shards_[s].writer.Stop();
+      shards_[s].readers.Shutdown();
+    }
+    delete[] shards_;
+    shards_ = nullptr;
+    num_shards_ = 0;
+  }
+
+  bool IsOpen() const { return shards_ != nullptr; }
+  uint32_t NumShards() const { return num_shards_; }
+
+  const char* ShardPath(uint32_t shard) const {
+    return shard < num_shards_ ? shards_[shard].path : nullptr;
+  }
+
+  // --- Routing ---
+
+  uint32_t ShardOf(int64_t key) const {
+    return Reduce(Mix(static_cast<uint64_t>(key)));
+  }
+
+  uint32_t ShardOf(TextView key) const {
+    uint64_t h = 14695981039346656037ULL;  // FNV-1a, 64-bit
+    for (int32_t i = 0; i < key.size; ++i) {
+      h ^= static_cast<uint8_t>(key.data[i]);
+      h *= 1099511628211ULL;
+    }
+    return Reduce(Mix(h));
+  }
+
+  /// Writer of one shard (0 <= shard < NumShards()).
+  Sqlite3Writer& Writer(uint32_t shard) { return shards_[shard].writer; }
+
+  // --- Routed writes ---
+
+  std::future<WriteResult> Submit(int64_t key, Job job) {
+    return SubmitTo(ShardOf(key), std::move(job));
+  }
+
+  std::future<WriteResult> Submit(TextView key, Job job) {
+    return SubmitTo(ShardOf(key), std::move(job));
+  }
+
+  /// Run `sql` (DDL, maintenance) on every shard and wait for all of
+  /// them. Returns the first failure.
+  Error ExecAll(const char* sql) {
+    if (shards_ == nullptr) {
+      return Error::Make(ErrorCode::kNotOpen, "sharded db not open");
+    }
+    if (sql == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "sql is null");
+    }
+    std::future<WriteResult>* results =
+        new std::future<WriteResult>[num_shards_];
+    for (uint32_t s = 0; s < num_shards_; ++s) {
+      results[s] = shards_[s].writer.SubmitDml(sql);
+    }
+    Error first;
+    for (uint32_t s = 0; s < num_shards_; ++s) {
+      WriteResult r = results[s].get();
+      if (!r.error.ok() && first.ok()) { first = r.error; }
+    }
+    delete[] results;
+    return first;
+  }
+
+  // --- Routed reads ---
+
+  /// Check out a reader connection of `shard` (invalid handle on timeout
+  /// or when closed). Release it before Close().
+  Reader AcquireReader(uint32_t shard, Error* out_error = nullptr) {
+    if (shard >= num_shards_) {
+      if (out_error != nullptr) {
+        *out_error = Error::Make(ErrorCode::kRange, "no such shard");
+      }
+      return Reader();
+    }
+    return shards_[shard].readers.Acquire(
+        static_cast<uint32_t>(reader_timeout_ms_), out_error);
+  }
+
+  // --- Scatter-gather ---
+
+  /// Run the read query `sql` on every shard in parallel and merge the
+  /// results into `out` as described by `opts`.
+  Error Gather(const char* sql, const GatherOptions& opts,
+               ShardedResult* out) {
+    if (out == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "out is null");
+    }
+    for (int32_t k = 0; k < opts.num_keys; ++k) {
+      if (opts.order_by == nullptr || opts.order_by[k].column < 0) {
+        return Error::Make(ErrorCode::kRange, "invalid sort key");
+      }
+    }
+    Error err = Scatter(sql, out);
+    if (!err.ok()) { return err; }
+    for (int32_t k = 0; k < opts.num_keys; ++k) {
+      if (opts.order_by[k].column >= out->NumFields()) {
+        out->Finalize();
+        return Error::Make(ErrorCode::kRange, "sort key out of range");
+      }
+    }
+    out->Merge(opts);
+    return Error::Ok();
+  }
+
+  /// Run an aggregate query on every shard and fold its columns, e.g.
+  ///   SELECT COUNT(*), SUM(v), MIN(v), MAX(v) FROM t;
+  /// with ops {kCount, kSum, kMin, kMax}. Every row of every shard is
+  /// folded. AVG: gather SUM and COUNT and divide.
+  Error GatherAggregate(const char* sql, const MergeOp* ops, int32_t num_ops,
+                        AggregateValue* out) {
+    if (ops == nullptr || out == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "ops/out is null");
+    }
+    ShardedResult parts;
+    Error err = Scatter(sql, &parts);
+    if (!err.ok()) { return err; }
+    if (num_ops > parts.NumFields()) {
+      return Error::Make(ErrorCode::kRange, "more ops than columns");
+    }
+
+    for (int32_t c = 0; c < num_ops; ++c) {
+      out[c] = AggregateValue{};
+      if (ops[c] == MergeOp::kCount) { out[c].type = SQLITE_INTEGER; }
+    }
+    for (uint32_t s = 0; s < parts.num_parts_; ++s) {
+      Sqlite3TypedResultSet& rs = parts.parts_[s];
+      for (rs.SeekRow(0); !rs.Eof(); rs.NextRow()) {
+        for (int32_t c = 0; c < num_ops; ++c) {
+          err = Fold(ops[c], rs, c, &out[c]);
+          if (!err.ok()) { return err; }
+        }
+      }
+    }
+    return Error::Ok();
+  }
+
+ private:
+  struct Shard {
+    char path[kMaxPathLen] = {};
+    Sqlite3Writer writer;
+    ConnectionPool<Sqlite3Backend> readers;
+  };
+
+  // splitmix64 finalizer: spreads sequential ids over all shards.
+  static uint64_t Mix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+  }
+
+  /// Map a hash onto [0, num_shards_) without a division.
+  uint32_t Reduce(uint64_t h) const {
+    return static_cast<uint32_t>(((h >> 32) * num_shards_) >> 32);
+  }
+
+  std::future<WriteResult> SubmitTo(uint32_t shard, Job job) {
+    if (shards_ == nullptr) {
+      std::promise<WriteResult> p;
+      WriteResult r;
+      r.error = Error::Make(ErrorCode::kNotOpen, "sharded db not open");
+      p.set_value(r);
+      return p.get_future();
+    }
+    return shards_[shard].writer.Submit(std::move(job));
+  }
+
+  /// Load `sql` from every shard into out->parts_, shard 0 on the calling
+  /// thread and the others on one thread each.
+  Error Scatter(const char* sql, ShardedResult* out) {
+    if (shards_ == nullptr) {
+      return Error::Make(ErrorCode::kNotOpen, "sharded db not open");
+    }
+    if (sql == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "sql is null");
+    }
+    out->Reset(num_shards_);
+    Error* errors = new Error[num_shards_];
+    std::thread* threads = new std::thread[num_shards_];
+    for (uint32_t s = 1; s < num_shards_; ++s) {
+      threads[s] = std::thread([this, sql, out, errors, s] {
+        LoadShard(s, sql, &out->parts_[s], &errors[s]);
+      });
+    }
+    LoadShard(0, sql, &out->parts_[0], &errors[0]);
+    for (uint32_t s = 1; s < num_shards_; ++s) { threads[s].join(); }
+
+    Error first;
+    for (uint32_t s = 0; s < num_shards_ && first.ok(); ++s) {
+      if (!errors[s].ok()) { first = errors[s]; }
+    }
+    delete[] threads;
+    delete[] errors;
+    if (!first.ok()) { out->Finalize(); }
+    return first;
+  }
+
+  void LoadShard(uint32_t shard, const char* sql, Sqlite3TypedResultSet* rs,
+                 Error* out_error) {
+    Reader conn = AcquireReader(shard, out_error);
+    if (!conn) {
+      if (out_error->ok()) {
+        *out_error = Error::Make(ErrorCode::kBusy, "no reader available");
+      }
+      return;
+    }
+    *rs = conn->Impl().GetTypedResultSet(sql, out_error);
+  }
+
+  static Error Fold(MergeOp op, const Sqlite3TypedResultSet& rs, int32_t col,
+                    AggregateValue* acc) {
+    int32_t type = rs.FieldDataType(col);
+    if (type == SQLITE_NULL) { return Error::Ok(); }
+    if (type != SQLITE_INTEGER && type != SQLITE_FLOAT) {
+      return Error::Make(ErrorCode::kMismatch,
+                         "aggregate merge needs numeric partials");
+    }
+
+    switch (op) {
+      case MergeOp::kSum:
+      case MergeOp::kCount:
+        if (acc->type == SQLITE_NULL) {
+          acc->type = type;
+          acc->i = rs.GetInt64(col);
+          acc->d = rs.GetDouble(col);
+        } else if (acc->type == SQLITE_INTEGER && type == SQLITE_INTEGER) {
+          int64_t v = rs.GetInt64(col);
+          if ((v > 0 && acc->i > INT64_MAX - v) ||
+              (v < 0 && acc->i < INT64_MIN - v)) {
+            return Error::Make(ErrorCode::kRange, "integer overflow");
+          }
+          acc->i += v;
+        } else {
+          acc->d = acc->AsDouble() + rs.GetDouble(col);
+          acc->type = SQLITE_FLOAT;
+        }
+        break;
+      case MergeOp::kMin:
+      case MergeOp::kMax: {
+        bool take = acc->type == SQLITE_NULL;
+        if (!take) {
+          bool less = (acc->type == SQLITE_INTEGER && type == SQLITE_INTEGER)
+              ? rs.GetInt64(col) < acc->i
+              : rs.GetDouble(col) < acc->AsDouble();
+          bool greater =
+              (acc->type == SQLITE_INTEGER && type == SQLITE_INTEGER)
+                  ? rs.GetInt64(col) > acc->i
+                  : rs.GetDouble(col) > acc->AsDouble();
+          take = (op == MergeOp::kMin) ? less : greater;
+        }
+        if (take) {
+          acc->type = type;
+          acc->i = rs.GetInt64(col);
+          acc->d = rs.GetDouble(col);
+        }
+        break;
+      }
+    }
+    return Error::Ok();
+  }
+
+  Shard* shards_ = nullptr;
+  uint32_t num_shards_ = 0;
+  int32_t reader_timeout_ms_ = 5000;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,313 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Backup -- online, throttled backup of a live database.
+//
+// Design:
+//   - Thin RAII wrapper over sqlite3_backup_init/step/finish: the source
+//     stays fully usable; it is only read-locked for the duration of one
+//     step (pages_per_step pages), never across the pauses
+//   - Throttling between steps: a fixed pause (sleep_ms, or a yield) and
+//     an optional bandwidth cap (max_bytes_per_sec) that sleeps until the
+//     copied bytes are back under the budget
+//   - A write to the source through another connection makes SQLite start
+//     the copy over on the next step; this is detected (remaining pages go
+//     up) and reported as a restart, optionally bounded by max_restarts.
+//     Writes through the source connection itself are applied to the copy
+//   - BUSY/LOCKED steps are retried after a pause, up to max_busy_retries
+//   - The destination is written in one transaction that commits on the
+//     last step: a failed or cancelled backup leaves it unchanged
+//   - Destination: another open connection (To) or a file (ToFile)
+//
+// Usage:
+//   dbpp::BackupOptions opts;
+//   opts.pages_per_step = 256;
+//   opts.max_bytes_per_sec = 32 << 20;
+//   Error err = dbpp::Sqlite3Backup::ToFile(db, "nightly.db", opts);
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_db.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// BackupOptions / BackupProgress
+// ---------------------------------------------------------------------------
+
+struct BackupProgress {
+  int32_t remaining = 0;         // Pages left in the current pass
+  int32_t page_count = 0;        // Source pages
+  int32_t page_size = 0;
+  uint64_t bytes_copied = 0;     // Over all passes
+  uint64_t steps = 0;
+  uint32_t restarts = 0;         // Passes started over (source changed)
+  uint32_t busy_retries = 0;
+  uint64_t elapsed_us = 0;
+  bool done = false;
+
+  double Fraction() const {
+    return page_count > 0
+        ? static_cast<double>(page_count - remaining) / page_count
+        : (done ? 1.0 : 0.0);
+  }
+};
+
+struct BackupOptions {
+  const char* source_schema = "main";
+  const char* dest_schema = "main";
+  /// Pages per sqlite3_backup_step; -1 copies everything in one step.
+  int32_t pages_per_step = 256;
+  /// Pause after each step; 0 = yield only.
+  uint32_t sleep_ms = 0;
+  /// Bandwidth cap over the whole backup; 0 = unlimited.
+  uint64_t max_bytes_per_sec = 0;
+  /// Give up (kBusy) after this many restarts; 0 = never.
+  uint32_t max_restarts = 0;
+  /// BUSY/LOCKED steps retried (after a pause of at least 1 ms).
+  uint32_t max_busy_retries = 1000;
+  /// Called after every step; returning false cancels the backup.
+  std::function<bool(const BackupProgress&)> progress;
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3Backup
+// ---------------------------------------------------------------------------
+
+class Sqlite3Backup {
+ public:
+  Sqlite3Backup() = default;
+
+  ~Sqlite3Backup() { Finish(); }
+
+  // Move
+  Sqlite3Backup(Sqlite3Backup&& other) noexcept { MoveFrom(other); }
+
+  Sqlite3Backup& operator=(Sqlite3Backup&& other) noexcept {
+    if (this != &other) {
+      Finish();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  Sqlite3Backup(const Sqlite3Backup&) = delete;
+  Sqlite3Backup& operator=(const Sqlite3Backup&) = delete;
+
+  // --- One-call backups ---
+
+  /// Copy `source` into the open connection `dest`, throttled per `opts`.
+  static Error To(Sqlite3Db& source, Sqlite3Db& dest,
+                  const BackupOptions& opts = BackupOptions{},
+                  BackupProgress* out_progress = nullptr) {
+    Sqlite3Backup backup;
+    Error err = backup.Begin(source, dest, opts);
+    if (err.ok()) { err = backup.Run(); }
+    if (out_progress != nullptr) { *out_progress = backup.Progress(); }
+    return err;
+  }
+
+  /// Copy `source` into the database file `path` (created or replaced).
+  static Error ToFile(Sqlite3Db& source, const char* path,
+                      const BackupOptions& opts = BackupOptions{},
+                      BackupProgress* out_progress = nullptr) {
+    if (path == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "path is null");
+    }
+    Sqlite3Db dest;
+    Error err = dest.Open(path);
+    if (!err.ok()) { return err; }
+    return To(source, dest, opts, out_progress);
+  }
+
+  // --- Step-wise control ---
+
+  /// Start a backup of `source` into `dest`. Both connections must stay
+  /// open until Finish(); `dest` must not be used meanwhile.
+  Error Begin(Sqlite3Db& source, Sqlite3Db& dest,
+              const BackupOptions& opts = BackupOptions{}) {
+    Finish();
+    if (!source.IsOpen() || !dest.IsOpen()) {
+      return Error::Make(ErrorCode::kNotOpen, "database not open");
+    }
+    if (source.Handle() == dest.Handle()) {
+      return Error::Make(ErrorCode::kMisuse, "source and dest are the same");
+    }
+    if (opts.pages_per_step == 0) {
+      return Error::Make(ErrorCode::kRange, "pages_per_step must not be 0");
+    }
+    const char* src_schema = opts.source_schema ? opts.source_schema : "main";
+    const char* dst_schema = opts.dest_schema ? opts.dest_schema : "main";
+    backup_ = sqlite3_backup_init(dest.Handle(), dst_schema, source.Handle(),
+                                  src_schema);
+    if (backup_ == nullptr) {
+      // Errors of backup_init are reported on the destination.
+      return Error::Make(ErrorCode::kError, sqlite3_errmsg(dest.Handle()));
+    }
+    dest_ = dest.Handle();
+    opts_ = opts;
+    progress_ = BackupProgress{};
+    // Page size is only known per connection; bytes are accounted with
+    // the source's.
+    Error err;
+    char sql[96];
+    std::snprintf(sql, sizeof(sql), "PRAGMA \"%s\".page_size;", src_schema);
+    progress_.page_size = source.ExecScalar(sql, 0, &err);
+    start_ = Clock::now();
+    last_remaining_ = -1;
+    return Error::Ok();
+  }
+
+  /// Copy one step of pages_per_step pages, with no throttling. Returns
+  /// true once the copy is complete (then call Finish()).
+  bool Step(Error* out_error = nullptr) {
+    if (backup_ == nullptr) {
+      if (out_error != nullptr) {
+        *out_error = Error::Make(ErrorCode::kMisuse, "backup not started");
+      }
+      return false;
+    }
+    int32_t rc = sqlite3_backup_step(backup_, opts_.pages_per_step);
+    ++progress_.steps;
+    int32_t remaining = sqlite3_backup_remaining(backup_);
+    int32_t page_count = sqlite3_backup_pagecount(backup_);
+    if (rc == SQLITE_OK || rc == SQLITE_DONE) {
+      // Remaining going up means the source changed and the copy restarted.
+      int32_t copied = (last_remaining_ >= 0 && remaining <= last_remaining_)
+          ? last_remaining_ - remaining
+          : page_count - remaining;
+      if (last_remaining_ >= 0 && remaining > last_remaining_) {
+        ++progress_.restarts;
+      }
+      progress_.bytes_copied +=
+          static_cast<uint64_t>(copied) * static_cast<uint32_t>(
+              progress_.page_size > 0 ? progress_.page_size : 0);
+      last_remaining_ = remaining;
+    }
+    progress_.remaining = remaining;
+    progress_.page_count = page_count;
+    progress_.elapsed_us = ElapsedUs();
+    if (rc == SQLITE_DONE) {
+      progress_.done = true;
+      return true;
+    }
+    if (rc != SQLITE_OK && out_error != nullptr) {
+      ErrorCode code = (rc == SQLITE_BUSY || rc == SQLITE_LOCKED)
+          ? ErrorCode::kBusy
+          : ErrorCode::kError;
+      out_error->SetFormat(code, "sqlite3_backup_step: %s",
+                           sqlite3_errstr(rc));
+    }
+    return false;
+  }
+
+  /// Step until done with the throttling of the options, then Finish().
+  Error Run() {
+    if (backup_ == nullptr) {
+      return Error::Make(ErrorCode::kMisuse, "backup not started");
+    }
+    Error err;
+    while (true) {
+      err.Clear();
+      if (Step(&err)) { return Finish(); }
+      if (err.code == ErrorCode::kBusy) {
+        if (++progress_.busy_retries > opts_.max_busy_retries) {
+          Finish();
+          return err;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(
+            opts_.sleep_ms > 0 ? opts_.sleep_ms : 1));
+        continue;
+      }
+      if (!err.ok()) {
+        Finish();
+        return err;
+      }
+      if (opts_.max_restarts > 0 && progress_.restarts > opts_.max_restarts) {
+        Finish();
+        return Error::Make(ErrorCode::kBusy,
+                           "source kept changing, backup restarted too often");
+      }
+      if (opts_.progress && !opts_.progress(progress_)) {
+        Finish();
+        return Error::Make(ErrorCode::kError, "backup cancelled");
+      }
+      Throttle();
+    }
+  }
+
+  /// Release the backup. Before completion this rolls the destination
+  /// back. Returns the backup's final status.
+  Error Finish() {
+    if (backup_ == nullptr) { return Error::Ok(); }
+    int32_t rc = sqlite3_backup_finish(backup_);
+    backup_ = nullptr;
+    progress_.elapsed_us = ElapsedUs();
+    if (rc != SQLITE_OK) {
+      Error err;
+      err.SetFormat(ErrorCode::kError, "backup failed: %s",
+                    sqlite3_errmsg(dest_));
+      return err;
+    }
+    return Error::Ok();
+  }
+
+  bool Active() const { return backup_ != nullptr; }
+  const BackupProgress& Progress() const { return progress_; }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  uint64_t ElapsedUs() const {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - start_).count());
+  }
+
+  /// Pause between steps: the fixed sleep, then whatever the bandwidth cap
+  /// still requires. No locks are held here, so writers run freely.
+  void Throttle() {
+    if (opts_.sleep_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(opts_.sleep_ms));
+    } else {
+      std::this_thread::yield();
+    }
+    if (opts_.max_bytes_per_sec == 0) { return; }
+    uint64_t budget_us = progress_.bytes_copied * 1000000ULL /
+                         opts_.max_bytes_per_sec;
+    uint64_t elapsed = ElapsedUs();
+    if (budget_us > elapsed) {
+      std::this_thread::sleep_for(
+          std::chrono::microseconds(budget_us - elapsed));
+    }
+  }
+
+  void MoveFrom(Sqlite3Backup& other) {
+    backup_ = other.backup_;
+    dest_ = other.dest_;
+    opts_ = std::move(other.opts_);
+    progress_ = other.progress_;
+    start_ = other.start_;
+    last_remaining_ = other.last_remaining_;
+    other.backup_ = nullptr;
+    other.dest_ = nullptr;
+  }
+
+  sqlite3_backup* backup_ = nullptr;
+  sqlite3* dest_ = nullptr;
+  BackupOptions opts_;
+  BackupProgress progress_;
+  Clock::time_point start_;
+  int32_t last_remaining_ = -1;
+};
+
+}  // namespace dbpp
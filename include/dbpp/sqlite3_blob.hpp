@@ -0,0 +1,235 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Blob -- incremental I/O on one BLOB cell.
+//
+// Design:
+//   - Wraps sqlite3_blob* (sqlite3_blob_open/read/write/reopen) with RAII;
+//     created by Sqlite3Db::OpenBlob()
+//   - Move-only (no copy)
+//   - Reads and writes go straight between the page cache and the
+//     caller's buffer: no statement, no whole-value copy, so a large
+//     value never has to fit in memory at once
+//   - Size is fixed by the row: preallocate with ZeroBlob{n} at insert,
+//     then fill in chunks. Writes cannot grow or shrink the value
+//   - Sequential cursor (ReadNext/WriteNext/Seek) on top of the
+//     positional Read/Write; ReadAll() streams the value to a sink
+//   - Reopen(rowid) moves to another row of the same column without
+//     re-parsing the schema -- much cheaper than a new OpenBlob()
+//   - Read/Write/Reopen return a code-only Status like the statement
+//     binders; ErrorMessage()/ToError() give the detail. A row changed or
+//     deleted behind an open handle makes it fail with native SQLITE_ABORT
+//
+// Usage:
+//   db.Exec("INSERT INTO fw(id, image) VALUES(?, ?);", 7, ZeroBlob{size});
+//   Sqlite3Blob blob = db.OpenBlob("fw", "image", 7, /*writable=*/true);
+//   while (int32_t n = file.Read(buf, sizeof(buf))) blob.WriteNext(buf, n);
+
+#pragma once
+
+#include <cstdint>
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+
+namespace dbpp {
+
+class Sqlite3Db;
+
+// ---------------------------------------------------------------------------
+// Sqlite3Blob
+// ---------------------------------------------------------------------------
+
+class Sqlite3Blob {
+ public:
+  Sqlite3Blob() = default;
+
+  ~Sqlite3Blob() { Close(); }
+
+  // Move
+  Sqlite3Blob(Sqlite3Blob&& other) noexcept
+      : db_(other.db_),
+        blob_(other.blob_),
+        rowid_(other.rowid_),
+        size_(other.size_),
+        pos_(other.pos_),
+        writable_(other.writable_) {
+    other.db_ = nullptr;
+    other.blob_ = nullptr;
+    other.size_ = 0;
+    other.pos_ = 0;
+  }
+
+  Sqlite3Blob& operator=(Sqlite3Blob&& other) noexcept {
+    if (this != &other) {
+      Close();
+      db_ = other.db_;
+      blob_ = other.blob_;
+      rowid_ = other.rowid_;
+      size_ = other.size_;
+      pos_ = other.pos_;
+      writable_ = other.writable_;
+      other.db_ = nullptr;
+      other.blob_ = nullptr;
+      other.size_ = 0;
+      other.pos_ = 0;
+    }
+    return *this;
+  }
+
+  // No copy
+  Sqlite3Blob(const Sqlite3Blob&) = delete;
+  Sqlite3Blob& operator=(const Sqlite3Blob&) = delete;
+
+  // --- Info ---
+
+  bool Valid() const { return blob_ != nullptr; }
+  explicit operator bool() const { return Valid(); }
+  bool Writable() const { return writable_; }
+  int64_t RowId() const { return rowid_; }
+
+  /// Size of the value in bytes (fixed while the handle is open).
+  int32_t Size() const { return size_; }
+
+  // --- Positional I/O ---
+
+  /// Read exactly `n` bytes at `offset` into `buf`.
+  Status Read(int32_t offset, void* buf, int32_t n) {
+    Status st = CheckRange(offset, n);
+    if (!st.ok() || n == 0) { return st; }
+    int32_t rc = sqlite3_blob_read(blob_, buf, n, offset);
+    if (rc != SQLITE_OK) { return Status(ErrorCode::kError, rc); }
+    return Status::Ok();
+  }
+
+  /// Write exactly `n` bytes at `offset`; must stay within Size().
+  Status Write(int32_t offset, const void* data, int32_t n) {
+    if (blob_ != nullptr && !writable_) {
+      return Status(ErrorCode::kMisuse);
+    }
+    Status st = CheckRange(offset, n);
+    if (!st.ok() || n == 0) { return st; }
+    int32_t rc = sqlite3_blob_write(blob_, data, n, offset);
+    if (rc != SQLITE_OK) { return Status(ErrorCode::kError, rc); }
+    return Status::Ok();
+  }
+
+  // --- Sequential I/O ---
+
+  int32_t Tell() const { return pos_; }
+
+  Status Seek(int32_t offset) {
+    if (blob_ == nullptr) { return Status(ErrorCode::kMisuse); }
+    if (offset < 0 || offset > size_) { return Status(ErrorCode::kRange); }
+    pos_ = offset;
+    return Status::Ok();
+  }
+
+  /// Read up to `n` bytes from the cursor and advance it. Returns the
+  /// byte count, 0 at the end, -1 on error (`out_status` says why).
+  int32_t ReadNext(void* buf, int32_t n, Status* out_status = nullptr) {
+    int32_t left = size_ - pos_;
+    int32_t count = (n < left) ? n : left;
+    Status st = Read(pos_, buf, count < 0 ? 0 : count);
+    if (out_status != nullptr) { *out_status = st; }
+    if (!st.ok()) { return -1; }
+    pos_ += count;
+    return count;
+  }
+
+  /// Write `n` bytes at the cursor and advance it.
+  Status WriteNext(const void* data, int32_t n) {
+    Status st = Write(pos_, data, n);
+    if (st.ok()) { pos_ += n; }
+    return st;
+  }
+
+  /// Stream the whole value through `buf` (`buf_size` bytes at a time):
+  /// sink(const uint8_t* chunk, int32_t len) -> bool, false stops early.
+  /// Does not move the cursor.
+  template <typename Sink>
+  Status ReadAll(Sink&& sink, void* buf, int32_t buf_size) {
+    if (blob_ == nullptr) { return Status(ErrorCode::kMisuse); }
+    if (buf == nullptr || buf_size <= 0) {
+      return Status(ErrorCode::kNullParam);
+    }
+    for (int32_t offset = 0; offset < size_; offset += buf_size) {
+      int32_t n = (size_ - offset < buf_size) ? size_ - offset : buf_size;
+      Status st = Read(offset, buf, n);
+      if (!st.ok()) { return st; }
+      if (!sink(static_cast<const uint8_t*>(buf), n)) { break; }
+    }
+    return Status::Ok();
+  }
+
+  // --- Re-target ---
+
+  /// Point the handle at the same column of row `rowid`; the cursor goes
+  /// back to 0. SQLite aborts the handle when this fails (no such row, or
+  /// not a blob/text value), so it is closed then.
+  Status Reopen(int64_t rowid) {
+    if (blob_ == nullptr) { return Status(ErrorCode::kMisuse); }
+    int32_t rc = sqlite3_blob_reopen(blob_, rowid);
+    pos_ = 0;
+    if (rc != SQLITE_OK) {
+      Close();
+      return Status(ErrorCode::kNotFound, rc);
+    }
+    rowid_ = rowid;
+    size_ = sqlite3_blob_bytes(blob_);
+    return Status::Ok();
+  }
+
+  void Close() {
+    if (blob_ != nullptr) {
+      sqlite3_blob_close(blob_);
+      blob_ = nullptr;
+    }
+    size_ = 0;
+    pos_ = 0;
+  }
+
+  sqlite3_blob* Handle() const { return blob_; }
+
+  // --- Error detail (read right after the failing call) ---
+
+  const char* ErrorMessage() const {
+    return db_ != nullptr ? sqlite3_errmsg(db_) : "Blob not open";
+  }
+
+  Error ToError(Status status) const {
+    Error e;
+    if (!status.ok()) {
+      e.Set(status.code, status.native != 0 ? ErrorMessage()
+                                            : ErrorCodeName(status.code));
+    }
+    return e;
+  }
+
+ private:
+  friend class Sqlite3Db;
+
+  Sqlite3Blob(sqlite3* db, sqlite3_blob* blob, int64_t rowid, bool writable)
+      : db_(db),
+        blob_(blob),
+        rowid_(rowid),
+        size_(sqlite3_blob_bytes(blob)),
+        writable_(writable) {}
+
+  Status CheckRange(int32_t offset, int32_t n) const {
+    if (blob_ == nullptr) { return Status(ErrorCode::kMisuse); }
+    if (n < 0 || offset < 0 || offset > size_ || n > size_ - offset) {
+      return Status(ErrorCode::kRange);
+    }
+    return Status::Ok();
+  }
+
+  sqlite3* db_ = nullptr;
+  sqlite3_blob* blob_ = nullptr;
+  int64_t rowid_ = 0;
+  int32_t size_ = 0;
+  int32_t pos_ = 0;
+  bool writable_ = false;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,221 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3BusyRetry -- lock-contention handling for one connection.
+//
+// Design:
+//   - Sqlite3ErrorCode() maps SQLite primary result codes to ErrorCode
+//     (BUSY/LOCKED -> kBusy, CONSTRAINT -> kConstraint, ...)
+//   - Installed as the connection's sqlite3_busy_handler: SQLite calls it
+//     where a lock is refused, so waits happen inside step/prepare/exec
+//     without re-running anything, and SQLite skips it where waiting
+//     could deadlock
+//   - StepFirst() re-runs a first step that still failed with
+//     SQLITE_LOCKED (shared-cache table lock, never sent to the handler),
+//     or with SQLITE_BUSY outside an explicit transaction (SQLite has
+//     released every lock, so the statement can start over)
+//   - Jittered exponential backoff, bounded by max_retries and a deadline
+//     per conflict; waits and time spent waiting are counted
+//   - Owned by Sqlite3Db through a stable pointer; not thread-safe (same
+//     rule as the connection)
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+
+namespace dbpp {
+
+/// ErrorCode for a SQLite result code (extended codes are reduced to
+/// their primary code). SQLITE_OK/ROW/DONE map to kOk.
+inline ErrorCode Sqlite3ErrorCode(int32_t rc) {
+  switch (rc & 0xFF) {
+    case SQLITE_OK:
+    case SQLITE_ROW:
+    case SQLITE_DONE:       return ErrorCode::kOk;
+    case SQLITE_BUSY:
+    case SQLITE_LOCKED:     return ErrorCode::kBusy;
+    case SQLITE_NOTFOUND:   return ErrorCode::kNotFound;
+    case SQLITE_CONSTRAINT: return ErrorCode::kConstraint;
+    case SQLITE_MISMATCH:   return ErrorCode::kMismatch;
+    case SQLITE_MISUSE:     return ErrorCode::kMisuse;
+    case SQLITE_RANGE:
+    case SQLITE_TOOBIG:     return ErrorCode::kRange;
+    case SQLITE_IOERR:
+    case SQLITE_CANTOPEN:   return ErrorCode::kIoError;
+    case SQLITE_FULL:
+    case SQLITE_NOMEM:      return ErrorCode::kFull;
+    default:                return ErrorCode::kError;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Sqlite3BusyPolicy / Sqlite3BusyStats
+// ---------------------------------------------------------------------------
+
+struct Sqlite3BusyPolicy {
+  /// Waits per conflict before giving up with kBusy; 0 = fail at once.
+  uint32_t max_retries = 100;
+  /// First delay; doubled per retry up to max_backoff_us.
+  uint32_t initial_backoff_us = 100;
+  uint32_t max_backoff_us = 20000;
+  /// Total wait budget per conflict; 0 = bounded by max_retries only.
+  uint32_t deadline_ms = 5000;
+  /// Up to this share of each delay is taken off at random, so waiters
+  /// that collided once do not retry in lockstep. 0..100.
+  uint32_t jitter_pct = 50;
+};
+
+struct Sqlite3BusyStats {
+  uint64_t conflicts = 0;   // BUSY/LOCKED results that started a wait
+  uint64_t waits = 0;       // Backoff sleeps
+  uint64_t wait_us = 0;     // Time spent in them
+  uint64_t reruns = 0;      // First steps re-run by StepFirst()
+  uint64_t give_ups = 0;    // Conflicts that ran out of retries/deadline
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3BusyRetry
+// ---------------------------------------------------------------------------
+
+class Sqlite3BusyRetry {
+ public:
+  explicit Sqlite3BusyRetry(const Sqlite3BusyPolicy& policy)
+      : policy_(policy) {
+    rng_ = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(this)) ^
+           static_cast<uint64_t>(Clock::now().time_since_epoch().count());
+    rng_ |= 1;
+  }
+
+  // No copy, no move (statements keep a pointer to it)
+  Sqlite3BusyRetry(const Sqlite3BusyRetry&) = delete;
+  Sqlite3BusyRetry& operator=(const Sqlite3BusyRetry&) = delete;
+
+  void SetPolicy(const Sqlite3BusyPolicy& policy) {
+    policy_ = policy;
+    enabled_ = true;
+  }
+  const Sqlite3BusyPolicy& Policy() const { return policy_; }
+
+  /// Install as `db`'s busy handler (replaces sqlite3_busy_timeout).
+  void Attach(sqlite3* db) {
+    if (db != nullptr && enabled_) {
+      sqlite3_busy_handler(db, &Sqlite3BusyRetry::OnBusy, this);
+    }
+  }
+
+  /// Remove the handler: conflicts fail at once, StepFirst() stops
+  /// re-running.
+  void Detach(sqlite3* db) {
+    enabled_ = false;
+    if (db != nullptr) { sqlite3_busy_handler(db, nullptr, nullptr); }
+  }
+
+  bool Enabled() const { return enabled_; }
+
+  const Sqlite3BusyStats& Stats() const { return stats_; }
+  void ResetStats() { stats_ = Sqlite3BusyStats{}; }
+
+  /// sqlite3_step() for the first step of a statement, re-running it
+  /// after SQLITE_LOCKED, or SQLITE_BUSY in autocommit mode, until it
+  /// gets past the conflict or the policy is exhausted. Bindings are kept.
+  int32_t StepFirst(sqlite3* db, sqlite3_stmt* stmt) {
+    uint64_t give_ups = stats_.give_ups;
+    int32_t rc = sqlite3_step(stmt);
+    if (!enabled_ || !Rerunnable(db, rc)) { return rc; }
+    // The handler already spent this conflict's budget.
+    if (stats_.give_ups != give_ups) { return rc; }
+    ++stats_.conflicts;
+    Clock::time_point start = Clock::now();
+    for (uint32_t attempt = 0; Backoff(attempt, start); ++attempt) {
+      ++stats_.reruns;
+      sqlite3_reset(stmt);
+      give_ups = stats_.give_ups;
+      rc = sqlite3_step(stmt);
+      if (!Rerunnable(db, rc) || stats_.give_ups != give_ups) { break; }
+    }
+    return rc;
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /// sqlite3_busy_handler callback; `count` is the number of earlier
+  /// calls for the same lock. Nonzero = try the lock again.
+  static int OnBusy(void* self, int count) {
+    Sqlite3BusyRetry* r = static_cast<Sqlite3BusyRetry*>(self);
+    if (count == 0) {
+      ++r->stats_.conflicts;
+      r->conflict_start_ = Clock::now();
+    }
+    return r->Backoff(static_cast<uint32_t>(count), r->conflict_start_) ? 1
+                                                                        : 0;
+  }
+
+  static bool Rerunnable(sqlite3* db, int32_t rc) {
+    int32_t primary = rc & 0xFF;
+    if (primary == SQLITE_LOCKED) { return true; }
+    return primary == SQLITE_BUSY && sqlite3_get_autocommit(db) != 0;
+  }
+
+  static uint64_t ElapsedUs(Clock::time_point since) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            Clock::now() - since).count());
+  }
+
+  /// Sleep before retry `attempt` (0-based) of a conflict that began at
+  /// `start`. False (counted as a give-up) when the policy is exhausted.
+  bool Backoff(uint32_t attempt, Clock::time_point start) {
+    if (attempt >= policy_.max_retries) {
+      ++stats_.give_ups;
+      return false;
+    }
+    uint64_t delay = Delay(attempt);
+    if (policy_.deadline_ms > 0) {
+      uint64_t budget = static_cast<uint64_t>(policy_.deadline_ms) * 1000;
+      uint64_t elapsed = ElapsedUs(start);
+      if (elapsed >= budget) {
+        ++stats_.give_ups;
+        return false;
+      }
+      if (delay > budget - elapsed) { delay = budget - elapsed; }
+    }
+    Clock::time_point before = Clock::now();
+    std::this_thread::sleep_for(std::chrono::microseconds(delay));
+    ++stats_.waits;
+    stats_.wait_us += ElapsedUs(before);
+    return true;
+  }
+
+  uint64_t Delay(uint32_t attempt) {
+    uint32_t shift = attempt < 20 ? attempt : 20;
+    uint64_t delay = static_cast<uint64_t>(policy_.initial_backoff_us)
+                     << shift;
+    if (delay > policy_.max_backoff_us) { delay = policy_.max_backoff_us; }
+    uint32_t pct = policy_.jitter_pct < 100 ? policy_.jitter_pct : 100;
+    uint64_t span = delay * pct / 100;
+    if (span > 0) { delay -= NextRandom() % (span + 1); }
+    return delay;
+  }
+
+  /// xorshift64*: cheap, per-connection, no shared RNG state.
+  uint64_t NextRandom() {
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    return rng_ * 0x2545F4914F6CDD1DULL;
+  }
+
+  Sqlite3BusyPolicy policy_;
+  Sqlite3BusyStats stats_;
+  Clock::time_point conflict_start_;
+  uint64_t rng_ = 1;
+  bool enabled_ = true;
+};
+
+}  // namespace dbpp
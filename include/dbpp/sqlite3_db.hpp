@@ -6,21 +6,52 @@
 //   - Wraps sqlite3* with RAII
 //   - Move-only (no copy)
 //   - Error reporting via Error* output parameter (no exceptions)
-//   - Transaction support (Begin/Commit/Rollback)
+//   - Transaction support (Begin/Commit/Rollback) in DEFERRED/IMMEDIATE/
+//     EXCLUSIVE mode plus a savepoint stack for Transaction<Db> guards;
+//     these statements are prepared once per connection and reused
 //   - Zero global state, thread-safe per connection
+//   - Optional LRU prepared-statement cache (EnableStatementCache)
+//   - Optional per-SQL profiling via sqlite3_trace_v2 (EnableProfiling)
+//   - Open(path, Sqlite3OpenOptions) applies open flags and pragmas
+//   - OpenBlob() for incremental BLOB I/O (Sqlite3Blob)
+//   - CreateFunction/CreateAggregate/CreateWindowFunction register C++
+//     callables as SQL functions (types deduced, see sqlite3_function.hpp)
+//   - CreateVirtualTable() exposes in-process C++ data as a read-only
+//     table (see sqlite3_vtab.hpp)
+//   - CompileScript() keeps a multi-statement script compiled for repeated
+//     runs (see sqlite3_script.hpp)
+//   - SQLite result codes map to ErrorCode (kBusy, kConstraint, ...);
+//     EnableBusyRetry() waits out lock conflicts with jittered backoff and
+//     counts the waits (see sqlite3_busy.hpp)
+//   - TableExists/ColumnExists/GetColumns answer from a SchemaCatalog
+//     loaded on first use and reloaded when PRAGMA schema_version moves
+//     (DDL from any connection); see schema_catalog.hpp
 
 #pragma once
 
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <utility>
+#include <vector>
 
 #include "sqlite3.h"
 
 #include "dbpp/error.hpp"
+#include "dbpp/schema_catalog.hpp"
+#include "dbpp/sqlite3_blob.hpp"
+#include "dbpp/sqlite3_busy.hpp"
+#include "dbpp/sqlite3_function.hpp"
+#include "dbpp/sqlite3_open_options.hpp"
+#include "dbpp/sqlite3_profiler.hpp"
 #include "dbpp/sqlite3_query.hpp"
 #include "dbpp/sqlite3_result_set.hpp"
+#include "dbpp/sqlite3_script.hpp"
 #include "dbpp/sqlite3_statement.hpp"
+#include "dbpp/sqlite3_stmt_cache.hpp"
+#include "dbpp/sqlite3_typed_result_set.hpp"
+#include "dbpp/sqlite3_vtab.hpp"
+#include "dbpp/transaction.hpp"
 
 namespace dbpp {
 
@@ -32,18 +63,57 @@ class Sqlite3Db {
  public:
   Sqlite3Db() = default;
 
-  ~Sqlite3Db() { Close(); }
+  ~Sqlite3Db() {
+    Close();
+    delete stmt_cache_;
+    delete profiler_;
+    delete busy_retry_;
+    delete catalog_;
+  }
 
   // Move
-  Sqlite3Db(Sqlite3Db&& other) noexcept : db_(other.db_) {
+  Sqlite3Db(Sqlite3Db&& other) noexcept
+      : db_(other.db_),
+        stmt_cache_(other.stmt_cache_),
+        profiler_(other.profiler_),
+        busy_retry_(other.busy_retry_),
+        catalog_(other.catalog_),
+        schema_version_stmt_(other.schema_version_stmt_),
+        txn_stmts_(other.txn_stmts_),
+        savepoint_depth_(other.savepoint_depth_) {
     other.db_ = nullptr;
+    other.stmt_cache_ = nullptr;
+    other.profiler_ = nullptr;
+    other.busy_retry_ = nullptr;
+    other.catalog_ = nullptr;
+    other.schema_version_stmt_ = nullptr;
+    other.txn_stmts_ = nullptr;
+    other.savepoint_depth_ = 0;
   }
 
   Sqlite3Db& operator=(Sqlite3Db&& other) noexcept {
     if (this != &other) {
       Close();
+      delete stmt_cache_;
+      delete profiler_;
+      delete busy_retry_;
+      delete catalog_;
       db_ = other.db_;
+      stmt_cache_ = other.stmt_cache_;
+      profiler_ = other.profiler_;
+      busy_retry_ = other.busy_retry_;
+      catalog_ = other.catalog_;
+      schema_version_stmt_ = other.schema_version_stmt_;
+      txn_stmts_ = other.txn_stmts_;
+      savepoint_depth_ = other.savepoint_depth_;
       other.db_ = nullptr;
+      other.stmt_cache_ = nullptr;
+      other.profiler_ = nullptr;
+      other.busy_retry_ = nullptr;
+      other.catalog_ = nullptr;
+      other.schema_version_stmt_ = nullptr;
+      other.txn_stmts_ = nullptr;
+      other.savepoint_depth_ = 0;
     }
     return *this;
   }
@@ -54,14 +124,32 @@ class Sqlite3Db {
 
   // --- Open / Close ---
 
-  Error Open(const char* path) {
+  Error Open(const char* path) { return Open(path, Sqlite3OpenOptions{}); }
+
+  /// Open with explicit flags and pragmas (see Sqlite3OpenOptions), e.g.
+  ///   db.Open("app.db", Sqlite3OpenOptions::Throughput());
+  /// If a pragma fails, or SQLite keeps another journal mode than the one
+  /// requested (WAL on :memory: or read-only files), the connection is
+  /// closed and the error returned.
+  Error Open(const char* path, const Sqlite3OpenOptions& opts) {
     if (path == nullptr) {
       return Error::Make(ErrorCode::kNullParam, "path is null");
     }
     Close();
-    int32_t rc = sqlite3_open(path, &db_);
+
+    int32_t flags = opts.read_only
+        ? SQLITE_OPEN_READONLY
+        : (SQLITE_OPEN_READWRITE | (opts.create ? SQLITE_OPEN_CREATE : 0));
+    if (opts.uri) { flags |= SQLITE_OPEN_URI; }
+    if (opts.thread_mode == Sqlite3ThreadMode::kMultiThread) {
+      flags |= SQLITE_OPEN_NOMUTEX;
+    } else if (opts.thread_mode == Sqlite3ThreadMode::kSerialized) {
+      flags |= SQLITE_OPEN_FULLMUTEX;
+    }
+
+    int32_t rc = sqlite3_open_v2(path, &db_, flags, nullptr);
     if (rc != SQLITE_OK) {
-      Error err = Error::Make(ErrorCode::kError,
+      Error err = Error::Make(Sqlite3ErrorCode(rc),
                               db_ ? sqlite3_errmsg(db_) : "sqlite3_open failed");
       if (db_ != nullptr) {
         sqlite3_close(db_);
@@ -69,10 +157,26 @@ class Sqlite3Db {
       }
       return err;
     }
+
+    Error err = ApplyLookaside(opts);
+    if (err.ok()) { err = ApplyPragmas(opts); }
+    if (!err.ok()) {
+      sqlite3_close(db_);
+      db_ = nullptr;
+      return err;
+    }
+    if (profiler_ != nullptr) { profiler_->Attach(db_); }
+    if (busy_retry_ != nullptr) { busy_retry_->Attach(db_); }
     return Error::Ok();
   }
 
   void Close() {
+    if (stmt_cache_ != nullptr) { stmt_cache_->Clear(); }
+    FinalizeTxnStatements();
+    savepoint_depth_ = 0;
+    sqlite3_finalize(schema_version_stmt_);
+    schema_version_stmt_ = nullptr;
+    if (catalog_ != nullptr) { catalog_->Invalidate(); }
     if (db_ != nullptr) {
       sqlite3_close(db_);
       db_ = nullptr;
@@ -85,6 +189,11 @@ class Sqlite3Db {
 
   /// Execute DML (CREATE/DROP/INSERT/UPDATE/DELETE).
   /// Returns number of affected rows, or -1 on error.
+  /// With the statement cache or busy retry enabled, statements are
+  /// prepared and stepped here (single ones from the cache when enabled);
+  /// a multi-statement string runs statement by statement from the first
+  /// one already compiled, so nothing is parsed twice. Otherwise the
+  /// string goes to sqlite3_exec.
   int32_t ExecDml(const char* sql, Error* out_error = nullptr) {
     if (db_ == nullptr) {
       if (out_error != nullptr) {
@@ -99,6 +208,18 @@ class Sqlite3Db {
       return -1;
     }
 
+    if (stmt_cache_ != nullptr || BusyRetryEnabled()) {
+      bool cached = false;
+      bool whole = false;
+      const char* tail = nullptr;
+      sqlite3_stmt* stmt = Acquire(sql, &cached, out_error, &whole, &tail);
+      if (stmt != nullptr && whole) {
+        return StepDml(stmt, cached, out_error);
+      }
+      if (stmt == nullptr && tail == nullptr) { return -1; }  // Compile error
+      return ExecScript(stmt, tail, out_error);
+    }
+
     char* errmsg = nullptr;
     int32_t rc = sqlite3_exec(db_, sql, nullptr, nullptr, &errmsg);
     if (rc == SQLITE_OK) {
@@ -106,7 +227,7 @@ class Sqlite3Db {
     }
 
     if (out_error != nullptr) {
-      out_error->Set(ErrorCode::kError,
+      out_error->Set(Sqlite3ErrorCode(rc),
                      errmsg ? errmsg : sqlite3_errmsg(db_));
     }
     if (errmsg != nullptr) { sqlite3_free(errmsg); }
@@ -146,21 +267,23 @@ class Sqlite3Db {
       return Sqlite3Query{};
     }
 
-    sqlite3_stmt* stmt = Compile(sql, out_error);
+    bool cached = false;
+    sqlite3_stmt* stmt = Acquire(sql, &cached, out_error);
     if (stmt == nullptr) { return Sqlite3Query{}; }
+    Sqlite3StmtCache* owner = cached ? stmt_cache_ : nullptr;
 
-    int32_t rc = sqlite3_step(stmt);
+    int32_t rc = StepFirst(stmt);
     if (rc == SQLITE_DONE) {
-      return Sqlite3Query(db_, stmt, true);
+      return Sqlite3Query(db_, stmt, true, owner);
     }
     if (rc == SQLITE_ROW) {
-      return Sqlite3Query(db_, stmt, false);
+      return Sqlite3Query(db_, stmt, false, owner);
     }
 
     if (out_error != nullptr) {
-      out_error->Set(ErrorCode::kError, sqlite3_errmsg(db_));
+      out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
     }
-    sqlite3_finalize(stmt);
+    Release(stmt, cached);
     return Sqlite3Query{};
   }
 
@@ -194,13 +317,59 @@ class Sqlite3Db {
     }
 
     if (out_error != nullptr) {
-      out_error->Set(ErrorCode::kError,
+      out_error->Set(Sqlite3ErrorCode(rc),
                      errmsg ? errmsg : sqlite3_errmsg(db_));
     }
     if (errmsg != nullptr) { sqlite3_free(errmsg); }
     return Sqlite3ResultSet{};
   }
 
+  /// Execute query and materialize all rows with native types
+  /// (int64/double/text/blob) into a single arena. Prefer this over
+  /// GetResultSet() for large or numeric results.
+  Sqlite3TypedResultSet GetTypedResultSet(const char* sql,
+                                          Error* out_error = nullptr) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return Sqlite3TypedResultSet{};
+    }
+    if (sql == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNullParam, "sql is null");
+      }
+      return Sqlite3TypedResultSet{};
+    }
+
+    bool cached = false;
+    sqlite3_stmt* stmt = Acquire(sql, &cached, out_error);
+    if (stmt == nullptr) { return Sqlite3TypedResultSet{}; }
+
+    Sqlite3TypedResultSet rs;
+    Error err = rs.Load(db_, stmt, false);
+    Release(stmt, cached);
+    if (!err.ok()) {
+      if (out_error != nullptr) { *out_error = err; }
+      return Sqlite3TypedResultSet{};
+    }
+    return rs;
+  }
+
+  /// Execute one parameterized statement: args bind to ?1..?N (text/blob
+  /// copied) and the statement is stepped to completion. Served from the
+  /// statement cache when enabled. Only the first statement of `sql` runs.
+  /// A trailing Error* receives the failure:
+  ///   db.Exec("INSERT INTO t VALUES(?, ?);", id, name, &err);
+  /// Returns affected row count, or -1 on error.
+  template <typename... Args>
+  int32_t Exec(const char* sql, const Args&... args) {
+    auto run = [this, sql](Error* out_error, const auto&... values) {
+      return ExecBound(sql, out_error, values...);
+    };
+    return detail::CallWithOutError(run, args...);
+  }
+
   // --- Statement ---
 
   /// Compile a prepared statement.
@@ -215,68 +384,822 @@ class Sqlite3Db {
 
     sqlite3_stmt* stmt = Compile(sql, out_error);
     if (stmt == nullptr) { return Sqlite3Statement{}; }
-    return Sqlite3Statement(db_, stmt);
+    return Sqlite3Statement(db_, stmt, busy_retry_);
+  }
+
+  /// Compile a multi-statement script for repeated Run() calls. Parsing
+  /// errors surface from Run(), at the statement that fails.
+  Sqlite3Script CompileScript(const char* sql, Error* out_error = nullptr) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return Sqlite3Script{};
+    }
+    if (sql == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNullParam, "sql is null");
+      }
+      return Sqlite3Script{};
+    }
+    return Sqlite3Script(db_, sql, busy_retry_);
+  }
+
+  // --- Incremental BLOB I/O ---
+
+  /// Open `column` of row `rowid` in `table` for chunked reads (and
+  /// writes if `writable`). The value must already have its final size,
+  /// e.g. inserted as ZeroBlob{n}.
+  Sqlite3Blob OpenBlob(const char* table, const char* column, int64_t rowid,
+                       bool writable = false, Error* out_error = nullptr) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return Sqlite3Blob{};
+    }
+    if (table == nullptr || column == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNullParam, "table or column is null");
+      }
+      return Sqlite3Blob{};
+    }
+    sqlite3_blob* blob = nullptr;
+    int32_t rc = sqlite3_blob_open(db_, "main", table, column, rowid,
+                                   writable ? 1 : 0, &blob);
+    if (rc != SQLITE_OK) {
+      if (out_error != nullptr) {
+        out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+      }
+      sqlite3_blob_close(blob);  // May be allocated on failure
+      return Sqlite3Blob{};
+    }
+    return Sqlite3Blob(db_, blob, rowid, writable);
+  }
+
+  // --- SQL functions ---
+
+  /// Register `fn` as scalar SQL function `name`. Arity, argument and
+  /// result conversions come from fn's signature, e.g.
+  ///   db.CreateFunction("clamp", [](double v, double lo, double hi) {...});
+  /// `fn` is moved to the heap and lives until replaced or Close().
+  template <typename F>
+  Error CreateFunction(const char* name, F fn,
+                       const FunctionOptions& opts = FunctionOptions{}) {
+    using Fn = detail::ScalarFunction<F>;
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    // On failure SQLite calls Destroy itself.
+    int32_t rc = sqlite3_create_function_v2(
+        db_, name, Fn::Sig::Sql::kCount, opts.Flags(), new F(std::move(fn)),
+        &Fn::Call, nullptr, nullptr, &Fn::Destroy);
+    return RegisterResult(rc);
+  }
+
+  /// Register aggregate `name` over `State`: default-constructible, with
+  /// Step(args...) per row and Final() -> result per group.
+  template <typename State>
+  Error CreateAggregate(const char* name,
+                        const FunctionOptions& opts = FunctionOptions{}) {
+    using Fn = detail::AggregateFunction<State>;
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    int32_t rc = sqlite3_create_function_v2(
+        db_, name, Fn::StepSig::Sql::kCount, opts.Flags(), nullptr, nullptr,
+        &Fn::Step, &Fn::Final, nullptr);
+    return RegisterResult(rc);
+  }
+
+  /// Register aggregate window function `name`: State as for
+  /// CreateAggregate plus Inverse(args...) (row leaves the frame) and
+  /// Value() (current result, state kept).
+  template <typename State>
+  Error CreateWindowFunction(const char* name,
+                             const FunctionOptions& opts = FunctionOptions{}) {
+    using Fn = detail::WindowFunction<State>;
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    int32_t rc = sqlite3_create_window_function(
+        db_, name, Fn::StepSig::Sql::kCount, opts.Flags(), nullptr,
+        &Fn::Step, &Fn::Final, &Fn::Value, &Fn::Inverse, nullptr);
+    return RegisterResult(rc);
+  }
+
+  /// Unregister the `num_args` overload of function `name`.
+  Error RemoveFunction(const char* name, int32_t num_args) {
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    int32_t rc = sqlite3_create_function_v2(db_, name, num_args, SQLITE_UTF8,
+                                            nullptr, nullptr, nullptr,
+                                            nullptr, nullptr);
+    return RegisterResult(rc);
   }
 
-  // --- Table exists ---
+  // --- Virtual tables ---
 
-  bool TableExists(const char* table) {
-    if (db_ == nullptr || table == nullptr) { return false; }
-    char sql[256];
-    std::snprintf(sql, sizeof(sql),
-        "SELECT count(*) FROM sqlite_master "
-        "WHERE type='table' AND name='%s'", table);
-    return ExecScalar(sql) > 0;
+  /// Make `*source` queryable as table `name` (read-only, no copy).
+  /// `source` is not owned: keep it alive until DropVirtualTable() or
+  /// Close(), and do not mutate it while a statement reads it.
+  template <typename Source>
+  Error CreateVirtualTable(const char* name, const Source* source) {
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    if (source == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "source is null");
+    }
+    int32_t rc = sqlite3_create_module_v2(
+        db_, name, detail::VirtualTable<Source>::Module(),
+        const_cast<Source*>(source), nullptr);
+    return RegisterResult(rc);
+  }
+
+  /// Unregister virtual table `name`; its source may be released after.
+  /// Finalize statements reading the table first.
+  Error DropVirtualTable(const char* name) {
+    Error err = CheckRegisterName(name);
+    if (!err.ok()) { return err; }
+    int32_t rc = sqlite3_create_module_v2(db_, name, nullptr, nullptr,
+                                          nullptr);
+    return RegisterResult(rc);
+  }
+
+  // --- Schema catalog ---
+
+  /// Table lookups below cover the main database and compare names
+  /// ASCII case-insensitively, as SQLite does. Each call costs one step
+  /// of a prepared PRAGMA schema_version; the catalog is reloaded only
+  /// after a schema change. Returned pointers stay valid until the next
+  /// reload, InvalidateSchema() or Close().
+
+  bool TableExists(const char* table, Error* out_error = nullptr) {
+    return GetTable(table, out_error) != nullptr;
+  }
+
+  bool ColumnExists(const char* table, const char* column,
+                    Error* out_error = nullptr) {
+    const SchemaCatalog* catalog = Catalog(out_error);
+    return catalog != nullptr &&
+           catalog->FindColumn(table, column) != nullptr;
+  }
+
+  /// Table `table` with its columns and indexes, or nullptr. Columns of
+  /// virtual tables are not listed.
+  const SchemaTable* GetTable(const char* table, Error* out_error = nullptr) {
+    const SchemaCatalog* catalog = Catalog(out_error);
+    return catalog != nullptr ? catalog->FindTable(table) : nullptr;
+  }
+
+  /// Columns of `table` in declaration order, or nullptr.
+  const std::vector<SchemaColumn>* GetColumns(const char* table,
+                                              Error* out_error = nullptr) {
+    const SchemaTable* t = GetTable(table, out_error);
+    return t != nullptr ? &t->columns : nullptr;
+  }
+
+  /// Reload the catalog on the next lookup.
+  void InvalidateSchema() {
+    if (catalog_ != nullptr) { catalog_->Invalidate(); }
   }
 
   // --- Transaction ---
 
-  Error BeginTransaction() {
+  Error BeginTransaction() { return BeginTransaction(TxnMode::kDeferred); }
+
+  /// BEGIN in `mode`. Writers under contention should use kImmediate: a
+  /// deferred transaction that later writes can fail with kBusy on the
+  /// lock upgrade and must then be retried from the start.
+  Error BeginTransaction(TxnMode mode) {
     Error err;
-    ExecDml("BEGIN TRANSACTION;", &err);
+    switch (mode) {
+      case TxnMode::kImmediate:
+        err = RunTxnStatement(kBeginImmediate, "BEGIN IMMEDIATE;");
+        break;
+      case TxnMode::kExclusive:
+        err = RunTxnStatement(kBeginExclusive, "BEGIN EXCLUSIVE;");
+        break;
+      default:
+        err = RunTxnStatement(kBeginDeferred, "BEGIN DEFERRED;");
+        break;
+    }
+    if (err.ok()) { savepoint_depth_ = 0; }
     return err;
   }
 
   Error Commit() {
-    Error err;
-    ExecDml("COMMIT TRANSACTION;", &err);
+    Error err = RunTxnStatement(kCommit, "COMMIT;");
+    if (err.ok()) { savepoint_depth_ = 0; }
     return err;
   }
 
   Error Rollback() {
-    Error err;
-    ExecDml("ROLLBACK;", &err);
+    Error err = RunTxnStatement(kRollback, "ROLLBACK;");
+    savepoint_depth_ = 0;
+    return err;
+  }
+
+  // --- Savepoints (a stack, used by Transaction<Db> for nesting) ---
+
+  /// Push SAVEPOINT dbpp_sp<depth>. Outside a transaction this also
+  /// starts one (deferred).
+  Error Savepoint() {
+    if (!InTransaction()) { savepoint_depth_ = 0; }
+    Error err = RunSavepointStatement(kSpOpen, savepoint_depth_);
+    if (err.ok()) { ++savepoint_depth_; }
     return err;
   }
 
+  /// Pop the innermost savepoint, keeping its changes (RELEASE).
+  Error ReleaseSavepoint() {
+    Error err = CheckSavepoint();
+    if (!err.ok()) { return err; }
+    err = RunSavepointStatement(kSpRelease, savepoint_depth_ - 1);
+    if (err.ok()) { --savepoint_depth_; }
+    return err;
+  }
+
+  /// Pop the innermost savepoint, undoing its changes (ROLLBACK TO +
+  /// RELEASE); the enclosing transaction stays open.
+  Error RollbackToSavepoint() {
+    Error err = CheckSavepoint();
+    if (!err.ok()) { return err; }
+    err = RunSavepointStatement(kSpRollback, savepoint_depth_ - 1);
+    if (err.ok()) {
+      err = RunSavepointStatement(kSpRelease, savepoint_depth_ - 1);
+    }
+    if (err.ok()) { --savepoint_depth_; }
+    return err;
+  }
+
+  /// Open savepoints pushed by Savepoint() in the current transaction.
+  uint32_t SavepointDepth() const {
+    return InTransaction() ? savepoint_depth_ : 0;
+  }
+
   bool InTransaction() const {
     if (db_ == nullptr) { return false; }
     return sqlite3_get_autocommit(db_) == 0;
   }
 
-  // --- Misc ---
+  // --- Statement cache ---
+
+  /// Enable an LRU cache of up to `capacity` prepared statements used by
+  /// ExecDml/ExecQuery/ExecScalar. 0 disables the cache.
+  /// Replacing the cache finalizes all idle statements; call it while no
+  /// Sqlite3Query from this connection is alive. Queries served from the
+  /// cache must not outlive this Sqlite3Db.
+  void EnableStatementCache(uint32_t capacity) {
+    delete stmt_cache_;
+    stmt_cache_ = nullptr;
+    if (capacity > 0) {
+      stmt_cache_ = new Sqlite3StmtCache(capacity);
+    }
+  }
+
+  bool StatementCacheEnabled() const { return stmt_cache_ != nullptr; }
+
+  /// Finalize all idle cached statements (e.g. to release schema locks).
+  void ClearStatementCache() {
+    if (stmt_cache_ != nullptr) { stmt_cache_->Clear(); }
+  }
+
+  Sqlite3StmtCacheStats StatementCacheStats() const {
+    if (stmt_cache_ == nullptr) { return Sqlite3StmtCacheStats{}; }
+    return stmt_cache_->Stats();
+  }
+
+  void ResetStatementCacheStats() {
+    if (stmt_cache_ != nullptr) { stmt_cache_->ResetStats(); }
+  }
+
+  // --- Profiling ---
+
+  /// Record per-SQL latency and stmt_status counters from now on
+  /// (replaces any previous profiler and its data). Applies across
+  /// Close()/Open(). When disabled, no trace callback is installed.
+  void EnableProfiling(
+      const Sqlite3ProfilerOptions& opts = Sqlite3ProfilerOptions{}) {
+    DisableProfiling();
+    profiler_ = new Sqlite3Profiler(opts);
+    profiler_->Attach(db_);
+  }
+
+  void DisableProfiling() {
+    if (profiler_ == nullptr) { return; }
+    Sqlite3Profiler::Detach(db_);
+    delete profiler_;
+    profiler_ = nullptr;
+  }
+
+  bool ProfilingEnabled() const { return profiler_ != nullptr; }
+
+  /// Copy up to `max_entries` per-SQL stats into `out`, hottest (by total
+  /// time) first. sql pointers stay valid until ResetProfile() or
+  /// DisableProfiling(). Returns the number written.
+  uint32_t ProfileSnapshot(Sqlite3SqlStats* out, uint32_t max_entries) const {
+    if (profiler_ == nullptr) { return 0; }
+    return profiler_->Snapshot(out, max_entries);
+  }
+
+  void ResetProfile() {
+    if (profiler_ != nullptr) { profiler_->Reset(); }
+  }
 
+  /// Print the `top_n` hottest statements as a text table.
+  void DumpProfile(std::FILE* out, uint32_t top_n = 20) const {
+    if (profiler_ != nullptr) { profiler_->Dump(out, top_n); }
+  }
+
+  // --- Lock contention ---
+
+  /// Wait out SQLITE_BUSY/SQLITE_LOCKED per `policy` (jittered exponential
+  /// backoff, retry and deadline limits) instead of failing at once with
+  /// kBusy; replaces any SetBusyTimeout(). Applies across Close()/Open().
+  /// Statements compiled before the first call only get SQLite-side waits.
+  void EnableBusyRetry(const Sqlite3BusyPolicy& policy = Sqlite3BusyPolicy{}) {
+    if (busy_retry_ == nullptr) {
+      busy_retry_ = new Sqlite3BusyRetry(policy);
+    } else {
+      busy_retry_->SetPolicy(policy);
+    }
+    busy_retry_->Attach(db_);
+  }
+
+  /// Conflicts fail with kBusy at once. Stats are kept.
+  void DisableBusyRetry() {
+    if (busy_retry_ != nullptr) { busy_retry_->Detach(db_); }
+  }
+
+  bool BusyRetryEnabled() const {
+    return busy_retry_ != nullptr && busy_retry_->Enabled();
+  }
+
+  /// Conflicts, waits and time spent waiting since enabled / reset.
+  Sqlite3BusyStats BusyStats() const {
+    if (busy_retry_ == nullptr) { return Sqlite3BusyStats{}; }
+    return busy_retry_->Stats();
+  }
+
+  void ResetBusyStats() {
+    if (busy_retry_ != nullptr) { busy_retry_->ResetStats(); }
+  }
+
+  /// SQLite's built-in fixed-interval busy handler; disables busy retry.
   void SetBusyTimeout(int32_t ms) {
+    if (busy_retry_ != nullptr) { busy_retry_->Detach(db_); }
     if (db_ != nullptr) { sqlite3_busy_timeout(db_, ms); }
   }
 
+  // --- Misc ---
+
+  /// Rowid of the last successful INSERT on this connection.
+  int64_t LastInsertRowId() const {
+    if (db_ == nullptr) { return 0; }
+    return static_cast<int64_t>(sqlite3_last_insert_rowid(db_));
+  }
+
   sqlite3* Handle() const { return db_; }
 
  private:
-  sqlite3_stmt* Compile(const char* sql, Error* out_error) {
+  // Prepared-once transaction statements: the BEGIN/COMMIT/ROLLBACK
+  // slots, then kSpKinds slots per savepoint level below
+  // kCachedSavepoints (deeper levels are prepared per call).
+  enum TxnSlot : uint32_t {
+    kBeginDeferred = 0,
+    kBeginImmediate,
+    kBeginExclusive,
+    kCommit,
+    kRollback,
+    kNumTxnSlots
+  };
+  enum SavepointKind : uint32_t { kSpOpen = 0, kSpRelease, kSpRollback };
+  static constexpr uint32_t kSpKinds = 3;
+  static constexpr uint32_t kCachedSavepoints = 8;
+  static constexpr uint32_t kTxnStmtCount =
+      kNumTxnSlots + kSpKinds * kCachedSavepoints;
+
+  /// Step a cached transaction statement, preparing it on first use.
+  /// SQLITE_BUSY/LOCKED map to kBusy.
+  Error RunTxnStatement(uint32_t slot, const char* sql) {
+    if (db_ == nullptr) {
+      return Error::Make(ErrorCode::kNotOpen, "Database not open");
+    }
+    if (txn_stmts_ == nullptr) {
+      txn_stmts_ = new sqlite3_stmt*[kTxnStmtCount]();
+    }
+    Error err;
+    if (txn_stmts_[slot] == nullptr) {
+      txn_stmts_[slot] = Compile(sql, &err);
+      if (txn_stmts_[slot] == nullptr) { return err; }
+    }
+    return StepTxnStatement(txn_stmts_[slot]);
+  }
+
+  Error StepTxnStatement(sqlite3_stmt* stmt) {
+    int32_t rc = sqlite3_step(stmt);
+    Error err;
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+      err.Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+    }
+    sqlite3_reset(stmt);
+    return err;
+  }
+
+  Error RunSavepointStatement(SavepointKind kind, uint32_t level) {
+    static const char* const kFormats[kSpKinds] = {
+        "SAVEPOINT dbpp_sp%u;", "RELEASE dbpp_sp%u;",
+        "ROLLBACK TO dbpp_sp%u;"};
+    char sql[48];
+    std::snprintf(sql, sizeof(sql), kFormats[kind], level);
+    if (level < kCachedSavepoints) {
+      return RunTxnStatement(kNumTxnSlots + level * kSpKinds + kind, sql);
+    }
+    if (db_ == nullptr) {
+      return Error::Make(ErrorCode::kNotOpen, "Database not open");
+    }
+    Error err;
+    sqlite3_stmt* stmt = Compile(sql, &err);
+    if (stmt == nullptr) { return err; }
+    err = StepTxnStatement(stmt);
+    sqlite3_finalize(stmt);
+    return err;
+  }
+
+  Error CheckSavepoint() {
+    if (SavepointDepth() == 0) {
+      // The transaction may have been rolled back under the stack.
+      savepoint_depth_ = 0;
+      return Error::Make(ErrorCode::kMisuse, "no open savepoint");
+    }
+    return Error::Ok();
+  }
+
+  void FinalizeTxnStatements() {
+    if (txn_stmts_ == nullptr) { return; }
+    for (uint32_t i = 0; i < kTxnStmtCount; ++i) {
+      if (txn_stmts_[i] != nullptr) { sqlite3_finalize(txn_stmts_[i]); }
+    }
+    delete[] txn_stmts_;
+    txn_stmts_ = nullptr;
+  }
+
+  Error CheckRegisterName(const char* name) const {
+    if (db_ == nullptr) {
+      return Error::Make(ErrorCode::kNotOpen, "Database not open");
+    }
+    if (name == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "name is null");
+    }
+    return Error::Ok();
+  }
+
+  Error RegisterResult(int32_t rc) const {
+    if (rc != SQLITE_OK) {
+      return Error::Make(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+    }
+    return Error::Ok();
+  }
+
+  sqlite3_stmt* Compile(const char* sql, Error* out_error,
+                        const char** out_tail = nullptr) {
     const char* tail = nullptr;
     sqlite3_stmt* stmt = nullptr;
     int32_t rc = sqlite3_prepare_v2(db_, sql, -1, &stmt, &tail);
     if (rc != SQLITE_OK) {
       if (out_error != nullptr) {
-        out_error->Set(ErrorCode::kError, sqlite3_errmsg(db_));
+        out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
       }
       return nullptr;
     }
+    if (out_tail != nullptr) { *out_tail = tail; }
+    return stmt;
+  }
+
+  /// Resize the lookaside allocator. Must run before the first statement,
+  /// while no lookaside memory is in use. SQLite allocates the buffer; a
+  /// half left at -1 takes SQLite's default (1200 bytes x 100 slots).
+  Error ApplyLookaside(const Sqlite3OpenOptions& opts) {
+    if (opts.lookaside_slot_size < 0 && opts.lookaside_slots < 0) {
+      return Error::Ok();
+    }
+    int32_t size = opts.lookaside_slot_size < 0 ? 1200
+                                                : opts.lookaside_slot_size;
+    int32_t count = opts.lookaside_slots < 0 ? 100 : opts.lookaside_slots;
+    int32_t rc = sqlite3_db_config(db_, SQLITE_DBCONFIG_LOOKASIDE, nullptr,
+                                   static_cast<int>(size),
+                                   static_cast<int>(count));
+    if (rc != SQLITE_OK) {
+      Error err;
+      err.SetFormat(ErrorCode::kError, "lookaside %d x %d: %s", size, count,
+                    sqlite3_errstr(rc));
+      return err;
+    }
+    return Error::Ok();
+  }
+
+  /// Apply the pragmas of `opts` that are not left at their default.
+  /// page_size and locking_mode go first: both must precede WAL.
+  Error ApplyPragmas(const Sqlite3OpenOptions& opts) {
+    constexpr int32_t kMaxPragmas = 7;
+    char sql[kMaxPragmas][64];
+    int32_t n = 0;
+    if (opts.page_size > 0) {
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA page_size=%u;",
+                    opts.page_size);
+    }
+    if (opts.exclusive_locking) {
+      std::snprintf(sql[n++], sizeof(sql[0]),
+                    "PRAGMA locking_mode=EXCLUSIVE;");
+    }
+    const char* journal = JournalModeName(opts.journal_mode);
+    int32_t journal_at = -1;
+    if (journal != nullptr) {
+      journal_at = n;
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA journal_mode=%s;",
+                    journal);
+    }
+    if (const char* sync = SynchronousName(opts.synchronous)) {
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA synchronous=%s;", sync);
+    }
+    if (opts.cache_size != 0) {
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA cache_size=%d;",
+                    opts.cache_size);
+    }
+    if (opts.mmap_size >= 0) {
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA mmap_size=%lld;",
+                    static_cast<long long>(opts.mmap_size));
+    }
+    if (const char* store = TempStoreName(opts.temp_store)) {
+      std::snprintf(sql[n++], sizeof(sql[0]), "PRAGMA temp_store=%s;", store);
+    }
+
+    for (int32_t i = 0; i < n; ++i) {
+      if (i == journal_at) {
+        Error err = ApplyJournalMode(sql[i], journal);
+        if (!err.ok()) { return err; }
+        continue;
+      }
+      if (sqlite3_exec(db_, sql[i], nullptr, nullptr, nullptr) != SQLITE_OK) {
+        Error err;
+        err.SetFormat(ErrorCode::kError, "%s %s", sql[i], sqlite3_errmsg(db_));
+        return err;
+      }
+    }
+    return Error::Ok();
+  }
+
+  /// Run a journal_mode pragma and check the mode SQLite reports back: it
+  /// keeps the old mode, without an error, where the new one is not
+  /// possible (WAL on :memory:, read-only or no-shm VFS databases).
+  Error ApplyJournalMode(const char* sql, const char* mode) {
+    Error err;
+    sqlite3_stmt* stmt = Compile(sql, &err);
+    if (stmt == nullptr) {
+      err.SetFormat(err.code, "%s %s", sql, sqlite3_errmsg(db_));
+      return err;
+    }
+    int32_t rc = sqlite3_step(stmt);
+    if (rc != SQLITE_ROW) {
+      err.SetFormat(Sqlite3ErrorCode(rc), "%s %s", sql, sqlite3_errmsg(db_));
+    } else {
+      const unsigned char* text = sqlite3_column_text(stmt, 0);
+      const char* got = text != nullptr ? reinterpret_cast<const char*>(text)
+                                        : "";
+      if (sqlite3_stricmp(got, mode) != 0) {
+        err.SetFormat(ErrorCode::kError, "%s not applied: journal mode is %s",
+                      sql, got);
+      }
+    }
+    sqlite3_finalize(stmt);
+    return err;
+  }
+
+  /// Get a statement for `sql`, from the cache when enabled.
+  /// *out_cached is true when the statement belongs to the cache and must
+  /// be handed back with Release(); only statements compiled from the whole
+  /// string (up to blanks, ';' and comments) are cacheable. *out_whole (if
+  /// given) tells whether they were, *out_tail where compiling stopped
+  /// (nullptr after a compile error).
+  sqlite3_stmt* Acquire(const char* sql, bool* out_cached,
+                        Error* out_error, bool* out_whole = nullptr,
+                        const char** out_tail = nullptr) {
+    *out_cached = false;
+    if (stmt_cache_ != nullptr) {
+      sqlite3_stmt* stmt = stmt_cache_->Take(sql);
+      if (stmt != nullptr) {
+        *out_cached = true;
+        if (out_whole != nullptr) { *out_whole = true; }
+        return stmt;
+      }
+    }
+    const char* tail = nullptr;
+    sqlite3_stmt* stmt = Compile(sql, out_error, &tail);
+    bool whole = (stmt != nullptr && tail != nullptr && IsBlankSql(tail));
+    if (out_tail != nullptr) { *out_tail = tail; }
+    // A trailing comment makes sqlite3_sql() differ from the lookup key:
+    // such a statement would never be found again, so it is not cached.
+    *out_cached = whole && stmt_cache_ != nullptr &&
+                  Sqlite3StmtCache::SameKey(sql, sqlite3_sql(stmt));
+    if (out_whole != nullptr) { *out_whole = whole; }
     return stmt;
   }
 
+  template <typename... Args>
+  int32_t ExecBound(const char* sql, Error* out_error, const Args&... args) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return -1;
+    }
+    if (sql == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNullParam, "sql is null");
+      }
+      return -1;
+    }
+    bool cached = false;
+    sqlite3_stmt* stmt = Acquire(sql, &cached, out_error);
+    if (stmt == nullptr) { return -1; }
+
+    Sqlite3Statement binder(db_, stmt);
+    Status st = binder.BindAll(args...);
+    if (!st.ok() && out_error != nullptr) { *out_error = binder.ToError(st); }
+    binder.stmt_ = nullptr;  // stmt stays ours, Release() below
+    if (!st.ok()) {
+      Release(stmt, cached);
+      return -1;
+    }
+    return StepDml(stmt, cached, out_error);
+  }
+
+  /// True if `sql` holds only whitespace, ';' and comments.
+  static bool IsBlankSql(const char* sql) {
+    const char* p = sql;
+    while (*p != '\0') {
+      if (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == ';') {
+        ++p;
+      } else if (p[0] == '-' && p[1] == '-') {
+        while (*p != '\0' && *p != '\n') { ++p; }
+      } else if (p[0] == '/' && p[1] == '*') {
+        const char* end = std::strstr(p + 2, "*/");
+        if (end == nullptr) { return true; }  // SQLite ignores it too
+        p = end + 2;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Release(sqlite3_stmt* stmt, bool cached) {
+    if (cached) {
+      stmt_cache_->Put(stmt);
+    } else {
+      sqlite3_finalize(stmt);
+    }
+  }
+
+  /// Run a single statement to completion (sqlite3_exec semantics),
+  /// then Release() it.
+  int32_t StepDml(sqlite3_stmt* stmt, bool cached, Error* out_error) {
+    int32_t rc = StepFirst(stmt);
+    while (rc == SQLITE_ROW) { rc = sqlite3_step(stmt); }
+    if (rc == SQLITE_DONE) {
+      int32_t changes = sqlite3_changes(db_);
+      Release(stmt, cached);
+      return changes;
+    }
+    if (out_error != nullptr) {
+      out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+    }
+    Release(stmt, cached);
+    return -1;
+  }
+
+  /// Run a multi-statement string from its compiled first statement
+  /// `stmt` (nullptr if it was empty) on: each later statement is compiled
+  /// from `tail` after the previous one ran, as sqlite3_exec does. Returns
+  /// sqlite3_changes() like sqlite3_exec, or -1 at the first failure.
+  int32_t ExecScript(sqlite3_stmt* stmt, const char* tail, Error* out_error) {
+    for (;;) {
+      if (stmt != nullptr && StepDml(stmt, false, out_error) < 0) {
+        return -1;
+      }
+      if (*tail == '\0') { break; }
+      Error err;
+      stmt = Compile(tail, &err, &tail);
+      if (!err.ok()) {
+        if (out_error != nullptr) { *out_error = err; }
+        return -1;
+      }
+    }
+    return sqlite3_changes(db_);
+  }
+
+  /// The schema catalog, (re)loaded if PRAGMA schema_version moved since
+  /// the last load. nullptr on error.
+  const SchemaCatalog* Catalog(Error* out_error) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kNotOpen, "Database not open");
+      }
+      return nullptr;
+    }
+    if (schema_version_stmt_ == nullptr) {
+      schema_version_stmt_ = Compile("PRAGMA schema_version;", out_error);
+      if (schema_version_stmt_ == nullptr) { return nullptr; }
+    }
+    int32_t rc = StepFirst(schema_version_stmt_);
+    if (rc != SQLITE_ROW) {  // kBusy etc.: no version to compare
+      if (out_error != nullptr) {
+        out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+      }
+      sqlite3_reset(schema_version_stmt_);
+      return nullptr;
+    }
+    uint64_t version = static_cast<uint64_t>(
+        sqlite3_column_int64(schema_version_stmt_, 0));
+    sqlite3_reset(schema_version_stmt_);
+    if (catalog_ == nullptr) { catalog_ = new SchemaCatalog(); }
+    if (catalog_->Loaded() && catalog_->Version() == version) {
+      return catalog_;
+    }
+    Error err = LoadCatalog(version);
+    if (!err.ok()) {
+      catalog_->Invalidate();
+      if (out_error != nullptr) { *out_error = err; }
+      return nullptr;
+    }
+    return catalog_;
+  }
+
+  /// Fill catalog_ from sqlite_master and the table_info/index_list/
+  /// index_info pragmas: three statements, whatever the table count.
+  Error LoadCatalog(uint64_t version) {
+    // Virtual tables are skipped by the pragma joins: reading their
+    // columns needs the module, which may not be registered.
+    static const char* const kTables =
+        "SELECT name FROM sqlite_master WHERE type = 'table';";
+    static const char* const kColumns =
+        "SELECT m.name, p.name, p.type, p.\"notnull\", p.pk "
+        "FROM sqlite_master AS m JOIN pragma_table_info(m.name) AS p "
+        "WHERE m.type = 'table' AND m.sql NOT LIKE 'CREATE VIRTUAL%' "
+        "ORDER BY m.name, p.cid;";
+    static const char* const kIndexes =
+        "SELECT m.name, il.name, il.\"unique\", ii.name "
+        "FROM sqlite_master AS m JOIN pragma_index_list(m.name) AS il "
+        "JOIN pragma_index_info(il.name) AS ii "
+        "WHERE m.type = 'table' AND m.sql NOT LIKE 'CREATE VIRTUAL%' "
+        "ORDER BY m.name, il.name, ii.seqno;";
+    catalog_->BeginLoad(version, true);
+    for (int32_t pass = 0; pass < 3; ++pass) {
+      const char* sql = pass == 0 ? kTables
+                                  : (pass == 1 ? kColumns : kIndexes);
+      Error err;
+      sqlite3_stmt* stmt = Compile(sql, &err);
+      if (stmt == nullptr) { return err; }
+      int32_t rc = StepFirst(stmt);
+      for (; rc == SQLITE_ROW; rc = sqlite3_step(stmt)) {
+        int32_t t = catalog_->AddTable(ColumnText(stmt, 0));
+        if (pass == 1) {
+          catalog_->AddColumn(t, ColumnText(stmt, 1), ColumnText(stmt, 2),
+                              sqlite3_column_int(stmt, 3) != 0,
+                              sqlite3_column_int(stmt, 4) != 0);
+        } else if (pass == 2) {
+          catalog_->AddIndexColumn(t, ColumnText(stmt, 1),
+                                   sqlite3_column_int(stmt, 2) != 0,
+                                   ColumnText(stmt, 3));
+        }
+      }
+      if (rc != SQLITE_DONE) {
+        err = Error::Make(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+      }
+      sqlite3_finalize(stmt);
+      if (!err.ok()) { return err; }
+    }
+    catalog_->EndLoad();
+    return Error::Ok();
+  }
+
+  static const char* ColumnText(sqlite3_stmt* stmt, int32_t col) {
+    const unsigned char* text = sqlite3_column_text(stmt, col);
+    return text != nullptr ? reinterpret_cast<const char*>(text) : "";
+  }
+
+  /// First step of a statement, re-run on lock conflicts when enabled.
+  int32_t StepFirst(sqlite3_stmt* stmt) {
+    return busy_retry_ != nullptr ? busy_retry_->StepFirst(db_, stmt)
+                                  : sqlite3_step(stmt);
+  }
+
   sqlite3* db_ = nullptr;
+  Sqlite3StmtCache* stmt_cache_ = nullptr;
+  Sqlite3Profiler* profiler_ = nullptr;
+  Sqlite3BusyRetry* busy_retry_ = nullptr;  // Created by EnableBusyRetry
+  SchemaCatalog* catalog_ = nullptr;         // Created on first lookup
+  sqlite3_stmt* schema_version_stmt_ = nullptr;
+  sqlite3_stmt** txn_stmts_ = nullptr;  // kTxnStmtCount, on first use
+  uint32_t savepoint_depth_ = 0;
 };
 
 }  // namespace dbpp
@@ -0,0 +1,399 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp SQL functions -- C++ callables registered as SQLite functions.
+//
+// Design:
+//   - Sqlite3Db::CreateFunction(name, fn) registers a scalar function; the
+//     SQL arity, argument conversions and result type are deduced from the
+//     callable's signature at compile time (no per-call dispatch on types)
+//   - Aggregates and window functions are a State type: Step(args...) and
+//     Final() (plus Inverse(args...) and Value() for windows). One State
+//     is heap-allocated per group on the first Step and freed by Final
+//   - Argument types: integral, floating point, bool, TextView, BlobView,
+//     std::string, Nullable<T> (SQL NULL aware), sqlite3_value* (raw).
+//     TextView/BlobView point into SQLite's value: valid during the call
+//   - Result types: the same plus void (NULL); text/blob are copied
+//     (SQLITE_TRANSIENT)
+//   - A leading `FunctionContext&` parameter gives access to error
+//     reporting; a reported error wins over the returned value
+//   - FunctionOptions maps to SQLITE_DETERMINISTIC / SQLITE_INNOCUOUS /
+//     SQLITE_DIRECTONLY so deterministic functions can be used in
+//     indexes, CHECK constraints and generated columns
+
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "sqlite3.h"
+
+#include "dbpp/value_types.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// FunctionOptions
+// ---------------------------------------------------------------------------
+
+struct FunctionOptions {
+  /// Same result for the same arguments (SQLITE_DETERMINISTIC).
+  bool deterministic = true;
+  /// No side effects, safe to call from schema objects (SQLITE_INNOCUOUS).
+  bool innocuous = false;
+  /// Only callable from top-level SQL (SQLITE_DIRECTONLY).
+  bool direct_only = false;
+
+  int32_t Flags() const {
+    int32_t flags = SQLITE_UTF8;
+    if (deterministic) { flags |= SQLITE_DETERMINISTIC; }
+#ifdef SQLITE_INNOCUOUS
+    if (innocuous) { flags |= SQLITE_INNOCUOUS; }
+#endif
+#ifdef SQLITE_DIRECTONLY
+    if (direct_only) { flags |= SQLITE_DIRECTONLY; }
+#endif
+    return flags;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// FunctionContext
+// ---------------------------------------------------------------------------
+
+/// Per-call context, passed to callables whose first parameter is
+/// `FunctionContext&`.
+class FunctionContext {
+ public:
+  explicit FunctionContext(sqlite3_context* ctx) : ctx_(ctx) {}
+
+  /// Fail the SQL statement with `message`; the return value is ignored.
+  void SetError(const char* message) {
+    sqlite3_result_error(ctx_, message, -1);
+    failed_ = true;
+  }
+
+  /// Fail with a range error (e.g. argument out of domain).
+  void SetTooBig() {
+    sqlite3_result_error_toobig(ctx_);
+    failed_ = true;
+  }
+
+  bool Failed() const { return failed_; }
+  sqlite3_context* Handle() const { return ctx_; }
+  sqlite3* Db() const { return sqlite3_context_db_handle(ctx_); }
+
+ private:
+  sqlite3_context* ctx_;
+  bool failed_ = false;
+};
+
+namespace detail {
+
+// --- Argument conversion ---
+
+template <typename T, typename Enable = void>
+struct SqlArg;
+
+template <typename T>
+struct SqlArg<T, typename std::enable_if<std::is_integral<T>::value &&
+                                         !std::is_same<T, bool>::value>::type> {
+  static T Get(sqlite3_value* v) {
+    return static_cast<T>(sqlite3_value_int64(v));
+  }
+};
+
+template <>
+struct SqlArg<bool> {
+  static bool Get(sqlite3_value* v) { return sqlite3_value_int64(v) != 0; }
+};
+
+template <typename T>
+struct SqlArg<T, typename std::enable_if<
+                     std::is_floating_point<T>::value>::type> {
+  static T Get(sqlite3_value* v) {
+    return static_cast<T>(sqlite3_value_double(v));
+  }
+};
+
+template <>
+struct SqlArg<TextView> {
+  static TextView Get(sqlite3_value* v) {
+    const char* text = reinterpret_cast<const char*>(sqlite3_value_text(v));
+    return TextView(text, text != nullptr ? sqlite3_value_bytes(v) : 0);
+  }
+};
+
+template <>
+struct SqlArg<BlobView> {
+  static BlobView Get(sqlite3_value* v) {
+    const void* blob = sqlite3_value_blob(v);
+    return BlobView(blob, blob != nullptr ? sqlite3_value_bytes(v) : 0);
+  }
+};
+
+template <>
+struct SqlArg<std::string> {
+  static std::string Get(sqlite3_value* v) {
+    TextView t = SqlArg<TextView>::Get(v);
+    return std::string(t.data != nullptr ? t.data : "",
+                       static_cast<size_t>(t.size));
+  }
+};
+
+template <typename T>
+struct SqlArg<Nullable<T>> {
+  static Nullable<T> Get(sqlite3_value* v) {
+    if (sqlite3_value_type(v) == SQLITE_NULL) { return Nullable<T>(); }
+    return Nullable<T>(SqlArg<T>::Get(v));
+  }
+};
+
+template <>
+struct SqlArg<sqlite3_value*> {
+  static sqlite3_value* Get(sqlite3_value* v) { return v; }
+};
+
+// --- Result conversion ---
+
+inline void SetResult(sqlite3_context* ctx, TextView v) {
+  if (v.data == nullptr) {
+    sqlite3_result_null(ctx);
+  } else {
+    sqlite3_result_text(ctx, v.data, v.size, SQLITE_TRANSIENT);
+  }
+}
+
+inline void SetResult(sqlite3_context* ctx, const char* v) {
+  SetResult(ctx, TextView(v));
+}
+
+inline void SetResult(sqlite3_context* ctx, const std::string& v) {
+  sqlite3_result_text(ctx, v.data(), static_cast<int32_t>(v.size()),
+                      SQLITE_TRANSIENT);
+}
+
+inline void SetResult(sqlite3_context* ctx, BlobView v) {
+  if (v.data == nullptr) {
+    sqlite3_result_null(ctx);
+  } else {
+    sqlite3_result_blob(ctx, v.data, v.size, SQLITE_TRANSIENT);
+  }
+}
+
+inline void SetResult(sqlite3_context* ctx, std::nullptr_t) {
+  sqlite3_result_null(ctx);
+}
+
+inline void SetResult(sqlite3_context* ctx, bool v) {
+  sqlite3_result_int(ctx, v ? 1 : 0);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value &&
+                        !std::is_same<T, bool>::value>::type
+SetResult(sqlite3_context* ctx, T v) {
+  sqlite3_result_int64(ctx, static_cast<sqlite3_int64>(v));
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+SetResult(sqlite3_context* ctx, T v) {
+  sqlite3_result_double(ctx, static_cast<double>(v));
+}
+
+template <typename T>
+void SetResult(sqlite3_context* ctx, const Nullable<T>& v) {
+  if (v.is_null) {
+    sqlite3_result_null(ctx);
+  } else {
+    SetResult(ctx, v.value);
+  }
+}
+
+// --- Signature traits ---
+
+template <typename... Args>
+struct ArgList {
+  static constexpr int32_t kCount = static_cast<int32_t>(sizeof...(Args));
+  using Tuple = std::tuple<typename std::decay<Args>::type...>;
+};
+
+/// Splits an optional leading FunctionContext& off the parameter list.
+template <typename... Args>
+struct SplitContext {
+  static constexpr bool kWantsContext = false;
+  using Sql = ArgList<Args...>;
+};
+
+template <typename... Args>
+struct SplitContext<FunctionContext&, Args...> {
+  static constexpr bool kWantsContext = true;
+  using Sql = ArgList<Args...>;
+};
+
+template <typename R, typename... Args>
+struct SignatureBase {
+  using Result = R;
+  using Split = SplitContext<Args...>;
+  static constexpr bool kWantsContext = Split::kWantsContext;
+  using Sql = typename Split::Sql;
+};
+
+template <typename F>
+struct Signature : Signature<decltype(&F::operator())> {};
+
+template <typename R, typename... Args>
+struct Signature<R (*)(Args...)> : SignatureBase<R, Args...> {};
+
+template <typename R, typename... Args>
+struct Signature<R(Args...)> : SignatureBase<R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct Signature<R (C::*)(Args...)> : SignatureBase<R, Args...> {};
+
+template <typename C, typename R, typename... Args>
+struct Signature<R (C::*)(Args...) const> : SignatureBase<R, Args...> {};
+
+// --- Invocation ---
+
+template <typename Tuple, size_t... I>
+Tuple ReadArgs(sqlite3_value** argv, std::index_sequence<I...>) {
+  (void)argv;  // Unused for zero-argument functions
+  return Tuple(
+      SqlArg<typename std::tuple_element<I, Tuple>::type>::Get(argv[I])...);
+}
+
+/// Call `fn` with the SQL arguments, passing `fctx` first if the callable
+/// wants it. Deduced return type: only the selected overload's body is
+/// instantiated.
+template <typename Fn, typename Tuple, size_t... I>
+auto Apply(Fn&& fn, FunctionContext& fctx, Tuple& args,
+           std::index_sequence<I...>, std::true_type) {
+  return fn(fctx, std::get<I>(args)...);
+}
+
+template <typename Fn, typename Tuple, size_t... I>
+auto Apply(Fn&& fn, FunctionContext&, Tuple& args,
+           std::index_sequence<I...>, std::false_type) {
+  (void)args;  // Unused for zero-argument functions
+  return fn(std::get<I>(args)...);
+}
+
+/// Invoke `fn` (signature Sig) on argv and store its result in ctx.
+template <typename Sig, typename Fn>
+typename std::enable_if<!std::is_void<typename Sig::Result>::value>::type
+Invoke(Fn&& fn, sqlite3_context* ctx, sqlite3_value** argv) {
+  using Tuple = typename Sig::Sql::Tuple;
+  using Seq = std::make_index_sequence<std::tuple_size<Tuple>::value>;
+  Tuple args = ReadArgs<Tuple>(argv, Seq{});
+  FunctionContext fctx(ctx);
+  auto result = Apply(std::forward<Fn>(fn), fctx, args, Seq{},
+                      std::integral_constant<bool, Sig::kWantsContext>{});
+  if (!fctx.Failed()) { SetResult(ctx, result); }
+}
+
+template <typename Sig, typename Fn>
+typename std::enable_if<std::is_void<typename Sig::Result>::value>::type
+Invoke(Fn&& fn, sqlite3_context* ctx, sqlite3_value** argv) {
+  using Tuple = typename Sig::Sql::Tuple;
+  using Seq = std::make_index_sequence<std::tuple_size<Tuple>::value>;
+  Tuple args = ReadArgs<Tuple>(argv, Seq{});
+  FunctionContext fctx(ctx);
+  Apply(std::forward<Fn>(fn), fctx, args, Seq{},
+        std::integral_constant<bool, Sig::kWantsContext>{});
+}
+
+// --- Callbacks ---
+
+template <typename F>
+struct ScalarFunction {
+  using Sig = Signature<F>;
+
+  static void Call(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    F* fn = static_cast<F*>(sqlite3_user_data(ctx));
+    Invoke<Sig>(*fn, ctx, argv);
+  }
+
+  static void Destroy(void* p) { delete static_cast<F*>(p); }
+};
+
+template <typename State>
+struct AggregateFunction {
+  using StepSig = Signature<decltype(&State::Step)>;
+  using FinalSig = Signature<decltype(&State::Final)>;
+
+  /// The group's State, created on the first call (nullptr on OOM).
+  static State* Get(sqlite3_context* ctx) {
+    State** slot = static_cast<State**>(
+        sqlite3_aggregate_context(ctx, sizeof(State*)));
+    if (slot == nullptr) { return nullptr; }
+    if (*slot == nullptr) { *slot = new (std::nothrow) State(); }
+    return *slot;
+  }
+
+  static void Step(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    State* state = Get(ctx);
+    if (state == nullptr) {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    Invoke<StepSig>(
+        [state](auto&&... a) { return state->Step(
+            std::forward<decltype(a)>(a)...); },
+        ctx, argv);
+  }
+
+  static void Final(sqlite3_context* ctx) {
+    // No rows: the slot was never allocated; finalize a fresh State.
+    State** slot = static_cast<State**>(sqlite3_aggregate_context(ctx, 0));
+    State empty_state;
+    State* state = (slot != nullptr && *slot != nullptr) ? *slot
+                                                         : &empty_state;
+    Invoke<FinalSig>(
+        [state](auto&&... a) { return state->Final(
+            std::forward<decltype(a)>(a)...); },
+        ctx, nullptr);
+    if (slot != nullptr) {
+      delete *slot;
+      *slot = nullptr;
+    }
+  }
+};
+
+template <typename State>
+struct WindowFunction : AggregateFunction<State> {
+  using Base = AggregateFunction<State>;
+  using InverseSig = Signature<decltype(&State::Inverse)>;
+  using ValueSig = Signature<decltype(&State::Value)>;
+
+  static void Value(sqlite3_context* ctx) {
+    State* state = Base::Get(ctx);
+    if (state == nullptr) {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    Invoke<ValueSig>(
+        [state](auto&&... a) { return state->Value(
+            std::forward<decltype(a)>(a)...); },
+        ctx, nullptr);
+  }
+
+  static void Inverse(sqlite3_context* ctx, int, sqlite3_value** argv) {
+    State* state = Base::Get(ctx);
+    if (state == nullptr) {
+      sqlite3_result_error_nomem(ctx);
+      return;
+    }
+    Invoke<InverseSig>(
+        [state](auto&&... a) { return state->Inverse(
+            std::forward<decltype(a)>(a)...); },
+        ctx, argv);
+  }
+};
+
+}  // namespace detail
+}  // namespace dbpp
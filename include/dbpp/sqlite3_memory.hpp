@@ -0,0 +1,259 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Memory -- process-level SQLite memory configuration.
+//
+// Design:
+//   - Configure() must run before the first Sqlite3Db::Open (sqlite3_config
+//     is rejected once SQLite is initialized); Reset() shuts SQLite down and
+//     returns to the built-in allocator
+//   - Page-cache arena (SQLITE_CONFIG_PAGECACHE): one fixed block of
+//     page-sized slots, so cache pages never go through malloc
+//   - Heap arena (SQLITE_CONFIG_HEAP): every SQLite allocation comes from a
+//     fixed block, giving a hard memory ceiling. Needs SQLite built with
+//     SQLITE_ENABLE_MEMSYS5 (the bundled build is)
+//   - Arenas are mmap'd, optionally with MAP_HUGETLB; without reserved huge
+//     pages this falls back to a regular mapping (Stats().huge_pages says
+//     which one was used). malloc on platforms without mmap
+//   - Per-connection lookaside is set with Sqlite3OpenOptions::lookaside_*
+//   - Not thread-safe: call from the main thread at startup
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// Sqlite3MemoryOptions
+// ---------------------------------------------------------------------------
+
+struct Sqlite3MemoryOptions {
+  // --- SQLITE_CONFIG_PAGECACHE ---
+  uint32_t page_cache_pages = 0;  // Slots in the arena; 0 = no arena
+  uint32_t page_size = 4096;      // Largest page size served from the arena
+
+  // --- SQLITE_CONFIG_HEAP (SQLITE_ENABLE_MEMSYS5) ---
+  uint64_t heap_bytes = 0;       // 0 = keep the system malloc
+  uint32_t heap_min_alloc = 64;  // Smallest allocation, power of two
+
+  // --- Arena backing ---
+  bool huge_pages = false;  // Try MAP_HUGETLB first
+
+  // --- Limits (sqlite3_soft/hard_heap_limit64), 0 = none ---
+  int64_t soft_heap_limit = 0;
+  int64_t hard_heap_limit = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3MemoryStats
+// ---------------------------------------------------------------------------
+
+struct Sqlite3MemoryStats {
+  int64_t used_bytes = 0;          // SQLITE_STATUS_MEMORY_USED
+  int64_t peak_bytes = 0;          // ... highwater
+  int64_t allocations = 0;         // SQLITE_STATUS_MALLOC_COUNT
+  int64_t page_cache_used = 0;     // Arena slots in use
+  int64_t page_cache_peak = 0;
+  int64_t page_cache_overflow = 0; // Bytes that did not fit in the arena
+  uint64_t page_cache_arena_bytes = 0;
+  uint64_t heap_arena_bytes = 0;
+  bool huge_pages = false;         // At least one arena uses huge pages
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3Memory
+// ---------------------------------------------------------------------------
+
+class Sqlite3Memory {
+ public:
+  Sqlite3Memory() = delete;
+
+  /// Install the arenas and limits of `opts`. Fails with kMisuse if SQLite
+  /// is already initialized (a connection was opened before) or arenas are
+  /// already installed; call Reset() first in that case.
+  static Error Configure(const Sqlite3MemoryOptions& opts) {
+    State& st = GetState();
+    if (st.page_cache.ptr != nullptr || st.heap.ptr != nullptr) {
+      return Error::Make(ErrorCode::kMisuse, "memory already configured");
+    }
+    if (opts.page_cache_pages > 0 && opts.page_size < 512) {
+      return Error::Make(ErrorCode::kRange, "page_size below 512");
+    }
+    if (opts.heap_bytes > 0 &&
+        (opts.heap_min_alloc == 0 ||
+         (opts.heap_min_alloc & (opts.heap_min_alloc - 1)) != 0)) {
+      return Error::Make(ErrorCode::kRange,
+                         "heap_min_alloc must be a power of two");
+    }
+    if (opts.heap_bytes > 0x7fffffffu) {
+      return Error::Make(ErrorCode::kRange, "heap_bytes above 2 GiB");
+    }
+    if (opts.heap_bytes > 0 && !sqlite3_compileoption_used("ENABLE_MEMSYS5")) {
+      return Error::Make(ErrorCode::kMisuse,
+                         "heap arena needs SQLITE_ENABLE_MEMSYS5");
+    }
+
+    // sqlite3_config only works before sqlite3_initialize; probe with an
+    // option that is harmless to set again.
+    if (sqlite3_config(SQLITE_CONFIG_MEMSTATUS, 1) != SQLITE_OK) {
+      return Error::Make(ErrorCode::kMisuse,
+                         "SQLite already initialized: configure memory "
+                         "before the first Open or after Reset()");
+    }
+
+    if (opts.heap_bytes > 0) {
+      if (!Allocate(opts.heap_bytes, opts.huge_pages, &st.heap)) {
+        return Error::Make(ErrorCode::kError, "heap arena allocation failed");
+      }
+      if (sqlite3_config(SQLITE_CONFIG_HEAP, st.heap.ptr,
+                         static_cast<int>(opts.heap_bytes),
+                         static_cast<int>(opts.heap_min_alloc)) != SQLITE_OK) {
+        Reset();
+        return Error::Make(ErrorCode::kError, "SQLITE_CONFIG_HEAP failed");
+      }
+    }
+
+    if (opts.page_cache_pages > 0) {
+      int hdr = 0;
+      sqlite3_config(SQLITE_CONFIG_PCACHE_HDRSZ, &hdr);
+      // Slots must be 8-byte aligned; SQLite rounds the size down otherwise.
+      uint32_t slot = (opts.page_size + static_cast<uint32_t>(hdr) + 7u) & ~7u;
+      uint64_t bytes = uint64_t{slot} * opts.page_cache_pages;
+      if (!Allocate(bytes, opts.huge_pages, &st.page_cache)) {
+        Reset();
+        return Error::Make(ErrorCode::kError,
+                           "page cache arena allocation failed");
+      }
+      if (sqlite3_config(SQLITE_CONFIG_PAGECACHE, st.page_cache.ptr,
+                         static_cast<int>(slot),
+                         static_cast<int>(opts.page_cache_pages)) !=
+          SQLITE_OK) {
+        Reset();
+        return Error::Make(ErrorCode::kError, "SQLITE_CONFIG_PAGECACHE failed");
+      }
+    }
+
+    if (sqlite3_initialize() != SQLITE_OK) {
+      Reset();
+      return Error::Make(ErrorCode::kError, "sqlite3_initialize failed");
+    }
+    sqlite3_soft_heap_limit64(opts.soft_heap_limit);
+    sqlite3_hard_heap_limit64(opts.hard_heap_limit);
+    return Error::Ok();
+  }
+
+  /// Shut SQLite down, restore the default allocator and page cache and
+  /// release the arenas. Every connection must be closed first.
+  static void Reset() {
+    State& st = GetState();
+    // Setting a heap limit initializes SQLite, so clear them first.
+    sqlite3_soft_heap_limit64(0);
+    sqlite3_hard_heap_limit64(0);
+    sqlite3_shutdown();
+    if (st.heap.ptr != nullptr) {
+      sqlite3_config(SQLITE_CONFIG_HEAP, nullptr, 0, 0);
+    }
+    if (st.page_cache.ptr != nullptr) {
+      sqlite3_config(SQLITE_CONFIG_PAGECACHE, nullptr, 0, 0);
+    }
+    Release(&st.heap);
+    Release(&st.page_cache);
+  }
+
+  static Sqlite3MemoryStats Stats() {
+    const State& st = GetState();
+    Sqlite3MemoryStats s;
+    sqlite3_int64 cur = 0;
+    sqlite3_int64 hi = 0;
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &cur, &hi, 0);
+    s.used_bytes = cur;
+    s.peak_bytes = hi;
+    sqlite3_status64(SQLITE_STATUS_MALLOC_COUNT, &cur, &hi, 0);
+    s.allocations = cur;
+    sqlite3_status64(SQLITE_STATUS_PAGECACHE_USED, &cur, &hi, 0);
+    s.page_cache_used = cur;
+    s.page_cache_peak = hi;
+    sqlite3_status64(SQLITE_STATUS_PAGECACHE_OVERFLOW, &cur, &hi, 0);
+    s.page_cache_overflow = cur;
+    s.page_cache_arena_bytes = st.page_cache.bytes;
+    s.heap_arena_bytes = st.heap.bytes;
+    s.huge_pages = st.page_cache.huge || st.heap.huge;
+    return s;
+  }
+
+ private:
+  static constexpr uint64_t kHugePageSize = uint64_t{2} << 20;
+
+  struct Arena {
+    void* ptr = nullptr;
+    uint64_t bytes = 0;
+    bool mapped = false;  // mmap'd (else malloc'd)
+    bool huge = false;
+  };
+
+  struct State {
+    Arena page_cache;
+    Arena heap;
+  };
+
+  static State& GetState() {
+    static State state;
+    return state;
+  }
+
+  static bool Allocate(uint64_t bytes, bool huge_pages, Arena* out) {
+#if defined(__unix__) || defined(__APPLE__)
+#ifdef MAP_HUGETLB
+    if (huge_pages) {
+      uint64_t rounded = (bytes + kHugePageSize - 1) & ~(kHugePageSize - 1);
+      void* p = mmap(nullptr, rounded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+      if (p != MAP_FAILED) {
+        *out = Arena{p, rounded, true, true};
+        return true;
+      }
+    }
+#endif
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) { return false; }
+#ifdef MADV_HUGEPAGE
+    // No reserved huge pages: let transparent huge pages back the arena.
+    if (huge_pages) { madvise(p, bytes, MADV_HUGEPAGE); }
+#endif
+    *out = Arena{p, bytes, true, false};
+    return true;
+#else
+    (void)huge_pages;
+    void* p = std::malloc(bytes);
+    if (p == nullptr) { return false; }
+    *out = Arena{p, bytes, false, false};
+    return true;
+#endif
+  }
+
+  static void Release(Arena* arena) {
+    if (arena->ptr == nullptr) { return; }
+#if defined(__unix__) || defined(__APPLE__)
+    if (arena->mapped) {
+      munmap(arena->ptr, arena->bytes);
+    } else {
+      std::free(arena->ptr);
+    }
+#else
+    std::free(arena->ptr);
+#endif
+    *arena = Arena{};
+  }
+};
+
+}  // namespace dbpp
@@ -0,0 +1,168 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3OpenOptions -- open flags and connection pragmas.
+//
+// Design:
+//   - One struct for everything usually applied by hand after open:
+//     sqlite3_open_v2 flags plus journal_mode, synchronous, mmap_size,
+//     cache_size, temp_store, locking_mode and page_size
+//   - Per-connection lookaside size, for connections owned by one thread
+//   - Every field defaults to "leave SQLite's default", so
+//     Sqlite3OpenOptions{} behaves exactly like sqlite3_open()
+//   - Named presets for the common deployments; FromName() maps a config
+//     string ("durable", "throughput", "read-only-replica") to a preset
+//   - Plain aggregate, applied by Sqlite3Db::Open(path, opts)
+//   - journal_mode is read back after the pragma: Open() fails when SQLite
+//     keeps another mode (WAL on :memory: or a read-only file)
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace dbpp {
+
+enum class Sqlite3ThreadMode : uint8_t {
+  kDefault = 0,     // Compile-time / sqlite3_config default
+  kMultiThread,     // SQLITE_OPEN_NOMUTEX: one thread per connection
+  kSerialized       // SQLITE_OPEN_FULLMUTEX
+};
+
+enum class Sqlite3JournalMode : uint8_t {
+  kDefault = 0,
+  kDelete,
+  kTruncate,
+  kPersist,
+  kMemory,
+  kWal,
+  kOff
+};
+
+enum class Sqlite3Synchronous : uint8_t {
+  kDefault = 0,
+  kOff,
+  kNormal,
+  kFull,
+  kExtra
+};
+
+enum class Sqlite3TempStore : uint8_t {
+  kDefault = 0,
+  kFile,
+  kMemory
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3OpenOptions
+// ---------------------------------------------------------------------------
+
+struct Sqlite3OpenOptions {
+  // --- sqlite3_open_v2 flags ---
+  bool read_only = false;  // SQLITE_OPEN_READONLY
+  bool create = true;      // SQLITE_OPEN_CREATE (ignored when read_only)
+  bool uri = false;        // SQLITE_OPEN_URI: accept "file:...?mode=ro"
+  Sqlite3ThreadMode thread_mode = Sqlite3ThreadMode::kDefault;
+
+  // --- SQLITE_DBCONFIG_LOOKASIDE (per connection, before any pragma) ---
+  int32_t lookaside_slot_size = -1;  // Bytes, multiple of 8; -1 = default
+  int32_t lookaside_slots = -1;      // 0 disables lookaside; -1 = default
+
+  // --- Pragmas (applied in this order) ---
+  uint32_t page_size = 0;          // Bytes; 0 = default. New files only
+  bool exclusive_locking = false;  // locking_mode=EXCLUSIVE
+  Sqlite3JournalMode journal_mode = Sqlite3JournalMode::kDefault;
+  Sqlite3Synchronous synchronous = Sqlite3Synchronous::kDefault;
+  int32_t cache_size = 0;   // SQLite semantics: >0 pages, <0 KiB; 0 = default
+  int64_t mmap_size = -1;   // Bytes; -1 = default, 0 disables mmap
+  Sqlite3TempStore temp_store = Sqlite3TempStore::kDefault;
+
+  // --- Presets ---
+
+  /// WAL + synchronous=FULL: no committed transaction is lost on power
+  /// failure.
+  static Sqlite3OpenOptions Durable() {
+    Sqlite3OpenOptions o;
+    o.journal_mode = Sqlite3JournalMode::kWal;
+    o.synchronous = Sqlite3Synchronous::kFull;
+    return o;
+  }
+
+  /// WAL + synchronous=NORMAL, 64 MiB page cache, 256 MiB mmap and memory
+  /// temp store. Consistent after a crash, but the last transactions may
+  /// roll back on power failure.
+  static Sqlite3OpenOptions Throughput() {
+    Sqlite3OpenOptions o;
+    o.journal_mode = Sqlite3JournalMode::kWal;
+    o.synchronous = Sqlite3Synchronous::kNormal;
+    o.cache_size = -64 * 1024;
+    o.mmap_size = int64_t{256} << 20;
+    o.temp_store = Sqlite3TempStore::kMemory;
+    return o;
+  }
+
+  /// Read-only connection for a reader that never writes: no mutexes,
+  /// 64 MiB page cache, 256 MiB mmap, memory temp store.
+  static Sqlite3OpenOptions ReadOnlyReplica() {
+    Sqlite3OpenOptions o;
+    o.read_only = true;
+    o.thread_mode = Sqlite3ThreadMode::kMultiThread;
+    o.cache_size = -64 * 1024;
+    o.mmap_size = int64_t{256} << 20;
+    o.temp_store = Sqlite3TempStore::kMemory;
+    return o;
+  }
+
+  /// Look up a preset by name: "default", "durable", "throughput" or
+  /// "read-only-replica". Returns false (and leaves *out alone) if unknown.
+  static bool FromName(const char* name, Sqlite3OpenOptions* out) {
+    if (name == nullptr || out == nullptr) { return false; }
+    if (std::strcmp(name, "default") == 0) {
+      *out = Sqlite3OpenOptions{};
+    } else if (std::strcmp(name, "durable") == 0) {
+      *out = Durable();
+    } else if (std::strcmp(name, "throughput") == 0) {
+      *out = Throughput();
+    } else if (std::strcmp(name, "read-only-replica") == 0) {
+      *out = ReadOnlyReplica();
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Pragma value names
+// ---------------------------------------------------------------------------
+
+inline const char* JournalModeName(Sqlite3JournalMode m) {
+  switch (m) {
+    case Sqlite3JournalMode::kDelete:   return "DELETE";
+    case Sqlite3JournalMode::kTruncate: return "TRUNCATE";
+    case Sqlite3JournalMode::kPersist:  return "PERSIST";
+    case Sqlite3JournalMode::kMemory:   return "MEMORY";
+    case Sqlite3JournalMode::kWal:      return "WAL";
+    case Sqlite3JournalMode::kOff:      return "OFF";
+    default:                            return nullptr;
+  }
+}
+
+inline const char* SynchronousName(Sqlite3Synchronous s) {
+  switch (s) {
+    case Sqlite3Synchronous::kOff:    return "OFF";
+    case Sqlite3Synchronous::kNormal: return "NORMAL";
+    case Sqlite3Synchronous::kFull:   return "FULL";
+    case Sqlite3Synchronous::kExtra:  return "EXTRA";
+    default:                          return nullptr;
+  }
+}
+
+inline const char* TempStoreName(Sqlite3TempStore t) {
+  switch (t) {
+    case Sqlite3TempStore::kFile:   return "FILE";
+    case Sqlite3TempStore::kMemory: return "MEMORY";
+    default:                        return nullptr;
+  }
+}
+
+}  // namespace dbpp
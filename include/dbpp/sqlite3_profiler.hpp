@@ -0,0 +1,329 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Profiler -- per-SQL latency and execution statistics.
+//
+// Design:
+//   - Fed by sqlite3_trace_v2(SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW):
+//     one PROFILE event per statement run carries its wall time in ns
+//   - On each PROFILE event the sqlite3_stmt_status counters (FULLSCAN_STEP,
+//     SORT, AUTOINDEX, VM_STEP) are read and reset, so they are per run
+//   - Keyed by unexpanded SQL text (sqlite3_sql), so parameterized
+//     statements aggregate across bindings
+//   - Latency histogram with log2(ns) buckets: fixed size, no allocation
+//     on the hot path; percentiles are bucket upper bounds
+//   - Bounded: at most max_sql distinct statements are tracked, later ones
+//     only bump a dropped counter
+//   - Chained hash index over a growable entry array, no STL containers
+//   - Owned by Sqlite3Db; not thread-safe (same rule as the connection).
+//     When disabled no trace callback is registered, so the cost is zero
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "sqlite3.h"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// Sqlite3SqlStats -- aggregated counters for one SQL text
+// ---------------------------------------------------------------------------
+
+struct Sqlite3SqlStats {
+  static constexpr uint32_t kBuckets = 40;  // bucket b: [2^b, 2^(b+1)) ns
+
+  const char* sql = nullptr;  // Owned by the profiler
+  uint64_t calls = 0;
+  uint64_t rows = 0;
+  uint64_t total_ns = 0;
+  uint64_t min_ns = 0;
+  uint64_t max_ns = 0;
+  uint64_t fullscan_steps = 0;
+  uint64_t sorts = 0;
+  uint64_t autoindexes = 0;
+  uint64_t vm_steps = 0;
+  uint32_t histogram[kBuckets] = {};
+
+  double AvgNs() const {
+    return calls > 0 ? static_cast<double>(total_ns) / calls : 0.0;
+  }
+
+  /// Latency at percentile p in (0, 100], as the upper bound of the
+  /// histogram bucket holding it (capped at max_ns).
+  uint64_t PercentileNs(double p) const {
+    if (calls == 0) { return 0; }
+    uint64_t rank = static_cast<uint64_t>(p / 100.0 * calls + 0.999999);
+    if (rank == 0) { rank = 1; }
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < kBuckets; ++b) {
+      seen += histogram[b];
+      if (seen >= rank) {
+        return std::min(uint64_t{1} << (b + 1), max_ns);
+      }
+    }
+    return max_ns;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3ProfilerOptions
+// ---------------------------------------------------------------------------
+
+struct Sqlite3ProfilerOptions {
+  uint32_t max_sql = 1024;  // Distinct SQL texts tracked
+  bool count_rows = true;   // Also register SQLITE_TRACE_ROW
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3Profiler
+// ---------------------------------------------------------------------------
+
+class Sqlite3Profiler {
+ public:
+  explicit Sqlite3Profiler(const Sqlite3ProfilerOptions& opts)
+      : opts_(opts) {
+    num_buckets_ = 16;
+    while (num_buckets_ < opts_.max_sql * 2) { num_buckets_ <<= 1; }
+    buckets_ = new int32_t[num_buckets_];
+    for (uint32_t i = 0; i < num_buckets_; ++i) { buckets_[i] = kNil; }
+  }
+
+  ~Sqlite3Profiler() {
+    Reset();
+    delete[] entries_;
+    delete[] buckets_;
+  }
+
+  // No copy, no move (the trace callback holds a stable pointer)
+  Sqlite3Profiler(const Sqlite3Profiler&) = delete;
+  Sqlite3Profiler& operator=(const Sqlite3Profiler&) = delete;
+
+  /// Register the trace callback on `db`.
+  void Attach(sqlite3* db) {
+    if (db == nullptr) { return; }
+    uint32_t mask = SQLITE_TRACE_PROFILE;
+    if (opts_.count_rows) { mask |= SQLITE_TRACE_ROW; }
+    sqlite3_trace_v2(db, mask, &Sqlite3Profiler::TraceCallback, this);
+  }
+
+  /// Unregister any trace callback on `db`.
+  static void Detach(sqlite3* db) {
+    if (db != nullptr) { sqlite3_trace_v2(db, 0, nullptr, nullptr); }
+  }
+
+  /// Number of distinct SQL texts tracked.
+  uint32_t Size() const { return size_; }
+
+  /// Statement runs not recorded because max_sql was reached.
+  uint64_t Dropped() const { return dropped_; }
+
+  /// Copy up to `max_entries` stats into `out`, by total time descending.
+  /// The sql pointers stay valid until Reset() or profiler destruction.
+  /// Returns the number of entries written.
+  uint32_t Snapshot(Sqlite3SqlStats* out, uint32_t max_entries) const {
+    if (out == nullptr || max_entries == 0 || size_ == 0) { return 0; }
+    int32_t* order = new int32_t[size_];
+    for (uint32_t i = 0; i < size_; ++i) { order[i] = static_cast<int32_t>(i); }
+    uint32_t n = std::min(max_entries, size_);
+    std::partial_sort(order, order + n, order + size_,
+                      [this](int32_t a, int32_t b) {
+                        return entries_[a].stats.total_ns >
+                               entries_[b].stats.total_ns;
+                      });
+    for (uint32_t i = 0; i < n; ++i) { out[i] = entries_[order[i]].stats; }
+    delete[] order;
+    return n;
+  }
+
+  /// Drop all statistics.
+  void Reset() {
+    for (uint32_t i = 0; i < size_; ++i) {
+      delete[] entries_[i].sql;
+      entries_[i] = Entry{};
+    }
+    for (uint32_t i = 0; i < num_buckets_; ++i) { buckets_[i] = kNil; }
+    for (Pending& p : pending_) { p = Pending{}; }
+    size_ = 0;
+    dropped_ = 0;
+  }
+
+  /// Print the `top_n` statements by total time as a text table.
+  void Dump(std::FILE* out, uint32_t top_n = 20) const {
+    if (out == nullptr) { return; }
+    std::fprintf(out, "%10s %12s %10s %10s %10s %10s %10s %6s %7s %12s  %s\n",
+                 "calls", "total_ms", "avg_us", "p50_us", "p99_us", "rows",
+                 "fullscan", "sorts", "autoidx", "vm_steps", "sql");
+    if (top_n == 0 || size_ == 0) { return; }
+    Sqlite3SqlStats* top = new Sqlite3SqlStats[std::min(top_n, size_)];
+    uint32_t n = Snapshot(top, top_n);
+    for (uint32_t i = 0; i < n; ++i) {
+      const Sqlite3SqlStats& s = top[i];
+      std::fprintf(out,
+                   "%10llu %12.3f %10.1f %10.1f %10.1f %10llu %10llu %6llu "
+                   "%7llu %12llu  %.120s\n",
+                   static_cast<unsigned long long>(s.calls),
+                   static_cast<double>(s.total_ns) / 1e6, s.AvgNs() / 1e3,
+                   static_cast<double>(s.PercentileNs(50.0)) / 1e3,
+                   static_cast<double>(s.PercentileNs(99.0)) / 1e3,
+                   static_cast<unsigned long long>(s.rows),
+                   static_cast<unsigned long long>(s.fullscan_steps),
+                   static_cast<unsigned long long>(s.sorts),
+                   static_cast<unsigned long long>(s.autoindexes),
+                   static_cast<unsigned long long>(s.vm_steps), s.sql);
+    }
+    if (dropped_ > 0) {
+      std::fprintf(out, "(%llu runs of untracked SQL, max_sql=%u)\n",
+                   static_cast<unsigned long long>(dropped_), opts_.max_sql);
+    }
+    delete[] top;
+  }
+
+ private:
+  static constexpr int32_t kNil = -1;
+  static constexpr uint32_t kMaxPending = 8;  // Concurrently open statements
+
+  struct Entry {
+    Sqlite3SqlStats stats;
+    char* sql = nullptr;
+    uint64_t hash = 0;
+    int32_t chain = kNil;
+  };
+
+  /// Rows seen for a statement whose PROFILE event has not fired yet.
+  struct Pending {
+    sqlite3_stmt* stmt = nullptr;
+    uint64_t rows = 0;
+  };
+
+  static int TraceCallback(unsigned type, void* ctx, void* p, void* x) {
+    Sqlite3Profiler* self = static_cast<Sqlite3Profiler*>(ctx);
+    sqlite3_stmt* stmt = static_cast<sqlite3_stmt*>(p);
+    if (type == SQLITE_TRACE_ROW) {
+      self->OnRow(stmt);
+    } else if (type == SQLITE_TRACE_PROFILE) {
+      self->OnProfile(stmt, *static_cast<sqlite3_int64*>(x));
+    }
+    return 0;
+  }
+
+  void OnRow(sqlite3_stmt* stmt) {
+    Pending* empty = nullptr;
+    for (Pending& p : pending_) {
+      if (p.stmt == stmt) {
+        ++p.rows;
+        return;
+      }
+      if (p.stmt == nullptr && empty == nullptr) { empty = &p; }
+    }
+    if (empty != nullptr) {
+      empty->stmt = stmt;
+      empty->rows = 1;
+    }
+  }
+
+  uint64_t TakeRows(sqlite3_stmt* stmt) {
+    for (Pending& p : pending_) {
+      if (p.stmt == stmt) {
+        uint64_t rows = p.rows;
+        p = Pending{};
+        return rows;
+      }
+    }
+    return 0;
+  }
+
+  void OnProfile(sqlite3_stmt* stmt, sqlite3_int64 elapsed_ns) {
+    uint64_t rows = TakeRows(stmt);
+    const char* sql = sqlite3_sql(stmt);
+    if (sql == nullptr) { return; }
+    Entry* e = Find(sql);
+    if (e == nullptr) {
+      ++dropped_;
+      return;
+    }
+
+    Sqlite3SqlStats& s = e->stats;
+    uint64_t ns = elapsed_ns > 0 ? static_cast<uint64_t>(elapsed_ns) : 0;
+    if (s.calls == 0 || ns < s.min_ns) { s.min_ns = ns; }
+    if (ns > s.max_ns) { s.max_ns = ns; }
+    ++s.calls;
+    s.total_ns += ns;
+    s.rows += rows;
+    ++s.histogram[Bucket(ns)];
+    s.fullscan_steps += static_cast<uint64_t>(
+        sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_FULLSCAN_STEP, 1));
+    s.sorts += static_cast<uint64_t>(
+        sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_SORT, 1));
+    s.autoindexes += static_cast<uint64_t>(
+        sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_AUTOINDEX, 1));
+    s.vm_steps += static_cast<uint64_t>(
+        sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_VM_STEP, 1));
+  }
+
+  /// Entry for `sql`, created on first use; nullptr when full.
+  Entry* Find(const char* sql) {
+    uint64_t hash = Hash(sql);
+    int32_t& bucket = buckets_[hash & (num_buckets_ - 1)];
+    for (int32_t i = bucket; i != kNil; i = entries_[i].chain) {
+      if (entries_[i].hash == hash && std::strcmp(entries_[i].sql, sql) == 0) {
+        return &entries_[i];
+      }
+    }
+    if (size_ >= opts_.max_sql) { return nullptr; }
+    if (size_ == capacity_) { Grow(); }
+
+    size_t len = std::strlen(sql);
+    Entry& e = entries_[size_];
+    e.sql = new char[len + 1];
+    std::memcpy(e.sql, sql, len + 1);
+    e.stats.sql = e.sql;
+    e.hash = hash;
+    e.chain = bucket;
+    bucket = static_cast<int32_t>(size_);
+    ++size_;
+    return &e;
+  }
+
+  void Grow() {
+    uint32_t cap = (capacity_ == 0) ? 16 : capacity_ * 2;
+    if (cap > opts_.max_sql) { cap = opts_.max_sql; }
+    Entry* grown = new Entry[cap];
+    for (uint32_t i = 0; i < size_; ++i) { grown[i] = entries_[i]; }
+    delete[] entries_;
+    entries_ = grown;
+    capacity_ = cap;
+  }
+
+  static uint32_t Bucket(uint64_t ns) {
+    uint32_t b = 0;
+    while (ns > 1 && b + 1 < Sqlite3SqlStats::kBuckets) {
+      ns >>= 1;
+      ++b;
+    }
+    return b;
+  }
+
+  // FNV-1a, 64-bit
+  static uint64_t Hash(const char* s) {
+    uint64_t h = 14695981039346656037ULL;
+    while (*s != '\0') {
+      h ^= static_cast<uint8_t>(*s++);
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  Sqlite3ProfilerOptions opts_;
+  Entry* entries_ = nullptr;
+  int32_t* buckets_ = nullptr;
+  uint32_t size_ = 0;
+  uint32_t capacity_ = 0;
+  uint32_t num_buckets_ = 0;
+  uint64_t dropped_ = 0;
+  Pending pending_[kMaxPending];
+};
+
+}  // namespace dbpp
@@ -5,22 +5,35 @@
 // Design:
 //   - Wraps sqlite3_stmt* with RAII
 //   - Move-only (no copy)
-//   - Forward iteration via Eof()/NextRow()
+//   - Forward iteration via Eof()/NextRow(); a failed step also ends the
+//     rows but is kept in StepStatus(), so a truncated result (e.g. kBusy)
+//     is not mistaken for the end of the data
 //   - Type-safe field accessors with null defaults
+//   - Statements borrowed from a Sqlite3StmtCache are returned on Finalize()
+//   - As<Ts...>() gives a validated, compile-time typed row cursor
+//   - Named access goes through a lazily built ColumnIndex; Column(name)
+//     gives a ColumnRef for the row loop
 
 #pragma once
 
 #include <cstdint>
 #include <cstring>
+#include <string>
+#include <utility>
 
 #include "sqlite3.h"
 
+#include "dbpp/column_index.hpp"
 #include "dbpp/error.hpp"
+#include "dbpp/sqlite3_busy.hpp"
+#include "dbpp/sqlite3_stmt_cache.hpp"
+#include "dbpp/typed_cursor.hpp"
 
 namespace dbpp {
 
 class Sqlite3Db;
 class Sqlite3Statement;
+class Sqlite3TypedResultSet;
 
 // ---------------------------------------------------------------------------
 // Sqlite3Query
@@ -36,12 +49,17 @@ class Sqlite3Query {
   Sqlite3Query(Sqlite3Query&& other) noexcept
       : db_(other.db_),
         stmt_(other.stmt_),
+        cache_(other.cache_),
         eof_(other.eof_),
-        num_fields_(other.num_fields_) {
+        num_fields_(other.num_fields_),
+        status_(other.status_),
+        name_index_(std::move(other.name_index_)) {
     other.db_ = nullptr;
     other.stmt_ = nullptr;
+    other.cache_ = nullptr;
     other.eof_ = true;
     other.num_fields_ = 0;
+    other.status_ = Status::Ok();
   }
 
   Sqlite3Query& operator=(Sqlite3Query&& other) noexcept {
@@ -49,12 +67,17 @@ class Sqlite3Query {
       Finalize();
       db_ = other.db_;
       stmt_ = other.stmt_;
+      cache_ = other.cache_;
       eof_ = other.eof_;
       num_fields_ = other.num_fields_;
+      status_ = other.status_;
+      name_index_ = std::move(other.name_index_);
       other.db_ = nullptr;
       other.stmt_ = nullptr;
+      other.cache_ = nullptr;
       other.eof_ = true;
       other.num_fields_ = 0;
+      other.status_ = Status::Ok();
     }
     return *this;
   }
@@ -68,14 +91,16 @@ class Sqlite3Query {
   int32_t NumFields() const { return num_fields_; }
 
   int32_t FieldIndex(const char* name) const {
-    if (stmt_ == nullptr || name == nullptr) { return -1; }
-    for (int32_t i = 0; i < num_fields_; ++i) {
-      const char* col_name = sqlite3_column_name(stmt_, i);
-      if (col_name != nullptr && std::strcmp(name, col_name) == 0) {
-        return i;
-      }
-    }
-    return -1;
+    if (stmt_ == nullptr) { return -1; }
+    sqlite3_stmt* stmt = stmt_;
+    return name_index_.Find(name, num_fields_, [stmt](int32_t i) {
+      return sqlite3_column_name(stmt, i);
+    });
+  }
+
+  /// Resolve `name` once, for positional access inside a row loop.
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
   }
 
   const char* FieldName(int32_t col) const {
@@ -169,28 +194,64 @@ class Sqlite3Query {
   void NextRow() {
     if (stmt_ == nullptr) { return; }
     int32_t rc = sqlite3_step(stmt_);
-    if (rc == SQLITE_DONE) {
-      eof_ = true;
-    } else if (rc != SQLITE_ROW) {
-      eof_ = true;
-    }
+    if (rc == SQLITE_ROW) { return; }
+    eof_ = true;
+    if (rc != SQLITE_DONE) { status_ = Status(Sqlite3ErrorCode(rc), rc); }
+  }
+
+  /// Why Eof() became true: ok at the real end of the rows, otherwise the
+  /// failed step's code (kBusy, kIoError, ...) -- the rows seen so far
+  /// are then only a prefix of the result. Check it before Finalize().
+  Status StepStatus() const { return status_; }
+
+  /// StepStatus() as an Error with SQLite's text for the result code.
+  Error ToError() const {
+    Error e;
+    if (!status_.ok()) { e.Set(status_.code, sqlite3_errstr(status_.native)); }
+    return e;
+  }
+
+  // --- Typed cursor ---
+
+  /// Validated typed view of the remaining rows, e.g.
+  ///   for (auto row : q.As<int64_t, TextView, double>()) { ... }
+  template <typename... Ts>
+  TypedCursor<Sqlite3Query, Ts...> As(Error* out_error = nullptr) & {
+    return TypedCursor<Sqlite3Query, Ts...>(*this, out_error);
   }
 
+  /// Same, taking ownership of a temporary query.
+  template <typename... Ts>
+  TypedCursor<Sqlite3Query, Ts...> As(Error* out_error = nullptr) && {
+    return TypedCursor<Sqlite3Query, Ts...>(std::move(*this), out_error);
+  }
+
+  sqlite3_stmt* Handle() const { return stmt_; }
+
   void Finalize() {
     if (stmt_ != nullptr) {
-      sqlite3_finalize(stmt_);
+      if (cache_ != nullptr) {
+        cache_->Put(stmt_);
+      } else {
+        sqlite3_finalize(stmt_);
+      }
       stmt_ = nullptr;
     }
+    cache_ = nullptr;
     eof_ = true;
     num_fields_ = 0;
+    status_ = Status::Ok();
+    name_index_.Clear();
   }
 
  private:
   friend class Sqlite3Db;
   friend class Sqlite3Statement;
+  friend class Sqlite3TypedResultSet;
 
-  Sqlite3Query(sqlite3* db, sqlite3_stmt* stmt, bool eof)
-      : db_(db), stmt_(stmt), eof_(eof) {
+  Sqlite3Query(sqlite3* db, sqlite3_stmt* stmt, bool eof,
+               Sqlite3StmtCache* cache = nullptr)
+      : db_(db), stmt_(stmt), cache_(cache), eof_(eof) {
     if (stmt_ != nullptr) {
       num_fields_ = sqlite3_column_count(stmt_);
     }
@@ -198,8 +259,99 @@ class Sqlite3Query {
 
   sqlite3* db_ = nullptr;
   sqlite3_stmt* stmt_ = nullptr;
+  Sqlite3StmtCache* cache_ = nullptr;  // Owner of stmt_ when not null
   bool eof_ = true;
   int32_t num_fields_ = 0;
+  Status status_;  // Set when a step fails mid-iteration
+  mutable ColumnIndex name_index_;  // Built on first FieldIndex()
+};
+
+// ---------------------------------------------------------------------------
+// ColumnAccess<Sqlite3Query> -- direct sqlite3_column_* decoding
+// ---------------------------------------------------------------------------
+
+template <>
+struct ColumnAccess<Sqlite3Query> {
+  // NULL is accepted for every type and decodes to the type's default.
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value, bool>::type
+  Check(const Sqlite3Query& q, int32_t col, TypeTag<T>) {
+    int32_t type = sqlite3_column_type(q.Handle(), col);
+    return type == SQLITE_INTEGER || type == SQLITE_NULL;
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+  Check(const Sqlite3Query& q, int32_t col, TypeTag<T>) {
+    int32_t type = sqlite3_column_type(q.Handle(), col);
+    return type == SQLITE_FLOAT || type == SQLITE_INTEGER ||
+           type == SQLITE_NULL;
+  }
+
+  template <typename T>
+  static typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+  Check(const Sqlite3Query& q, int32_t col, TypeTag<T>) {
+    int32_t type = sqlite3_column_type(q.Handle(), col);
+    return type == SQLITE_TEXT || type == SQLITE_NULL ||
+           (type == SQLITE_BLOB && std::is_same<T, BlobView>::value);
+  }
+
+  template <typename T>
+  static bool Check(const Sqlite3Query& q, int32_t col,
+                    TypeTag<Nullable<T>>) {
+    return Check(q, col, TypeTag<T>{});
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value>::type
+  Read(const Sqlite3Query& q, int32_t col, T& out) {
+    out = static_cast<T>(sqlite3_column_int64(q.Handle(), col));
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  Read(const Sqlite3Query& q, int32_t col, T& out) {
+    out = static_cast<T>(sqlite3_column_double(q.Handle(), col));
+  }
+
+  static void Read(const Sqlite3Query& q, int32_t col, const char*& out) {
+    const unsigned char* p = sqlite3_column_text(q.Handle(), col);
+    out = (p != nullptr) ? reinterpret_cast<const char*>(p) : "";
+  }
+
+  static void Read(const Sqlite3Query& q, int32_t col, TextView& out) {
+    // Pointer first, then length (sqlite3 conversion rules)
+    const unsigned char* p = sqlite3_column_text(q.Handle(), col);
+    out = TextView(reinterpret_cast<const char*>(p),
+                   sqlite3_column_bytes(q.Handle(), col));
+  }
+
+  static void Read(const Sqlite3Query& q, int32_t col, BlobView& out) {
+    const void* p = sqlite3_column_blob(q.Handle(), col);
+    out = BlobView(p, sqlite3_column_bytes(q.Handle(), col));
+  }
+
+  static void Read(const Sqlite3Query& q, int32_t col, std::string& out) {
+    TextView v;
+    Read(q, col, v);
+    out.assign(v.data != nullptr ? v.data : "", static_cast<size_t>(v.size));
+  }
+
+#if __cplusplus >= 201703L
+  static void Read(const Sqlite3Query& q, int32_t col,
+                   std::string_view& out) {
+    TextView v;
+    Read(q, col, v);
+    out = std::string_view(v.data, static_cast<size_t>(v.size));
+  }
+#endif
+
+  template <typename T>
+  static void Read(const Sqlite3Query& q, int32_t col, Nullable<T>& out) {
+    out.is_null = sqlite3_column_type(q.Handle(), col) == SQLITE_NULL;
+    if (!out.is_null) { Read(q, col, out.value); }
+  }
 };
 
 }  // namespace dbpp
@@ -7,14 +7,17 @@
 //   - Move-only (no copy)
 //   - Supports SeekRow() for random access
 //   - Forward iteration via Eof()/NextRow()
+//   - Named access through a lazily built ColumnIndex / ColumnRef
 
 #pragma once
 
 #include <cstdint>
 #include <cstring>
+#include <utility>
 
 #include "sqlite3.h"
 
+#include "dbpp/column_index.hpp"
 #include "dbpp/error.hpp"
 
 namespace dbpp {
@@ -36,7 +39,8 @@ class Sqlite3ResultSet {
       : results_(other.results_),
         num_rows_(other.num_rows_),
         num_cols_(other.num_cols_),
-        current_row_(other.current_row_) {
+        current_row_(other.current_row_),
+        name_index_(std::move(other.name_index_)) {
     other.results_ = nullptr;
     other.num_rows_ = 0;
     other.num_cols_ = 0;
@@ -50,6 +54,7 @@ class Sqlite3ResultSet {
       num_rows_ = other.num_rows_;
       num_cols_ = other.num_cols_;
       current_row_ = other.current_row_;
+      name_index_ = std::move(other.name_index_);
       other.results_ = nullptr;
       other.num_rows_ = 0;
       other.num_cols_ = 0;
@@ -68,13 +73,15 @@ class Sqlite3ResultSet {
   uint32_t NumRows() const { return num_rows_; }
 
   int32_t FieldIndex(const char* name) const {
-    if (results_ == nullptr || name == nullptr) { return -1; }
-    for (int32_t i = 0; i < num_cols_; ++i) {
-      if (results_[i] != nullptr && std::strcmp(name, results_[i]) == 0) {
-        return i;
-      }
-    }
-    return -1;
+    if (results_ == nullptr) { return -1; }
+    char** names = results_;  // Row 0 of the table holds the names
+    return name_index_.Find(name, num_cols_,
+                            [names](int32_t i) { return names[i]; });
+  }
+
+  /// Resolve `name` once, for positional access inside a row loop.
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
   }
 
   const char* FieldName(int32_t col) const {
@@ -135,6 +142,7 @@ class Sqlite3ResultSet {
     num_rows_ = 0;
     num_cols_ = 0;
     current_row_ = 0;
+    name_index_.Clear();
   }
 
  private:
@@ -158,6 +166,7 @@ class Sqlite3ResultSet {
   uint32_t num_rows_ = 0;
   int32_t num_cols_ = 0;
   uint32_t current_row_ = 0;
+  mutable ColumnIndex name_index_;  // Built on first FieldIndex()
 };
 
 }  // namespace dbpp
@@ -0,0 +1,257 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Script -- a multi-statement SQL script compiled once.
+//
+// Design:
+//   - Split with the sqlite3_prepare_v3 pzTail loop (PREPARE_PERSISTENT)
+//     once; Run() re-executes the kept statements in order, so repeated
+//     scripts skip the parser that sqlite3_exec runs on every call
+//   - A statement that cannot be prepared yet (it uses a table an earlier
+//     statement creates) is prepared when Run() first reaches it, like
+//     sqlite3_exec would
+//   - Per-statement parameters via BindAll(index, args...); bindings stay
+//     across runs until re-bound
+//   - Per-statement change counts from the last Run(); rows returned by a
+//     statement (PRAGMA, SELECT) are stepped through and discarded
+//   - Stops at the first failing statement, naming its index; there is no
+//     implicit transaction (put BEGIN/COMMIT in the script)
+//   - Lock conflicts go through the connection's busy retry if enabled
+//   - Move-only; must not outlive the Sqlite3Db that compiled it
+//
+// Usage:
+//   Sqlite3Script tick = db.CompileScript(
+//       "DELETE FROM samples WHERE ts < ?;"
+//       "INSERT INTO rollup SELECT ...;"
+//       "PRAGMA incremental_vacuum;", &err);
+//   tick.BindAll(0, cutoff);
+//   tick.Run(&err);
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "sqlite3.h"
+
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_busy.hpp"
+#include "dbpp/sqlite3_statement.hpp"
+
+namespace dbpp {
+
+class Sqlite3Db;
+
+// ---------------------------------------------------------------------------
+// Sqlite3Script
+// ---------------------------------------------------------------------------
+
+class Sqlite3Script {
+ public:
+  Sqlite3Script() = default;
+
+  ~Sqlite3Script() { Finalize(); }
+
+  // Move
+  Sqlite3Script(Sqlite3Script&& other) noexcept { MoveFrom(other); }
+
+  Sqlite3Script& operator=(Sqlite3Script&& other) noexcept {
+    if (this != &other) {
+      Finalize();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  Sqlite3Script(const Sqlite3Script&) = delete;
+  Sqlite3Script& operator=(const Sqlite3Script&) = delete;
+
+  bool Valid() const { return db_ != nullptr; }
+
+  /// Statements compiled so far (empty statements are not counted).
+  uint32_t Size() const { return count_; }
+
+  /// True once the whole text is compiled; until then the remaining
+  /// statements are prepared by the next Run().
+  bool Complete() const { return sql_ == nullptr || sql_[tail_] == '\0'; }
+
+  // --- Execute ---
+
+  /// Execute every statement in order. Returns the total change count,
+  /// or -1 at the first failure (later statements do not run).
+  int32_t Run(Error* out_error = nullptr) {
+    if (db_ == nullptr) {
+      if (out_error != nullptr) {
+        out_error->Set(ErrorCode::kMisuse, "Script not compiled");
+      }
+      return -1;
+    }
+    for (uint32_t i = 0; i < count_; ++i) { entries_[i].changes = -1; }
+    int32_t total = 0;
+    for (uint32_t i = 0;; ++i) {
+      if (i == count_) {
+        if (Complete()) { break; }
+        Error err = CompileNext();
+        if (!err.ok()) {
+          if (out_error != nullptr) {
+            out_error->SetFormat(err.code, "statement %u: %s", i,
+                                 err.message);
+          }
+          return -1;
+        }
+        if (i == count_) { break; }  // Only blanks/comments were left
+      }
+      int32_t changes = StepOne(i, out_error);
+      if (changes < 0) { return -1; }
+      total += changes;
+    }
+    return total;
+  }
+
+  /// Rows changed by statement `index` in the last Run(): 0 for DDL and
+  /// queries, -1 if it did not run.
+  int32_t Changes(uint32_t index) const {
+    return index < count_ ? entries_[index].changes : -1;
+  }
+
+  // --- Bind ---
+
+  /// Bind args to parameters 1..N of statement `index` (0-based, counted
+  /// as in Size()); text/blob are copied.
+  template <typename... Args>
+  Status BindAll(uint32_t index, const Args&... args) {
+    if (index >= count_) { return Status(ErrorCode::kRange); }
+    Sqlite3Statement binder(db_, entries_[index].stmt);
+    Status st = binder.BindAll(args...);
+    binder.stmt_ = nullptr;  // Still ours
+    return st;
+  }
+
+  // --- Access ---
+
+  /// SQL text of statement `index`, or nullptr.
+  const char* Sql(uint32_t index) const {
+    return index < count_ ? sqlite3_sql(entries_[index].stmt) : nullptr;
+  }
+
+  sqlite3_stmt* Handle(uint32_t index) const {
+    return index < count_ ? entries_[index].stmt : nullptr;
+  }
+
+  void Finalize() {
+    for (uint32_t i = 0; i < count_; ++i) {
+      sqlite3_finalize(entries_[i].stmt);
+    }
+    delete[] entries_;
+    delete[] sql_;
+    entries_ = nullptr;
+    sql_ = nullptr;
+    count_ = 0;
+    capacity_ = 0;
+    tail_ = 0;
+    db_ = nullptr;
+    retry_ = nullptr;
+  }
+
+ private:
+  friend class Sqlite3Db;
+
+  struct Entry {
+    sqlite3_stmt* stmt;
+    int32_t changes;
+  };
+
+  /// Keep a copy of `sql` and prepare as many statements as possible.
+  Sqlite3Script(sqlite3* db, const char* sql, Sqlite3BusyRetry* retry)
+      : db_(db), retry_(retry) {
+    size_t len = std::strlen(sql);
+    sql_ = new char[len + 1];
+    std::memcpy(sql_, sql, len + 1);
+    while (!Complete() && CompileNext().ok()) {}
+  }
+
+  /// Prepare the statement at tail_ and append it; skips empty ones. On
+  /// failure tail_ stays put, so the next Run() tries again.
+  Error CompileNext() {
+    while (!Complete()) {
+      const char* start = sql_ + tail_;
+      const char* tail = nullptr;
+      sqlite3_stmt* stmt = nullptr;
+      int32_t rc = sqlite3_prepare_v3(db_, start, -1,
+                                      SQLITE_PREPARE_PERSISTENT, &stmt,
+                                      &tail);
+      if (rc != SQLITE_OK) {
+        return Error::Make(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
+      }
+      tail_ = static_cast<uint32_t>(tail - sql_);
+      if (stmt != nullptr) {
+        Append(stmt);
+        return Error::Ok();
+      }
+    }
+    return Error::Ok();
+  }
+
+  void Append(sqlite3_stmt* stmt) {
+    if (count_ == capacity_) {
+      uint32_t capacity = capacity_ == 0 ? 8 : capacity_ * 2;
+      Entry* grown = new Entry[capacity];
+      for (uint32_t i = 0; i < count_; ++i) { grown[i] = entries_[i]; }
+      delete[] entries_;
+      entries_ = grown;
+      capacity_ = capacity;
+    }
+    entries_[count_++] = Entry{stmt, -1};
+  }
+
+  /// Run statement `index` to completion. Returns its change count or -1.
+  int32_t StepOne(uint32_t index, Error* out_error) {
+    sqlite3_stmt* stmt = entries_[index].stmt;
+    int32_t before = sqlite3_total_changes(db_);
+    int32_t rc = retry_ != nullptr ? retry_->StepFirst(db_, stmt)
+                                   : sqlite3_step(stmt);
+    while (rc == SQLITE_ROW) { rc = sqlite3_step(stmt); }
+    if (rc != SQLITE_DONE) {
+      if (out_error != nullptr) {
+        out_error->SetFormat(Sqlite3ErrorCode(rc), "statement %u: %s", index,
+                             sqlite3_errmsg(db_));
+      }
+      sqlite3_reset(stmt);
+      return -1;
+    }
+    sqlite3_reset(stmt);
+    // sqlite3_changes() keeps the last DML's count across DDL/queries.
+    int32_t changes = sqlite3_total_changes(db_) == before
+                          ? 0
+                          : sqlite3_changes(db_);
+    entries_[index].changes = changes;
+    return changes;
+  }
+
+  void MoveFrom(Sqlite3Script& other) {
+    db_ = other.db_;
+    retry_ = other.retry_;
+    sql_ = other.sql_;
+    entries_ = other.entries_;
+    count_ = other.count_;
+    capacity_ = other.capacity_;
+    tail_ = other.tail_;
+    other.db_ = nullptr;
+    other.retry_ = nullptr;
+    other.sql_ = nullptr;
+    other.entries_ = nullptr;
+    other.count_ = 0;
+    other.capacity_ = 0;
+    other.tail_ = 0;
+  }
+
+  sqlite3* db_ = nullptr;
+  Sqlite3BusyRetry* retry_ = nullptr;  // Owned by Sqlite3Db, may be null
+  char* sql_ = nullptr;                // Owned copy of the script text
+  Entry* entries_ = nullptr;
+  uint32_t count_ = 0;
+  uint32_t capacity_ = 0;
+  uint32_t tail_ = 0;  // Offset of the first uncompiled byte in sql_
+};
+
+}  // namespace dbpp
@@ -7,6 +7,16 @@
 //   - Move-only (no copy)
 //   - 1-based parameter binding (matches SQLite3 convention)
 //   - ExecDml() for INSERT/UPDATE/DELETE, ExecQuery() for SELECT
+//   - BindAll(args...) binds 1..N in one call, dispatched at compile time;
+//     text/blob are copied (SQLITE_TRANSIENT). BindAllNoCopy() binds them
+//     SQLITE_STATIC -- the caller keeps the data alive until the statement
+//     is reset, re-bound or finalized
+//   - Bind*/Reset return a code-only Status, mapped like step failures
+//     (kRange for a bad index, kBusy, ...); ErrorMessage()/ToError() fetch
+//     the connection's message only when a caller wants it
+//   - Step failures carry the mapped code (kBusy, kConstraint, ...); with
+//     the connection's busy retry enabled, a first step blocked by a lock
+//     is re-run per its policy (see sqlite3_busy.hpp)
 
 #pragma once
 
@@ -14,12 +24,16 @@
 
 #include "sqlite3.h"
 
+#include "dbpp/bind_args.hpp"
 #include "dbpp/error.hpp"
+#include "dbpp/sqlite3_busy.hpp"
 #include "dbpp/sqlite3_query.hpp"
+#include "dbpp/value_types.hpp"
 
 namespace dbpp {
 
 class Sqlite3Db;
+class Sqlite3Script;
 
 // ---------------------------------------------------------------------------
 // Sqlite3Statement
@@ -33,9 +47,10 @@ class Sqlite3Statement {
 
   // Move
   Sqlite3Statement(Sqlite3Statement&& other) noexcept
-      : db_(other.db_), stmt_(other.stmt_) {
+      : db_(other.db_), stmt_(other.stmt_), retry_(other.retry_) {
     other.db_ = nullptr;
     other.stmt_ = nullptr;
+    other.retry_ = nullptr;
   }
 
   Sqlite3Statement& operator=(Sqlite3Statement&& other) noexcept {
@@ -43,8 +58,10 @@ class Sqlite3Statement {
       Finalize();
       db_ = other.db_;
       stmt_ = other.stmt_;
+      retry_ = other.retry_;
       other.db_ = nullptr;
       other.stmt_ = nullptr;
+      other.retry_ = nullptr;
     }
     return *this;
   }
@@ -64,20 +81,20 @@ class Sqlite3Statement {
       return -1;
     }
 
-    int32_t rc = sqlite3_step(stmt_);
+    int32_t rc = Step();
     if (rc == SQLITE_DONE) {
       int32_t changes = sqlite3_changes(db_);
       int32_t reset_rc = sqlite3_reset(stmt_);
       if (reset_rc != SQLITE_OK && out_error != nullptr) {
-        out_error->Set(ErrorCode::kError, sqlite3_errmsg(db_));
+        out_error->Set(Sqlite3ErrorCode(reset_rc), sqlite3_errmsg(db_));
       }
       return changes;
     }
 
-    sqlite3_reset(stmt_);
     if (out_error != nullptr) {
-      out_error->Set(ErrorCode::kError, sqlite3_errmsg(db_));
+      out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
     }
+    sqlite3_reset(stmt_);
     return -1;
   }
 
@@ -92,7 +109,7 @@ class Sqlite3Statement {
       return Sqlite3Query{};
     }
 
-    int32_t rc = sqlite3_step(stmt_);
+    int32_t rc = Step();
     if (rc == SQLITE_DONE) {
       // No rows
       Sqlite3Query q(db_, stmt_, true);
@@ -105,95 +122,153 @@ class Sqlite3Statement {
       return q;
     }
 
-    sqlite3_reset(stmt_);
     if (out_error != nullptr) {
-      out_error->Set(ErrorCode::kError, sqlite3_errmsg(db_));
+      out_error->Set(Sqlite3ErrorCode(rc), sqlite3_errmsg(db_));
     }
+    sqlite3_reset(stmt_);
     return Sqlite3Query{};
   }
 
+  /// Bind args to parameters 1..N and execute DML in one call. A trailing
+  /// Error* receives the failure (kBusy, kConstraint, kRange, ...):
+  ///   stmt.Exec(id, name, &err);
+  /// Returns affected row count, or -1 on bind/step failure.
+  template <typename... Args>
+  int32_t Exec(const Args&... args) {
+    auto run = [this](Error* out_error, const auto&... values) {
+      return ExecBound(out_error, values...);
+    };
+    return detail::CallWithOutError(run, args...);
+  }
+
   // --- Bind (1-based index) ---
 
-  Error Bind(int32_t param, const char* value) {
+  /// Bind args to parameters 1..N; text/blob are copied.
+  template <typename... Args>
+  Status BindAll(const Args&... args) {
+    return detail::BindArgs<false>(*this, args...);
+  }
+
+  /// Bind args to parameters 1..N without copying text/blob.
+  template <typename... Args>
+  Status BindAllNoCopy(const Args&... args) {
+    return detail::BindArgs<true>(*this, args...);
+  }
+
+  Status Bind(int32_t param, const char* value) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_text(stmt_, param, value, -1,
                                     SQLITE_TRANSIENT);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind text failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, int32_t value) {
+  Status Bind(int32_t param, int32_t value) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_int(stmt_, param, value);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind int failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, int64_t value) {
+  Status Bind(int32_t param, int64_t value) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_int64(stmt_, param, value);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind int64 failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, double value) {
+  Status Bind(int32_t param, double value) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_double(stmt_, param, value);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind double failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error Bind(int32_t param, const uint8_t* blob, int32_t len) {
+  Status Bind(int32_t param, const uint8_t* blob, int32_t len) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_blob(stmt_, param, blob, len,
                                     SQLITE_TRANSIENT);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind blob failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
-  Error BindNull(int32_t param) {
+  Status Bind(int32_t param, TextView value) {
+    return BindText(param, value, SQLITE_TRANSIENT);
+  }
+
+  Status Bind(int32_t param, BlobView value) {
+    return BindBlob(param, value, SQLITE_TRANSIENT);
+  }
+
+  /// Zero-copy text bind: `value` must stay valid until the next
+  /// Reset()/re-bind of `param`, or Finalize().
+  Status BindNoCopy(int32_t param, TextView value) {
+    return BindText(param, value, SQLITE_STATIC);
+  }
+
+  /// Zero-copy blob bind, same lifetime rule as BindNoCopy(TextView).
+  Status BindNoCopy(int32_t param, BlobView value) {
+    return BindBlob(param, value, SQLITE_STATIC);
+  }
+
+  /// Bind a zero-filled blob of `size` bytes without allocating it; fill
+  /// it afterwards through Sqlite3Db::OpenBlob(). kRange if `size`
+  /// exceeds SQLITE_MAX_LENGTH.
+  Status BindZeroBlob(int32_t param, int64_t size) {
+    if (stmt_ == nullptr) {
+      return Status(ErrorCode::kMisuse);
+    }
+    if (size < 0) {
+      return Status(ErrorCode::kRange);
+    }
+    int32_t rc = sqlite3_bind_zeroblob64(stmt_, param,
+                                         static_cast<sqlite3_uint64>(size));
+    if (rc != SQLITE_OK) {  // SQLITE_TOOBIG maps to kRange
+      return Status(Sqlite3ErrorCode(rc), rc);
+    }
+    return Status::Ok();
+  }
+
+  Status BindNull(int32_t param) {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_bind_null(stmt_, param);
     if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError, "bind null failed");
+      return Status(Sqlite3ErrorCode(rc), rc);
     }
-    return Error::Ok();
+    return Status::Ok();
   }
 
   // --- Reset ---
 
-  Error Reset() {
+  Status Reset() {
     if (stmt_ == nullptr) {
-      return Error::Make(ErrorCode::kMisuse, "Statement not initialized");
+      return Status(ErrorCode::kMisuse);
     }
     int32_t rc = sqlite3_reset(stmt_);
-    if (rc != SQLITE_OK) {
-      return Error::Make(ErrorCode::kError,
-                         db_ ? sqlite3_errmsg(db_) : "reset failed");
-    }
-    return Error::Ok();
+    if (rc != SQLITE_OK) { return Status(Sqlite3ErrorCode(rc), rc); }
+    return Status::Ok();
   }
 
   void Finalize() {
@@ -206,14 +281,75 @@ class Sqlite3Statement {
   bool Valid() const { return stmt_ != nullptr; }
   sqlite3_stmt* Handle() const { return stmt_; }
 
+  // --- Error detail (read right after the failing call) ---
+
+  /// The connection's message for the last failed call.
+  const char* ErrorMessage() const {
+    return db_ != nullptr ? sqlite3_errmsg(db_) : "Statement not initialized";
+  }
+
+  /// Expand a Status into an Error carrying the connection's message.
+  Error ToError(Status status) const {
+    Error e;
+    if (!status.ok()) {
+      e.Set(status.code, status.native != 0 ? ErrorMessage()
+                                            : ErrorCodeName(status.code));
+    }
+    return e;
+  }
+
  private:
   friend class Sqlite3Db;
+  friend class Sqlite3Script;  // Binds its statements in place
 
-  Sqlite3Statement(sqlite3* db, sqlite3_stmt* stmt)
-      : db_(db), stmt_(stmt) {}
+  Sqlite3Statement(sqlite3* db, sqlite3_stmt* stmt,
+                   Sqlite3BusyRetry* retry = nullptr)
+      : db_(db), stmt_(stmt), retry_(retry) {}
+
+  template <typename... Args>
+  int32_t ExecBound(Error* out_error, const Args&... args) {
+    Status st = BindAll(args...);
+    if (!st.ok()) {
+      if (out_error != nullptr) { *out_error = ToError(st); }
+      return -1;
+    }
+    return ExecDml(out_error);
+  }
+
+  /// First step of an execution, through the busy retry when set.
+  int32_t Step() {
+    return retry_ != nullptr ? retry_->StepFirst(db_, stmt_)
+                             : sqlite3_step(stmt_);
+  }
+
+  Status BindText(int32_t param, TextView value,
+                  sqlite3_destructor_type dtor) {
+    if (stmt_ == nullptr) {
+      return Status(ErrorCode::kMisuse);
+    }
+    // A null data pointer binds SQL NULL.
+    int32_t rc = sqlite3_bind_text(stmt_, param, value.data, value.size, dtor);
+    if (rc != SQLITE_OK) {
+      return Status(Sqlite3ErrorCode(rc), rc);
+    }
+    return Status::Ok();
+  }
+
+  Status BindBlob(int32_t param, BlobView value,
+                  sqlite3_destructor_type dtor) {
+    if (stmt_ == nullptr) {
+      return Status(ErrorCode::kMisuse);
+    }
+    int32_t rc = sqlite3_bind_blob(stmt_, param, value.data, value.size, dtor);
+    if (rc != SQLITE_OK) {
+      return Status(Sqlite3ErrorCode(rc), rc);
+    }
+    return Status::Ok();
+  }
 
   sqlite3* db_ = nullptr;
   sqlite3_stmt* stmt_ = nullptr;
+  Sqlite3BusyRetry* retry_ = nullptr;  // Owned by Sqlite3Db, may be null
 };
 
 }  // namespace dbpp
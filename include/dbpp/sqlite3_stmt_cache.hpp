@@ -0,0 +1,249 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3StmtCache -- per-connection LRU cache of prepared statements.
+//
+// Design:
+//   - Keyed by SQL text minus trailing blanks and ';', so "SELECT 1;\n"
+//     finds the statement whose sqlite3_sql() is "SELECT 1;"
+//   - Holds only idle statements: Take() removes a handle from the cache,
+//     Put() resets it, clears bindings and makes it available again
+//   - Fixed capacity chosen at construction, storage allocated once
+//   - Chained hash index over an intrusive LRU list, no STL containers
+//   - Owned by Sqlite3Db; not thread-safe (same rule as the connection)
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "sqlite3.h"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// Sqlite3StmtCacheStats
+// ---------------------------------------------------------------------------
+
+struct Sqlite3StmtCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+  uint32_t size = 0;
+  uint32_t capacity = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3StmtCache
+// ---------------------------------------------------------------------------
+
+class Sqlite3StmtCache {
+ public:
+  explicit Sqlite3StmtCache(uint32_t capacity) : capacity_(capacity) {
+    if (capacity_ == 0) { return; }
+    entries_ = new Entry[capacity_];
+    num_buckets_ = 1;
+    while (num_buckets_ < capacity_ * 2) { num_buckets_ <<= 1; }
+    buckets_ = new int32_t[num_buckets_];
+    for (uint32_t i = 0; i < num_buckets_; ++i) { buckets_[i] = kNil; }
+    // All slots start on the free list
+    for (uint32_t i = 0; i < capacity_; ++i) {
+      entries_[i].next = (i + 1 < capacity_) ? static_cast<int32_t>(i + 1)
+                                             : kNil;
+    }
+    free_ = 0;
+  }
+
+  ~Sqlite3StmtCache() {
+    Clear();
+    delete[] entries_;
+    delete[] buckets_;
+  }
+
+  // No copy, no move (Sqlite3Db owns it through a stable pointer)
+  Sqlite3StmtCache(const Sqlite3StmtCache&) = delete;
+  Sqlite3StmtCache& operator=(const Sqlite3StmtCache&) = delete;
+
+  /// Remove and return an idle statement compiled from `sql`, or nullptr
+  /// on a miss. The caller owns the handle until it calls Put().
+  sqlite3_stmt* Take(const char* sql) {
+    if (capacity_ == 0) { return nullptr; }
+    uint32_t len = KeyLength(sql);
+    uint64_t hash = Hash(sql, len);
+    for (int32_t i = buckets_[hash & (num_buckets_ - 1)]; i != kNil;
+         i = entries_[i].chain) {
+      Entry& e = entries_[i];
+      if (e.hash == hash && e.len == len &&
+          std::memcmp(e.sql, sql, len) == 0) {
+        sqlite3_stmt* stmt = e.stmt;
+        Remove(i);
+        ++stats_.hits;
+        return stmt;
+      }
+    }
+    ++stats_.misses;
+    return nullptr;
+  }
+
+  /// Return a statement to the cache. The key is sqlite3_sql(stmt), so the
+  /// statement must have been compiled from SQL with the same key
+  /// (SameKey()).
+  /// Evicts the least recently used entry when full.
+  void Put(sqlite3_stmt* stmt) {
+    if (stmt == nullptr) { return; }
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+
+    const char* sql = sqlite3_sql(stmt);
+    if (capacity_ == 0 || sql == nullptr) {
+      sqlite3_finalize(stmt);
+      return;
+    }
+
+    uint32_t len = KeyLength(sql);
+    uint64_t hash = Hash(sql, len);
+    for (int32_t i = buckets_[hash & (num_buckets_ - 1)]; i != kNil;
+         i = entries_[i].chain) {
+      const Entry& other = entries_[i];
+      if (other.hash == hash && other.len == len &&
+          std::memcmp(other.sql, sql, len) == 0) {
+        // Same SQL was checked out twice; keep the cached copy
+        sqlite3_finalize(stmt);
+        return;
+      }
+    }
+
+    if (free_ == kNil) {
+      int32_t victim = lru_tail_;
+      sqlite3_finalize(entries_[victim].stmt);
+      Remove(victim);
+      ++stats_.evictions;
+    }
+
+    int32_t idx = free_;
+    Entry& e = entries_[idx];
+    free_ = e.next;
+    e.stmt = stmt;
+    e.sql = sql;
+    e.len = len;
+    e.hash = hash;
+
+    // Link into hash chain
+    int32_t& bucket = buckets_[hash & (num_buckets_ - 1)];
+    e.chain = bucket;
+    bucket = idx;
+
+    // Link at LRU head (most recently used)
+    e.prev = kNil;
+    e.next = lru_head_;
+    if (lru_head_ != kNil) { entries_[lru_head_].prev = idx; }
+    lru_head_ = idx;
+    if (lru_tail_ == kNil) { lru_tail_ = idx; }
+    ++stats_.size;
+  }
+
+  /// Finalize all idle statements. Counters are kept.
+  void Clear() {
+    while (lru_head_ != kNil) {
+      int32_t idx = lru_head_;
+      sqlite3_finalize(entries_[idx].stmt);
+      Remove(idx);
+    }
+  }
+
+  void ResetStats() {
+    stats_.hits = 0;
+    stats_.misses = 0;
+    stats_.evictions = 0;
+  }
+
+  Sqlite3StmtCacheStats Stats() const {
+    Sqlite3StmtCacheStats s = stats_;
+    s.capacity = capacity_;
+    return s;
+  }
+
+  uint32_t Capacity() const { return capacity_; }
+
+  /// True if `a` and `b` are the same cache key.
+  static bool SameKey(const char* a, const char* b) {
+    uint32_t len = KeyLength(a);
+    return len == KeyLength(b) && std::memcmp(a, b, len) == 0;
+  }
+
+ private:
+  static constexpr int32_t kNil = -1;
+
+  struct Entry {
+    sqlite3_stmt* stmt = nullptr;
+    const char* sql = nullptr;  // Points into the statement (sqlite3_sql)
+    uint32_t len = 0;           // Key length, see KeyLength()
+    uint64_t hash = 0;
+    int32_t prev = kNil;   // LRU list
+    int32_t next = kNil;   // LRU list, or free list when unused
+    int32_t chain = kNil;  // Hash bucket chain
+  };
+
+  /// Length of `sql` without trailing whitespace and semicolons.
+  static uint32_t KeyLength(const char* sql) {
+    size_t len = std::strlen(sql);
+    while (len > 0) {
+      char c = sql[len - 1];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != ';') {
+        break;
+      }
+      --len;
+    }
+    return static_cast<uint32_t>(len);
+  }
+
+  // FNV-1a, 64-bit, over the first `len` bytes
+  static uint64_t Hash(const char* s, uint32_t len) {
+    uint64_t h = 14695981039346656037ULL;
+    for (uint32_t i = 0; i < len; ++i) {
+      h ^= static_cast<uint8_t>(s[i]);
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+  /// Unlink entry from its hash chain and the LRU list, then free the slot.
+  void Remove(int32_t idx) {
+    Entry& e = entries_[idx];
+
+    int32_t* link = &buckets_[e.hash & (num_buckets_ - 1)];
+    while (*link != idx) { link = &entries_[*link].chain; }
+    *link = e.chain;
+
+    if (e.prev != kNil) {
+      entries_[e.prev].next = e.next;
+    } else {
+      lru_head_ = e.next;
+    }
+    if (e.next != kNil) {
+      entries_[e.next].prev = e.prev;
+    } else {
+      lru_tail_ = e.prev;
+    }
+
+    e.stmt = nullptr;
+    e.sql = nullptr;
+    e.len = 0;
+    e.prev = kNil;
+    e.chain = kNil;
+    e.next = free_;
+    free_ = idx;
+    --stats_.size;
+  }
+
+  Entry* entries_ = nullptr;
+  int32_t* buckets_ = nullptr;
+  uint32_t capacity_ = 0;
+  uint32_t num_buckets_ = 0;
+  int32_t lru_head_ = kNil;
+  int32_t lru_tail_ = kNil;
+  int32_t free_ = kNil;
+  Sqlite3StmtCacheStats stats_;
+};
+
+}  // namespace dbpp
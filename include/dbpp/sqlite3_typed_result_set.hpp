@@ -0,0 +1,398 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3TypedResultSet -- type-preserving, arena-backed result set.
+//
+// Design:
+//   - Materialized from sqlite3_step(), no sqlite3_get_table() round trip
+//     through text: integers and doubles keep their native type
+//   - Row-major 8-byte value array (int64 / double bits / heap ref) plus
+//     one type byte per cell; TEXT/BLOB bytes live in a single heap
+//     buffer addressed by offset+length
+//   - Three growable buffers in total, so large results cost a handful
+//     of allocations instead of one malloc per cell
+//   - Move-only, O(1) SeekRow(), cursor API compatible with
+//     Sqlite3ResultSet plus typed getters
+//   - Heap is limited to 4 GiB (32-bit offsets); exceeding it is kFull
+//   - Named access through a lazily built ColumnIndex / ColumnRef
+
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "sqlite3.h"
+
+#include "dbpp/column_index.hpp"
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_busy.hpp"
+#include "dbpp/sqlite3_query.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// Sqlite3TypedResultSet
+// ---------------------------------------------------------------------------
+
+class Sqlite3TypedResultSet {
+ public:
+  Sqlite3TypedResultSet() = default;
+
+  ~Sqlite3TypedResultSet() { Finalize(); }
+
+  // Move
+  Sqlite3TypedResultSet(Sqlite3TypedResultSet&& other) noexcept {
+    MoveFrom(other);
+  }
+
+  Sqlite3TypedResultSet& operator=(Sqlite3TypedResultSet&& other) noexcept {
+    if (this != &other) {
+      Finalize();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  // No copy
+  Sqlite3TypedResultSet(const Sqlite3TypedResultSet&) = delete;
+  Sqlite3TypedResultSet& operator=(const Sqlite3TypedResultSet&) = delete;
+
+  /// Drain the remaining rows of `query` (starting at its current row)
+  /// into a new result set. The query is finalized afterwards.
+  static Sqlite3TypedResultSet FromQuery(Sqlite3Query& query,
+                                         Error* out_error = nullptr) {
+    Sqlite3TypedResultSet rs;
+    if (query.stmt_ == nullptr) { return rs; }
+    Error err = rs.Load(query.db_, query.stmt_, !query.Eof());
+    query.Finalize();
+    if (!err.ok()) {
+      if (out_error != nullptr) { *out_error = err; }
+      rs.Finalize();
+    }
+    return rs;
+  }
+
+  // --- Field info ---
+
+  int32_t NumFields() const { return num_cols_; }
+  uint32_t NumRows() const { return num_rows_; }
+
+  int32_t FieldIndex(const char* name) const {
+    return name_index_.Find(name, num_cols_, [this](int32_t i) {
+      return heap_ + name_offsets_[i];
+    });
+  }
+
+  /// Resolve `name` once, for positional access inside a row loop.
+  ColumnRef Column(const char* name) const {
+    return ColumnRef(FieldIndex(name));
+  }
+
+  const char* FieldName(int32_t col) const {
+    if (col < 0 || col >= num_cols_) { return nullptr; }
+    return heap_ + name_offsets_[col];
+  }
+
+  /// SQLITE_INTEGER, SQLITE_FLOAT, SQLITE_TEXT, SQLITE_BLOB or SQLITE_NULL
+  /// for the current row; -1 when out of range.
+  int32_t FieldDataType(int32_t col) const {
+    int64_t idx = CellIndex(col);
+    return (idx >= 0) ? types_[idx] : -1;
+  }
+
+  bool FieldIsNull(int32_t col) const {
+    int64_t idx = CellIndex(col);
+    return idx < 0 || types_[idx] == SQLITE_NULL;
+  }
+
+  // --- Typed accessors (current row) ---
+
+  int64_t GetInt64(int32_t col, int64_t null_value = 0) const {
+    int64_t idx = CellIndex(col);
+    if (idx < 0) { return null_value; }
+    switch (types_[idx]) {
+      case SQLITE_INTEGER: return values_[idx].i;
+      case SQLITE_FLOAT:   return static_cast<int64_t>(values_[idx].d);
+      default:             return null_value;
+    }
+  }
+
+  int32_t GetInt(int32_t col, int32_t null_value = 0) const {
+    return static_cast<int32_t>(GetInt64(col, null_value));
+  }
+
+  double GetDouble(int32_t col, double null_value = 0.0) const {
+    int64_t idx = CellIndex(col);
+    if (idx < 0) { return null_value; }
+    switch (types_[idx]) {
+      case SQLITE_FLOAT:   return values_[idx].d;
+      case SQLITE_INTEGER: return static_cast<double>(values_[idx].i);
+      default:             return null_value;
+    }
+  }
+
+  /// TEXT (or BLOB) cells only; numeric cells return null_value, use
+  /// GetInt64()/GetDouble() for those. The string is NUL-terminated.
+  const char* GetString(int32_t col, const char* null_value = "") const {
+    int64_t idx = CellIndex(col);
+    if (idx < 0 || !IsHeapType(types_[idx])) { return null_value; }
+    return heap_ + values_[idx].ref.offset;
+  }
+
+  /// TEXT/BLOB byte length, 0 for other types.
+  int32_t GetBytes(int32_t col) const {
+    int64_t idx = CellIndex(col);
+    if (idx < 0 || !IsHeapType(types_[idx])) { return 0; }
+    return static_cast<int32_t>(values_[idx].ref.len);
+  }
+
+  const uint8_t* GetBlob(int32_t col, int32_t& out_len) const {
+    out_len = 0;
+    int64_t idx = CellIndex(col);
+    if (idx < 0 || !IsHeapType(types_[idx])) { return nullptr; }
+    out_len = static_cast<int32_t>(values_[idx].ref.len);
+    return reinterpret_cast<const uint8_t*>(heap_ + values_[idx].ref.offset);
+  }
+
+  // --- Named accessors ---
+
+  int64_t GetInt64(const char* name, int64_t null_value = 0) const {
+    int32_t idx = FieldIndex(name);
+    return (idx >= 0) ? GetInt64(idx, null_value) : null_value;
+  }
+
+  int32_t GetInt(const char* name, int32_t null_value = 0) const {
+    int32_t idx = FieldIndex(name);
+    return (idx >= 0) ? GetInt(idx, null_value) : null_value;
+  }
+
+  double GetDouble(const char* name, double null_value = 0.0) const {
+    int32_t idx = FieldIndex(name);
+    return (idx >= 0) ? GetDouble(idx, null_value) : null_value;
+  }
+
+  const char* GetString(const char* name,
+                        const char* null_value = "") const {
+    int32_t idx = FieldIndex(name);
+    return (idx >= 0) ? GetString(idx, null_value) : null_value;
+  }
+
+  // --- Navigation ---
+
+  bool Eof() const { return current_row_ >= num_rows_; }
+
+  void NextRow() {
+    if (current_row_ < num_rows_) { ++current_row_; }
+  }
+
+  void SeekRow(uint32_t row) {
+    if (row >= num_rows_ && num_rows_ > 0) {
+      current_row_ = num_rows_ - 1;
+    } else {
+      current_row_ = row;
+    }
+  }
+
+  uint32_t CurrentRow() const { return current_row_; }
+
+  /// Bytes held by the result set (values + types + heap capacity).
+  size_t MemoryBytes() const {
+    return cell_cap_ * (sizeof(Value) + sizeof(uint8_t)) + heap_cap_ +
+           static_cast<size_t>(num_cols_) * sizeof(uint32_t);
+  }
+
+  void Finalize() {
+    std::free(values_);
+    std::free(types_);
+    std::free(heap_);
+    std::free(name_offsets_);
+    values_ = nullptr;
+    types_ = nullptr;
+    heap_ = nullptr;
+    name_offsets_ = nullptr;
+    cell_cap_ = 0;
+    heap_len_ = 0;
+    heap_cap_ = 0;
+    num_rows_ = 0;
+    num_cols_ = 0;
+    current_row_ = 0;
+    name_index_.Clear();
+  }
+
+ private:
+  friend class Sqlite3Db;
+
+  struct HeapRef {
+    uint32_t offset;
+    uint32_t len;
+  };
+
+  union Value {
+    int64_t i;
+    double d;
+    HeapRef ref;
+  };
+
+  static bool IsHeapType(uint8_t type) {
+    return type == SQLITE_TEXT || type == SQLITE_BLOB;
+  }
+
+  int64_t CellIndex(int32_t col) const {
+    if (col < 0 || col >= num_cols_ || current_row_ >= num_rows_) {
+      return -1;
+    }
+    return static_cast<int64_t>(current_row_) * num_cols_ + col;
+  }
+
+  /// Read column metadata, then append rows. If `has_row` the statement is
+  /// already positioned on a row (SQLITE_ROW returned by the caller).
+  Error Load(sqlite3* db, sqlite3_stmt* stmt, bool has_row) {
+    num_cols_ = sqlite3_column_count(stmt);
+    if (num_cols_ > 0) {
+      name_offsets_ = static_cast<uint32_t*>(
+          std::malloc(static_cast<size_t>(num_cols_) * sizeof(uint32_t)));
+      if (name_offsets_ == nullptr) {
+        return Error::Make(ErrorCode::kFull, "out of memory");
+      }
+    }
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      const char* name = sqlite3_column_name(stmt, c);
+      if (name == nullptr) { name = ""; }
+      uint32_t off = 0;
+      if (!HeapAppend(name, static_cast<uint32_t>(std::strlen(name)), &off)) {
+        return Error::Make(ErrorCode::kFull, "result heap exhausted");
+      }
+      name_offsets_[c] = off;
+    }
+
+    if (has_row) {
+      Error err = AppendRow(stmt);
+      if (!err.ok()) { return err; }
+    }
+    while (true) {
+      int32_t rc = sqlite3_step(stmt);
+      if (rc == SQLITE_DONE) { return Error::Ok(); }
+      if (rc != SQLITE_ROW) {
+        return Error::Make(Sqlite3ErrorCode(rc),
+                           db ? sqlite3_errmsg(db) : "step failed");
+      }
+      Error err = AppendRow(stmt);
+      if (!err.ok()) { return err; }
+    }
+  }
+
+  Error AppendRow(sqlite3_stmt* stmt) {
+    size_t base = static_cast<size_t>(num_rows_) * num_cols_;
+    if (!ReserveCells(base + num_cols_)) {
+      return Error::Make(ErrorCode::kFull, "out of memory");
+    }
+    for (int32_t c = 0; c < num_cols_; ++c) {
+      int32_t type = sqlite3_column_type(stmt, c);
+      Value& v = values_[base + c];
+      types_[base + c] = static_cast<uint8_t>(type);
+      switch (type) {
+        case SQLITE_INTEGER:
+          v.i = sqlite3_column_int64(stmt, c);
+          break;
+        case SQLITE_FLOAT:
+          v.d = sqlite3_column_double(stmt, c);
+          break;
+        case SQLITE_TEXT:
+        case SQLITE_BLOB: {
+          // Fetch pointer first, then length (sqlite3 docs ordering rule)
+          const void* p = (type == SQLITE_TEXT)
+              ? static_cast<const void*>(sqlite3_column_text(stmt, c))
+              : sqlite3_column_blob(stmt, c);
+          uint32_t len = static_cast<uint32_t>(sqlite3_column_bytes(stmt, c));
+          if (!HeapAppend(p, len, &v.ref.offset)) {
+            return Error::Make(ErrorCode::kFull, "result heap exhausted");
+          }
+          v.ref.len = len;
+          break;
+        }
+        default:
+          v.i = 0;
+          break;
+      }
+    }
+    ++num_rows_;
+    return Error::Ok();
+  }
+
+  bool ReserveCells(size_t need) {
+    if (need <= cell_cap_) { return true; }
+    size_t cap = (cell_cap_ > 0) ? cell_cap_ * 2 : 64;
+    while (cap < need) { cap *= 2; }
+    Value* values = static_cast<Value*>(
+        std::realloc(values_, cap * sizeof(Value)));
+    if (values == nullptr) { return false; }
+    values_ = values;
+    uint8_t* types = static_cast<uint8_t*>(std::realloc(types_, cap));
+    if (types == nullptr) { return false; }
+    types_ = types;
+    cell_cap_ = cap;
+    return true;
+  }
+
+  /// Copy `len` bytes plus a NUL terminator into the heap.
+  bool HeapAppend(const void* data, uint32_t len, uint32_t* out_offset) {
+    uint64_t need = static_cast<uint64_t>(heap_len_) + len + 1;
+    if (need > UINT32_MAX) { return false; }
+    if (need > heap_cap_) {
+      uint64_t cap = (heap_cap_ > 0) ? heap_cap_ * 2ULL : 1024ULL;
+      while (cap < need) { cap *= 2; }
+      if (cap > UINT32_MAX) { cap = UINT32_MAX; }
+      char* heap = static_cast<char*>(
+          std::realloc(heap_, static_cast<size_t>(cap)));
+      if (heap == nullptr) { return false; }
+      heap_ = heap;
+      heap_cap_ = static_cast<uint32_t>(cap);
+    }
+    *out_offset = heap_len_;
+    if (len > 0 && data != nullptr) {
+      std::memcpy(heap_ + heap_len_, data, len);
+    }
+    heap_[heap_len_ + len] = '\0';
+    heap_len_ += len + 1;
+    return true;
+  }
+
+  void MoveFrom(Sqlite3TypedResultSet& other) {
+    values_ = other.values_;
+    types_ = other.types_;
+    heap_ = other.heap_;
+    name_offsets_ = other.name_offsets_;
+    cell_cap_ = other.cell_cap_;
+    heap_len_ = other.heap_len_;
+    heap_cap_ = other.heap_cap_;
+    num_rows_ = other.num_rows_;
+    num_cols_ = other.num_cols_;
+    current_row_ = other.current_row_;
+    name_index_ = std::move(other.name_index_);
+    other.values_ = nullptr;
+    other.types_ = nullptr;
+    other.heap_ = nullptr;
+    other.name_offsets_ = nullptr;
+    other.cell_cap_ = 0;
+    other.heap_len_ = 0;
+    other.heap_cap_ = 0;
+    other.num_rows_ = 0;
+    other.num_cols_ = 0;
+    other.current_row_ = 0;
+  }
+
+  Value* values_ = nullptr;
+  uint8_t* types_ = nullptr;
+  char* heap_ = nullptr;
+  uint32_t* name_offsets_ = nullptr;  // Column names, offsets into heap_
+  size_t cell_cap_ = 0;
+  uint32_t heap_len_ = 0;
+  uint32_t heap_cap_ = 0;
+  uint32_t num_rows_ = 0;
+  int32_t num_cols_ = 0;
+  uint32_t current_row_ = 0;
+  mutable ColumnIndex name_index_;  // Built on first FieldIndex()
+};
+
+}  // namespace dbpp
@@ -0,0 +1,375 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp virtual tables -- in-process C++ data exposed to SQL, read-only.
+//
+// Design:
+//   - Sqlite3Db::CreateVirtualTable(name, &source) registers an
+//     eponymous-only module over sqlite3_create_module_v2: `name` is
+//     directly queryable (SELECT ... FROM name), joins with real tables,
+//     and rows are read in place -- nothing is copied into SQLite
+//   - Source is any type (no base class, no virtual dispatch) with
+//       const char* Schema() const;      // "CREATE TABLE x(ts INTEGER,..)"
+//       int64_t Size() const;            // rows 0..Size()-1
+//       void Column(int64_t row, int32_t col, VtabCell& cell) const;
+//     The row index is the rowid. Size() is sampled once per scan
+//   - Optional sorted key: a Source that also has
+//       int32_t KeyColumn() const;       // column, -1 = none
+//       int64_t Key(int64_t row) const;  // non-decreasing in row order
+//     gets =, <, <=, >, >= on that column pushed down (xBestIndex) and
+//     resolved by binary search, and ORDER BY key ASC consumed. Rowid
+//     constraints are pushed down for every Source
+//   - Pushed-down constraints are not omitted: SQLite re-checks them, so
+//     non-integer operands simply fall back to a wider scan
+//   - ContainerTable adapts any random-access container (vector, deque,
+//     ring buffer with operator[] / size()) plus a per-row column lambda
+//   - The source is not owned and must outlive the registration (the
+//     connection, or DropVirtualTable()); synchronizing with writers to
+//     the source is the caller's job
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "sqlite3.h"
+
+#include "dbpp/sqlite3_function.hpp"
+#include "dbpp/value_types.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// VtabCell
+// ---------------------------------------------------------------------------
+
+/// Output slot for one column value in Source::Column(). Accepts the
+/// result types of SQL functions (integral, floating point, bool,
+/// TextView, std::string, BlobView, Nullable<T>); text/blob are copied.
+class VtabCell {
+ public:
+  explicit VtabCell(sqlite3_context* ctx) : ctx_(ctx) {}
+
+  template <typename T>
+  void Set(const T& value) { detail::SetResult(ctx_, value); }
+
+  void SetNull() { sqlite3_result_null(ctx_); }
+
+  sqlite3_context* Handle() const { return ctx_; }
+
+ private:
+  sqlite3_context* ctx_;
+};
+
+// ---------------------------------------------------------------------------
+// ContainerTable
+// ---------------------------------------------------------------------------
+
+/// Source over a random-access container; `row_fn(elem, col, cell)`
+/// writes column `col` of one element.
+template <typename Container, typename RowFn>
+class ContainerTable {
+ public:
+  ContainerTable(const char* schema, const Container* container, RowFn row_fn)
+      : schema_(schema), container_(container), row_fn_(std::move(row_fn)) {}
+
+  const char* Schema() const { return schema_; }
+
+  int64_t Size() const { return static_cast<int64_t>(container_->size()); }
+
+  void Column(int64_t row, int32_t col, VtabCell& cell) const {
+    row_fn_((*container_)[static_cast<size_t>(row)], col, cell);
+  }
+
+ private:
+  const char* schema_;
+  const Container* container_;
+  RowFn row_fn_;
+};
+
+template <typename Container, typename RowFn>
+ContainerTable<Container, RowFn> MakeContainerTable(
+    const char* schema, const Container* container, RowFn row_fn) {
+  return ContainerTable<Container, RowFn>(schema, container,
+                                          std::move(row_fn));
+}
+
+namespace detail {
+
+// --- Optional sorted key detection ---
+
+template <typename S, typename = void>
+struct HasSortedKey : std::false_type {};
+
+template <typename S>
+struct HasSortedKey<S, decltype(
+    (void)std::declval<const S&>().KeyColumn(),
+    (void)std::declval<const S&>().Key(int64_t{}))> : std::true_type {};
+
+template <typename S>
+int32_t KeyColumnOf(const S& s, std::true_type) { return s.KeyColumn(); }
+
+template <typename S>
+int32_t KeyColumnOf(const S&, std::false_type) { return -1; }
+
+template <typename S>
+int64_t KeyOf(const S& s, int64_t row, std::true_type) { return s.Key(row); }
+
+template <typename S>
+int64_t KeyOf(const S&, int64_t, std::false_type) { return 0; }
+
+// --- Module ---
+
+template <typename Source>
+struct VirtualTable {
+  using Keyed = HasSortedKey<Source>;
+
+  // Pushed-down constraint, 4 bits per xFilter argument in idxNum:
+  // bit 3 = key column (else rowid), bits 0-2 = operator.
+  enum Op : int32_t { kEq = 1, kGt, kGe, kLt, kLe };
+  static constexpr int32_t kKeyBit = 8;
+  static constexpr int32_t kMaxArgs = 7;
+
+  struct Table : sqlite3_vtab {
+    const Source* source;
+  };
+
+  struct Cursor : sqlite3_vtab_cursor {
+    int64_t row;
+    int64_t end;
+  };
+
+  static const Source& SourceOf(sqlite3_vtab_cursor* cur) {
+    return *static_cast<Table*>(cur->pVtab)->source;
+  }
+
+  static const sqlite3_module* Module() {
+    static const sqlite3_module module = MakeModule();
+    return &module;
+  }
+
+  static sqlite3_module MakeModule() {
+    sqlite3_module m{};
+    // xCreate == nullptr: eponymous-only, no CREATE VIRTUAL TABLE needed.
+    // xUpdate == nullptr: read-only.
+    m.xConnect = &Connect;
+    m.xBestIndex = &BestIndex;
+    m.xDisconnect = &Disconnect;
+    m.xDestroy = &Disconnect;
+    m.xOpen = &Open;
+    m.xClose = &Close;
+    m.xFilter = &Filter;
+    m.xNext = &Next;
+    m.xEof = &Eof;
+    m.xColumn = &ColumnCb;
+    m.xRowid = &Rowid;
+    return m;
+  }
+
+  static int Connect(sqlite3* db, void* app, int, const char* const*,
+                     sqlite3_vtab** out, char** err) {
+    const Source* source = static_cast<const Source*>(app);
+    int rc = sqlite3_declare_vtab(db, source->Schema());
+    if (rc != SQLITE_OK) {
+      *err = sqlite3_mprintf("bad virtual table schema: %s",
+                             sqlite3_errmsg(db));
+      return rc;
+    }
+    Table* table = static_cast<Table*>(sqlite3_malloc(sizeof(Table)));
+    if (table == nullptr) { return SQLITE_NOMEM; }
+    *static_cast<sqlite3_vtab*>(table) = sqlite3_vtab{};
+    table->source = source;
+    *out = table;
+    return SQLITE_OK;
+  }
+
+  static int Disconnect(sqlite3_vtab* vtab) {
+    sqlite3_free(vtab);
+    return SQLITE_OK;
+  }
+
+  static int32_t OpOf(unsigned char op) {
+    switch (op) {
+      case SQLITE_INDEX_CONSTRAINT_EQ: return kEq;
+      case SQLITE_INDEX_CONSTRAINT_GT: return kGt;
+      case SQLITE_INDEX_CONSTRAINT_GE: return kGe;
+      case SQLITE_INDEX_CONSTRAINT_LT: return kLt;
+      case SQLITE_INDEX_CONSTRAINT_LE: return kLe;
+      default: return 0;
+    }
+  }
+
+  static int BestIndex(sqlite3_vtab* vtab, sqlite3_index_info* info) {
+    const Source& source = *static_cast<Table*>(vtab)->source;
+    int32_t key_col = KeyColumnOf(source, Keyed{});
+    double rows = static_cast<double>(source.Size());
+    double est = rows > 1 ? rows : 1;
+    int32_t num_args = 0;
+    int32_t idx_num = 0;
+    for (int32_t i = 0; i < info->nConstraint && num_args < kMaxArgs; ++i) {
+      const auto& c = info->aConstraint[i];
+      int32_t op = OpOf(c.op);
+      if (!c.usable || op == 0) { continue; }
+      int32_t code;
+      if (c.iColumn == -1) {
+        code = op;
+      } else if (key_col >= 0 && c.iColumn == key_col) {
+        code = op | kKeyBit;
+      } else {
+        continue;
+      }
+      idx_num |= code << (4 * num_args);
+      info->aConstraintUsage[i].argvIndex = ++num_args;
+      info->aConstraintUsage[i].omit = 0;
+      // Equality: a handful of rows; a bound: roughly halves the scan.
+      est = (op == kEq) ? (est < 4 ? est : 4) : est / 2;
+    }
+    info->idxNum = idx_num;
+    info->estimatedRows = static_cast<sqlite3_int64>(est);
+    // Binary search to the range, then a sequential scan of it.
+    info->estimatedCost = est + (num_args > 0 ? 20.0 : 0.0);
+    // Rows come out in rowid order, so also in key order.
+    if (info->nOrderBy == 1 && !info->aOrderBy[0].desc &&
+        (info->aOrderBy[0].iColumn == -1 ||
+         (key_col >= 0 && info->aOrderBy[0].iColumn == key_col))) {
+      info->orderByConsumed = 1;
+    }
+    return SQLITE_OK;
+  }
+
+  static int Open(sqlite3_vtab*, sqlite3_vtab_cursor** out) {
+    Cursor* cur = static_cast<Cursor*>(sqlite3_malloc(sizeof(Cursor)));
+    if (cur == nullptr) { return SQLITE_NOMEM; }
+    *static_cast<sqlite3_vtab_cursor*>(cur) = sqlite3_vtab_cursor{};
+    cur->row = 0;
+    cur->end = 0;
+    *out = cur;
+    return SQLITE_OK;
+  }
+
+  static int Close(sqlite3_vtab_cursor* cur) {
+    sqlite3_free(cur);
+    return SQLITE_OK;
+  }
+
+  /// First row in [lo, hi) whose key is >= `key` (or > `key` if strict).
+  static int64_t KeyBound(const Source& s, int64_t lo, int64_t hi,
+                          int64_t key, bool strict) {
+    while (lo < hi) {
+      int64_t mid = lo + (hi - lo) / 2;
+      int64_t k = KeyOf(s, mid, Keyed{});
+      if (k < key || (strict && k == key)) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  }
+
+  /// Narrow [lo, hi) by a rowid constraint: plain index arithmetic.
+  static void RowidBound(int32_t op, int64_t v, int64_t* lo, int64_t* hi) {
+    switch (op) {
+      case kEq:
+        if (v > *lo) { *lo = v; }
+        if (v < INT64_MAX && v + 1 < *hi) { *hi = v + 1; }
+        break;
+      case kGe:
+        if (v > *lo) { *lo = v; }
+        break;
+      case kGt:
+        if (v == INT64_MAX) {
+          *hi = *lo;
+        } else if (v + 1 > *lo) {
+          *lo = v + 1;
+        }
+        break;
+      case kLe:
+        if (v < INT64_MAX && v + 1 < *hi) { *hi = v + 1; }
+        break;
+      case kLt:
+        if (v < *hi) { *hi = v; }
+        break;
+      default:
+        break;
+    }
+  }
+
+  /// Narrow [lo, hi) (lo < hi) by a key constraint: binary search.
+  static void KeyRange(const Source& s, int32_t op, int64_t v, int64_t* lo,
+                       int64_t* hi) {
+    switch (op) {
+      case kEq:
+        *lo = KeyBound(s, *lo, *hi, v, false);
+        *hi = KeyBound(s, *lo, *hi, v, true);
+        break;
+      case kGe:
+        *lo = KeyBound(s, *lo, *hi, v, false);
+        break;
+      case kGt:
+        *lo = KeyBound(s, *lo, *hi, v, true);
+        break;
+      case kLe:
+        *hi = KeyBound(s, *lo, *hi, v, true);
+        break;
+      case kLt:
+        *hi = KeyBound(s, *lo, *hi, v, false);
+        break;
+      default:
+        break;
+    }
+  }
+
+  static int Filter(sqlite3_vtab_cursor* base, int idx_num, const char*,
+                    int argc, sqlite3_value** argv) {
+    Cursor* cur = static_cast<Cursor*>(base);
+    const Source& source = SourceOf(base);
+    int64_t lo = 0;
+    int64_t hi = source.Size();
+    // Rowid bounds first, then key bounds by binary search inside them.
+    for (int32_t pass = 0; pass < 2; ++pass) {
+      for (int32_t i = 0; i < argc; ++i) {
+        int32_t code = (idx_num >> (4 * i)) & 0xF;
+        bool is_key = (code & kKeyBit) != 0;
+        if (is_key != (pass == 1)) { continue; }
+        // Non-integer operands are left to SQLite's re-check.
+        if (sqlite3_value_type(argv[i]) != SQLITE_INTEGER) { continue; }
+        int64_t v = sqlite3_value_int64(argv[i]);
+        if (!is_key) {
+          RowidBound(code & 0x7, v, &lo, &hi);
+        } else if (lo < hi) {
+          KeyRange(source, code & 0x7, v, &lo, &hi);
+        }
+      }
+    }
+    cur->row = lo;
+    cur->end = (hi > lo) ? hi : lo;
+    return SQLITE_OK;
+  }
+
+  static int Next(sqlite3_vtab_cursor* base) {
+    ++static_cast<Cursor*>(base)->row;
+    return SQLITE_OK;
+  }
+
+  static int Eof(sqlite3_vtab_cursor* base) {
+    Cursor* cur = static_cast<Cursor*>(base);
+    return cur->row >= cur->end;
+  }
+
+  static int ColumnCb(sqlite3_vtab_cursor* base, sqlite3_context* ctx,
+                      int col) {
+    Cursor* cur = static_cast<Cursor*>(base);
+    VtabCell cell(ctx);
+    SourceOf(base).Column(cur->row, col, cell);
+    return SQLITE_OK;
+  }
+
+  static int Rowid(sqlite3_vtab_cursor* base, sqlite3_int64* out) {
+    *out = static_cast<Cursor*>(base)->row;
+    return SQLITE_OK;
+  }
+};
+
+}  // namespace detail
+}  // namespace dbpp
@@ -0,0 +1,438 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Sqlite3Writer -- single-writer executor with group commit.
+//
+// Design:
+//   - Owns one Sqlite3Db and one writer thread; every write goes through
+//     it, so writers in this process never contend for the SQLite lock
+//   - Jobs are submitted from any thread through an intrusive lock-free
+//     MPSC queue (Vyukov); producers never take a lock on the fast path,
+//     the mutex/condvar is only used to park the writer thread while the
+//     queue is empty or a producer is between its two push steps
+//   - Group commit: all queued jobs (up to max_batch) run in one
+//     BEGIN IMMEDIATE ... COMMIT, so N submitters share one fsync
+//   - Each job runs inside its own SAVEPOINT: a failing job is rolled back
+//     alone and the rest of the batch still commits
+//   - Transaction and savepoint statements go through Sqlite3Db's cached
+//     BeginTransaction/Savepoint/Commit API; another process holding the
+//     write lock is waited out per Sqlite3WriterOptions::busy
+//   - Results are delivered after COMMIT, through a std::future or a
+//     callback (called on the writer thread; keep it short)
+//   - Jobs must not BEGIN/COMMIT themselves; they see an open transaction
+//
+// Usage:
+//   dbpp::Sqlite3Writer writer;
+//   dbpp::Sqlite3WriterOptions opts;
+//   opts.path = "app.db";
+//   writer.Start(opts);
+//   auto f = writer.SubmitDml("INSERT INTO t VALUES(1);");
+//   auto g = writer.Submit([](dbpp::Sqlite3Db& db, dbpp::Error* e) {
+//     return db.Exec("INSERT INTO t VALUES(?);", 2);
+//   });
+//   if (f.get().error.ok()) { ... }
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include "dbpp/error.hpp"
+#include "dbpp/sqlite3_busy.hpp"
+#include "dbpp/sqlite3_db.hpp"
+#include "dbpp/sqlite3_open_options.hpp"
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// Sqlite3WriterOptions / WriteResult / Sqlite3WriterStats
+// ---------------------------------------------------------------------------
+
+struct Sqlite3WriterOptions {
+  const char* path = nullptr;
+  /// Durable by default: group commit is what makes synchronous=FULL cheap.
+  Sqlite3OpenOptions open = Sqlite3OpenOptions::Durable();
+  /// Most jobs coalesced into one transaction.
+  uint32_t max_batch = 256;
+  /// Extra time the writer waits for more jobs once a batch has started.
+  /// 0 = only batch what is already queued.
+  uint32_t max_batch_delay_us = 0;
+  /// Wait for the write lock held by another connection (BEGIN IMMEDIATE,
+  /// COMMIT) before failing the batch with kBusy.
+  Sqlite3BusyPolicy busy;
+};
+
+struct WriteResult {
+  Error error;
+  int32_t changes = 0;  // Value returned by the job (rows affected)
+};
+
+struct Sqlite3WriterStats {
+  uint64_t jobs = 0;      // Jobs executed
+  uint64_t failed = 0;    // Jobs whose result carried an error
+  uint64_t batches = 0;   // Transactions committed or attempted
+  uint64_t largest_batch = 0;
+
+  double AvgBatch() const {
+    return batches > 0 ? static_cast<double>(jobs) / batches : 0.0;
+  }
+};
+
+// ---------------------------------------------------------------------------
+// Sqlite3Writer
+// ---------------------------------------------------------------------------
+
+class Sqlite3Writer {
+ public:
+  /// A write job: runs on the writer thread, returns rows affected or -1,
+  /// reporting failures through out_error (same contract as ExecDml).
+  using Job = std::function<int32_t(Sqlite3Db&, Error*)>;
+  using Callback = std::function<void(const WriteResult&)>;
+
+  Sqlite3Writer() = default;
+  ~Sqlite3Writer() { Stop(); }
+
+  // No copy, no move (the writer thread holds `this`)
+  Sqlite3Writer(const Sqlite3Writer&) = delete;
+  Sqlite3Writer& operator=(const Sqlite3Writer&) = delete;
+
+  /// Open the database and start the writer thread.
+  Error Start(const Sqlite3WriterOptions& opts) {
+    if (running_.load()) {
+      return Error::Make(ErrorCode::kMisuse, "writer already started");
+    }
+    if (opts.path == nullptr) {
+      return Error::Make(ErrorCode::kNullParam, "path is null");
+    }
+    if (opts.max_batch == 0) {
+      return Error::Make(ErrorCode::kRange, "max_batch must be > 0");
+    }
+    Error err = db_.Open(opts.path, opts.open);
+    if (!err.ok()) { return err; }
+    db_.EnableBusyRetry(opts.busy);
+    // Jobs' ExecDml/Exec SQL is usually repeated: keep it prepared.
+    db_.EnableStatementCache(16);
+
+    opts_ = opts;
+    batch_ = new Node*[opts_.max_batch];
+    stop_.store(false);
+    running_.store(true);
+    thread_ = std::thread(&Sqlite3Writer::Run, this);
+    return Error::Ok();
+  }
+
+  /// Run every job already submitted, then stop the thread and close the
+  /// database. Later submissions fail with kMisuse.
+  void Stop() {
+    if (!running_.load()) { return; }
+    stop_.store(true);
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      cv_.notify_one();
+    }
+    thread_.join();
+    running_.store(false);
+    delete[] batch_;
+    batch_ = nullptr;
+    db_.Close();
+  }
+
+  bool Running() const { return running_.load(); }
+
+  // --- Submit ---
+
+  /// Queue a job; the future becomes ready after its batch commits.
+  std::future<WriteResult> Submit(Job job) {
+    Node* node = new Node;
+    node->job = std::move(job);
+    node->promise = new std::promise<WriteResult>;
+    std::future<WriteResult> future = node->promise->get_future();
+    Enqueue(node);
+    return future;
+  }
+
+  /// Queue a job; `done` runs on the writer thread after its batch
+  /// commits (or inline, if the writer is stopped).
+  void Submit(Job job, Callback done) {
+    Node* node = new Node;
+    node->job = std::move(job);
+    node->done = std::move(done);
+    Enqueue(node);
+  }
+
+  /// Queue one SQL statement (copied) for ExecDml.
+  std::future<WriteResult> SubmitDml(const char* sql) {
+    std::string text = (sql != nullptr) ? sql : "";
+    return Submit([text](Sqlite3Db& db, Error* out_error) {
+      return db.ExecDml(text.c_str(), out_error);
+    });
+  }
+
+  // --- Stats ---
+
+  Sqlite3WriterStats Stats() const {
+    Sqlite3WriterStats s;
+    s.jobs = jobs_.load(std::memory_order_relaxed);
+    s.failed = failed_.load(std::memory_order_relaxed);
+    s.batches = batches_.load(std::memory_order_relaxed);
+    s.largest_batch = largest_batch_.load(std::memory_order_relaxed);
+    return s;
+  }
+
+ private:
+  struct Link {
+    std::atomic<Link*> next{nullptr};
+  };
+
+  struct Node : Link {
+    Job job;
+    Callback done;
+    std::promise<WriteResult>* promise = nullptr;
+    WriteResult result;
+  };
+
+  // --- MPSC queue ---
+
+  void Enqueue(Node* node) {
+    // pending_ is raised before stop_ is checked; Run() reads them in the
+    // opposite order, so a job is either rejected here or drained there.
+    pending_.fetch_add(1);
+    if (stop_.load() || !running_.load()) {
+      pending_.fetch_sub(1);
+      Wake();  // A stopping writer may be waiting for this push
+      node->result.error = Error::Make(ErrorCode::kMisuse,
+                                       "writer not running");
+      Deliver(node);
+      return;
+    }
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Link* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+    linked_.fetch_add(1);
+    Wake();
+  }
+
+  /// Notify the writer thread if it is parked. It sleeps until linked_
+  /// moves past the value it read before its last empty Pop().
+  void Wake() {
+    if (sleeping_.load()) {
+      std::lock_guard<std::mutex> lock(mu_);
+      cv_.notify_one();
+    }
+  }
+
+  /// Consumer side. nullptr when empty or a producer is mid-push.
+  Node* Pop() {
+    Link* tail = tail_;
+    Link* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) { return nullptr; }
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (next == nullptr) {
+      if (tail != head_.load(std::memory_order_acquire)) { return nullptr; }
+      stub_.next.store(nullptr, std::memory_order_relaxed);
+      Link* prev = head_.exchange(&stub_, std::memory_order_acq_rel);
+      prev->next.store(&stub_, std::memory_order_release);
+      next = tail->next.load(std::memory_order_acquire);
+      if (next == nullptr) { return nullptr; }
+    }
+    tail_ = next;
+    pending_.fetch_sub(1);
+    return static_cast<Node*>(tail);
+  }
+
+  /// Block until a job arrives; nullptr once stopped and drained.
+  Node* PopWait() {
+    for (;;) {
+      uint64_t seen = linked_.load();
+      Node* node = Pop();
+      if (node != nullptr) { return node; }
+      if (Drained()) { return nullptr; }
+      // Empty, or a producer is mid-push: its linked_ bump wakes us.
+      std::unique_lock<std::mutex> lock(mu_);
+      sleeping_.store(true);
+      cv_.wait(lock, [this, seen] {
+        return linked_.load() != seen || Drained();
+      });
+      sleeping_.store(false);
+    }
+  }
+
+  /// Stopped with no push in flight (stop_ is read before pending_).
+  bool Drained() const { return stop_.load() && pending_.load() == 0; }
+
+  // --- Writer thread ---
+
+  void Run() {
+    for (;;) {
+      Node* first = PopWait();
+      if (first == nullptr) { return; }
+      uint32_t n = 0;
+      batch_[n++] = first;
+      Fill(&n);
+      RunBatch(n);
+    }
+  }
+
+  /// Top up the batch with queued jobs, waiting max_batch_delay_us at most.
+  void Fill(uint32_t* n) {
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::microseconds(opts_.max_batch_delay_us);
+    while (*n < opts_.max_batch) {
+      uint64_t seen = linked_.load();
+      Node* node = Pop();
+      if (node != nullptr) {
+        batch_[(*n)++] = node;
+        continue;
+      }
+      bool mid_push = pending_.load() > 0;
+      if (!mid_push && std::chrono::steady_clock::now() >= deadline) {
+        return;
+      }
+      std::unique_lock<std::mutex> lock(mu_);
+      sleeping_.store(true);
+      if (mid_push) {
+        // Rejected pushes (writer stopping) lower pending_ without a link.
+        cv_.wait(lock, [this, seen] {
+          return linked_.load() != seen || pending_.load() == 0;
+        });
+      } else {
+        cv_.wait_until(lock, deadline, [this, seen] {
+          return linked_.load() != seen || stop_.load();
+        });
+      }
+      sleeping_.store(false);
+    }
+  }
+
+  void RunBatch(uint32_t n) {
+    uint32_t txn_start = 0;  // First job of the open transaction
+    Error err = Begin();
+    for (uint32_t i = 0; i < n; ++i) {
+      Node* node = batch_[i];
+      if (!err.ok()) {
+        node->result.error = err;
+        continue;
+      }
+      RunJob(node);
+      if (!db_.InTransaction()) {
+        // The job's failure made SQLite roll back the whole transaction:
+        // earlier jobs of this batch are lost too.
+        Error lost = node->result.error.ok()
+            ? Error::Make(ErrorCode::kError, "transaction rolled back")
+            : node->result.error;
+        for (uint32_t j = txn_start; j < i; ++j) {
+          if (batch_[j]->result.error.ok()) { batch_[j]->result.error = lost; }
+        }
+        txn_start = i + 1;
+        err = Begin();
+      }
+    }
+    if (err.ok()) {
+      err = db_.Commit();
+      if (!err.ok()) {
+        err = RollbackFailedCommit(err);
+        for (uint32_t j = txn_start; j < n; ++j) {
+          if (batch_[j]->result.error.ok()) { batch_[j]->result.error = err; }
+        }
+      }
+    }
+
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    jobs_.fetch_add(n, std::memory_order_relaxed);
+    if (n > largest_batch_.load(std::memory_order_relaxed)) {
+      largest_batch_.store(n, std::memory_order_relaxed);
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      if (!batch_[i]->result.error.ok()) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+      }
+      Deliver(batch_[i]);
+    }
+  }
+
+  /// BEGIN IMMEDIATE; a lock held elsewhere is waited out by the busy
+  /// handler (opts_.busy) before this fails with kBusy.
+  Error Begin() {
+    if (db_.InTransaction()) {
+      // A ROLLBACK after a failed COMMIT failed too: try it again first.
+      Error err = db_.Rollback();
+      if (!err.ok()) { return err; }
+    }
+    return db_.BeginTransaction(TxnMode::kImmediate);
+  }
+
+  /// The batch is lost once COMMIT fails; a COMMIT still blocked (kBusy)
+  /// leaves the transaction open, so roll it back. Returns the error the
+  /// batch's jobs report.
+  Error RollbackFailedCommit(const Error& commit_err) {
+    if (!db_.InTransaction()) { return commit_err; }  // SQLite rolled back
+    Error rb = db_.Rollback();
+    if (rb.ok()) { return commit_err; }
+    Error err;
+    err.SetFormat(commit_err.code, "%s (rollback failed: %s)",
+                  commit_err.message, rb.message);
+    return err;
+  }
+
+  /// Run one job inside its own savepoint.
+  void RunJob(Node* node) {
+    WriteResult& r = node->result;
+    r.error = db_.Savepoint();
+    if (!r.error.ok()) { return; }
+    r.changes = node->job ? node->job(db_, &r.error) : -1;
+    if (r.error.ok() && r.changes < 0) {
+      r.error = Error::Make(ErrorCode::kError, "write job failed");
+    }
+    if (!db_.InTransaction()) { return; }
+    if (r.error.ok()) {
+      r.error = db_.ReleaseSavepoint();
+      if (r.error.ok()) { return; }
+    }
+    db_.RollbackToSavepoint();
+  }
+
+  static void Deliver(Node* node) {
+    if (node->promise != nullptr) {
+      node->promise->set_value(node->result);
+      delete node->promise;
+    } else if (node->done) {
+      node->done(node->result);
+    }
+    delete node;
+  }
+
+  Sqlite3Db db_;
+  Sqlite3WriterOptions opts_;
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  Node** batch_ = nullptr;
+
+  // Queue: producers exchange head_, the writer thread owns tail_.
+  Link stub_;
+  std::atomic<Link*> head_{&stub_};
+  Link* tail_ = &stub_;
+  std::atomic<uint64_t> pending_{0};  // Pushes started, not yet popped
+  std::atomic<uint64_t> linked_{0};   // Pushes completed
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> sleeping_{false};
+  std::mutex mu_;
+  std::condition_variable cv_;
+
+  std::atomic<uint64_t> jobs_{0};
+  std::atomic<uint64_t> failed_{0};
+  std::atomic<uint64_t> batches_{0};
+  std::atomic<uint64_t> largest_batch_{0};
+};
+
+}  // namespace dbpp
@@ -0,0 +1,144 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::Transaction<Db> -- scoped transaction / savepoint guard.
+//
+// Design:
+//   - RAII: rolls back on scope exit unless Commit() succeeded
+//   - The outermost guard on a connection begins a real transaction in the
+//     requested TxnMode; a guard created while a transaction is open
+//     becomes a nested SAVEPOINT (Commit = RELEASE, rollback = ROLLBACK
+//     TO + RELEASE), so helpers can open a guard without knowing whether
+//     their caller already did
+//   - Works with any connection exposing BeginTransaction(TxnMode),
+//     Commit/Rollback, Savepoint/ReleaseSavepoint/RollbackToSavepoint and
+//     SavepointDepth(): Sqlite3Db, MariaDb and Database<Backend>
+//   - A failed Commit() (e.g. kBusy) leaves the guard active: retry, or
+//     let it roll back
+//   - Move-only; guards must be released innermost first
+//
+// Usage:
+//   Transaction<Sqlite3Db> txn(db, TxnMode::kImmediate, &err);
+//   ...writes...
+//   err = txn.Commit();
+
+#pragma once
+
+#include <cstdint>
+
+#include "dbpp/error.hpp"
+
+namespace dbpp {
+
+/// How a transaction acquires locks.
+///   SQLite:  kDeferred = BEGIN DEFERRED, kImmediate = BEGIN IMMEDIATE
+///            (write lock up front: no BUSY on the read->write upgrade),
+///            kExclusive = BEGIN EXCLUSIVE, kReadOnly = BEGIN DEFERRED.
+///   MariaDB: kDeferred = START TRANSACTION, kImmediate/kExclusive =
+///            START TRANSACTION READ WRITE, kReadOnly = ... READ ONLY.
+enum class TxnMode : uint8_t {
+  kDeferred = 0,
+  kImmediate,
+  kExclusive,
+  kReadOnly
+};
+
+// ---------------------------------------------------------------------------
+// Transaction<Db>
+// ---------------------------------------------------------------------------
+
+template <typename Db>
+class Transaction {
+ public:
+  Transaction() = default;
+
+  /// Begin a transaction (or a savepoint if one is already open).
+  /// Check Active() or `out_error`.
+  explicit Transaction(Db& db, TxnMode mode = TxnMode::kDeferred,
+                       Error* out_error = nullptr) {
+    Error err = Begin(db, mode);
+    if (out_error != nullptr) { *out_error = err; }
+  }
+
+  ~Transaction() { Rollback(); }
+
+  // Move
+  Transaction(Transaction&& other) noexcept
+      : db_(other.db_), level_(other.level_) {
+    other.db_ = nullptr;
+  }
+
+  Transaction& operator=(Transaction&& other) noexcept {
+    if (this != &other) {
+      Rollback();
+      db_ = other.db_;
+      level_ = other.level_;
+      other.db_ = nullptr;
+    }
+    return *this;
+  }
+
+  // No copy
+  Transaction(const Transaction&) = delete;
+  Transaction& operator=(const Transaction&) = delete;
+
+  Error Begin(Db& db, TxnMode mode = TxnMode::kDeferred) {
+    Rollback();
+    Error err;
+    if (db.InTransaction()) {
+      err = db.Savepoint();
+      level_ = db.SavepointDepth();
+    } else {
+      err = db.BeginTransaction(mode);
+      level_ = 0;
+    }
+    if (err.ok()) { db_ = &db; }
+    return err;
+  }
+
+  /// COMMIT (outermost) or RELEASE (nested).
+  Error Commit() {
+    Error err = CheckInnermost();
+    if (!err.ok()) { return err; }
+    err = (level_ == 0) ? db_->Commit() : db_->ReleaseSavepoint();
+    if (err.ok()) { db_ = nullptr; }
+    return err;
+  }
+
+  /// ROLLBACK (outermost) or ROLLBACK TO + RELEASE (nested). Done by the
+  /// destructor when not committed.
+  Error Rollback() {
+    if (db_ == nullptr) { return Error::Ok(); }
+    Db* db = db_;
+    db_ = nullptr;
+    // SQLite may already have rolled the whole transaction back (e.g.
+    // after SQLITE_FULL): nothing left to undo.
+    if (!db->InTransaction()) { return Error::Ok(); }
+    if (level_ == 0) { return db->Rollback(); }
+    if (db->SavepointDepth() != level_) {
+      return Error::Make(ErrorCode::kMisuse, "inner transaction still open");
+    }
+    return db->RollbackToSavepoint();
+  }
+
+  bool Active() const { return db_ != nullptr; }
+  bool Nested() const { return level_ > 0; }
+
+  /// Savepoint level (1 = first nested guard); 0 for the outermost.
+  uint32_t Level() const { return level_; }
+
+ private:
+  Error CheckInnermost() const {
+    if (db_ == nullptr) {
+      return Error::Make(ErrorCode::kMisuse, "transaction not active");
+    }
+    if (db_->SavepointDepth() != level_) {
+      return Error::Make(ErrorCode::kMisuse, "inner transaction still open");
+    }
+    return Error::Ok();
+  }
+
+  Db* db_ = nullptr;
+  uint32_t level_ = 0;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,285 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp::TypedCursor<Query, Ts...> -- compile-time typed row iteration.
+//
+// Design:
+//   - Column count and (where the backend exposes it) column types are
+//     validated once, on construction; the per-row path does no checks
+//   - Each column is decoded by ColumnAccess<Query>::Read(), chosen by
+//     overload resolution at compile time; no runtime type switch
+//   - The generic ColumnAccess uses the query's public typed getters and
+//     field metadata (MariaQuery); Sqlite3Query specializes it to read
+//     sqlite3_column_* directly
+//   - Rows decode into std::tuple<Ts...>, an aggregate struct (GetAs<S>())
+//     or straight into a callback's arguments (ForEach)
+//   - Range-for support; the cursor borrows an lvalue query or takes
+//     ownership of an rvalue one, so db.ExecQuery(...).As<...>() is safe
+//
+// Supported column types: integral, floating point, const char*,
+// std::string, TextView, BlobView (std::string_view with C++17) and
+// Nullable<T> of any of those.
+//
+// Usage:
+//   auto q = db.ExecQuery("SELECT id, name, score FROM t;");
+//   for (auto row : q.As<int64_t, dbpp::TextView, double>()) {
+//     int64_t id = std::get<0>(row);
+//   }
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+#include "dbpp/error.hpp"
+#include "dbpp/value_types.hpp"
+
+namespace dbpp {
+
+template <typename T>
+struct TypeTag {};
+
+// ---------------------------------------------------------------------------
+// ColumnAccess<Query> -- generic decoder over public getters
+// ---------------------------------------------------------------------------
+
+template <typename Query>
+struct ColumnAccess {
+  /// Type check against the result metadata (MariaQuery's FieldIs*),
+  /// with the rules of ColumnAccess<Sqlite3Query>: integers for integral
+  /// types, any number for floating point, non-numeric text for strings
+  /// and also binary for BlobView. A NULL first-row cell (e.g. a bare
+  /// SELECT NULL column) is accepted. BIGINT UNSIGNED passes as integral
+  /// but values above INT64_MAX are clamped; read them as text.
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value, bool>::type
+  Check(const Query& q, int32_t col, TypeTag<T>) {
+    return q.FieldIsInteger(col) || q.FieldIsNull(col);
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+  Check(const Query& q, int32_t col, TypeTag<T>) {
+    return q.FieldIsNumeric(col) || q.FieldIsNull(col);
+  }
+
+  template <typename T>
+  static typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+  Check(const Query& q, int32_t col, TypeTag<T>) {
+    if (q.FieldIsNull(col)) { return true; }
+    if (q.FieldIsBinary(col)) { return std::is_same<T, BlobView>::value; }
+    return !q.FieldIsNumeric(col);
+  }
+
+  template <typename T>
+  static bool Check(const Query& q, int32_t col, TypeTag<Nullable<T>>) {
+    return Check(q, col, TypeTag<T>{});
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_integral<T>::value>::type
+  Read(const Query& q, int32_t col, T& out) {
+    out = static_cast<T>(q.GetInt64(col));
+  }
+
+  template <typename T>
+  static typename std::enable_if<std::is_floating_point<T>::value>::type
+  Read(const Query& q, int32_t col, T& out) {
+    out = static_cast<T>(q.GetDouble(col));
+  }
+
+  static void Read(const Query& q, int32_t col, const char*& out) {
+    out = q.GetString(col);
+  }
+
+  static void Read(const Query& q, int32_t col, TextView& out) {
+    int32_t len = 0;
+    const uint8_t* p = q.GetBlob(col, len);
+    out = TextView(reinterpret_cast<const char*>(p), len);
+  }
+
+  static void Read(const Query& q, int32_t col, BlobView& out) {
+    int32_t len = 0;
+    const uint8_t* p = q.GetBlob(col, len);
+    out = BlobView(p, len);
+  }
+
+  static void Read(const Query& q, int32_t col, std::string& out) {
+    TextView v;
+    Read(q, col, v);
+    out.assign(v.data != nullptr ? v.data : "", static_cast<size_t>(v.size));
+  }
+
+#if __cplusplus >= 201703L
+  static void Read(const Query& q, int32_t col, std::string_view& out) {
+    TextView v;
+    Read(q, col, v);
+    out = std::string_view(v.data, static_cast<size_t>(v.size));
+  }
+#endif
+
+  template <typename T>
+  static void Read(const Query& q, int32_t col, Nullable<T>& out) {
+    out.is_null = q.FieldIsNull(col);
+    if (!out.is_null) { Read(q, col, out.value); }
+  }
+};
+
+// ---------------------------------------------------------------------------
+// TypedCursor<Query, Ts...>
+// ---------------------------------------------------------------------------
+
+template <typename Query, typename... Ts>
+class TypedCursor {
+ public:
+  using Row = std::tuple<Ts...>;
+  using Access = ColumnAccess<Query>;
+  static constexpr int32_t kNumColumns = static_cast<int32_t>(sizeof...(Ts));
+
+  /// Borrow `query`; it must outlive the cursor.
+  TypedCursor(Query& query, Error* out_error) : query_(&query) {
+    Validate(out_error);
+  }
+
+  /// Take ownership of a temporary query.
+  TypedCursor(Query&& query, Error* out_error)
+      : owned_(std::move(query)), query_(&owned_) {
+    Validate(out_error);
+  }
+
+  // Move
+  TypedCursor(TypedCursor&& other) noexcept
+      : owned_(std::move(other.owned_)),
+        query_(other.query_ == &other.owned_ ? &owned_ : other.query_),
+        valid_(other.valid_) {
+    other.query_ = nullptr;
+    other.valid_ = false;
+  }
+
+  // No copy, no assignment
+  TypedCursor(const TypedCursor&) = delete;
+  TypedCursor& operator=(const TypedCursor&) = delete;
+  TypedCursor& operator=(TypedCursor&&) = delete;
+
+  /// False if column count or types did not match.
+  bool Valid() const { return valid_; }
+  bool Eof() const { return !valid_ || query_->Eof(); }
+  void Next() { query_->NextRow(); }
+
+  /// Decode the current row.
+  Row Get() const { return GetImpl(std::index_sequence_for<Ts...>{}); }
+
+  /// Decode the current row into an aggregate: S{col0, col1, ...}.
+  template <typename S>
+  S GetAs() const {
+    return GetAsImpl<S>(std::index_sequence_for<Ts...>{});
+  }
+
+  /// Call fn(col0, col1, ...) for every remaining row. Returns ToError().
+  template <typename Fn>
+  Error ForEach(Fn&& fn) {
+    while (!Eof()) {
+      CallImpl(fn, std::index_sequence_for<Ts...>{});
+      Next();
+    }
+    return ToError();
+  }
+
+  /// Why the rows ended: ok at the real end, else the query's failed step
+  /// (the rows seen are a prefix). Check it after a range-for loop.
+  Error ToError() const {
+    return query_ != nullptr ? query_->ToError() : Error::Ok();
+  }
+
+  // --- Range-for ---
+
+  class Iterator {
+   public:
+    explicit Iterator(TypedCursor* cursor) : cursor_(cursor) {}
+    Row operator*() const { return cursor_->Get(); }
+    Iterator& operator++() {
+      cursor_->Next();
+      return *this;
+    }
+    bool operator==(const Iterator& other) const {
+      return AtEnd() == other.AtEnd();
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    bool AtEnd() const { return cursor_ == nullptr || cursor_->Eof(); }
+    TypedCursor* cursor_;
+  };
+
+  Iterator begin() { return Iterator(this); }
+  Iterator end() { return Iterator(nullptr); }
+
+ private:
+  void Validate(Error* out_error) {
+    valid_ = false;
+    if (query_->NumFields() != kNumColumns) {
+      if (out_error != nullptr && out_error->ok()) {
+        out_error->SetFormat(ErrorCode::kMismatch,
+                             "column count mismatch: query has %d, "
+                             "cursor expects %d",
+                             query_->NumFields(), kNumColumns);
+      }
+      return;
+    }
+    if (!query_->Eof()) {
+      int32_t bad = CheckTypes(std::index_sequence_for<Ts...>{});
+      if (bad >= 0) {
+        if (out_error != nullptr && out_error->ok()) {
+          out_error->SetFormat(ErrorCode::kMismatch,
+                               "column %d type mismatch", bad);
+        }
+        return;
+      }
+    }
+    valid_ = true;
+  }
+
+  /// Index of the first incompatible column, or -1.
+  template <size_t... I>
+  int32_t CheckTypes(std::index_sequence<I...>) const {
+    const bool ok[] = {true, Access::Check(*query_, static_cast<int32_t>(I),
+                                           TypeTag<Ts>{})...};
+    for (int32_t i = 0; i < kNumColumns; ++i) {
+      if (!ok[i + 1]) { return i; }
+    }
+    return -1;
+  }
+
+  template <typename T>
+  T ReadColumn(int32_t col) const {
+    T value{};
+    Access::Read(*query_, col, value);
+    return value;
+  }
+
+  template <size_t... I>
+  Row GetImpl(std::index_sequence<I...>) const {
+    return Row(ReadColumn<Ts>(static_cast<int32_t>(I))...);
+  }
+
+  template <typename S, size_t... I>
+  S GetAsImpl(std::index_sequence<I...>) const {
+    return S{ReadColumn<Ts>(static_cast<int32_t>(I))...};
+  }
+
+  template <typename Fn, size_t... I>
+  void CallImpl(Fn& fn, std::index_sequence<I...>) const {
+    fn(ReadColumn<Ts>(static_cast<int32_t>(I))...);
+  }
+
+  Query owned_;
+  Query* query_ = nullptr;
+  bool valid_ = false;
+};
+
+}  // namespace dbpp
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 liudegui. MIT License.
+//
+// dbpp value types -- non-owning views and nullable wrapper.
+//
+// Design:
+//   - TextView / BlobView: pointer + length, no allocation, no strlen on
+//     the hot path (C++14 stand-in for std::string_view)
+//   - Nullable<T>: value + null flag for columns/parameters that may be NULL
+//   - ZeroBlob: parameter bound as a zero-filled blob of a given size,
+//     preallocated for incremental writes (SQLite)
+//   - Backend-independent, shared by typed cursors and parameter binding
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace dbpp {
+
+// ---------------------------------------------------------------------------
+// TextView
+// ---------------------------------------------------------------------------
+
+struct TextView {
+  const char* data = nullptr;
+  int32_t size = 0;
+
+  TextView() = default;
+  TextView(const char* s, int32_t n) : data(s), size(n) {}
+  TextView(const char* s)  // NOLINT(runtime/explicit)
+      : data(s), size(s ? static_cast<int32_t>(std::strlen(s)) : 0) {}
+
+  bool empty() const { return size == 0; }
+};
+
+inline bool operator==(const TextView& a, const TextView& b) {
+  return a.size == b.size &&
+         (a.size == 0 || std::memcmp(a.data, b.data, a.size) == 0);
+}
+
+inline bool operator!=(const TextView& a, const TextView& b) {
+  return !(a == b);
+}
+
+// ---------------------------------------------------------------------------
+// BlobView
+// ---------------------------------------------------------------------------
+
+struct BlobView {
+  const uint8_t* data = nullptr;
+  int32_t size = 0;
+
+  BlobView() = default;
+  BlobView(const void* p, int32_t n)
+      : data(static_cast<const uint8_t*>(p)), size(n) {}
+
+  bool empty() const { return size == 0; }
+};
+
+// ---------------------------------------------------------------------------
+// ZeroBlob
+// ---------------------------------------------------------------------------
+
+struct ZeroBlob {
+  int64_t size = 0;
+
+  ZeroBlob() = default;
+  explicit ZeroBlob(int64_t n) : size(n) {}
+};
+
+// ---------------------------------------------------------------------------
+// Nullable<T>
+// ---------------------------------------------------------------------------
+
+template <typename T>
+struct Nullable {
+  T value{};
+  bool is_null = true;
+
+  Nullable() = default;
+  Nullable(const T& v) : value(v), is_null(false) {}  // NOLINT
+
+  bool has_value() const { return !is_null; }
+  T value_or(const T& fallback) const { return is_null ? fallback : value; }
+};
+
+}  // namespace dbpp
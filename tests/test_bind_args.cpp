@@ -0,0 +1,158 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for variadic binding (BindAll/BindAllNoCopy/Exec).
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "dbpp/db.hpp"
+
+using namespace dbpp;
+
+static Db OpenTestDb() {
+  Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE t(i INTEGER, big INTEGER, r REAL, s TEXT, b BLOB);");
+  return db;
+}
+
+TEST_CASE("BindAll: mixed types in one call", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t VALUES(?, ?, ?, ?, ?);");
+  REQUIRE(stmt.Valid());
+
+  const uint8_t blob[] = {0x01, 0x00, 0x02};
+  std::string name = "alpha";
+  REQUIRE(stmt.BindAll(static_cast<int16_t>(7), INT64_C(1) << 40, 2.5f,
+                       name, BlobView(blob, 3)).ok());
+  REQUIRE(stmt.ExecDml() == 1);
+
+  auto q = db.ExecQuery("SELECT i, big, r, s, length(b) FROM t;");
+  REQUIRE(q.GetInt(0) == 7);
+  REQUIRE(q.GetInt64(1) == (INT64_C(1) << 40));
+  REQUIRE(q.GetDouble(2) == Catch::Approx(2.5));
+  REQUIRE(std::strcmp(q.GetString(3), "alpha") == 0);
+  REQUIRE(q.GetInt(4) == 3);
+}
+
+TEST_CASE("BindAll: TextView carries its length", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(s) VALUES(?);");
+  const char buf[] = "abcdef";
+  REQUIRE(stmt.BindAll(TextView(buf, 3)).ok());
+  REQUIRE(stmt.ExecDml() == 1);
+  REQUIRE(db.ExecScalar("SELECT length(s) FROM t;") == 3);
+}
+
+TEST_CASE("BindAll: NULL from nullptr, null char* and Nullable",
+          "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(i, r, s) VALUES(?, ?, ?);");
+  const char* none = nullptr;
+  REQUIRE(stmt.BindAll(nullptr, Nullable<double>(), none).ok());
+  REQUIRE(stmt.ExecDml() == 1);
+  REQUIRE(stmt.BindAll(Nullable<int32_t>(5), Nullable<double>(1.0),
+                       "x").ok());
+  REQUIRE(stmt.ExecDml() == 1);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t WHERE i IS NULL AND "
+                        "r IS NULL AND s IS NULL;") == 1);
+  REQUIRE(db.ExecScalar("SELECT i FROM t WHERE s = 'x';") == 5);
+}
+
+TEST_CASE("BindAll: too many args reports an error", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(i) VALUES(?);");
+  REQUIRE_FALSE(stmt.BindAll(1, 2).ok());
+}
+
+TEST_CASE("BindAll: copied text survives the source buffer", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(s) VALUES(?);");
+  char buf[8];
+  std::strcpy(buf, "keep");
+  REQUIRE(stmt.BindAll(TextView(buf, 4)).ok());
+  std::strcpy(buf, "XXXX");
+  REQUIRE(stmt.ExecDml() == 1);
+  auto q = db.ExecQuery("SELECT s FROM t;");
+  REQUIRE(std::strcmp(q.GetString(0), "keep") == 0);
+}
+
+TEST_CASE("BindAllNoCopy: binds caller buffers in place", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(s, b) VALUES(?, ?);");
+  char text[8];
+  std::strcpy(text, "temp");
+  const uint8_t blob[] = {9, 8, 7, 6};
+  REQUIRE(stmt.BindAllNoCopy(TextView(text, 4), BlobView(blob, 4)).ok());
+  // The statement reads the buffer at execution time.
+  std::strcpy(text, "live");
+  REQUIRE(stmt.ExecDml() == 1);
+  auto q = db.ExecQuery("SELECT s, length(b) FROM t;");
+  REQUIRE(std::strcmp(q.GetString(0), "live") == 0);
+  REQUIRE(q.GetInt(1) == 4);
+}
+
+TEST_CASE("Statement Exec: bind and execute per row", "[bind_args]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO t(i, s) VALUES(?, ?);");
+  for (int32_t i = 0; i < 10; ++i) {
+    REQUIRE(stmt.Exec(i, "row") == 1);
+  }
+  REQUIRE(db.ExecScalar("SELECT SUM(i) FROM t;") == 45);
+  REQUIRE(stmt.Exec(1, 2, 3) == -1);
+}
+
+TEST_CASE("Database Exec: parameterized one-shot statement", "[bind_args]") {
+  auto db = OpenTestDb();
+  REQUIRE(db.Exec("INSERT INTO t(i, s) VALUES(?, ?);", 1, "a") == 1);
+  REQUIRE(db.Exec("INSERT INTO t(i, s) VALUES(?, ?);", 2,
+                  std::string("b")) == 1);
+  REQUIRE(db.Exec("UPDATE t SET i = i + ? WHERE s = ?;", 10, "a") == 1);
+  REQUIRE(db.ExecScalar("SELECT i FROM t WHERE s = 'a';") == 11);
+  REQUIRE(db.Exec("INSERT INTO missing VALUES(?);", 1) == -1);
+}
+
+TEST_CASE("Database Exec: trailing Error* reports failures",
+          "[bind_args]") {
+  auto db = OpenTestDb();
+  db.ExecDml("CREATE TABLE u(id INTEGER PRIMARY KEY);");
+  Error err;
+  REQUIRE(db.Exec("INSERT INTO u VALUES(?);", 1, &err) == 1);
+  REQUIRE(err.ok());
+  REQUIRE(db.Exec("INSERT INTO u VALUES(?);", 1, &err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+  REQUIRE(std::strstr(err.message, "UNIQUE") != nullptr);
+
+  err.Clear();
+  REQUIRE(db.Exec("INSERT INTO missing VALUES(?);", 1, &err) == -1);
+  REQUIRE(std::strstr(err.message, "missing") != nullptr);
+
+  err.Clear();
+  REQUIRE(db.Exec("INSERT INTO u VALUES(?);", 2, 3, &err) == -1);
+  REQUIRE(std::strstr(err.message, "out of range") != nullptr);
+
+  // No arguments besides the Error*
+  err.Clear();
+  REQUIRE(db.Exec("DELETE FROM u;", &err) == 1);
+  REQUIRE(err.ok());
+
+  Db closed;
+  REQUIRE(closed.Exec("SELECT 1;", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+}
+
+TEST_CASE("Database Exec: uses the statement cache", "[bind_args]") {
+  auto db = OpenTestDb();
+  db.Impl().EnableStatementCache(4);
+  for (int32_t i = 0; i < 5; ++i) {
+    REQUIRE(db.Exec("INSERT INTO t(i) VALUES(?);", i) == 1);
+  }
+  auto stats = db.Impl().StatementCacheStats();
+  REQUIRE(stats.misses == 1);
+  REQUIRE(stats.hits == 4);
+  // Bindings are cleared when a statement goes back to the cache.
+  REQUIRE(db.Exec("INSERT INTO t(i) VALUES(?);") == 1);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t WHERE i IS NULL;") == 1);
+}
@@ -0,0 +1,169 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::BulkInserter<Backend> (using SQLite3 backend).
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+#include "dbpp/bulk_inserter.hpp"
+
+using namespace dbpp;
+
+static Db OpenTestDb() {
+  Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, score REAL);");
+  return db;
+}
+
+TEST_CASE("BulkInserter: variadic insert", "[bulk_inserter]") {
+  auto db = OpenTestDb();
+  BulkInserter<> bulk;
+  REQUIRE(bulk.Begin(db, "INSERT INTO t VALUES(?, ?, ?);").ok());
+
+  REQUIRE(bulk.Insert(1, "Alice", 9.5).ok());
+  REQUIRE(bulk.Insert(int64_t{5000000000}, std::string("Bob"), 7.0f).ok());
+  REQUIRE(bulk.Insert(3, nullptr, 1).ok());
+  REQUIRE(db.InTransaction());
+  REQUIRE(bulk.Finish().ok());
+  REQUIRE_FALSE(db.InTransaction());
+
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t;") == 3);
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t WHERE name IS NULL;") == 1);
+  auto q = db.ExecQuery("SELECT id, score FROM t WHERE name = 'Bob';");
+  REQUIRE(q.GetInt64(0) == 5000000000LL);
+  REQUIRE(q.GetDouble(1) == Catch::Approx(7.0));
+
+  auto stats = bulk.Stats();
+  REQUIRE(stats.rows == 3);
+  REQUIRE(stats.errors == 0);
+  REQUIRE(stats.commits == 1);
+}
+
+TEST_CASE("BulkInserter: commits every N rows", "[bulk_inserter]") {
+  auto db = OpenTestDb();
+  BulkInserter<> bulk;
+  BulkInsertOptions opts;
+  opts.rows_per_txn = 100;
+  opts.max_txn_ms = 0;
+  REQUIRE(bulk.Begin(db, "INSERT INTO t(id) VALUES(?);", opts).ok());
+
+  for (int32_t i = 0; i < 250; ++i) {
+    REQUIRE(bulk.Insert(i).ok());
+  }
+  REQUIRE(bulk.Stats().commits == 2);
+  REQUIRE(db.InTransaction());  // 50 rows pending
+  bulk.Finish();
+  REQUIRE(bulk.Stats().commits == 3);
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t;") == 250);
+  REQUIRE(bulk.Stats().RowsPerSec() > 0.0);
+}
+
+TEST_CASE("BulkInserter: tuples and row callback", "[bulk_inserter]") {
+  auto db = OpenTestDb();
+  BulkInserter<> bulk;
+  REQUIRE(bulk.Begin(db, "INSERT INTO t VALUES(?, ?, ?);").ok());
+
+  REQUIRE(bulk.InsertTuple(std::make_tuple(1, "one", 1.0)).ok());
+
+  int32_t next = 2;
+  auto err = bulk.InsertRows([&next](Statement& stmt) {
+    if (next > 10) { return false; }
+    stmt.Bind(1, next);
+    stmt.Bind(2, "cb");
+    stmt.Bind(3, next * 0.5);
+    ++next;
+    return true;
+  });
+  REQUIRE(err.ok());
+  bulk.Finish();
+
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t;") == 10);
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t WHERE name = 'cb';") == 9);
+}
+
+TEST_CASE("BulkInserter: outer transaction is left to caller",
+          "[bulk_inserter]") {
+  auto db = OpenTestDb();
+  db.BeginTransaction();
+
+  BulkInserter<> bulk;
+  BulkInsertOptions opts;
+  opts.rows_per_txn = 1;
+  REQUIRE(bulk.Begin(db, "INSERT INTO t(id) VALUES(?);", opts).ok());
+  bulk.Insert(1);
+  bulk.Insert(2);
+  bulk.Finish();
+  REQUIRE(bulk.Stats().commits == 0);
+  REQUIRE(db.InTransaction());
+
+  db.Rollback();
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM t;") == 0);
+}
+
+TEST_CASE("BulkInserter: a busy commit keeps the chunk",
+          "[bulk_inserter]") {
+  const char* path = "dbpp_test_bulk.db";
+  std::remove(path);
+  Db db;
+  Db reader;
+  REQUIRE(db.Open(path).ok());
+  REQUIRE(reader.Open(path).ok());
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, score REAL);");
+
+  BulkInserter<> bulk;
+  BulkInsertOptions opts;
+  opts.rows_per_txn = 0;
+  opts.max_txn_ms = 0;
+  REQUIRE(bulk.Begin(db, "INSERT INTO t VALUES(?, ?, ?);", opts).ok());
+  REQUIRE(bulk.Insert(1, "a", 1.0).ok());
+  REQUIRE(bulk.Insert(2, "b", 2.0).ok());
+
+  {
+    // An open read holds a shared lock: COMMIT cannot take the file
+    auto q = reader.ExecQuery("SELECT count(*) FROM t;");
+    REQUIRE(bulk.Flush().code == ErrorCode::kBusy);
+    REQUIRE(db.InTransaction());
+  }
+  REQUIRE(bulk.Flush().ok());
+  REQUIRE(reader.ExecScalar("SELECT count(*) FROM t;") == 2);
+
+  // Finish() does not leave a failed chunk open
+  REQUIRE(bulk.Insert(3, "c", 3.0).ok());
+  {
+    auto q = reader.ExecQuery("SELECT count(*) FROM t;");
+    REQUIRE(bulk.Finish().code == ErrorCode::kBusy);
+    REQUIRE_FALSE(db.InTransaction());
+  }
+  REQUIRE(reader.ExecScalar("SELECT count(*) FROM t;") == 2);
+
+  db.Close();
+  reader.Close();
+  std::remove(path);
+}
+
+TEST_CASE("BulkInserter: errors and abort", "[bulk_inserter]") {
+  auto db = OpenTestDb();
+  db.ExecDml("CREATE TABLE u(id INTEGER PRIMARY KEY);");
+
+  BulkInserter<> bulk;
+  Error err = bulk.Insert(1);
+  REQUIRE(err.code == ErrorCode::kMisuse);
+
+  err = bulk.Begin(db, "INSERT INTO nonexistent VALUES(?);");
+  REQUIRE_FALSE(err.ok());
+  REQUIRE_FALSE(bulk.Active());
+
+  REQUIRE(bulk.Begin(db, "INSERT INTO u VALUES(?);").ok());
+  REQUIRE(bulk.Insert(1).ok());
+  REQUIRE_FALSE(bulk.Insert(1).ok());  // duplicate key
+  REQUIRE(bulk.Insert(2).ok());
+  REQUIRE(bulk.Stats().errors == 1);
+
+  REQUIRE(bulk.Abort().ok());
+  bulk.Finish();
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM u;") == 0);
+}
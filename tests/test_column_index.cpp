@@ -0,0 +1,111 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::ColumnIndex / ColumnRef (named column access).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+/// Table w(c0 .. c{n-1}) with one row where c{i} = i.
+static void MakeWideTable(Sqlite3Db& db, int32_t cols) {
+  std::string create = "CREATE TABLE w(";
+  std::string insert = "INSERT INTO w VALUES(";
+  for (int32_t i = 0; i < cols; ++i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%sc%d INTEGER", i ? ", " : "", i);
+    create += buf;
+    std::snprintf(buf, sizeof(buf), "%s%d", i ? ", " : "", i);
+    insert += buf;
+  }
+  db.ExecDml((create + ");").c_str());
+  db.ExecDml((insert + ");").c_str());
+}
+
+TEST_CASE("ColumnIndex: linear and hashed lookups agree", "[column_index]") {
+  const char* names[] = {"a", "b", "c", "dup", "dup", nullptr, "e", "f",
+                         "g", "h", "i", "j"};
+  auto name_of = [&names](int32_t i) { return names[i]; };
+
+  ColumnIndex narrow;
+  REQUIRE(narrow.Find("c", 4, name_of) == 2);
+  REQUIRE_FALSE(narrow.Built());
+
+  ColumnIndex wide;
+  REQUIRE(wide.Find("j", 12, name_of) == 11);
+  REQUIRE(wide.Built());
+  REQUIRE(wide.Find("a", 12, name_of) == 0);
+  REQUIRE(wide.Find("dup", 12, name_of) == 3);  // First duplicate wins
+  REQUIRE(wide.Find("missing", 12, name_of) == -1);
+  REQUIRE(wide.Find(nullptr, 12, name_of) == -1);
+
+  ColumnIndex moved(std::move(wide));
+  REQUIRE(moved.Built());
+  REQUIRE_FALSE(wide.Built());
+  REQUIRE(moved.Find("e", 12, name_of) == 6);
+}
+
+TEST_CASE("ColumnIndex: wide query by name", "[column_index]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  MakeWideTable(db, 64);
+
+  auto q = db.ExecQuery("SELECT * FROM w;");
+  REQUIRE(q.NumFields() == 64);
+  for (int32_t i = 0; i < 64; ++i) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "c%d", i);
+    REQUIRE(q.FieldIndex(name) == i);
+    REQUIRE(q.GetInt(name) == i);
+  }
+  REQUIRE(q.FieldIndex("nope") == -1);
+  REQUIRE(q.GetInt("nope", -7) == -7);
+}
+
+TEST_CASE("ColumnRef: resolve once, read in the loop", "[column_index]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, price REAL);");
+  db.ExecDml("INSERT INTO t VALUES(1, 'a', 1.5), (2, 'b', 2.5);");
+
+  auto q = db.ExecQuery("SELECT id, name, price FROM t ORDER BY id;");
+  ColumnRef id = q.Column("id");
+  ColumnRef price = q.Column("price");
+  ColumnRef missing = q.Column("missing");
+  REQUIRE(id.valid());
+  REQUIRE(price.index == 2);
+  REQUIRE_FALSE(missing.valid());
+
+  double sum = 0.0;
+  int32_t ids = 0;
+  for (; !q.Eof(); q.NextRow()) {
+    ids += q.GetInt(id);
+    sum += q.GetDouble(price);
+    REQUIRE(q.GetInt(missing, -1) == -1);
+  }
+  REQUIRE(ids == 3);
+  REQUIRE(sum == 4.0);
+}
+
+TEST_CASE("ColumnIndex: result sets and move", "[column_index]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  MakeWideTable(db, 20);
+
+  auto rs = db.GetResultSet("SELECT * FROM w;");
+  REQUIRE(rs.FieldIndex("c19") == 19);
+  ColumnRef c7 = rs.Column("c7");
+  REQUIRE(std::string(rs.FieldValue(c7)) == "7");
+
+  Sqlite3ResultSet moved(std::move(rs));
+  REQUIRE(moved.FieldIndex("c12") == 12);
+  REQUIRE(rs.FieldIndex("c12") == -1);
+
+  auto typed = db.GetTypedResultSet("SELECT * FROM w;");
+  REQUIRE(typed.GetInt64("c15") == 15);
+  REQUIRE(typed.GetInt64(typed.Column("c3")) == 3);
+  typed.Finalize();
+  REQUIRE(typed.FieldIndex("c3") == -1);
+}
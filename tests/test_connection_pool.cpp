@@ -0,0 +1,212 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::ConnectionPool<Backend> (using SQLite3 backend).
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "dbpp/connection_pool.hpp"
+
+using namespace dbpp;
+
+static ConnectionPoolOptions MakeOptions(uint32_t min_size,
+                                         uint32_t max_size) {
+  ConnectionPoolOptions opts;
+  opts.dsn = ":memory:";
+  opts.min_size = min_size;
+  opts.max_size = max_size;
+  return opts;
+}
+
+TEST_CASE("ConnectionPool: init opens min_size", "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(2, 4)).ok());
+
+  auto stats = pool.Stats();
+  REQUIRE(stats.open == 2);
+  REQUIRE(stats.in_use == 0);
+  REQUIRE(stats.max_size == 4);
+}
+
+TEST_CASE("ConnectionPool: invalid options", "[connection_pool]") {
+  ConnectionPool<> pool;
+  ConnectionPoolOptions opts;
+  REQUIRE(pool.Init(opts).code == ErrorCode::kNullParam);
+  REQUIRE(pool.Init(MakeOptions(3, 2)).code == ErrorCode::kRange);
+  REQUIRE(pool.Init(MakeOptions(0, 0)).code == ErrorCode::kRange);
+
+  Error err;
+  auto conn = pool.Acquire(0, &err);
+  REQUIRE_FALSE(conn.Valid());
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+}
+
+TEST_CASE("ConnectionPool: acquire and release", "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(1, 2)).ok());
+
+  {
+    auto conn = pool.Acquire(100);
+    REQUIRE(conn.Valid());
+    REQUIRE(conn->IsOpen());
+    conn->ExecDml("CREATE TABLE t(id INTEGER);");
+    REQUIRE(conn->TableExists("t"));
+    REQUIRE(pool.Stats().in_use == 1);
+  }
+  REQUIRE(pool.Stats().in_use == 0);
+
+  // LIFO reuse: same in-memory database comes back
+  auto conn = pool.Acquire(100);
+  REQUIRE(conn->TableExists("t"));
+  REQUIRE(pool.Stats().opens == 1);
+}
+
+TEST_CASE("ConnectionPool: grows on demand up to max", "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(0, 2)).ok());
+  REQUIRE(pool.Stats().open == 0);
+
+  auto c1 = pool.Acquire(100);
+  auto c2 = pool.Acquire(100);
+  REQUIRE(c1.Valid());
+  REQUIRE(c2.Valid());
+  REQUIRE(pool.Stats().open == 2);
+  REQUIRE(pool.Stats().Utilization() == 1.0);
+
+  Error err;
+  auto c3 = pool.TryAcquire(&err);
+  REQUIRE_FALSE(c3.Valid());
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(pool.Stats().timeouts == 1);
+}
+
+TEST_CASE("ConnectionPool: waiter wakes on release", "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(1, 1)).ok());
+
+  auto held = pool.Acquire(100);
+  REQUIRE(held.Valid());
+
+  std::thread releaser([&held]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    held.Release();
+  });
+
+  auto conn = pool.Acquire(2000);
+  releaser.join();
+  REQUIRE(conn.Valid());
+
+  auto stats = pool.Stats();
+  REQUIRE(stats.waits == 1);
+  REQUIRE(stats.max_wait_us > 0);
+}
+
+TEST_CASE("ConnectionPool: rolls back open transaction on return",
+          "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(1, 1)).ok());
+  {
+    auto conn = pool.Acquire(100);
+    conn->ExecDml("CREATE TABLE t(id INTEGER);");
+    conn->BeginTransaction();
+    conn->ExecDml("INSERT INTO t VALUES(1);");
+  }
+  auto conn = pool.Acquire(100);
+  REQUIRE_FALSE(conn->InTransaction());
+  REQUIRE(conn->ExecScalar("SELECT count(*) FROM t;") == 0);
+}
+
+TEST_CASE("ConnectionPool: on_open hook", "[connection_pool]") {
+  ConnectionPool<> pool;
+  auto opts = MakeOptions(2, 2);
+  int32_t calls = 0;
+  opts.on_open = [&calls](Db& db) {
+    ++calls;
+    db.Impl().EnableStatementCache(16);
+    return Error::Ok();
+  };
+  REQUIRE(pool.Init(opts).ok());
+  REQUIRE(calls == 2);
+
+  auto conn = pool.Acquire(100);
+  REQUIRE(conn->Impl().StatementCacheEnabled());
+}
+
+TEST_CASE("ConnectionPool: failing on_open", "[connection_pool]") {
+  ConnectionPool<> pool;
+  auto opts = MakeOptions(1, 1);
+  opts.on_open = [](Db&) { return Error::Make(ErrorCode::kError, "nope"); };
+  REQUIRE(pool.Init(opts).code == ErrorCode::kError);
+
+  // Pool can be initialized again after a failed Init()
+  REQUIRE(pool.Init(MakeOptions(1, 1)).ok());
+}
+
+TEST_CASE("ConnectionPool: idle eviction keeps min_size", "[connection_pool]") {
+  ConnectionPool<> pool;
+  auto opts = MakeOptions(1, 3);
+  opts.idle_timeout_ms = 1;
+  REQUIRE(pool.Init(opts).ok());
+
+  {
+    auto c1 = pool.Acquire(100);
+    auto c2 = pool.Acquire(100);
+    auto c3 = pool.Acquire(100);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  pool.EvictIdle();
+
+  auto stats = pool.Stats();
+  REQUIRE(stats.open == 1);
+  REQUIRE(stats.evictions == 2);
+}
+
+TEST_CASE("ConnectionPool: shutdown", "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(1, 2)).ok());
+  auto held = pool.Acquire(100);
+
+  pool.Shutdown();
+  REQUIRE(pool.Stats().open == 1);
+  REQUIRE_FALSE(pool.Acquire(0).Valid());
+
+  held.Release();
+  REQUIRE(pool.Stats().open == 0);
+}
+
+TEST_CASE("ConnectionPool: concurrent checkouts stay bounded",
+          "[connection_pool]") {
+  ConnectionPool<> pool;
+  REQUIRE(pool.Init(MakeOptions(1, 3)).ok());
+
+  std::atomic<int32_t> active{0};
+  std::atomic<int32_t> max_active{0};
+  std::atomic<int32_t> failures{0};
+  std::vector<std::thread> workers;
+  for (int32_t t = 0; t < 8; ++t) {
+    workers.emplace_back([&]() {
+      for (int32_t i = 0; i < 50; ++i) {
+        auto conn = pool.Acquire(5000);
+        if (!conn) {
+          ++failures;
+          continue;
+        }
+        int32_t now = ++active;
+        int32_t prev = max_active.load();
+        while (now > prev && !max_active.compare_exchange_weak(prev, now)) {}
+        conn->ExecScalar("SELECT 1;");
+        --active;
+      }
+    });
+  }
+  for (auto& w : workers) { w.join(); }
+
+  REQUIRE(failures.load() == 0);
+  REQUIRE(max_active.load() <= 3);
+  auto stats = pool.Stats();
+  REQUIRE(stats.acquires == 400);
+  REQUIRE(stats.open <= 3);
+  REQUIRE(stats.peak_in_use <= 3);
+}
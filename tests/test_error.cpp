@@ -66,3 +66,25 @@ TEST_CASE("Error: message truncation", "[error]") {
   REQUIRE(std::strlen(err.message) < Error::kMaxMessageLen);
   REQUIRE(err.message[Error::kMaxMessageLen - 1] == '\0');
 }
+
+TEST_CASE("Status: fits a register", "[error]") {
+  static_assert(sizeof(Status) == 8, "Status must stay register-sized");
+  Status st;
+  REQUIRE(st.ok());
+  REQUIRE(Status::Ok().code == ErrorCode::kOk);
+  REQUIRE_FALSE(Status(ErrorCode::kRange).ok());
+}
+
+TEST_CASE("Status: converts to Error", "[error]") {
+  Error ok = Status::Ok();
+  REQUIRE(ok.ok());
+  REQUIRE(ok.message[0] == '\0');
+
+  Error range = Status(ErrorCode::kRange);
+  REQUIRE(range.code == ErrorCode::kRange);
+  REQUIRE(std::strcmp(range.message, "out of range") == 0);
+
+  Error native = Status(ErrorCode::kError, 25);
+  REQUIRE(native.code == ErrorCode::kError);
+  REQUIRE(std::strstr(native.message, "25") != nullptr);
+}
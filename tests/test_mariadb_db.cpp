@@ -70,6 +70,30 @@ TEST_CASE("MariaDb: TableExists", "[mariadb]") {
   REQUIRE_FALSE(db.TableExists("nonexistent_table_xyz"));
 }
 
+TEST_CASE("MariaDb: DDL from another connection reaches the catalog",
+          "[mariadb]") {
+  auto db = OpenTestDb();
+  MDb other;
+  REQUIRE(other.Open(GetDsn()).ok());
+  other.ExecDml("DROP TABLE IF EXISTS dept;");
+  db.Impl().SetSchemaCheckInterval(0);  // Check before every lookup
+  REQUIRE(db.TableExists("emp"));
+  REQUIRE_FALSE(db.TableExists("dept"));
+
+  other.ExecDml("CREATE TABLE dept(deptno INT);");
+  REQUIRE(db.TableExists("dept"));
+  other.ExecDml("ALTER TABLE emp ADD COLUMN salary INT;");
+  REQUIRE(db.ColumnExists("emp", "salary"));
+
+  // Within the interval the cached catalog answers without a check
+  db.Impl().SetSchemaCheckInterval(60000);
+  REQUIRE(db.TableExists("dept"));
+  other.ExecDml("DROP TABLE dept;");
+  REQUIRE(db.TableExists("dept"));
+  db.InvalidateSchema();
+  REQUIRE_FALSE(db.TableExists("dept"));
+}
+
 TEST_CASE("MariaDb: transaction commit", "[mariadb]") {
   auto db = OpenTestDb();
 
@@ -7,6 +7,8 @@
 #include <cstring>
 
 #include "dbpp/db.hpp"
+#include "dbpp/record_batch.hpp"
+#include "dbpp/result_exporter.hpp"
 
 using namespace dbpp;
 
@@ -104,6 +106,81 @@ TEST_CASE("MariaQuery: double field", "[mariadb_query]") {
   REQUIRE(q.GetDouble(0) == Catch::Approx(3.14));
 }
 
+TEST_CASE("MariaQuery: temporal fields are text, not binary",
+          "[mariadb_query]") {
+  auto db = OpenTestDb();
+  db.ExecDml("DROP TABLE IF EXISTS times;");
+  db.ExecDml("CREATE TABLE times(d DATE, dt DATETIME, ts TIMESTAMP NULL, "
+             "t TIME, b VARBINARY(8), bl BLOB);");
+  db.ExecDml("INSERT INTO times VALUES('2024-05-06', '2024-05-06 07:08:09', "
+             "'2024-05-06 07:08:09', '07:08:09', x'0102', x'03');");
+
+  auto q = db.ExecQuery("SELECT d, dt, ts, t, b, bl FROM times;");
+  REQUIRE_FALSE(q.Eof());
+  for (int32_t c = 0; c < 4; ++c) { REQUIRE_FALSE(q.FieldIsBinary(c)); }
+  REQUIRE(q.FieldIsBinary(4));
+  REQUIRE(q.FieldIsBinary(5));
+  REQUIRE(std::strcmp(q.GetString(1), "2024-05-06 07:08:09") == 0);
+
+  // The exporter writes them as text, not hex; batches as utf8
+  ExportCell cell;
+  ExportAccess<MQuery>::Read(q, 1, &cell);
+  REQUIRE(cell.kind == ExportCellKind::kText);
+  REQUIRE(BatchAccess<MQuery>::Type(q, 1) == BatchType::kUtf8);
+  REQUIRE(BatchAccess<MQuery>::Type(q, 4) == BatchType::kBinary);
+}
+
+TEST_CASE("MariaQuery: BIGINT UNSIGNED is not clamped in a batch",
+          "[mariadb_query]") {
+  auto db = OpenTestDb();
+  db.ExecDml("DROP TABLE IF EXISTS big;");
+  db.ExecDml("CREATE TABLE big(u BIGINT UNSIGNED, i BIGINT, s INT UNSIGNED);");
+  db.ExecDml("INSERT INTO big VALUES(18446744073709551615, -1, 4294967295);");
+
+  auto q = db.ExecQuery("SELECT u, i, s FROM big;");
+  REQUIRE_FALSE(q.FieldFitsInt64(0));
+  REQUIRE(q.FieldFitsInt64(1));
+  REQUIRE(q.FieldFitsInt64(2));
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 10, &batch) == 1);
+  REQUIRE(batch.ColumnType(0) == BatchType::kUtf8);
+  REQUIRE(batch.GetText(0, 0) == TextView("18446744073709551615"));
+  REQUIRE(batch.Int64Values(2)[0] == 4294967295LL);
+}
+
+TEST_CASE("MariaQuery: typed cursor checks column types",
+          "[mariadb_query]") {
+  auto db = OpenTestDb();
+  db.ExecDml("DROP TABLE IF EXISTS typed;");
+  db.ExecDml("CREATE TABLE typed(i INT, d DOUBLE, s VARCHAR(8), "
+             "b VARBINARY(8));");
+  db.ExecDml("INSERT INTO typed VALUES(7, 1.5, 'x', x'01');");
+
+  Error err;
+  auto ok = db.ExecQuery("SELECT i, d, s, b FROM typed;")
+                .As<int64_t, double, TextView, BlobView>(&err);
+  REQUIRE(ok.Valid());
+  REQUIRE(err.ok());
+  REQUIRE(std::get<0>(ok.Get()) == 7);
+
+  auto widen = db.ExecQuery("SELECT i, i FROM typed;")
+                   .As<double, Nullable<int32_t>>(&err);
+  REQUIRE(widen.Valid());
+
+  auto text_as_int = db.ExecQuery("SELECT s FROM typed;").As<int32_t>(&err);
+  REQUIRE_FALSE(text_as_int.Valid());
+  REQUIRE(err.code == ErrorCode::kMismatch);
+
+  err = Error::Ok();
+  auto blob_as_text = db.ExecQuery("SELECT b FROM typed;").As<TextView>(&err);
+  REQUIRE_FALSE(blob_as_text.Valid());
+  REQUIRE(err.code == ErrorCode::kMismatch);
+
+  err = Error::Ok();
+  auto null_col = db.ExecQuery("SELECT NULL;").As<Nullable<int64_t>>(&err);
+  REQUIRE(null_col.Valid());
+}
+
 TEST_CASE("MariaQuery: Finalize", "[mariadb_query]") {
   auto db = OpenTestDb();
   auto q = db.ExecQuery("SELECT * FROM emp;");
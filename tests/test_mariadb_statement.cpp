@@ -7,6 +7,7 @@
 #include <cstdio>
 #include <cstring>
 
+#include "dbpp/bulk_inserter.hpp"
 #include "dbpp/db.hpp"
 
 using namespace dbpp;
@@ -131,6 +132,16 @@ TEST_CASE("MariaStatement: exec on invalid", "[mariadb_statement]") {
   REQUIRE(err.code == ErrorCode::kMisuse);
 }
 
+TEST_CASE("MariaStatement: bind failure returns a Status",
+          "[mariadb_statement]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO emp VALUES(?, ?);");
+  Status st = stmt.Bind(3, 1);
+  REQUIRE(st.code == ErrorCode::kRange);
+  Error err = stmt.ToError(st);
+  REQUIRE(err.code == ErrorCode::kRange);
+}
+
 TEST_CASE("MariaStatement: update with bind", "[mariadb_statement]") {
   auto db = OpenTestDb();
   db.ExecDml("INSERT INTO emp VALUES(1, 'Alice');");
@@ -146,3 +157,59 @@ TEST_CASE("MariaStatement: update with bind", "[mariadb_statement]") {
   auto q = db.ExecQuery("SELECT empname FROM emp WHERE empno = 1;");
   REQUIRE(std::strcmp(q.GetString(0), "Alicia") == 0);
 }
+
+TEST_CASE("MariaStatement: BulkInserter chunked insert", "[mariadb_statement]") {
+  auto db = OpenTestDb();
+
+  BulkInserter<MariaBackend> bulk;
+  BulkInsertOptions opts;
+  opts.rows_per_txn = 10;
+  REQUIRE(bulk.Begin(db, "INSERT INTO emp VALUES(?, ?);", opts).ok());
+  for (int32_t i = 0; i < 25; ++i) {
+    REQUIRE(bulk.Insert(i, "bulk").ok());
+  }
+  REQUIRE(bulk.Finish().ok());
+  REQUIRE(bulk.Stats().commits == 3);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM emp;") == 25);
+}
+
+TEST_CASE("MariaStatement: BindAll copies text", "[mariadb_statement]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO emp VALUES(?, ?);");
+  char name[8];
+  std::strcpy(name, "Carol");
+  REQUIRE(stmt.BindAll(3, TextView(name, 5)).ok());
+  std::strcpy(name, "XXXXX");
+  REQUIRE(stmt.ExecDml() == 1);
+  REQUIRE(stmt.Exec(4, std::string("Dave")) == 1);
+
+  auto q = db.ExecQuery("SELECT empname FROM emp WHERE empno = 3;");
+  REQUIRE(std::strcmp(q.GetString(0), "Carol") == 0);
+}
+
+TEST_CASE("MariaStatement: BindAllNoCopy and Db Exec", "[mariadb_statement]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO emp VALUES(?, ?);");
+  const char name[] = "Erin";
+  REQUIRE(stmt.BindAllNoCopy(5, TextView(name, 4)).ok());
+  REQUIRE(stmt.ExecDml() == 1);
+
+  REQUIRE(db.Exec("UPDATE emp SET empname = ? WHERE empno = ?;",
+                  "Eve", 5) == 1);
+  auto q = db.ExecQuery("SELECT empname FROM emp WHERE empno = 5;");
+  REQUIRE(std::strcmp(q.GetString(0), "Eve") == 0);
+}
+
+TEST_CASE("MariaStatement: Exec reports through a trailing Error*",
+          "[mariadb_statement]") {
+  auto db = OpenTestDb();
+  db.ExecDml("DROP TABLE IF EXISTS uniq;");
+  db.ExecDml("CREATE TABLE uniq(id INT PRIMARY KEY, name VARCHAR(8));");
+  auto stmt = db.CompileStatement("INSERT INTO uniq VALUES(?, ?);");
+
+  Error err;
+  REQUIRE(stmt.Exec(1, "a", &err) == 1);
+  REQUIRE(err.ok());
+  REQUIRE(stmt.Exec(1, "b", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+}
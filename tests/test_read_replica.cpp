@@ -0,0 +1,169 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::ReadReplica (serialized in-memory snapshots).
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dbpp/read_replica.hpp"
+
+using namespace dbpp;
+
+static const char* kPath = "dbpp_test_replica.db";
+
+static void RemoveDb() {
+  std::remove(kPath);
+  std::remove((std::string(kPath) + "-wal").c_str());
+  std::remove((std::string(kPath) + "-shm").c_str());
+}
+
+/// Source file in WAL mode with `rows` rows in kv.
+static Sqlite3Db MakeSource(int32_t rows) {
+  RemoveDb();
+  Sqlite3Db db;
+  db.Open(kPath, Sqlite3OpenOptions::Durable());
+  db.ExecDml("CREATE TABLE kv(k INTEGER PRIMARY KEY, v TEXT);");
+  for (int32_t i = 0; i < rows; ++i) {
+    db.Exec("INSERT INTO kv VALUES(?, ?);", i, "v" + std::to_string(i));
+  }
+  return db;
+}
+
+TEST_CASE("ReadReplica: readers see a snapshot until refresh", "[replica]") {
+  Sqlite3Db writer = MakeSource(10);
+  ReadReplica replica;
+  ReadReplicaOptions opts;
+  opts.path = kPath;
+  REQUIRE(replica.Open(opts).ok());
+  REQUIRE(replica.Version() == 1);
+
+  Error err;
+  ReplicaReader reader = replica.NewReader(&err);
+  REQUIRE(err.ok());
+  REQUIRE(reader);
+  REQUIRE(reader.Db().ExecScalar("SELECT COUNT(*) FROM kv;") == 10);
+
+  writer.Exec("INSERT INTO kv VALUES(?, ?);", 100, "new");
+  REQUIRE(reader.Db().ExecScalar("SELECT COUNT(*) FROM kv;") == 10);
+
+  REQUIRE(replica.Refresh().ok());
+  REQUIRE(replica.Version() == 2);
+  REQUIRE(reader.Db().ExecScalar("SELECT COUNT(*) FROM kv;") == 11);
+  REQUIRE(reader.Version() == 2);
+
+  // Unchanged source: no new image
+  REQUIRE(replica.Refresh().ok());
+  ReadReplicaStats stats = replica.Stats();
+  REQUIRE(stats.version == 2);
+  REQUIRE(stats.refreshes == 2);
+  REQUIRE(stats.skipped == 1);
+  REQUIRE(stats.image_bytes > 0);
+
+  // Replica is read-only
+  REQUIRE(reader.Db().ExecDml("DELETE FROM kv;") < 0);
+
+  reader = ReplicaReader();
+  replica.Close();
+  writer.Close();
+  RemoveDb();
+}
+
+TEST_CASE("ReadReplica: RefreshFrom an open connection", "[replica]") {
+  Sqlite3Db mem;
+  REQUIRE(mem.Open(":memory:").ok());
+  mem.ExecDml("CREATE TABLE t(x);");
+  mem.ExecDml("INSERT INTO t VALUES(42);");
+
+  ReadReplica replica;
+  REQUIRE(replica.Open(ReadReplicaOptions{}).ok());
+  Error err;
+  REQUIRE_FALSE(replica.NewReader(&err));
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+  REQUIRE(replica.Refresh().code == ErrorCode::kNotOpen);
+
+  REQUIRE(replica.RefreshFrom(mem).ok());
+  ReplicaReader reader = replica.NewReader();
+  REQUIRE(reader.Db().ExecScalar("SELECT x FROM t;") == 42);
+
+  // The image outlives the replica's reference while a reader uses it
+  mem.ExecDml("UPDATE t SET x = 7;");
+  REQUIRE(replica.RefreshFrom(mem).ok());
+  ReplicaReader second = replica.NewReader();
+  REQUIRE(second.Db().ExecScalar("SELECT x FROM t;") == 7);
+  REQUIRE(reader.Db().ExecScalar("SELECT x FROM t;") == 7);
+}
+
+TEST_CASE("ReadReplica: empty source", "[replica]") {
+  RemoveDb();
+  {
+    Sqlite3Db create;
+    REQUIRE(create.Open(kPath).ok());
+  }
+  ReadReplica replica;
+  ReadReplicaOptions opts;
+  opts.path = kPath;
+  REQUIRE(replica.Open(opts).ok());
+  ReplicaReader reader = replica.NewReader();
+  REQUIRE(reader.Db().ExecScalar("SELECT COUNT(*) FROM sqlite_master;") == 0);
+  reader = ReplicaReader();
+  replica.Close();
+  RemoveDb();
+}
+
+TEST_CASE("ReadReplica: scheduled refresh with concurrent readers",
+          "[replica]") {
+  Sqlite3Db writer = MakeSource(1);
+  ReadReplica replica;
+  ReadReplicaOptions opts;
+  opts.path = kPath;
+  opts.refresh_interval_ms = 5;
+  REQUIRE(replica.Open(opts).ok());
+
+  std::atomic<bool> done{false};
+  std::atomic<int32_t> failures{0};
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < 3; ++t) {
+    threads.emplace_back([&] {
+      ReplicaReader reader = replica.NewReader();
+      int32_t last = 0;
+      while (!done.load()) {
+        int32_t n = reader.Db().ExecScalar("SELECT COUNT(*) FROM kv;", -1);
+        if (n < last) { ++failures; }  // Snapshots never go back in time
+        last = n;
+      }
+    });
+  }
+  for (int32_t i = 1; i <= 20; ++i) {
+    writer.Exec("INSERT INTO kv VALUES(?, ?);", i, "x");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  ReplicaReader check = replica.NewReader();
+  while (check.Db().ExecScalar("SELECT COUNT(*) FROM kv;") != 21 &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  REQUIRE(check.Db().ExecScalar("SELECT COUNT(*) FROM kv;") == 21);
+  done.store(true);
+  for (auto& th : threads) { th.join(); }
+  REQUIRE(failures.load() == 0);
+
+  check = ReplicaReader();
+  replica.Close();
+  writer.Close();
+  RemoveDb();
+}
+
+TEST_CASE("ReadReplica: open errors", "[replica]") {
+  ReadReplica replica;
+  ReadReplicaOptions opts;
+  opts.refresh_interval_ms = 10;
+  REQUIRE(replica.Open(opts).code == ErrorCode::kNullParam);
+  opts.path = "dbpp_test_no_such_replica.db";
+  REQUIRE_FALSE(replica.Open(opts).ok());
+  REQUIRE_FALSE(replica.IsOpen());
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::RecordBatch / FetchBatch (columnar, Arrow layout).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+
+#include "dbpp/record_batch.hpp"
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static Sqlite3Db MakeDb(int32_t rows) {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE t(id INTEGER, score REAL, name TEXT, data BLOB);");
+  db.ExecDml("BEGIN;");
+  auto stmt = db.CompileStatement("INSERT INTO t VALUES(?, ?, ?, ?);");
+  for (int32_t i = 0; i < rows; ++i) {
+    if (i % 5 == 4) {
+      stmt.BindAll(i, nullptr, nullptr, nullptr);
+    } else {
+      std::string name = "n" + std::to_string(i);
+      stmt.BindAll(i, i * 0.5, name, BlobView(&i, sizeof(i)));
+    }
+    stmt.ExecDml();
+    stmt.Reset();
+  }
+  db.ExecDml("COMMIT;");
+  return db;
+}
+
+TEST_CASE("FetchBatch: schema and typed buffers", "[batch]") {
+  Sqlite3Db db = MakeDb(10);
+  auto q = db.ExecQuery("SELECT id, score, name, data FROM t ORDER BY id;");
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 100, &batch) == 10);
+  REQUIRE(q.Eof());
+
+  REQUIRE(batch.NumColumns() == 4);
+  REQUIRE(batch.NumRows() == 10);
+  REQUIRE(batch.ColumnType(0) == BatchType::kInt64);
+  REQUIRE(batch.ColumnType(1) == BatchType::kDouble);
+  REQUIRE(batch.ColumnType(2) == BatchType::kUtf8);
+  REQUIRE(batch.ColumnType(3) == BatchType::kBinary);
+  REQUIRE(std::strcmp(batch.ColumnName(2), "name") == 0);
+  REQUIRE(batch.Column("score") == 1);
+
+  const int64_t* ids = batch.Int64Values(0);
+  REQUIRE(ids != nullptr);
+  REQUIRE(batch.DoubleValues(0) == nullptr);
+  int64_t sum = 0;
+  for (uint32_t r = 0; r < batch.NumRows(); ++r) { sum += ids[r]; }
+  REQUIRE(sum == 45);
+
+  const double* scores = batch.DoubleValues(1);
+  REQUIRE(scores[3] == 1.5);
+  REQUIRE(batch.NullCount(1) == 2);
+  REQUIRE(batch.IsNull(1, 4));
+  REQUIRE(scores[4] == 0.0);
+
+  REQUIRE(batch.GetText(2, 3) == TextView("n3"));
+  REQUIRE(batch.GetText(2, 4).size == 0);
+  const int32_t* offsets = batch.Offsets(2);
+  REQUIRE(offsets[0] == 0);
+  REQUIRE(offsets[4] == 8);  // n0 n1 n2 n3
+  REQUIRE(offsets[5] == 8);  // Row 4 is null
+
+  BlobView blob = batch.GetBlob(3, 7);
+  REQUIRE(blob.size == 4);
+  int32_t v = 0;
+  std::memcpy(&v, blob.data, sizeof(v));
+  REQUIRE(v == 7);
+
+  // Arrow layout: LSB-first validity, 64-byte aligned buffers
+  REQUIRE(batch.Validity(1)[0] == 0xEF);  // Row 4 null
+  REQUIRE(batch.Validity(1)[1] == 0x01);  // Row 8 valid, row 9 null
+  REQUIRE(reinterpret_cast<uintptr_t>(ids) % RecordBatch::kAlignment == 0);
+}
+
+TEST_CASE("FetchBatch: batches walk the result, buffers reused",
+          "[batch]") {
+  Sqlite3Db db = MakeDb(2500);
+  auto q = db.ExecQuery("SELECT id, name FROM t ORDER BY id;");
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 1000, &batch) == 1000);
+  const int64_t* first = batch.Int64Values(0);
+  size_t bytes = batch.MemoryBytes();
+
+  int64_t next_id = 1000;
+  uint32_t total = 1000;
+  uint32_t n = 0;
+  while ((n = FetchBatch(q, 1000, &batch)) > 0) {
+    REQUIRE(batch.Int64Values(0) == first);  // Same buffers
+    REQUIRE(batch.Int64Values(0)[0] == next_id);
+    next_id += n;
+    total += n;
+  }
+  REQUIRE(total == 2500);
+  REQUIRE(batch.NumRows() == 0);
+  REQUIRE(batch.MemoryBytes() == bytes);
+}
+
+TEST_CASE("FetchBatch: declared type for leading NULL", "[batch]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE m(a BIGINT, b DOUBLE, c VARCHAR(10), d BLOB);");
+  db.ExecDml("INSERT INTO m VALUES(NULL, NULL, NULL, NULL);");
+  db.ExecDml("INSERT INTO m VALUES(7, 2.5, 'x', x'01');");
+  auto q = db.ExecQuery("SELECT a, b, c, d, NULL AS e FROM m;");
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 10, &batch) == 2);
+  REQUIRE(batch.ColumnType(0) == BatchType::kInt64);
+  REQUIRE(batch.ColumnType(1) == BatchType::kDouble);
+  REQUIRE(batch.ColumnType(2) == BatchType::kUtf8);
+  REQUIRE(batch.ColumnType(3) == BatchType::kBinary);
+  REQUIRE(batch.ColumnType(4) == BatchType::kUtf8);
+  REQUIRE(batch.Int64Values(0)[1] == 7);
+  REQUIRE(batch.NullCount(4) == 2);
+}
+
+TEST_CASE("FetchBatch: new query rebuilds the schema", "[batch]") {
+  Sqlite3Db db = MakeDb(3);
+  RecordBatch batch;
+  auto q1 = db.ExecQuery("SELECT id FROM t;");
+  REQUIRE(FetchBatch(q1, 10, &batch) == 3);
+  auto q2 = db.ExecQuery("SELECT name, score FROM t;");
+  REQUIRE(FetchBatch(q2, 10, &batch) == 3);
+  REQUIRE(batch.NumColumns() == 2);
+  REQUIRE(batch.ColumnType(0) == BatchType::kUtf8);
+  REQUIRE(batch.GetText(0, 2) == TextView("n2"));
+}
+
+TEST_CASE("FetchBatch: later rows widen, never truncate", "[batch]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE m(a, b INTEGER, c NUMERIC, d TEXT);");
+  db.ExecDml("INSERT INTO m VALUES(1, 1, 1, 1);");
+  db.ExecDml("INSERT INTO m VALUES(2.5, 2.5, 2.5, 2.5);");
+  db.ExecDml("INSERT INTO m VALUES(3.75, 3, x'00ff', 'x');");
+  auto q = db.ExecQuery("SELECT a, b, d FROM m ORDER BY rowid;");
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 10, &batch) == 3);
+  REQUIRE(batch.ColumnType(0) == BatchType::kDouble);
+  REQUIRE(batch.DoubleValues(0)[0] == 1.0);
+  REQUIRE(batch.DoubleValues(0)[1] == 2.5);
+  REQUIRE(batch.DoubleValues(0)[2] == 3.75);
+  REQUIRE(batch.ColumnType(1) == BatchType::kDouble);  // INTEGER held 2.5
+  REQUIRE(batch.DoubleValues(1)[1] == 2.5);
+  REQUIRE(batch.DoubleValues(1)[2] == 3.0);
+  REQUIRE(batch.ColumnType(2) == BatchType::kUtf8);    // Declared TEXT
+  REQUIRE(batch.GetText(2, 1) == TextView("2.5"));
+
+  // Types are per batch: the first row of each decides, later rows widen
+  auto chunked = db.ExecQuery("SELECT a FROM m ORDER BY rowid;");
+  REQUIRE(FetchBatch(chunked, 1, &batch) == 1);
+  REQUIRE(batch.ColumnType(0) == BatchType::kInt64);
+  REQUIRE(FetchBatch(chunked, 1, &batch) == 1);
+  REQUIRE(batch.ColumnType(0) == BatchType::kDouble);
+
+  // A blob in a numeric column has no lossless type: the rows before it
+  // are kept and the query stays on it
+  auto bad = db.ExecQuery("SELECT c, d FROM m ORDER BY rowid;");
+  Error err;
+  REQUIRE(FetchBatch(bad, 10, &batch, &err) == 2);
+  REQUIRE(err.code == ErrorCode::kMismatch);
+  REQUIRE(batch.NumRows() == 2);
+  REQUIRE(batch.DoubleValues(0)[1] == 2.5);
+  REQUIRE(batch.NullCount(0) == 0);
+  REQUIRE(batch.Offsets(1)[2] == 4);  // "1" "2.5", not the failed row
+  REQUIRE(!bad.Eof());
+  err.Clear();
+  REQUIRE(FetchBatch(bad, 10, &batch, &err) == 1);  // Typed from the blob
+  REQUIRE(err.ok());
+  REQUIRE(batch.ColumnType(0) == BatchType::kBinary);
+}
+
+TEST_CASE("FetchBatch: same column names from another query", "[batch]") {
+  Sqlite3Db db = MakeDb(3);
+  RecordBatch batch;
+  auto q1 = db.ExecQuery("SELECT id AS v FROM t ORDER BY id;");
+  REQUIRE(FetchBatch(q1, 10, &batch) == 3);
+  REQUIRE(batch.ColumnType(0) == BatchType::kInt64);
+  q1.Finalize();
+
+  // Same names and a statement that may reuse q1's memory: the types
+  // still come from the new result
+  auto q2 = db.ExecQuery("SELECT name AS v FROM t ORDER BY id;");
+  REQUIRE(FetchBatch(q2, 10, &batch) == 3);
+  REQUIRE(batch.ColumnType(0) == BatchType::kUtf8);
+  REQUIRE(batch.GetText(0, 1) == TextView("n1"));
+}
+
+TEST_CASE("FetchBatch: a failed step is reported", "[batch]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  // abs() overflows on the third row
+  auto q = db.ExecQuery("SELECT abs(column1) FROM "
+                        "(VALUES(1), (2), (-9223372036854775807 - 1));");
+  RecordBatch batch;
+  Error err;
+  REQUIRE(FetchBatch(q, 10, &batch, &err) == 2);  // The prefix is kept
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(batch.Int64Values(0)[1] == 2);
+  err.Clear();
+  REQUIRE(FetchBatch(q, 10, &batch, &err) == 0);
+  REQUIRE(err.code == ErrorCode::kError);
+}
+
+TEST_CASE("FetchBatch: edge cases", "[batch]") {
+  Sqlite3Db db = MakeDb(3);
+  auto q = db.ExecQuery("SELECT id FROM t;");
+  Error err;
+  REQUIRE(FetchBatch(q, 10, nullptr, &err) == 0);
+  REQUIRE(err.code == ErrorCode::kNullParam);
+
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 0, &batch) == 0);
+  REQUIRE(FetchBatch(q, 2, &batch) == 2);
+  REQUIRE(FetchBatch(q, 2, &batch) == 1);
+  REQUIRE(FetchBatch(q, 2, &batch) == 0);
+
+  RecordBatch moved(std::move(batch));
+  REQUIRE(moved.NumColumns() == 1);
+  REQUIRE(batch.NumColumns() == 0);
+  REQUIRE(moved.Int64Values(5) == nullptr);
+  REQUIRE(moved.IsNull(0, 100));
+}
+
+TEST_CASE("RecordBatch: ExportArrow hands buffers over", "[batch]") {
+  Sqlite3Db db = MakeDb(6);
+  auto q = db.ExecQuery("SELECT id, name FROM t ORDER BY id;");
+  RecordBatch batch;
+  REQUIRE(FetchBatch(q, 4, &batch) == 4);
+  const void* ids = batch.Int64Values(0);
+
+  ArrowArray array;
+  ArrowSchema schema;
+  REQUIRE(batch.ExportArrow(&array, &schema).ok());
+  REQUIRE(batch.NumRows() == 0);
+
+  REQUIRE(std::strcmp(schema.format, "+s") == 0);
+  REQUIRE(schema.n_children == 2);
+  REQUIRE(std::strcmp(schema.children[0]->format, "l") == 0);
+  REQUIRE(std::strcmp(schema.children[1]->format, "u") == 0);
+  REQUIRE(std::strcmp(schema.children[1]->name, "name") == 0);
+
+  REQUIRE(array.length == 4);
+  REQUIRE(array.n_children == 2);
+  ArrowArray* id_col = array.children[0];
+  REQUIRE(id_col->n_buffers == 2);
+  REQUIRE(id_col->buffers[1] == ids);  // Zero copy
+  REQUIRE(static_cast<const int64_t*>(id_col->buffers[1])[3] == 3);
+  ArrowArray* name_col = array.children[1];
+  REQUIRE(name_col->n_buffers == 3);
+  REQUIRE(name_col->null_count == 0);
+  const int32_t* offsets = static_cast<const int32_t*>(name_col->buffers[1]);
+  REQUIRE(std::memcmp(static_cast<const char*>(name_col->buffers[2]) +
+                          offsets[2], "n2", 2) == 0);
+
+  // The batch keeps working with fresh buffers
+  REQUIRE(FetchBatch(q, 4, &batch) == 2);
+  REQUIRE(batch.Int64Values(0)[0] == 4);
+
+  // A consumer may release a child on its own first
+  array.children[1]->release(array.children[1]);
+  array.release(&array);
+  schema.release(&schema);
+  REQUIRE(array.release == nullptr);
+  REQUIRE(schema.release == nullptr);
+}
@@ -0,0 +1,202 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::ResultExporter (CSV / JSON Lines streaming export).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "dbpp/result_exporter.hpp"
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static const char* kPath = "dbpp_test_export.out";
+
+static std::string ReadFile(const char* path) {
+  std::string out;
+  std::FILE* f = std::fopen(path, "rb");
+  if (f == nullptr) { return out; }
+  char buf[4096];
+  size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) { out.append(buf, n); }
+  std::fclose(f);
+  return out;
+}
+
+static Sqlite3Db SampleDb() {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, score REAL, data BLOB);");
+  db.ExecDml("INSERT INTO t VALUES(1, 'plain', 0.1, x'00ff');");
+  db.ExecDml("INSERT INTO t VALUES(-42, 'a,b \"q\"', -2.5, NULL);");
+  db.ExecDml("INSERT INTO t VALUES(9223372036854775807, 'line\nbreak', "
+             "1e300, x'');");
+  db.ExecDml("INSERT INTO t VALUES(NULL, NULL, NULL, NULL);");
+  return db;
+}
+
+static std::string ExportSample(const ExportOptions& opts,
+                                ExportStats* stats = nullptr) {
+  Sqlite3Db db = SampleDb();
+  ResultExporter ex(opts);
+  REQUIRE(ex.Open(kPath).ok());
+  REQUIRE(ex.ExportSql(db, "SELECT * FROM t ORDER BY rowid;", stats).ok());
+  REQUIRE(ex.Close().ok());
+  std::string out = ReadFile(kPath);
+  std::remove(kPath);
+  return out;
+}
+
+TEST_CASE("ResultExporter: CSV with quoting", "[exporter]") {
+  ExportStats stats;
+  std::string out = ExportSample(ExportOptions{}, &stats);
+  REQUIRE(out ==
+          "id,name,score,data\n"
+          "1,plain,0.1,00ff\n"
+          "-42,\"a,b \"\"q\"\"\",-2.5,\n"
+          "9223372036854775807,\"line\nbreak\",1e+300,\n"
+          ",,,\n");
+  REQUIRE(stats.rows == 4);
+  REQUIRE(stats.bytes == out.size());
+}
+
+TEST_CASE("ResultExporter: CSV options", "[exporter]") {
+  ExportOptions opts;
+  opts.header = false;
+  opts.delimiter = '\t';
+  opts.max_rows = 2;
+  std::string out = ExportSample(opts);
+  // Commas no longer force quoting, embedded quotes still do.
+  REQUIRE(out == "1\tplain\t0.1\t00ff\n-42\t\"a,b \"\"q\"\"\"\t-2.5\t\n");
+}
+
+TEST_CASE("ResultExporter: chunked CSV export has one header",
+          "[exporter]") {
+  Sqlite3Db db = SampleDb();
+  ExportOptions opts;
+  opts.max_rows = 1;
+  ResultExporter ex(opts);
+  REQUIRE(ex.Open(kPath).ok());
+  Sqlite3Query q = db.ExecQuery("SELECT id FROM t ORDER BY rowid;");
+  int32_t chunks = 0;
+  for (; !q.Eof(); ++chunks) { REQUIRE(ex.Export(q).ok()); }
+  REQUIRE(chunks == 4);
+  REQUIRE(ex.Close().ok());
+  REQUIRE(ReadFile(kPath) == "id\n1\n-42\n9223372036854775807\n\n");
+
+  // A new output gets its own header
+  REQUIRE(ex.Open(kPath).ok());
+  REQUIRE(ex.ExportSql(db, "SELECT id FROM t LIMIT 1;").ok());
+  REQUIRE(ex.Close().ok());
+  REQUIRE(ReadFile(kPath) == "id\n1\n");
+  std::remove(kPath);
+}
+
+TEST_CASE("ResultExporter: JSON Lines", "[exporter]") {
+  ExportOptions opts;
+  opts.format = ExportFormat::kJsonLines;
+  std::string out = ExportSample(opts);
+  REQUIRE(out ==
+          "{\"id\":1,\"name\":\"plain\",\"score\":0.1,\"data\":\"00ff\"}\n"
+          "{\"id\":-42,\"name\":\"a,b \\\"q\\\"\",\"score\":-2.5,"
+          "\"data\":null}\n"
+          "{\"id\":9223372036854775807,\"name\":\"line\\nbreak\","
+          "\"score\":1e+300,\"data\":\"\"}\n"
+          "{\"id\":null,\"name\":null,\"score\":null,\"data\":null}\n");
+}
+
+TEST_CASE("ResultExporter: JSON escapes keys and control bytes",
+          "[exporter]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  ExportOptions opts;
+  opts.format = ExportFormat::kJsonLines;
+  ResultExporter ex(opts);
+  REQUIRE(ex.Open(kPath).ok());
+  REQUIRE(ex.ExportSql(db, "SELECT char(1, 9, 92) AS \"k\"\"ey\";").ok());
+  ex.Close();
+  REQUIRE(ReadFile(kPath) == "{\"k\\\"ey\":\"\\u0001\\t\\\\\"}\n");
+  std::remove(kPath);
+}
+
+TEST_CASE("ResultExporter: progress callback and stop", "[exporter]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE n(i INTEGER);");
+  db.ExecDml("WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 "
+             "FROM c WHERE x < 1000) INSERT INTO n SELECT x FROM c;");
+
+  uint64_t calls = 0;
+  ExportOptions opts;
+  opts.header = false;
+  opts.progress_interval = 100;
+  opts.progress = [&calls](uint64_t rows, uint64_t bytes) {
+    ++calls;
+    REQUIRE(rows == calls * 100);
+    REQUIRE(bytes > 0);
+    return rows < 300;
+  };
+  ResultExporter ex(opts);
+  REQUIRE(ex.Open(kPath).ok());
+  ExportStats stats;
+  REQUIRE(ex.ExportSql(db, "SELECT i FROM n ORDER BY i;", &stats).ok());
+  ex.Close();
+  REQUIRE(calls == 3);
+  REQUIRE(stats.rows == 300);
+  REQUIRE(stats.stopped);
+  std::remove(kPath);
+}
+
+TEST_CASE("ResultExporter: fields larger than the buffer", "[exporter]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  ExportOptions opts;
+  opts.buffer_size = 0;  // Clamped to the 4 KiB minimum
+  opts.header = false;
+  ResultExporter ex(opts);
+  REQUIRE(ex.Open(kPath).ok());
+  ExportStats stats;
+  REQUIRE(ex.ExportSql(db, "SELECT printf('%.*c', 10000, 'x'), 7 "
+                           "UNION ALL SELECT 'y', 8;", &stats).ok());
+  REQUIRE(ex.Close().ok());
+  std::string out = ReadFile(kPath);
+  REQUIRE(out == std::string(10000, 'x') + ",7\ny,8\n");
+  REQUIRE(stats.bytes == out.size());
+  std::remove(kPath);
+}
+
+TEST_CASE("ResultExporter: a failed step fails the export",
+          "[exporter]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  ResultExporter ex;
+  REQUIRE(ex.Open(kPath).ok());
+  ExportStats stats;
+  // abs() overflows on the third row
+  Error err = ex.ExportSql(db, "SELECT abs(column1) AS v FROM "
+                           "(VALUES(1), (2), (-9223372036854775807 - 1));",
+                           &stats);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(stats.rows == 2);
+  REQUIRE(ex.Close().ok());
+  REQUIRE(ReadFile(kPath) == "v\n1\n2\n");
+  std::remove(kPath);
+}
+
+TEST_CASE("ResultExporter: errors", "[exporter]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  ResultExporter ex;
+  REQUIRE(ex.ExportSql(db, "SELECT 1;").code == ErrorCode::kNotOpen);
+  REQUIRE(ex.Open(nullptr).code == ErrorCode::kNullParam);
+  REQUIRE(ex.Open("/nonexistent-dir/x.csv").code == ErrorCode::kIoError);
+  REQUIRE(ex.Open(kPath).ok());
+  REQUIRE_FALSE(ex.ExportSql(db, "SELECT * FROM missing;").ok());
+
+  ResultExporter moved(std::move(ex));
+  REQUIRE(moved.IsOpen());
+  REQUIRE_FALSE(ex.IsOpen());
+  REQUIRE(moved.Close().ok());
+  std::remove(kPath);
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for the per-connection schema catalog (TableExists, GetColumns).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "dbpp/db.hpp"
+
+using namespace dbpp;
+
+static const char* kPath = "dbpp_test_schema.db";
+
+static void RemoveDb() {
+  std::remove(kPath);
+  std::remove((std::string(kPath) + "-journal").c_str());
+}
+
+TEST_CASE("Schema: table and column lookups", "[schema]") {
+  Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE emp(id INTEGER PRIMARY KEY, "
+             "name TEXT NOT NULL, dept VARCHAR(32), salary REAL);");
+  db.ExecDml("CREATE UNIQUE INDEX emp_name ON emp(name);");
+  db.ExecDml("CREATE INDEX emp_dept_salary ON emp(dept, salary DESC);");
+
+  Error err;
+  REQUIRE(db.TableExists("emp", &err));
+  REQUIRE(err.ok());
+  REQUIRE(db.TableExists("EMP"));
+  REQUIRE(!db.TableExists("nonexistent"));
+  REQUIRE(!db.TableExists("emp' OR '1'='1"));
+  REQUIRE(!db.TableExists(nullptr));
+
+  REQUIRE(db.ColumnExists("emp", "salary"));
+  REQUIRE(db.ColumnExists("Emp", "NAME"));
+  REQUIRE(!db.ColumnExists("emp", "bonus"));
+  REQUIRE(!db.ColumnExists("nonexistent", "id"));
+
+  const std::vector<SchemaColumn>* cols = db.GetColumns("emp");
+  REQUIRE(cols != nullptr);
+  REQUIRE(cols->size() == 4);
+  REQUIRE((*cols)[0].name == "id");
+  REQUIRE((*cols)[0].type == "INTEGER");
+  REQUIRE((*cols)[0].primary_key);
+  REQUIRE((*cols)[1].name == "name");
+  REQUIRE((*cols)[1].not_null);
+  REQUIRE((*cols)[2].type == "VARCHAR(32)");
+  REQUIRE(!(*cols)[2].not_null);
+  REQUIRE(db.GetColumns("nonexistent") == nullptr);
+
+  const SchemaTable* emp = db.GetTable("emp");
+  REQUIRE(emp != nullptr);
+  REQUIRE(emp->name == "emp");
+  REQUIRE(emp->indexes.size() == 2);
+  REQUIRE(emp->indexes[0].name == "emp_dept_salary");
+  REQUIRE(!emp->indexes[0].unique);
+  REQUIRE(emp->indexes[0].columns ==
+          std::vector<std::string>{"dept", "salary"});
+  REQUIRE(emp->indexes[1].name == "emp_name");
+  REQUIRE(emp->indexes[1].unique);
+
+  // Hits do not reload: the same objects come back
+  REQUIRE(db.GetTable("emp") == emp);
+  REQUIRE(db.GetColumns("emp") == cols);
+}
+
+TEST_CASE("Schema: names longer than any fixed buffer", "[schema]") {
+  Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  std::string table(300, 't');
+  std::string column(300, 'c');
+  std::string sql = "CREATE TABLE \"" + table + "\"(\"" + column + "\");";
+  REQUIRE(db.ExecDml(sql.c_str()) == 0);
+  REQUIRE(db.TableExists(table.c_str()));
+  REQUIRE(db.ColumnExists(table.c_str(), column.c_str()));
+  REQUIRE(!db.TableExists((table + "x").c_str()));
+
+  // Many tables: the maps grow past their first size
+  for (int32_t i = 0; i < 200; ++i) {
+    std::string ddl = "CREATE TABLE t" + std::to_string(i) + "(x, y);";
+    db.ExecDml(ddl.c_str());
+  }
+  for (int32_t i = 0; i < 200; ++i) {
+    std::string name = "T" + std::to_string(i);
+    REQUIRE(db.ColumnExists(name.c_str(), "Y"));
+  }
+  REQUIRE(!db.TableExists("t200"));
+}
+
+TEST_CASE("Schema: DDL invalidates the catalog", "[schema]") {
+  RemoveDb();
+  Db db;
+  Db other;
+  REQUIRE(db.Open(kPath).ok());
+  REQUIRE(other.Open(kPath).ok());
+  db.ExecDml("CREATE TABLE kv(k TEXT PRIMARY KEY, v BLOB);");
+  REQUIRE(db.TableExists("kv"));
+  REQUIRE(!db.ColumnExists("kv", "ts"));
+
+  // Same connection
+  db.ExecDml("ALTER TABLE kv ADD COLUMN ts INTEGER;");
+  REQUIRE(db.ColumnExists("kv", "ts"));
+  REQUIRE(db.GetColumns("kv")->size() == 3);
+
+  // Another connection: PRAGMA schema_version is in the file header
+  REQUIRE(!db.TableExists("log"));
+  other.ExecDml("CREATE TABLE log(msg TEXT);");
+  REQUIRE(db.TableExists("log"));
+  other.ExecDml("DROP TABLE kv;");
+  REQUIRE(!db.TableExists("kv"));
+  REQUIRE(db.GetTable("kv") == nullptr);
+
+  // A rolled-back change leaves the catalog as it was
+  REQUIRE(db.BeginTransaction().ok());
+  db.ExecDml("CREATE TABLE tmp(x);");
+  REQUIRE(db.TableExists("tmp"));
+  REQUIRE(db.Rollback().ok());
+  REQUIRE(!db.TableExists("tmp"));
+
+  db.InvalidateSchema();
+  REQUIRE(db.TableExists("log"));
+
+  // A schema_version read blocked by another writer is an error, not
+  // version 0
+  REQUIRE(other.ExecDml("BEGIN EXCLUSIVE;") == 0);
+  Error err;
+  REQUIRE(!db.TableExists("log", &err));
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(other.ExecDml("COMMIT;") == 0);
+  REQUIRE(db.TableExists("log"));
+
+  db.Close();
+  other.Close();
+  RemoveDb();
+}
+
+TEST_CASE("Schema: errors and reopening", "[schema]") {
+  Db db;
+  Error err;
+  REQUIRE(!db.TableExists("t", &err));
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+  err.Clear();
+  REQUIRE(db.GetColumns("t", &err) == nullptr);
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+
+  // Reopening drops the old catalog even when the versions match
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE a(x);");
+  REQUIRE(db.TableExists("a"));
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE b(x);");
+  REQUIRE(!db.TableExists("a"));
+  REQUIRE(db.TableExists("b"));
+
+  // Moving keeps the catalog
+  Db moved(std::move(db));
+  REQUIRE(moved.TableExists("b"));
+  err.Clear();
+  REQUIRE(!db.TableExists("b", &err));
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+}
+
+TEST_CASE("Schema: DDL statement detection", "[schema]") {
+  REQUIRE(detail::IsSchemaStatement("CREATE TABLE t(x)"));
+  REQUIRE(detail::IsSchemaStatement("  alter table t add y int"));
+  REQUIRE(detail::IsSchemaStatement("-- note\n/* c */ DROP TABLE t"));
+  REQUIRE(detail::IsSchemaStatement("# note\nRename table a to b"));
+  REQUIRE(detail::IsSchemaStatement("TRUNCATE t"));
+  REQUIRE(detail::IsSchemaStatement("USE other_db"));
+  REQUIRE(!detail::IsSchemaStatement("INSERT INTO created VALUES(1)"));
+  REQUIRE(!detail::IsSchemaStatement("SELECT 'CREATE TABLE x'"));
+  REQUIRE(!detail::IsSchemaStatement("created_at"));
+  REQUIRE(!detail::IsSchemaStatement("user_id"));
+  REQUIRE(!detail::IsSchemaStatement("/* unterminated"));
+  REQUIRE(!detail::IsSchemaStatement(nullptr));
+}
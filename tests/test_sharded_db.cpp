@@ -0,0 +1,208 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::ShardedDb (hash partitioning, scatter-gather merge).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "dbpp/sharded_db.hpp"
+
+using namespace dbpp;
+
+static const char* kFormat = "dbpp_test_shard_%u.db";
+
+static void RemoveShards(uint32_t n) {
+  for (uint32_t s = 0; s < n; ++s) {
+    char path[64];
+    std::snprintf(path, sizeof(path), kFormat, s);
+    std::remove(path);
+    std::remove((std::string(path) + "-wal").c_str());
+    std::remove((std::string(path) + "-shm").c_str());
+  }
+}
+
+/// Four shards holding rows (id, id % 7, "k<id>") for id in [0, rows).
+static Error OpenFilled(ShardedDb& db, int32_t rows, uint32_t shards = 4) {
+  RemoveShards(shards);
+  ShardedDbOptions opts;
+  opts.path_format = kFormat;
+  opts.shards = shards;
+  opts.writer.open.synchronous = Sqlite3Synchronous::kOff;
+  Error err = db.Open(opts);
+  if (!err.ok()) { return err; }
+  err = db.ExecAll("CREATE TABLE t(id INTEGER PRIMARY KEY, v INTEGER, "
+                   "k TEXT);");
+  if (!err.ok()) { return err; }
+  std::vector<std::future<WriteResult>> results;
+  for (int32_t id = 0; id < rows; ++id) {
+    results.push_back(db.Submit(id, [id](Sqlite3Db& s, Error*) {
+      std::string key = "k" + std::to_string(id);
+      return s.Exec("INSERT INTO t VALUES(?, ?, ?);", id, id % 7, key);
+    }));
+  }
+  for (auto& f : results) {
+    WriteResult r = f.get();
+    if (!r.error.ok()) { return r.error; }
+  }
+  return Error::Ok();
+}
+
+TEST_CASE("ShardedDb: routing is stable and spread", "[sharded]") {
+  ShardedDb db;
+  REQUIRE(OpenFilled(db, 0).ok());
+  REQUIRE(db.NumShards() == 4);
+  uint32_t counts[4] = {};
+  for (int64_t k = 0; k < 4000; ++k) {
+    uint32_t s = db.ShardOf(k);
+    REQUIRE(s < 4);
+    REQUIRE(db.ShardOf(k) == s);
+    ++counts[s];
+  }
+  for (uint32_t c : counts) { REQUIRE(c > 800); }
+  REQUIRE(db.ShardOf(TextView("user-1")) == db.ShardOf(TextView("user-1")));
+  REQUIRE(std::strcmp(db.ShardPath(2), "dbpp_test_shard_2.db") == 0);
+  db.Close();
+  RemoveShards(4);
+}
+
+TEST_CASE("ShardedDb: point write lands on the owning shard", "[sharded]") {
+  ShardedDb db;
+  REQUIRE(OpenFilled(db, 200).ok());
+  for (int64_t id : {0, 17, 123, 199}) {
+    uint32_t owner = db.ShardOf(id);
+    for (uint32_t s = 0; s < db.NumShards(); ++s) {
+      auto reader = db.AcquireReader(s);
+      REQUIRE(reader);
+      std::string sql = "SELECT COUNT(*) FROM t WHERE id = " +
+                        std::to_string(id) + ";";
+      REQUIRE(reader->ExecScalar(sql.c_str()) == (s == owner ? 1 : 0));
+    }
+  }
+  // Readers are query_only
+  auto reader = db.AcquireReader(0);
+  REQUIRE(reader->ExecDml("DELETE FROM t;") < 0);
+  reader.Release();
+  db.Close();
+  RemoveShards(4);
+}
+
+TEST_CASE("ShardedDb: gather concatenates with offset/limit", "[sharded]") {
+  ShardedDb db;
+  REQUIRE(OpenFilled(db, 100).ok());
+  ShardedResult rs;
+  REQUIRE(db.Gather("SELECT id, k FROM t;", GatherOptions{}, &rs).ok());
+  REQUIRE(rs.NumRows() == 100);
+  REQUIRE(rs.NumFields() == 2);
+  REQUIRE(rs.FieldIndex("k") == 1);
+  int64_t sum = 0;
+  for (; !rs.Eof(); rs.NextRow()) {
+    REQUIRE(rs.RowShard() == db.ShardOf(rs.GetInt64(0)));
+    sum += rs.GetInt64(0);
+  }
+  REQUIRE(sum == 4950);
+
+  GatherOptions opts;
+  opts.offset = 95;
+  opts.limit = 10;
+  REQUIRE(db.Gather("SELECT id FROM t;", opts, &rs).ok());
+  REQUIRE(rs.NumRows() == 5);
+  db.Close();
+  RemoveShards(4);
+}
+
+TEST_CASE("ShardedDb: gather merges ORDER BY across shards", "[sharded]") {
+  ShardedDb db;
+  REQUIRE(OpenFilled(db, 300).ok());
+  SortKey keys[2] = {{1, true}, {0, false}};  // v DESC, id ASC
+  GatherOptions opts;
+  opts.order_by = keys;
+  opts.num_keys = 2;
+  opts.limit = 50;
+  ShardedResult rs;
+  REQUIRE(db.Gather("SELECT id, v FROM t ORDER BY v DESC, id LIMIT 50;",
+                    opts, &rs).ok());
+  REQUIRE(rs.NumRows() == 50);
+  // v = 6 for ids 6, 13, ..., 293 (42 of them), then v = 5 from id 5
+  int64_t prev_id = -1;
+  for (uint64_t r = 0; r < 42; ++r, rs.NextRow()) {
+    REQUIRE(rs.GetInt64(1) == 6);
+    REQUIRE(rs.GetInt64(0) > prev_id);
+    prev_id = rs.GetInt64(0);
+  }
+  REQUIRE(rs.GetInt64(1) == 5);
+  REQUIRE(rs.GetInt64(0) == 5);
+
+  SortKey by_text[1] = {{0, false}};
+  opts.order_by = by_text;
+  opts.num_keys = 1;
+  opts.offset = 2;
+  opts.limit = 3;
+  REQUIRE(db.Gather("SELECT k FROM t ORDER BY k LIMIT 5;", opts, &rs).ok());
+  REQUIRE(rs.NumRows() == 3);
+  REQUIRE(std::strcmp(rs.GetString(0), "k10") == 0);  // k0 k1 | k10 k100 k101
+  rs.SeekRow(2);
+  REQUIRE(std::strcmp(rs.GetString(0), "k101") == 0);
+  db.Close();
+  RemoveShards(4);
+}
+
+TEST_CASE("ShardedDb: aggregate merge", "[sharded]") {
+  ShardedDb db;
+  REQUIRE(OpenFilled(db, 1000).ok());
+  MergeOp ops[5] = {MergeOp::kCount, MergeOp::kSum, MergeOp::kMin,
+                    MergeOp::kMax, MergeOp::kSum};
+  AggregateValue out[5];
+  REQUIRE(db.GatherAggregate(
+                "SELECT COUNT(*), SUM(id), MIN(id), MAX(id), "
+                "SUM(id * 0.5) FROM t;", ops, 5, out).ok());
+  REQUIRE(out[0].AsInt64() == 1000);
+  REQUIRE(out[1].type == SQLITE_INTEGER);
+  REQUIRE(out[1].i == 499500);
+  REQUIRE(out[2].i == 0);
+  REQUIRE(out[3].i == 999);
+  REQUIRE(out[4].type == SQLITE_FLOAT);
+  REQUIRE(out[4].d == 249750.0);
+
+  REQUIRE(db.GatherAggregate("SELECT COUNT(*), SUM(id) FROM t WHERE id < 0;",
+                             ops, 2, out).ok());
+  REQUIRE(out[0].AsInt64() == 0);
+  REQUIRE(out[1].IsNull());
+
+  REQUIRE(db.GatherAggregate("SELECT MIN(k) FROM t;", ops + 2, 1, out).code ==
+          ErrorCode::kMismatch);
+  db.Close();
+  RemoveShards(4);
+}
+
+TEST_CASE("ShardedDb: errors", "[sharded]") {
+  ShardedDb db;
+  ShardedResult rs;
+  REQUIRE(db.Gather("SELECT 1;", GatherOptions{}, &rs).code ==
+          ErrorCode::kNotOpen);
+  REQUIRE(db.ExecAll("SELECT 1;").code == ErrorCode::kNotOpen);
+  REQUIRE(db.Submit(1, [](Sqlite3Db&, Error*) { return 0; }).get()
+              .error.code == ErrorCode::kNotOpen);
+
+  ShardedDbOptions opts;
+  REQUIRE(db.Open(opts).code == ErrorCode::kNullParam);
+  opts.path_format = kFormat;
+  opts.shards = 0;
+  REQUIRE(db.Open(opts).code == ErrorCode::kRange);
+
+  REQUIRE(OpenFilled(db, 10, 2).ok());
+  REQUIRE_FALSE(db.Gather("SELECT * FROM missing;", GatherOptions{}, &rs)
+                    .ok());
+  SortKey bad[1] = {{5, false}};
+  GatherOptions gopts;
+  gopts.order_by = bad;
+  gopts.num_keys = 1;
+  REQUIRE(db.Gather("SELECT id FROM t;", gopts, &rs).code ==
+          ErrorCode::kRange);
+  REQUIRE(db.ExecAll("INSERT INTO t VALUES(1, 1, 'dup');").code !=
+          ErrorCode::kOk);
+  db.Close();
+  RemoveShards(2);
+}
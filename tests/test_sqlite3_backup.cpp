@@ -0,0 +1,218 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Backup (throttled online backup).
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "dbpp/sqlite3_backup.hpp"
+
+using namespace dbpp;
+
+static const char* kSrcPath = "dbpp_test_backup_src.db";
+static const char* kDstPath = "dbpp_test_backup_dst.db";
+
+static void RemoveFile(const char* path) {
+  std::remove(path);
+  std::remove((std::string(path) + "-wal").c_str());
+  std::remove((std::string(path) + "-shm").c_str());
+  std::remove((std::string(path) + "-journal").c_str());
+}
+
+/// Source with `rows` rows of ~200 bytes (one 4 KiB page holds ~19).
+static void FillSource(Sqlite3Db& db, int32_t rows) {
+  db.ExecDml("CREATE TABLE kv(k INTEGER PRIMARY KEY, v TEXT);");
+  db.ExecDml("BEGIN;");
+  for (int32_t i = 0; i < rows; ++i) {
+    db.Exec("INSERT INTO kv VALUES(?, ?);", i, std::string(200, 'a' + i % 26));
+  }
+  db.ExecDml("COMMIT;");
+}
+
+TEST_CASE("Sqlite3Backup: ToFile copies the database", "[backup]") {
+  RemoveFile(kDstPath);
+  Sqlite3Db src;
+  REQUIRE(src.Open(":memory:").ok());
+  FillSource(src, 500);
+
+  BackupProgress progress;
+  REQUIRE(Sqlite3Backup::ToFile(src, kDstPath, BackupOptions{}, &progress)
+              .ok());
+  REQUIRE(progress.done);
+  REQUIRE(progress.remaining == 0);
+  REQUIRE(progress.page_count > 1);
+  REQUIRE(progress.page_size > 0);
+  REQUIRE(progress.bytes_copied ==
+          static_cast<uint64_t>(progress.page_count) * progress.page_size);
+  REQUIRE(progress.restarts == 0);
+  REQUIRE(progress.Fraction() == 1.0);
+
+  Sqlite3Db dst;
+  REQUIRE(dst.Open(kDstPath).ok());
+  REQUIRE(dst.ExecScalar("SELECT COUNT(*) FROM kv;") == 500);
+  REQUIRE(dst.ExecScalar("SELECT length(v) FROM kv WHERE k = 7;") == 200);
+  dst.Close();
+  RemoveFile(kDstPath);
+}
+
+TEST_CASE("Sqlite3Backup: small steps report progress", "[backup]") {
+  Sqlite3Db src;
+  Sqlite3Db dst;
+  REQUIRE(src.Open(":memory:").ok());
+  REQUIRE(dst.Open(":memory:").ok());
+  FillSource(src, 300);
+
+  int32_t calls = 0;
+  double last_fraction = 0.0;
+  bool monotonic = true;
+  BackupOptions opts;
+  opts.pages_per_step = 1;
+  opts.progress = [&](const BackupProgress& p) {
+    ++calls;
+    if (p.Fraction() < last_fraction) { monotonic = false; }
+    last_fraction = p.Fraction();
+    return true;
+  };
+  BackupProgress progress;
+  REQUIRE(Sqlite3Backup::To(src, dst, opts, &progress).ok());
+  REQUIRE(monotonic);
+  // One callback per step but the last
+  REQUIRE(calls == progress.page_count - 1);
+  REQUIRE(progress.steps == static_cast<uint64_t>(progress.page_count));
+  REQUIRE(dst.ExecScalar("SELECT COUNT(*) FROM kv;") == 300);
+}
+
+TEST_CASE("Sqlite3Backup: cancel leaves the destination unchanged",
+          "[backup]") {
+  Sqlite3Db src;
+  Sqlite3Db dst;
+  REQUIRE(src.Open(":memory:").ok());
+  REQUIRE(dst.Open(":memory:").ok());
+  FillSource(src, 300);
+  dst.ExecDml("CREATE TABLE keep(x);");
+  dst.ExecDml("INSERT INTO keep VALUES(1);");
+
+  BackupOptions opts;
+  opts.pages_per_step = 2;
+  opts.progress = [](const BackupProgress& p) { return p.steps < 3; };
+  BackupProgress progress;
+  Error err = Sqlite3Backup::To(src, dst, opts, &progress);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(!progress.done);
+  REQUIRE(progress.steps == 3);
+  REQUIRE(dst.ExecScalar("SELECT COUNT(*) FROM keep;") == 1);
+  REQUIRE(!dst.TableExists("kv"));
+}
+
+TEST_CASE("Sqlite3Backup: foreign writes restart the copy", "[backup]") {
+  RemoveFile(kSrcPath);
+  Sqlite3Db src;
+  REQUIRE(src.Open(kSrcPath).ok());
+  FillSource(src, 300);
+  Sqlite3Db other;
+  REQUIRE(other.Open(kSrcPath).ok());
+  Sqlite3Db dst;
+  REQUIRE(dst.Open(":memory:").ok());
+
+  BackupOptions opts;
+  opts.pages_per_step = 1;
+  Sqlite3Backup backup;
+  REQUIRE(backup.Begin(src, dst, opts).ok());
+  REQUIRE(backup.Active());
+  Error err;
+  REQUIRE(!backup.Step(&err));
+  REQUIRE(err.ok());
+  REQUIRE(!backup.Step(&err));
+  // Written through another connection: the backup cannot see the change
+  // and starts over on the next step.
+  other.Exec("INSERT INTO kv VALUES(?, ?);", 1000, "late");
+  REQUIRE(backup.Run().ok());
+  REQUIRE(!backup.Active());
+  REQUIRE(backup.Progress().restarts >= 1);
+  REQUIRE(backup.Progress().bytes_copied >
+          static_cast<uint64_t>(backup.Progress().page_count) *
+              backup.Progress().page_size);
+  REQUIRE(dst.ExecScalar("SELECT COUNT(*) FROM kv;") == 301);
+
+  // Bounded restarts give up
+  other.ExecDml("DELETE FROM kv WHERE k = 1000;");
+  Sqlite3Db dst2;
+  REQUIRE(dst2.Open(":memory:").ok());
+  opts.max_restarts = 1;
+  int32_t writes = 0;
+  opts.progress = [&](const BackupProgress&) {
+    other.Exec("INSERT INTO kv VALUES(?, ?);", 2000 + writes++, "x");
+    return true;
+  };
+  err = Sqlite3Backup::To(src, dst2, opts);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(!dst2.TableExists("kv"));
+
+  other.Close();
+  src.Close();
+  RemoveFile(kSrcPath);
+}
+
+TEST_CASE("Sqlite3Backup: bandwidth cap paces the copy", "[backup]") {
+  Sqlite3Db src;
+  Sqlite3Db dst;
+  REQUIRE(src.Open(":memory:").ok());
+  REQUIRE(dst.Open(":memory:").ok());
+  FillSource(src, 400);
+
+  BackupOptions opts;
+  opts.pages_per_step = 4;
+  BackupProgress progress;
+  // Budget for the whole copy: ~100 ms
+  uint64_t bytes = static_cast<uint64_t>(
+      src.ExecScalar("PRAGMA page_count;") *
+      src.ExecScalar("PRAGMA page_size;"));
+  opts.max_bytes_per_sec = bytes * 10;
+  auto start = std::chrono::steady_clock::now();
+  REQUIRE(Sqlite3Backup::To(src, dst, opts, &progress).ok());
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+  // Pacing sleeps before each step but the last
+  uint64_t paced_us = (progress.bytes_copied - 4 * progress.page_size) *
+                      1000000ULL / opts.max_bytes_per_sec;
+  REQUIRE(ms >= static_cast<int64_t>(paced_us / 1000) - 1);
+  REQUIRE(progress.elapsed_us >= paced_us);
+  REQUIRE(dst.ExecScalar("SELECT COUNT(*) FROM kv;") == 400);
+}
+
+TEST_CASE("Sqlite3Backup: errors", "[backup]") {
+  Sqlite3Db src;
+  Sqlite3Db closed;
+  REQUIRE(src.Open(":memory:").ok());
+
+  Sqlite3Backup backup;
+  REQUIRE(!backup.Active());
+  REQUIRE(backup.Run().code == ErrorCode::kMisuse);
+  Error err;
+  REQUIRE(!backup.Step(&err));
+  REQUIRE(err.code == ErrorCode::kMisuse);
+  REQUIRE(backup.Finish().ok());
+
+  REQUIRE(backup.Begin(src, closed).code == ErrorCode::kNotOpen);
+  REQUIRE(backup.Begin(src, src).code == ErrorCode::kMisuse);
+  Sqlite3Db dst;
+  REQUIRE(dst.Open(":memory:").ok());
+  BackupOptions opts;
+  opts.pages_per_step = 0;
+  REQUIRE(backup.Begin(src, dst, opts).code == ErrorCode::kRange);
+  opts.pages_per_step = -1;
+  opts.source_schema = "nosuch";
+  REQUIRE(backup.Begin(src, dst, opts).code == ErrorCode::kError);
+  REQUIRE(Sqlite3Backup::ToFile(src, nullptr).code == ErrorCode::kNullParam);
+
+  // Moved-from backup is inert; the target finishes the copy
+  src.ExecDml("CREATE TABLE t(x);");
+  opts.source_schema = "main";
+  Sqlite3Backup first;
+  REQUIRE(first.Begin(src, dst, opts).ok());
+  Sqlite3Backup second(std::move(first));
+  REQUIRE(!first.Active());
+  REQUIRE(second.Run().ok());
+  REQUIRE(dst.TableExists("t"));
+}
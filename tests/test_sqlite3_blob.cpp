@@ -0,0 +1,186 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Blob (incremental BLOB I/O).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static void OpenDb(Sqlite3Db& db) {
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE fw(id INTEGER PRIMARY KEY, image BLOB);");
+}
+
+static uint8_t Pattern(int32_t i) { return static_cast<uint8_t>(i * 31 + 7); }
+
+TEST_CASE("Sqlite3Blob: zeroblob insert then chunked write and read",
+          "[blob]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  const int32_t kSize = 1 << 20;
+  REQUIRE(db.Exec("INSERT INTO fw(id, image) VALUES(?, ?);", 7,
+                  ZeroBlob(kSize)) == 1);
+  REQUIRE(db.LastInsertRowId() == 7);
+  REQUIRE(db.ExecScalar("SELECT length(image) FROM fw WHERE id = 7;") ==
+          kSize);
+
+  Error err;
+  Sqlite3Blob blob = db.OpenBlob("fw", "image", 7, true, &err);
+  REQUIRE(err.ok());
+  REQUIRE(blob);
+  REQUIRE(blob.Writable());
+  REQUIRE(blob.RowId() == 7);
+  REQUIRE(blob.Size() == kSize);
+
+  uint8_t chunk[4000];
+  int32_t written = 0;
+  while (written < kSize) {
+    int32_t n = kSize - written < 4000 ? kSize - written : 4000;
+    for (int32_t i = 0; i < n; ++i) { chunk[i] = Pattern(written + i); }
+    REQUIRE(blob.WriteNext(chunk, n).ok());
+    written += n;
+  }
+  REQUIRE(blob.Tell() == kSize);
+
+  // Sequential read back in a different chunk size
+  REQUIRE(blob.Seek(0).ok());
+  uint8_t buf[3333];
+  int32_t total = 0;
+  bool same = true;
+  int32_t n = 0;
+  while ((n = blob.ReadNext(buf, sizeof(buf))) > 0) {
+    for (int32_t i = 0; i < n; ++i) {
+      if (buf[i] != Pattern(total + i)) { same = false; }
+    }
+    total += n;
+  }
+  REQUIRE(n == 0);
+  REQUIRE(total == kSize);
+  REQUIRE(same);
+
+  // Positional read
+  uint8_t mid[16];
+  REQUIRE(blob.Read(500000, mid, 16).ok());
+  REQUIRE(mid[3] == Pattern(500003));
+  blob.Close();
+  REQUIRE(!blob);
+
+  // Visible through SQL
+  Sqlite3Query q = db.ExecQuery("SELECT image FROM fw WHERE id = 7;");
+  int32_t len = 0;
+  const uint8_t* data = q.GetBlob(0, len);
+  REQUIRE(len == kSize);
+  REQUIRE(data[kSize - 1] == Pattern(kSize - 1));
+}
+
+TEST_CASE("Sqlite3Blob: ReadAll streams to a sink", "[blob]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  std::vector<uint8_t> value(10000);
+  for (int32_t i = 0; i < 10000; ++i) { value[i] = Pattern(i); }
+  db.Exec("INSERT INTO fw(id, image) VALUES(?, ?);", 1,
+          BlobView(value.data(), 10000));
+
+  Sqlite3Blob blob = db.OpenBlob("fw", "image", 1);
+  REQUIRE(blob);
+  REQUIRE(!blob.Writable());
+  std::vector<uint8_t> out;
+  int32_t chunks = 0;
+  uint8_t buf[4096];
+  REQUIRE(blob.ReadAll([&](const uint8_t* p, int32_t len) {
+    ++chunks;
+    out.insert(out.end(), p, p + len);
+    return true;
+  }, buf, sizeof(buf)).ok());
+  REQUIRE(chunks == 3);
+  REQUIRE(out == value);
+
+  // Sink stops early
+  chunks = 0;
+  REQUIRE(blob.ReadAll([&](const uint8_t*, int32_t) {
+    return ++chunks < 2;
+  }, buf, sizeof(buf)).ok());
+  REQUIRE(chunks == 2);
+}
+
+TEST_CASE("Sqlite3Blob: Reopen moves across rows", "[blob]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  for (int32_t id = 1; id <= 5; ++id) {
+    db.Exec("INSERT INTO fw(id, image) VALUES(?, ?);", id, ZeroBlob(id * 10));
+  }
+  Sqlite3Blob blob = db.OpenBlob("fw", "image", 1, true);
+  REQUIRE(blob);
+  for (int32_t id = 1; id <= 5; ++id) {
+    if (id > 1) { REQUIRE(blob.Reopen(id).ok()); }
+    REQUIRE(blob.RowId() == id);
+    REQUIRE(blob.Size() == id * 10);
+    uint8_t tag = static_cast<uint8_t>(id);
+    REQUIRE(blob.Write(blob.Size() - 1, &tag, 1).ok());
+  }
+  REQUIRE(db.ExecScalar(
+      "SELECT SUM(unicode(CAST(substr(image, -1) AS TEXT))) FROM fw;") == 15);
+
+  Status st = blob.Reopen(99);
+  REQUIRE(st.code == ErrorCode::kNotFound);
+  REQUIRE(std::strlen(blob.ErrorMessage()) > 0);
+  REQUIRE(!blob);
+  REQUIRE(blob.Reopen(2).code == ErrorCode::kMisuse);
+}
+
+TEST_CASE("Sqlite3Blob: errors", "[blob]") {
+  Sqlite3Db closed;
+  Error err;
+  REQUIRE(!closed.OpenBlob("fw", "image", 1, false, &err));
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+
+  Sqlite3Db db;
+  OpenDb(db);
+  db.Exec("INSERT INTO fw(id, image) VALUES(?, ?);", 1, ZeroBlob(100));
+  err.Clear();
+  REQUIRE(!db.OpenBlob("fw", "image", 2, false, &err));
+  REQUIRE(err.code == ErrorCode::kError);
+  err.Clear();
+  REQUIRE(!db.OpenBlob("nosuch", "image", 1, false, &err));
+  REQUIRE(err.code == ErrorCode::kError);
+  err.Clear();
+  REQUIRE(!db.OpenBlob(nullptr, "image", 1, false, &err));
+  REQUIRE(err.code == ErrorCode::kNullParam);
+
+  uint8_t buf[200] = {};
+  Sqlite3Blob ro = db.OpenBlob("fw", "image", 1);
+  REQUIRE(ro.Write(0, buf, 1).code == ErrorCode::kMisuse);
+  REQUIRE(ro.Read(90, buf, 20).code == ErrorCode::kRange);
+  REQUIRE(ro.Read(-1, buf, 1).code == ErrorCode::kRange);
+  REQUIRE(ro.Seek(101).code == ErrorCode::kRange);
+  REQUIRE(ro.Read(0, buf, 100).ok());
+  ro.Close();
+
+  // Values keep their size: no writing past the end
+  Sqlite3Blob rw = db.OpenBlob("fw", "image", 1, true);
+  REQUIRE(rw.Write(50, buf, 51).code == ErrorCode::kRange);
+  REQUIRE(rw.WriteNext(buf, 100).ok());
+  REQUIRE(rw.WriteNext(buf, 1).code == ErrorCode::kRange);
+
+  // Row changed behind the handle: the handle is expired
+  db.ExecDml("UPDATE fw SET image = zeroblob(100) WHERE id = 1;");
+  Status st = rw.Read(0, buf, 10);
+  REQUIRE(st.code == ErrorCode::kError);
+  REQUIRE(st.native == SQLITE_ABORT);
+  REQUIRE(rw.ToError(st).code == ErrorCode::kError);
+
+  Sqlite3Blob none;
+  REQUIRE(none.Read(0, buf, 1).code == ErrorCode::kMisuse);
+  REQUIRE(none.ReadNext(buf, 1) == -1);
+  REQUIRE(none.Reopen(1).code == ErrorCode::kMisuse);
+
+  // Negative size is rejected before SQLite sees it
+  Sqlite3Statement stmt =
+      db.CompileStatement("INSERT INTO fw(id, image) VALUES(9, ?);");
+  REQUIRE(stmt.BindZeroBlob(1, -1).code == ErrorCode::kRange);
+  REQUIRE(stmt.BindZeroBlob(1, int64_t{1} << 40).code == ErrorCode::kRange);
+}
@@ -0,0 +1,262 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for SQLite result-code mapping and the busy retry policy.
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static const char* kPath = "dbpp_test_busy.db";
+
+static void RemoveDb() {
+  std::remove(kPath);
+  std::remove((std::string(kPath) + "-journal").c_str());
+}
+
+/// Two connections to one file with table t.
+static void OpenPair(Sqlite3Db& holder, Sqlite3Db& waiter) {
+  RemoveDb();
+  REQUIRE(holder.Open(kPath).ok());
+  REQUIRE(waiter.Open(kPath).ok());
+  holder.ExecDml("CREATE TABLE t(x INTEGER);");
+}
+
+/// `holder` takes an exclusive lock and keeps it until Commit().
+static void Lock(Sqlite3Db& holder) {
+  REQUIRE(holder.BeginTransaction(TxnMode::kExclusive).ok());
+  holder.ExecDml("INSERT INTO t VALUES(1);");
+}
+
+static void OpenLocked(Sqlite3Db& holder, Sqlite3Db& waiter) {
+  OpenPair(holder, waiter);
+  Lock(holder);
+}
+
+static int64_t ElapsedMs(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - since).count();
+}
+
+TEST_CASE("Busy: result codes are mapped", "[busy]") {
+  REQUIRE(Sqlite3ErrorCode(SQLITE_DONE) == ErrorCode::kOk);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_BUSY) == ErrorCode::kBusy);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_BUSY_SNAPSHOT) == ErrorCode::kBusy);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_LOCKED) == ErrorCode::kBusy);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_CONSTRAINT_UNIQUE) ==
+          ErrorCode::kConstraint);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_IOERR_READ) == ErrorCode::kIoError);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_FULL) == ErrorCode::kFull);
+  REQUIRE(Sqlite3ErrorCode(SQLITE_CORRUPT) == ErrorCode::kError);
+
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE u(id INTEGER PRIMARY KEY, v TEXT NOT NULL);");
+  db.ExecDml("INSERT INTO u VALUES(1, 'a');");
+  Error err;
+  REQUIRE(db.ExecDml("INSERT INTO u VALUES(1, 'b');", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+
+  Sqlite3Statement stmt = db.CompileStatement("INSERT INTO u VALUES(?, ?);");
+  stmt.BindAll(2, Nullable<int64_t>());
+  err.Clear();
+  REQUIRE(stmt.ExecDml(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+  stmt.BindAll("not an int", "x");
+  err.Clear();
+  REQUIRE(stmt.ExecDml(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kMismatch);
+
+  // Syntax errors stay generic
+  err.Clear();
+  db.ExecQuery("SELEC 1;", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+}
+
+TEST_CASE("Busy: a failed step is not end-of-data", "[busy]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(x INTEGER);");
+  for (int32_t i = 1; i <= 10; ++i) {
+    db.Exec("INSERT INTO t VALUES(?);", i);
+  }
+  REQUIRE(db.CreateFunction("check_row", [](FunctionContext& ctx, int64_t x) {
+    if (x == 5) { ctx.SetError("row 5 unreadable"); }
+    return x;
+  }).ok());
+
+  Sqlite3Query q = db.ExecQuery("SELECT check_row(x) FROM t;");
+  int32_t rows = 0;
+  for (; !q.Eof(); q.NextRow()) { ++rows; }
+  REQUIRE(rows == 4);
+  REQUIRE(q.StepStatus().code == ErrorCode::kError);
+  REQUIRE(!q.ToError().ok());
+
+  Sqlite3Query moved(std::move(q));
+  REQUIRE(!moved.StepStatus().ok());
+  moved.Finalize();
+  REQUIRE(moved.StepStatus().ok());
+
+  Sqlite3Query all = db.ExecQuery("SELECT x FROM t;");
+  for (rows = 0; !all.Eof(); all.NextRow()) { ++rows; }
+  REQUIRE(rows == 10);
+  REQUIRE(all.StepStatus().ok());
+}
+
+TEST_CASE("Busy: contention is reported as kBusy", "[busy]") {
+  Sqlite3Db holder;
+  Sqlite3Db waiter;
+  OpenPair(holder, waiter);
+  Sqlite3Statement stmt = waiter.CompileStatement("DELETE FROM t;");
+  REQUIRE(stmt.Valid());
+  Lock(holder);
+
+  Error err;
+  REQUIRE(waiter.ExecDml("INSERT INTO t VALUES(2);", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  err.Clear();
+  waiter.ExecQuery("SELECT * FROM t;", &err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  err.Clear();
+  REQUIRE(stmt.ExecDml(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  err.Clear();
+  Sqlite3Query q = stmt.ExecQuery(&err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(waiter.BusyStats().conflicts == 0);
+
+  stmt.Finalize();
+  REQUIRE(holder.Commit().ok());
+  holder.Close();
+  waiter.Close();
+  RemoveDb();
+}
+
+TEST_CASE("Busy: retry waits for the lock to be released", "[busy]") {
+  Sqlite3Db holder;
+  Sqlite3Db waiter;
+  OpenLocked(holder, waiter);
+  Sqlite3BusyPolicy policy;
+  policy.initial_backoff_us = 500;
+  policy.deadline_ms = 10000;
+  waiter.EnableBusyRetry(policy);
+  REQUIRE(waiter.BusyRetryEnabled());
+
+  std::thread release([&holder]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    holder.Commit();
+  });
+  Error err;
+  REQUIRE(waiter.ExecDml("INSERT INTO t VALUES(2);", &err) == 1);
+  release.join();
+  REQUIRE(err.ok());
+  REQUIRE(waiter.ExecScalar("SELECT COUNT(*) FROM t;") == 2);
+
+  Sqlite3BusyStats stats = waiter.BusyStats();
+  REQUIRE(stats.conflicts >= 1);
+  REQUIRE(stats.waits >= 1);
+  REQUIRE(stats.wait_us >= 20000);
+  REQUIRE(stats.give_ups == 0);
+  waiter.ResetBusyStats();
+  REQUIRE(waiter.BusyStats().waits == 0);
+
+  // Statements compiled after enabling use the policy too
+  Sqlite3Statement stmt = waiter.CompileStatement("INSERT INTO t VALUES(3);");
+  REQUIRE(holder.BeginTransaction(TxnMode::kExclusive).ok());
+  std::thread release2([&holder]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    holder.Commit();
+  });
+  REQUIRE(stmt.ExecDml() == 1);
+  release2.join();
+  REQUIRE(waiter.BusyStats().waits >= 1);
+  stmt.Finalize();
+
+  holder.Close();
+  waiter.Close();
+  RemoveDb();
+}
+
+TEST_CASE("Busy: deadline and retry limits", "[busy]") {
+  Sqlite3Db holder;
+  Sqlite3Db waiter;
+  OpenLocked(holder, waiter);
+
+  Sqlite3BusyPolicy policy;
+  policy.deadline_ms = 100;
+  waiter.EnableBusyRetry(policy);
+  auto start = std::chrono::steady_clock::now();
+  Error err;
+  REQUIRE(waiter.ExecDml("INSERT INTO t VALUES(2);", &err) == -1);
+  int64_t ms = ElapsedMs(start);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(ms >= 90);
+  REQUIRE(ms < 2000);
+  // One conflict, not one per layer
+  REQUIRE(waiter.BusyStats().give_ups == 1);
+  REQUIRE(waiter.BusyStats().reruns == 0);
+
+  policy.max_retries = 0;
+  waiter.EnableBusyRetry(policy);
+  waiter.ResetBusyStats();
+  start = std::chrono::steady_clock::now();
+  err.Clear();
+  waiter.ExecQuery("SELECT * FROM t;", &err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(ElapsedMs(start) < 50);
+  REQUIRE(waiter.BusyStats().waits == 0);
+
+  // SetBusyTimeout() takes over from the policy
+  waiter.SetBusyTimeout(0);
+  REQUIRE(!waiter.BusyRetryEnabled());
+  REQUIRE(holder.Commit().ok());
+  holder.Close();
+  waiter.Close();
+  RemoveDb();
+}
+
+TEST_CASE("Busy: LOCKED first steps are re-run", "[busy]") {
+  // Shared cache: a table write lock gives readers SQLITE_LOCKED, which
+  // SQLite never sends to the busy handler.
+  Sqlite3OpenOptions opts;
+  opts.uri = true;
+  Sqlite3Db writer;
+  Sqlite3Db reader;
+  REQUIRE(writer.Open("file:dbpp_busy_mem?mode=memory&cache=shared", opts)
+              .ok());
+  REQUIRE(reader.Open("file:dbpp_busy_mem?mode=memory&cache=shared", opts)
+              .ok());
+  writer.ExecDml("CREATE TABLE t(x INTEGER);");
+  REQUIRE(writer.BeginTransaction().ok());
+  writer.ExecDml("INSERT INTO t VALUES(1);");
+
+  Error err;
+  reader.ExecQuery("SELECT COUNT(*) FROM t;", &err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+
+  Sqlite3BusyPolicy policy;
+  policy.deadline_ms = 10000;
+  reader.EnableBusyRetry(policy);
+  std::thread release([&writer]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    writer.Commit();
+  });
+  err.Clear();
+  REQUIRE(reader.ExecScalar("SELECT COUNT(*) FROM t;", 0, &err) == 1);
+  release.join();
+  REQUIRE(err.ok());
+  REQUIRE(reader.BusyStats().reruns >= 1);
+
+  // Disabled: fails at once again
+  reader.DisableBusyRetry();
+  REQUIRE(writer.BeginTransaction().ok());
+  writer.ExecDml("INSERT INTO t VALUES(2);");
+  err.Clear();
+  reader.ExecQuery("SELECT COUNT(*) FROM t;", &err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(writer.Rollback().ok());
+}
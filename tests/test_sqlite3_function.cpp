@@ -0,0 +1,208 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for SQL functions registered from C++ callables.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static void OpenDb(Sqlite3Db& db) {
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(id INTEGER PRIMARY KEY, v REAL, s TEXT);");
+  for (int32_t i = 1; i <= 10; ++i) {
+    db.Exec("INSERT INTO t VALUES(?, ?, ?);", i, i * 1.5,
+            "s" + std::to_string(i));
+  }
+}
+
+static int64_t Twice(int64_t x) { return x * 2; }
+
+TEST_CASE("SQL function: scalar types are deduced", "[function]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  REQUIRE(db.CreateFunction("twice", &Twice).ok());
+  REQUIRE(db.CreateFunction("clamp", [](double v, double lo, double hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+  }).ok());
+  REQUIRE(db.CreateFunction("shout", [](TextView s) {
+    std::string out(s.data, s.size);
+    for (char& c : out) { c = static_cast<char>(std::toupper(c)); }
+    return out + "!";
+  }).ok());
+  REQUIRE(db.CreateFunction("is_even", [](int32_t x) {
+    return x % 2 == 0;
+  }).ok());
+  REQUIRE(db.CreateFunction("answer", []() { return 42; }).ok());
+
+  REQUIRE(db.ExecScalar("SELECT twice(21);") == 42);
+  REQUIRE(db.ExecScalar("SELECT answer();") == 42);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t WHERE is_even(id);") == 5);
+  // v = 1.5 * id -> 3, 3, 4.5, 6, 6, ...
+  REQUIRE(db.ExecScalar("SELECT SUM(clamp(v, 3, 6) * 2) FROM t;") ==
+          6 + 6 + 9 + 12 * 7);
+
+  Sqlite3Query q = db.ExecQuery("SELECT shout(s) FROM t WHERE id = 3;");
+  REQUIRE(std::string(q.GetString(0)) == "S3!");
+
+  // Arity is enforced by SQLite
+  Error err;
+  db.ExecQuery("SELECT twice(1, 2);", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+}
+
+TEST_CASE("SQL function: NULL handling and captured state", "[function]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  REQUIRE(db.CreateFunction("or_default",
+      [](Nullable<int64_t> v, int64_t d) {
+        return v.is_null ? d : v.value;
+      }).ok());
+  REQUIRE(db.CreateFunction("half_or_null", [](int64_t v) {
+    return v % 2 == 0 ? Nullable<int64_t>(v / 2) : Nullable<int64_t>();
+  }).ok());
+  REQUIRE(db.ExecScalar("SELECT or_default(NULL, 7);") == 7);
+  REQUIRE(db.ExecScalar("SELECT or_default(3, 7);") == 3);
+  REQUIRE(db.ExecScalar("SELECT COUNT(half_or_null(id)) FROM t;") == 5);
+
+  // Stateful functor, not deterministic
+  int32_t calls = 0;
+  FunctionOptions opts;
+  opts.deterministic = false;
+  REQUIRE(db.CreateFunction("tick", [&calls]() { return ++calls; }, opts)
+              .ok());
+  REQUIRE(db.ExecScalar("SELECT MAX(tick()) FROM t;") == 10);
+  REQUIRE(calls == 10);
+
+  // Raw values and blobs
+  REQUIRE(db.CreateFunction("type_of", [](sqlite3_value* v) {
+    return sqlite3_value_type(v);
+  }).ok());
+  REQUIRE(db.ExecScalar("SELECT type_of(x'00');") == SQLITE_BLOB);
+  REQUIRE(db.CreateFunction("blob_len", [](BlobView b) {
+    return b.size;
+  }).ok());
+  REQUIRE(db.ExecScalar("SELECT blob_len(x'010203');") == 3);
+}
+
+TEST_CASE("SQL function: errors reported through FunctionContext",
+          "[function]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  REQUIRE(db.CreateFunction("safe_sqrt", [](FunctionContext& ctx, double x) {
+    if (x < 0) {
+      ctx.SetError("safe_sqrt: negative argument");
+      return 0.0;
+    }
+    return std::sqrt(x);
+  }).ok());
+  REQUIRE(db.ExecScalar("SELECT safe_sqrt(16);") == 4);
+  Error err;
+  db.ExecQuery("SELECT safe_sqrt(-1);", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(std::strstr(err.message, "negative argument") != nullptr);
+
+  // Deterministic functions may be used in indexes
+  REQUIRE(db.ExecDml("CREATE INDEX t_sqrt ON t(safe_sqrt(v));") >= 0);
+
+  REQUIRE(db.RemoveFunction("safe_sqrt", 1).ok());
+  err.Clear();
+  db.ExecQuery("SELECT safe_sqrt(4.0);", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+
+  Sqlite3Db closed;
+  REQUIRE(closed.CreateFunction("f", []() { return 1; }).code ==
+          ErrorCode::kNotOpen);
+  REQUIRE(db.CreateFunction(nullptr, []() { return 1; }).code ==
+          ErrorCode::kNullParam);
+}
+
+namespace {
+
+struct GeoMean {
+  double log_sum = 0;
+  int64_t n = 0;
+
+  void Step(double x) {
+    if (x > 0) {
+      log_sum += std::log(x);
+      ++n;
+    }
+  }
+  Nullable<double> Final() const {
+    return n > 0 ? Nullable<double>(std::exp(log_sum / n))
+                 : Nullable<double>();
+  }
+};
+
+struct Concat {
+  std::string out;
+
+  void Step(TextView s, TextView sep) {
+    if (!out.empty()) { out.append(sep.data, sep.size); }
+    out.append(s.data, s.size);
+  }
+  std::string Final() const { return out; }
+};
+
+struct MovingSum {
+  int64_t sum = 0;
+
+  void Step(int64_t x) { sum += x; }
+  void Inverse(int64_t x) { sum -= x; }
+  int64_t Value() const { return sum; }
+  int64_t Final() const { return sum; }
+};
+
+}  // namespace
+
+TEST_CASE("SQL function: aggregates", "[function]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  REQUIRE(db.CreateAggregate<GeoMean>("geomean").ok());
+  REQUIRE(db.CreateAggregate<Concat>("concat_sep").ok());
+
+  Sqlite3Query q = db.ExecQuery("SELECT geomean(v) FROM t WHERE id <= 2;");
+  REQUIRE(std::fabs(q.GetDouble(0) - std::sqrt(1.5 * 3.0)) < 1e-9);
+  q.Finalize();
+
+  // Empty group: Final() on a fresh state
+  q = db.ExecQuery("SELECT geomean(v) FROM t WHERE id > 100;");
+  REQUIRE(q.FieldIsNull(0));
+  q.Finalize();
+
+  // One state per group
+  q = db.ExecQuery(
+      "SELECT id % 2, concat_sep(s, '|') FROM "
+      "(SELECT * FROM t WHERE id <= 4 ORDER BY id) GROUP BY id % 2 "
+      "ORDER BY 1;");
+  REQUIRE(std::string(q.GetString(1)) == "s2|s4");
+  q.NextRow();
+  REQUIRE(std::string(q.GetString(1)) == "s1|s3");
+}
+
+TEST_CASE("SQL function: window function", "[function]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  REQUIRE(db.CreateWindowFunction<MovingSum>("msum").ok());
+  Sqlite3Query q = db.ExecQuery(
+      "SELECT id, msum(id) OVER (ORDER BY id ROWS BETWEEN 2 PRECEDING "
+      "AND CURRENT ROW) FROM t ORDER BY id;");
+  int64_t expected[] = {1, 3, 6, 9, 12, 15, 18, 21, 24, 27};
+  int32_t row = 0;
+  bool same = true;
+  for (; !q.Eof(); q.NextRow(), ++row) {
+    if (q.GetInt64(1) != expected[row]) { same = false; }
+  }
+  REQUIRE(row == 10);
+  REQUIRE(same);
+  q.Finalize();
+
+  // Also usable as a plain aggregate
+  REQUIRE(db.ExecScalar("SELECT msum(id) FROM t;") == 55);
+}
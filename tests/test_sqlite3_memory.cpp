@@ -0,0 +1,128 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Memory and per-connection lookaside.
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "dbpp/sqlite3_db.hpp"
+#include "dbpp/sqlite3_memory.hpp"
+
+using namespace dbpp;
+
+static void Churn(Sqlite3Db& db, int32_t rows) {
+  db.ExecDml("CREATE TABLE t(id INTEGER PRIMARY KEY, v TEXT);");
+  db.ExecDml("BEGIN;");
+  auto stmt = db.CompileStatement("INSERT INTO t VALUES(?, ?);");
+  for (int32_t i = 0; i < rows; ++i) {
+    stmt.Exec(i, "some payload text to fill pages");
+  }
+  db.ExecDml("COMMIT;");
+}
+
+TEST_CASE("Sqlite3Memory: page cache arena serves pages", "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3MemoryOptions opts;
+  opts.page_cache_pages = 256;
+  REQUIRE(Sqlite3Memory::Configure(opts).ok());
+  REQUIRE(Sqlite3Memory::Stats().page_cache_arena_bytes >= 256u * 4096u);
+  {
+    Sqlite3Db db;
+    REQUIRE(db.Open(":memory:").ok());
+    Churn(db, 2000);
+    REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t;") == 2000);
+    Sqlite3MemoryStats s = Sqlite3Memory::Stats();
+    REQUIRE(s.page_cache_used > 0);
+    REQUIRE(s.page_cache_peak >= s.page_cache_used);
+  }
+  Sqlite3Memory::Reset();
+  REQUIRE(Sqlite3Memory::Stats().page_cache_arena_bytes == 0);
+}
+
+TEST_CASE("Sqlite3Memory: huge pages fall back to a plain mapping",
+          "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3MemoryOptions opts;
+  opts.page_cache_pages = 64;
+  opts.huge_pages = true;
+  REQUIRE(Sqlite3Memory::Configure(opts).ok());
+  {
+    Sqlite3Db db;
+    REQUIRE(db.Open(":memory:").ok());
+    Churn(db, 200);
+  }
+  Sqlite3Memory::Reset();
+}
+
+TEST_CASE("Sqlite3Memory: heap arena", "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3MemoryOptions opts;
+  opts.heap_bytes = 8u << 20;
+  Error err = Sqlite3Memory::Configure(opts);
+  if (!sqlite3_compileoption_used("ENABLE_MEMSYS5")) {
+    REQUIRE(err.code == ErrorCode::kMisuse);
+    return;
+  }
+  REQUIRE(err.ok());
+  {
+    Sqlite3Db db;
+    REQUIRE(db.Open(":memory:").ok());
+    Churn(db, 500);
+    REQUIRE(Sqlite3Memory::Stats().used_bytes <= int64_t{8} << 20);
+  }
+  Sqlite3Memory::Reset();
+}
+
+TEST_CASE("Sqlite3Memory: configure after initialization", "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  Sqlite3MemoryOptions opts;
+  opts.page_cache_pages = 16;
+  REQUIRE(Sqlite3Memory::Configure(opts).code == ErrorCode::kMisuse);
+  REQUIRE(Sqlite3Memory::Stats().page_cache_arena_bytes == 0);
+}
+
+TEST_CASE("Sqlite3Memory: option validation", "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3MemoryOptions opts;
+  opts.page_cache_pages = 16;
+  opts.page_size = 100;
+  REQUIRE(Sqlite3Memory::Configure(opts).code == ErrorCode::kRange);
+  opts = Sqlite3MemoryOptions{};
+  opts.heap_bytes = 1u << 20;
+  opts.heap_min_alloc = 48;
+  REQUIRE(Sqlite3Memory::Configure(opts).code == ErrorCode::kRange);
+}
+
+TEST_CASE("Sqlite3Memory: hard heap limit", "[memory]") {
+  Sqlite3Memory::Reset();
+  Sqlite3MemoryOptions opts;
+  opts.hard_heap_limit = int64_t{64} << 20;
+  REQUIRE(Sqlite3Memory::Configure(opts).ok());
+  REQUIRE(sqlite3_hard_heap_limit64(-1) == int64_t{64} << 20);
+  Sqlite3Memory::Reset();
+  REQUIRE(sqlite3_hard_heap_limit64(-1) == 0);
+}
+
+TEST_CASE("Sqlite3OpenOptions: lookaside per connection", "[memory]") {
+  if (sqlite3_compileoption_used("OMIT_LOOKASIDE")) { return; }
+  Sqlite3OpenOptions opts;
+  opts.lookaside_slot_size = 256;
+  opts.lookaside_slots = 500;
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:", opts).ok());
+  Churn(db, 100);
+
+  int cur = 0;
+  int hi = 0;
+  sqlite3_db_status(db.Handle(), SQLITE_DBSTATUS_LOOKASIDE_USED, &cur, &hi, 0);
+  REQUIRE(hi > 0);
+  REQUIRE(hi <= 500);
+
+  Sqlite3OpenOptions off;
+  off.lookaside_slots = 0;
+  Sqlite3Db db2;
+  REQUIRE(db2.Open(":memory:", off).ok());
+  Churn(db2, 10);
+  sqlite3_db_status(db2.Handle(), SQLITE_DBSTATUS_LOOKASIDE_USED, &cur, &hi, 0);
+  REQUIRE(hi == 0);
+}
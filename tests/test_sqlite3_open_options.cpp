@@ -0,0 +1,147 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for Sqlite3Db::Open(path, Sqlite3OpenOptions).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "dbpp/db.hpp"
+
+using namespace dbpp;
+
+static std::string TempDbPath(const char* name) {
+  std::string path = std::string("dbpp_test_") + name + ".db";
+  std::remove(path.c_str());
+  std::remove((path + "-wal").c_str());
+  std::remove((path + "-shm").c_str());
+  return path;
+}
+
+static std::string PragmaText(Sqlite3Db& db, const char* sql) {
+  auto q = db.ExecQuery(sql);
+  return q.Eof() ? std::string() : std::string(q.GetString(0));
+}
+
+TEST_CASE("OpenOptions: defaults match plain Open", "[open_options]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:", Sqlite3OpenOptions{}).ok());
+  REQUIRE(db.IsOpen());
+  REQUIRE(db.ExecDml("CREATE TABLE t(id INTEGER);") == 0);
+}
+
+TEST_CASE("OpenOptions: throughput preset applies pragmas",
+          "[open_options]") {
+  std::string path = TempDbPath("throughput");
+  Sqlite3Db db;
+  REQUIRE(db.Open(path.c_str(), Sqlite3OpenOptions::Throughput()).ok());
+  REQUIRE(PragmaText(db, "PRAGMA journal_mode;") == "wal");
+  REQUIRE(db.ExecScalar("PRAGMA synchronous;") == 1);   // NORMAL
+  REQUIRE(db.ExecScalar("PRAGMA cache_size;") == -64 * 1024);
+  REQUIRE(db.ExecScalar("PRAGMA temp_store;") == 2);    // MEMORY
+  db.Close();
+  std::remove(path.c_str());
+}
+
+TEST_CASE("OpenOptions: durable preset and page_size", "[open_options]") {
+  std::string path = TempDbPath("durable");
+  Sqlite3OpenOptions opts = Sqlite3OpenOptions::Durable();
+  opts.page_size = 8192;
+  Sqlite3Db db;
+  REQUIRE(db.Open(path.c_str(), opts).ok());
+  REQUIRE(PragmaText(db, "PRAGMA journal_mode;") == "wal");
+  REQUIRE(db.ExecScalar("PRAGMA synchronous;") == 2);   // FULL
+  REQUIRE(db.ExecScalar("PRAGMA page_size;") == 8192);
+  db.Close();
+  std::remove(path.c_str());
+}
+
+TEST_CASE("OpenOptions: read-only replica rejects writes", "[open_options]") {
+  std::string path = TempDbPath("replica");
+  {
+    Sqlite3Db writer;
+    REQUIRE(writer.Open(path.c_str()).ok());
+    writer.ExecDml("CREATE TABLE t(id INTEGER);");
+    writer.ExecDml("INSERT INTO t VALUES(1);");
+  }
+
+  Sqlite3Db db;
+  REQUIRE(db.Open(path.c_str(), Sqlite3OpenOptions::ReadOnlyReplica()).ok());
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t;") == 1);
+  Error err;
+  REQUIRE(db.ExecDml("INSERT INTO t VALUES(2);", &err) == -1);
+  REQUIRE_FALSE(err.ok());
+  db.Close();
+  std::remove(path.c_str());
+}
+
+TEST_CASE("OpenOptions: read-only open of a missing file fails",
+          "[open_options]") {
+  std::string path = TempDbPath("missing");
+  Sqlite3OpenOptions opts;
+  opts.read_only = true;
+  Sqlite3Db db;
+  REQUIRE_FALSE(db.Open(path.c_str(), opts).ok());
+  REQUIRE_FALSE(db.IsOpen());
+
+  opts = Sqlite3OpenOptions{};
+  opts.create = false;
+  REQUIRE_FALSE(db.Open(path.c_str(), opts).ok());
+}
+
+TEST_CASE("OpenOptions: URI filenames and exclusive locking",
+          "[open_options]") {
+  Sqlite3OpenOptions opts;
+  opts.uri = true;
+  opts.exclusive_locking = true;
+  opts.thread_mode = Sqlite3ThreadMode::kMultiThread;
+  Sqlite3Db db;
+  REQUIRE(db.Open("file:optdb?mode=memory", opts).ok());
+  REQUIRE(PragmaText(db, "PRAGMA locking_mode;") == "exclusive");
+}
+
+TEST_CASE("OpenOptions: presets by name", "[open_options]") {
+  Sqlite3OpenOptions opts;
+  REQUIRE(Sqlite3OpenOptions::FromName("throughput", &opts));
+  REQUIRE(opts.journal_mode == Sqlite3JournalMode::kWal);
+  REQUIRE(Sqlite3OpenOptions::FromName("read-only-replica", &opts));
+  REQUIRE(opts.read_only);
+  REQUIRE(Sqlite3OpenOptions::FromName("durable", &opts));
+  REQUIRE(opts.synchronous == Sqlite3Synchronous::kFull);
+  REQUIRE_FALSE(Sqlite3OpenOptions::FromName("fast", &opts));
+  REQUIRE(opts.synchronous == Sqlite3Synchronous::kFull);
+}
+
+TEST_CASE("OpenOptions: Database facade overload", "[open_options]") {
+  Sqlite3OpenOptions opts = Sqlite3OpenOptions::Throughput();
+  opts.journal_mode = Sqlite3JournalMode::kMemory;
+  Db db;
+  REQUIRE(db.Open(":memory:", opts).ok());
+  REQUIRE(db.ExecScalar("PRAGMA temp_store;") == 2);
+}
+
+TEST_CASE("OpenOptions: a journal mode SQLite keeps out is an error",
+          "[open_options]") {
+  // :memory: databases can only use MEMORY or OFF
+  Sqlite3Db db;
+  Error err = db.Open(":memory:", Sqlite3OpenOptions::Throughput());
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(std::strstr(err.message, "journal mode is memory") != nullptr);
+  REQUIRE(!db.IsOpen());
+
+  // A read-only handle cannot switch an existing file to WAL
+  std::string path = TempDbPath("ro_wal");
+  {
+    Sqlite3Db writer;
+    REQUIRE(writer.Open(path.c_str()).ok());
+    writer.ExecDml("CREATE TABLE t(id INTEGER);");
+  }
+  Sqlite3OpenOptions opts;
+  opts.read_only = true;
+  opts.journal_mode = Sqlite3JournalMode::kWal;
+  err = db.Open(path.c_str(), opts);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(std::strstr(err.message, "journal_mode=WAL") != nullptr);
+  REQUIRE(!db.IsOpen());
+  std::remove(path.c_str());
+}
@@ -0,0 +1,158 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Profiler (Sqlite3Db::EnableProfiling).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstring>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static const Sqlite3SqlStats* FindSql(const Sqlite3SqlStats* stats,
+                                      uint32_t n, const char* sql) {
+  for (uint32_t i = 0; i < n; ++i) {
+    if (std::strcmp(stats[i].sql, sql) == 0) { return &stats[i]; }
+  }
+  return nullptr;
+}
+
+static void FillTable(Sqlite3Db& db, int32_t rows) {
+  db.ExecDml("CREATE TABLE t(id INTEGER, v INTEGER);");
+  auto stmt = db.CompileStatement("INSERT INTO t VALUES(?, ?);");
+  for (int32_t i = 0; i < rows; ++i) { stmt.Exec(i, rows - i); }
+}
+
+TEST_CASE("Sqlite3Profiler: disabled by default", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  REQUIRE_FALSE(db.ProfilingEnabled());
+  db.ExecDml("CREATE TABLE t(id INTEGER);");
+  Sqlite3SqlStats out[4];
+  REQUIRE(db.ProfileSnapshot(out, 4) == 0);
+}
+
+TEST_CASE("Sqlite3Profiler: counts calls per SQL text", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.EnableProfiling();
+  FillTable(db, 50);
+
+  Sqlite3SqlStats out[8];
+  uint32_t n = db.ProfileSnapshot(out, 8);
+  const Sqlite3SqlStats* ins = FindSql(out, n, "INSERT INTO t VALUES(?, ?);");
+  REQUIRE(ins != nullptr);
+  REQUIRE(ins->calls == 50);
+  REQUIRE(ins->total_ns >= ins->max_ns);
+  REQUIRE(ins->min_ns <= ins->max_ns);
+  REQUIRE(ins->vm_steps > 0);
+
+  uint64_t hist = 0;
+  for (uint32_t b = 0; b < Sqlite3SqlStats::kBuckets; ++b) {
+    hist += ins->histogram[b];
+  }
+  REQUIRE(hist == 50);
+  REQUIRE(ins->PercentileNs(50.0) <= ins->PercentileNs(99.0));
+  REQUIRE(ins->PercentileNs(99.0) <= ins->max_ns);
+}
+
+TEST_CASE("Sqlite3Profiler: rows, full scans and sorts", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  FillTable(db, 20);
+  db.EnableProfiling();
+
+  const char* sql = "SELECT id FROM t ORDER BY v;";
+  {
+    auto q = db.ExecQuery(sql);
+    while (!q.Eof()) { q.NextRow(); }
+  }
+
+  Sqlite3SqlStats out[4];
+  uint32_t n = db.ProfileSnapshot(out, 4);
+  const Sqlite3SqlStats* s = FindSql(out, n, sql);
+  REQUIRE(s != nullptr);
+  REQUIRE(s->calls == 1);
+  REQUIRE(s->rows == 20);
+  REQUIRE(s->fullscan_steps > 0);
+  REQUIRE(s->sorts > 0);
+}
+
+TEST_CASE("Sqlite3Profiler: snapshot is hottest first", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  FillTable(db, 200);
+  db.EnableProfiling();
+  for (int32_t i = 0; i < 20; ++i) {
+    db.ExecScalar("SELECT COUNT(*) FROM t AS a, t AS b WHERE a.v = b.id;");
+  }
+  db.ExecScalar("SELECT 1;");
+
+  Sqlite3SqlStats out[8];
+  uint32_t n = db.ProfileSnapshot(out, 8);
+  REQUIRE(n == 2);
+  REQUIRE(out[0].total_ns >= out[1].total_ns);
+  REQUIRE(db.ProfileSnapshot(out, 1) == 1);
+}
+
+TEST_CASE("Sqlite3Profiler: reset and max_sql bound", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  Sqlite3ProfilerOptions opts;
+  opts.max_sql = 2;
+  db.EnableProfiling(opts);
+  db.ExecScalar("SELECT 1;");
+  db.ExecScalar("SELECT 2;");
+  db.ExecScalar("SELECT 3;");
+
+  Sqlite3SqlStats out[4];
+  REQUIRE(db.ProfileSnapshot(out, 4) == 2);
+
+  db.ResetProfile();
+  REQUIRE(db.ProfileSnapshot(out, 4) == 0);
+  db.ExecScalar("SELECT 3;");
+  REQUIRE(db.ProfileSnapshot(out, 4) == 1);
+}
+
+TEST_CASE("Sqlite3Profiler: disable stops recording", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.EnableProfiling();
+  db.ExecScalar("SELECT 1;");
+  db.DisableProfiling();
+  REQUIRE_FALSE(db.ProfilingEnabled());
+  db.ExecScalar("SELECT 1;");
+  Sqlite3SqlStats out[4];
+  REQUIRE(db.ProfileSnapshot(out, 4) == 0);
+}
+
+TEST_CASE("Sqlite3Profiler: survives reopen and move", "[profiler]") {
+  Sqlite3Db db;
+  db.EnableProfiling();  // before Open
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecScalar("SELECT 1;");
+
+  Sqlite3Db moved(std::move(db));
+  moved.ExecScalar("SELECT 1;");
+  Sqlite3SqlStats out[4];
+  REQUIRE(moved.ProfileSnapshot(out, 4) == 1);
+  REQUIRE(out[0].calls == 2);
+}
+
+TEST_CASE("Sqlite3Profiler: text dump", "[profiler]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.EnableProfiling();
+  db.ExecScalar("SELECT 42;");
+
+  std::FILE* f = std::tmpfile();
+  REQUIRE(f != nullptr);
+  db.DumpProfile(f, 10);
+  std::rewind(f);
+  char buf[1024] = {};
+  size_t len = std::fread(buf, 1, sizeof(buf) - 1, f);
+  std::fclose(f);
+  REQUIRE(len > 0);
+  REQUIRE(std::strstr(buf, "p99_us") != nullptr);
+  REQUIRE(std::strstr(buf, "SELECT 42;") != nullptr);
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Script (multi-statement scripts compiled once).
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static int32_t LiveStatements(const Sqlite3Db& db) {
+  int32_t n = 0;
+  for (sqlite3_stmt* s = sqlite3_next_stmt(db.Handle(), nullptr);
+       s != nullptr; s = sqlite3_next_stmt(db.Handle(), s)) {
+    ++n;
+  }
+  return n;
+}
+
+TEST_CASE("Script: schema setup with dependent statements", "[script]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  Error err;
+  Sqlite3Script setup = db.CompileScript(
+      "CREATE TABLE samples(ts INTEGER, v REAL);\n"
+      "-- seed\n"
+      "INSERT INTO samples VALUES(1, 0.5), (2, 1.5), (3, 2.5);\n"
+      "CREATE INDEX samples_ts ON samples(ts);\n",
+      &err);
+  REQUIRE(err.ok());
+  REQUIRE(setup.Valid());
+  // The INSERT needs the table: prepared when Run() reaches it
+  REQUIRE(setup.Size() == 1);
+  REQUIRE(!setup.Complete());
+
+  REQUIRE(setup.Run(&err) == 3);
+  REQUIRE(err.ok());
+  REQUIRE(setup.Complete());
+  REQUIRE(setup.Size() == 3);
+  REQUIRE(setup.Changes(0) == 0);
+  REQUIRE(setup.Changes(1) == 3);
+  REQUIRE(setup.Changes(2) == 0);
+  REQUIRE(std::strstr(setup.Sql(1), "INSERT INTO samples") != nullptr);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples;") == 3);
+}
+
+TEST_CASE("Script: repeated runs reuse the compiled statements",
+          "[script]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE samples(ts INTEGER, v REAL);");
+  db.ExecDml("CREATE TABLE rollup(ts INTEGER, total REAL);");
+  db.ExecDml("CREATE TABLE meta(k TEXT PRIMARY KEY, v INTEGER);");
+
+  Error err;
+  Sqlite3Script tick = db.CompileScript(
+      "INSERT INTO samples VALUES(?, ?);"
+      "INSERT INTO rollup SELECT MAX(ts), SUM(v) FROM samples;"
+      "DELETE FROM samples WHERE ts < ?;"
+      "PRAGMA table_info(samples);"  // Returns rows: discarded
+      "SELECT COUNT(*) FROM rollup;"
+      "INSERT OR REPLACE INTO meta VALUES('ticks', "
+      "  COALESCE((SELECT v FROM meta WHERE k = 'ticks'), 0) + 1);",
+      &err);
+  REQUIRE(err.ok());
+  REQUIRE(tick.Complete());
+  REQUIRE(tick.Size() == 6);
+  int32_t live = LiveStatements(db);
+  sqlite3_stmt* first = tick.Handle(0);
+
+  for (int64_t t = 1; t <= 50; ++t) {
+    REQUIRE(tick.BindAll(0, t, t * 0.5).ok());
+    REQUIRE(tick.BindAll(2, t - 5).ok());
+    REQUIRE(tick.Run(&err) >= 3);
+    REQUIRE(err.ok());
+    REQUIRE(tick.Changes(0) == 1);
+    REQUIRE(tick.Changes(1) == 1);
+    REQUIRE(tick.Changes(2) == (t > 6 ? 1 : 0));
+    REQUIRE(tick.Changes(3) == 0);
+    REQUIRE(tick.Changes(4) == 0);
+  }
+  REQUIRE(LiveStatements(db) == live);
+  REQUIRE(tick.Handle(0) == first);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples;") == 6);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM rollup;") == 50);
+  REQUIRE(db.ExecScalar("SELECT v FROM meta WHERE k = 'ticks';") == 50);
+
+  // Bindings persist between runs
+  REQUIRE(tick.Run(&err) >= 3);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts = 50;") == 2);
+
+  // Moving keeps the statements
+  Sqlite3Script moved(std::move(tick));
+  REQUIRE(!tick.Valid());
+  REQUIRE(moved.Size() == 6);
+  REQUIRE(moved.Run(&err) >= 3);
+  moved.Finalize();
+  REQUIRE(LiveStatements(db) == live - 6);
+}
+
+TEST_CASE("Script: errors stop the run at the failing statement",
+          "[script]") {
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(id INTEGER PRIMARY KEY);");
+
+  Error err;
+  Sqlite3Script script = db.CompileScript(
+      "INSERT INTO t VALUES(1);"
+      "INSERT INTO t VALUES(1);"
+      "INSERT INTO t VALUES(2);");
+  REQUIRE(script.Run(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+  REQUIRE(std::strstr(err.message, "statement 1") != nullptr);
+  REQUIRE(script.Changes(0) == 1);
+  REQUIRE(script.Changes(1) == -1);
+  REQUIRE(script.Changes(2) == -1);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t;") == 1);
+
+  // A syntax error is reported when the run reaches it
+  err.Clear();
+  Sqlite3Script bad = db.CompileScript(
+      "DELETE FROM t; INSERT INTO t VALUES(5); SELEC oops;", &err);
+  REQUIRE(err.ok());
+  REQUIRE(bad.Size() == 2);
+  REQUIRE(bad.Run(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(std::strstr(err.message, "statement 2") != nullptr);
+  REQUIRE(db.ExecScalar("SELECT id FROM t;") == 5);
+
+  // Blank and comment-only scripts do nothing
+  Sqlite3Script empty = db.CompileScript("  ; -- nothing\n;");
+  REQUIRE(empty.Complete());
+  REQUIRE(empty.Size() == 0);
+  REQUIRE(empty.Run() == 0);
+
+  REQUIRE(script.BindAll(3, 1).code == ErrorCode::kRange);
+  REQUIRE(script.Changes(9) == -1);
+  REQUIRE(script.Sql(9) == nullptr);
+
+  Sqlite3Script none;
+  err.Clear();
+  REQUIRE(none.Run(&err) == -1);
+  REQUIRE(err.code == ErrorCode::kMisuse);
+
+  Sqlite3Db closed;
+  err.Clear();
+  REQUIRE(!closed.CompileScript("SELECT 1;", &err).Valid());
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+  err.Clear();
+  REQUIRE(!db.CompileScript(nullptr, &err).Valid());
+  REQUIRE(err.code == ErrorCode::kNullParam);
+}
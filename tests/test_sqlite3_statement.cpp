@@ -162,6 +162,28 @@ TEST_CASE("Sqlite3Statement: exec on invalid", "[sqlite3_statement]") {
   REQUIRE(err.code == ErrorCode::kMisuse);
 }
 
+TEST_CASE("Sqlite3Statement: bind failure returns a Status",
+          "[sqlite3_statement]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("INSERT INTO emp VALUES(?, ?);");
+
+  Status st = stmt.Bind(3, 1);
+  REQUIRE(st.code == ErrorCode::kRange);
+  REQUIRE(st.native == SQLITE_RANGE);
+  REQUIRE(std::strstr(stmt.ErrorMessage(), "out of range") != nullptr);
+
+  Error err = stmt.ToError(st);
+  REQUIRE(err.code == ErrorCode::kRange);
+  REQUIRE(std::strstr(err.message, "out of range") != nullptr);
+
+  Error legacy = stmt.BindNull(0);  // Existing callers still get an Error
+  REQUIRE_FALSE(legacy.ok());
+
+  Sqlite3Statement invalid;
+  REQUIRE(invalid.Reset().code == ErrorCode::kMisuse);
+  REQUIRE(invalid.ToError(invalid.Reset()).code == ErrorCode::kMisuse);
+}
+
 TEST_CASE("Sqlite3Statement: update with bind", "[sqlite3_statement]") {
   auto db = OpenTestDb();
   db.ExecDml("INSERT INTO emp VALUES(1, 'Alice');");
@@ -177,3 +199,24 @@ TEST_CASE("Sqlite3Statement: update with bind", "[sqlite3_statement]") {
   auto q = db.ExecQuery("SELECT empname FROM emp WHERE empno = 1;");
   REQUIRE(std::strcmp(q.GetString(0), "Alicia") == 0);
 }
+
+TEST_CASE("Sqlite3Statement: Exec reports through a trailing Error*",
+          "[sqlite3_statement]") {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE u(id INTEGER PRIMARY KEY, name TEXT);");
+  auto stmt = db.CompileStatement("INSERT INTO u VALUES(?, ?);");
+
+  Error err;
+  REQUIRE(stmt.Exec(1, "a", &err) == 1);
+  REQUIRE(err.ok());
+
+  REQUIRE(stmt.Exec(1, "b", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kConstraint);
+
+  err = Error::Ok();
+  REQUIRE(stmt.Exec(2, "c", 3, &err) == -1);  // Too many parameters
+  REQUIRE(err.code == ErrorCode::kRange);
+
+  REQUIRE(stmt.Exec(2, "c") == 1);  // Error* stays optional
+}
@@ -0,0 +1,206 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3StmtCache and the Sqlite3Db statement cache.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static Sqlite3Db OpenCachedDb(uint32_t capacity) {
+  Sqlite3Db db;
+  auto err = db.Open(":memory:");
+  REQUIRE(err.ok());
+  db.EnableStatementCache(capacity);
+  db.ExecDml("CREATE TABLE emp(empno INTEGER, empname TEXT);");
+  db.ClearStatementCache();
+  return db;
+}
+
+TEST_CASE("Sqlite3StmtCache: disabled by default", "[stmt_cache]") {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  REQUIRE_FALSE(db.StatementCacheEnabled());
+  db.ExecScalar("SELECT 1;");
+  auto stats = db.StatementCacheStats();
+  REQUIRE(stats.hits == 0);
+  REQUIRE(stats.misses == 0);
+  REQUIRE(stats.capacity == 0);
+}
+
+TEST_CASE("Sqlite3StmtCache: query hits after first use", "[stmt_cache]") {
+  auto db = OpenCachedDb(8);
+  db.ResetStatementCacheStats();
+  db.ExecDml("INSERT INTO emp VALUES(1, 'Alice');");
+
+  for (int32_t i = 0; i < 5; ++i) {
+    REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;") == 1);
+  }
+
+  auto stats = db.StatementCacheStats();
+  REQUIRE(stats.misses == 2);  // INSERT + first SELECT
+  REQUIRE(stats.hits == 4);
+  REQUIRE(stats.size == 2);
+  REQUIRE(stats.capacity == 8);
+}
+
+TEST_CASE("Sqlite3StmtCache: ExecDml reuses statement", "[stmt_cache]") {
+  auto db = OpenCachedDb(8);
+  db.ResetStatementCacheStats();
+
+  for (int32_t i = 0; i < 3; ++i) {
+    REQUIRE(db.ExecDml("INSERT INTO emp VALUES(7, 'Same');") == 1);
+  }
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;") == 3);
+
+  auto stats = db.StatementCacheStats();
+  REQUIRE(stats.hits == 2);
+  REQUIRE(stats.misses == 2);
+}
+
+TEST_CASE("Sqlite3StmtCache: multi-statement ExecDml", "[stmt_cache]") {
+  auto db = OpenCachedDb(8);
+
+  Error err;
+  int32_t ret = db.ExecDml(
+      "INSERT INTO emp VALUES(1, 'A'); INSERT INTO emp VALUES(2, 'B');",
+      &err);
+  REQUIRE(err.ok());
+  REQUIRE(ret == 1);
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;") == 2);
+}
+
+/// Authorizer callback: counts INSERTs compiled (it runs at prepare time).
+static int CountInsertPrepares(void* count, int action, const char*,
+                               const char*, const char*, const char*) {
+  if (action == SQLITE_INSERT) { ++*static_cast<int32_t*>(count); }
+  return SQLITE_OK;
+}
+
+TEST_CASE("Sqlite3StmtCache: multi-statement ExecDml compiles once",
+          "[stmt_cache]") {
+  auto db = OpenCachedDb(8);
+  int32_t prepares = 0;
+  sqlite3_set_authorizer(db.Handle(), CountInsertPrepares, &prepares);
+
+  Error err;
+  REQUIRE(db.ExecDml("INSERT INTO emp VALUES(1, 'A');;  -- two\n"
+                     "INSERT INTO emp VALUES(2, 'B'); /* end */", &err) == 1);
+  REQUIRE(err.ok());
+  REQUIRE(prepares == 2);
+  REQUIRE(db.StatementCacheStats().size == 0);  // Scripts are not cached
+
+  // Stops at the failing statement; later ones are never compiled.
+  prepares = 0;
+  REQUIRE(db.ExecDml("INSERT INTO emp VALUES(3, 'C'); INSERT INTO nope "
+                     "VALUES(1); INSERT INTO emp VALUES(4, 'D');", &err) == -1);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(std::strstr(err.message, "nope") != nullptr);
+  REQUIRE(prepares == 1);
+  sqlite3_set_authorizer(db.Handle(), nullptr, nullptr);
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;") == 3);
+}
+
+TEST_CASE("Sqlite3StmtCache: trailing blanks and comments",
+          "[stmt_cache]") {
+  auto db = OpenCachedDb(8);
+  db.ResetStatementCacheStats();
+
+  for (int32_t i = 0; i < 3; ++i) {
+    REQUIRE(db.ExecDml("\n  INSERT INTO emp VALUES(1, 'A');\n  ") == 1);
+  }
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp") == 3);
+  // Same key with or without the trailing ';' and blanks
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;;\n") == 3);
+  auto stats = db.StatementCacheStats();
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.hits == 3);
+
+  // A trailing comment still runs as one statement, but is not cached
+  Error err;
+  REQUIRE(db.ExecDml("DELETE FROM emp; -- purge\n", &err) == 3);
+  REQUIRE(err.ok());
+  REQUIRE(db.ExecDml("DELETE FROM emp; -- purge\n", &err) == 0);
+  REQUIRE(db.StatementCacheStats().size == 2);
+}
+
+TEST_CASE("Sqlite3StmtCache: LRU eviction", "[stmt_cache]") {
+  auto db = OpenCachedDb(2);
+  db.ResetStatementCacheStats();
+
+  db.ExecScalar("SELECT 1;");
+  db.ExecScalar("SELECT 2;");
+  db.ExecScalar("SELECT 1;");  // hit, now most recent
+  db.ExecScalar("SELECT 3;");  // evicts "SELECT 2;"
+  REQUIRE(db.StatementCacheStats().evictions == 1);
+
+  db.ExecScalar("SELECT 1;");  // still cached
+  REQUIRE(db.StatementCacheStats().hits == 2);
+  db.ExecScalar("SELECT 2;");  // miss
+  REQUIRE(db.StatementCacheStats().misses == 4);
+  REQUIRE(db.StatementCacheStats().size == 2);
+}
+
+TEST_CASE("Sqlite3StmtCache: concurrent use of same SQL", "[stmt_cache]") {
+  auto db = OpenCachedDb(4);
+  db.ExecDml("INSERT INTO emp VALUES(1, 'Alice');");
+  db.ExecDml("INSERT INTO emp VALUES(2, 'Bob');");
+
+  auto q1 = db.ExecQuery("SELECT empno FROM emp ORDER BY empno;");
+  auto q2 = db.ExecQuery("SELECT empno FROM emp ORDER BY empno;");
+  REQUIRE(q1.GetInt(0) == 1);
+  q1.NextRow();
+  REQUIRE(q1.GetInt(0) == 2);
+  REQUIRE(q2.GetInt(0) == 1);
+
+  q1.Finalize();
+  q2.Finalize();
+  auto q3 = db.ExecQuery("SELECT empno FROM emp ORDER BY empno;");
+  REQUIRE_FALSE(q3.Eof());
+  REQUIRE(q3.GetInt(0) == 1);
+}
+
+TEST_CASE("Sqlite3StmtCache: errors are not cached", "[stmt_cache]") {
+  auto db = OpenCachedDb(4);
+
+  Error err;
+  db.ExecQuery("SELECT * FROM nonexistent;", &err);
+  REQUIRE_FALSE(err.ok());
+
+  err.Clear();
+  db.ExecDml("INSERT INTO nonexistent VALUES(1);", &err);
+  REQUIRE_FALSE(err.ok());
+
+  db.ExecDml("CREATE TABLE u(a INTEGER UNIQUE);");
+  REQUIRE(db.ExecDml("INSERT INTO u VALUES(1);") == 1);
+  err.Clear();
+  REQUIRE(db.ExecDml("INSERT INTO u VALUES(1);", &err) == -1);
+  REQUIRE_FALSE(err.ok());
+}
+
+TEST_CASE("Sqlite3StmtCache: transactions and reopen", "[stmt_cache]") {
+  auto db = OpenCachedDb(4);
+
+  REQUIRE(db.BeginTransaction().ok());
+  db.ExecDml("INSERT INTO emp VALUES(1, 'Alice');");
+  REQUIRE(db.Rollback().ok());
+  REQUIRE(db.ExecScalar("SELECT count(*) FROM emp;") == 0);
+
+  db.Close();
+  REQUIRE(db.StatementCacheStats().size == 0);
+  REQUIRE(db.Open(":memory:").ok());
+  REQUIRE(db.StatementCacheEnabled());
+  REQUIRE(db.ExecScalar("SELECT 42;") == 42);
+}
+
+TEST_CASE("Sqlite3StmtCache: move keeps cache", "[stmt_cache]") {
+  auto db1 = OpenCachedDb(4);
+  db1.ExecScalar("SELECT 1;");
+
+  Sqlite3Db db2(std::move(db1));
+  REQUIRE_FALSE(db1.StatementCacheEnabled());
+  REQUIRE(db2.StatementCacheEnabled());
+  db2.ExecScalar("SELECT 1;");
+  REQUIRE(db2.StatementCacheStats().hits >= 1);
+}
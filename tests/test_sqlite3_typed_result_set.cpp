@@ -0,0 +1,132 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3TypedResultSet.
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstring>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+static Sqlite3Db OpenTestDb() {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, score REAL, data BLOB);");
+  db.ExecDml("INSERT INTO t VALUES(1, 'Alice', 9.5, x'0102');");
+  db.ExecDml("INSERT INTO t VALUES(2, 'Bob', NULL, NULL);");
+  db.ExecDml("INSERT INTO t VALUES(5000000000, '', 1.25, x'');");
+  return db;
+}
+
+TEST_CASE("Sqlite3TypedResultSet: native types", "[typed_result_set]") {
+  auto db = OpenTestDb();
+  Error err;
+  auto rs = db.GetTypedResultSet("SELECT * FROM t ORDER BY id;", &err);
+  REQUIRE(err.ok());
+  REQUIRE(rs.NumRows() == 3);
+  REQUIRE(rs.NumFields() == 4);
+  REQUIRE(std::strcmp(rs.FieldName(1), "name") == 0);
+
+  REQUIRE(rs.FieldDataType(0) == SQLITE_INTEGER);
+  REQUIRE(rs.FieldDataType(1) == SQLITE_TEXT);
+  REQUIRE(rs.FieldDataType(2) == SQLITE_FLOAT);
+  REQUIRE(rs.FieldDataType(3) == SQLITE_BLOB);
+
+  REQUIRE(rs.GetInt64(0) == 1);
+  REQUIRE(std::strcmp(rs.GetString(1), "Alice") == 0);
+  REQUIRE(rs.GetDouble(2) == Catch::Approx(9.5));
+  int32_t len = 0;
+  const uint8_t* blob = rs.GetBlob(3, len);
+  REQUIRE(len == 2);
+  REQUIRE(blob[0] == 0x01);
+  REQUIRE(blob[1] == 0x02);
+}
+
+TEST_CASE("Sqlite3TypedResultSet: nulls and defaults", "[typed_result_set]") {
+  auto db = OpenTestDb();
+  auto rs = db.GetTypedResultSet("SELECT * FROM t ORDER BY id;");
+  rs.SeekRow(1);
+  REQUIRE(rs.FieldIsNull(2));
+  REQUIRE(rs.GetDouble(2, -1.0) == Catch::Approx(-1.0));
+  REQUIRE(std::strcmp(rs.GetString(3, "none"), "none") == 0);
+  REQUIRE(rs.GetInt(99, -7) == -7);
+  // Numeric cells are not text
+  REQUIRE(std::strcmp(rs.GetString(0, "n/a"), "n/a") == 0);
+}
+
+TEST_CASE("Sqlite3TypedResultSet: random access and iteration",
+          "[typed_result_set]") {
+  auto db = OpenTestDb();
+  auto rs = db.GetTypedResultSet("SELECT id, name FROM t ORDER BY id;");
+
+  rs.SeekRow(2);
+  REQUIRE(rs.GetInt64(0) == 5000000000LL);
+  REQUIRE(rs.GetBytes(1) == 0);
+  rs.SeekRow(0);
+  REQUIRE(rs.GetInt("id") == 1);
+  REQUIRE(std::strcmp(rs.GetString("name"), "Alice") == 0);
+  rs.SeekRow(100);
+  REQUIRE(rs.CurrentRow() == 2);
+
+  rs.SeekRow(0);
+  int32_t count = 0;
+  while (!rs.Eof()) {
+    ++count;
+    rs.NextRow();
+  }
+  REQUIRE(count == 3);
+}
+
+TEST_CASE("Sqlite3TypedResultSet: empty and error", "[typed_result_set]") {
+  auto db = OpenTestDb();
+  auto rs = db.GetTypedResultSet("SELECT * FROM t WHERE id < 0;");
+  REQUIRE(rs.NumRows() == 0);
+  REQUIRE(rs.NumFields() == 4);
+  REQUIRE(rs.Eof());
+
+  Error err;
+  auto bad = db.GetTypedResultSet("SELECT * FROM nonexistent;", &err);
+  REQUIRE_FALSE(err.ok());
+  REQUIRE(bad.NumRows() == 0);
+}
+
+TEST_CASE("Sqlite3TypedResultSet: from prepared query", "[typed_result_set]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("SELECT name FROM t WHERE id >= ? "
+                                  "ORDER BY id;");
+  stmt.Bind(1, 2);
+  auto q = stmt.ExecQuery();
+  auto rs = Sqlite3TypedResultSet::FromQuery(q);
+  REQUIRE(q.Eof());
+  REQUIRE(rs.NumRows() == 2);
+  REQUIRE(std::strcmp(rs.GetString(0), "Bob") == 0);
+}
+
+TEST_CASE("Sqlite3TypedResultSet: many rows", "[typed_result_set]") {
+  Sqlite3Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE n(i INTEGER, s TEXT);");
+  db.BeginTransaction();
+  auto stmt = db.CompileStatement("INSERT INTO n VALUES(?, ?);");
+  for (int32_t i = 0; i < 5000; ++i) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "row%d", i);
+    stmt.Bind(1, i);
+    stmt.Bind(2, buf);
+    stmt.ExecDml();
+  }
+  stmt.Finalize();
+  db.Commit();
+
+  auto rs = db.GetTypedResultSet("SELECT i, s FROM n ORDER BY i;");
+  REQUIRE(rs.NumRows() == 5000);
+  rs.SeekRow(4321);
+  REQUIRE(rs.GetInt(0) == 4321);
+  REQUIRE(std::strcmp(rs.GetString(1), "row4321") == 0);
+  REQUIRE(rs.MemoryBytes() > 0);
+
+  Sqlite3TypedResultSet moved(std::move(rs));
+  REQUIRE(rs.NumRows() == 0);
+  REQUIRE(moved.NumRows() == 5000);
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for read-only virtual tables over C++ sources.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dbpp/sqlite3_db.hpp"
+
+using namespace dbpp;
+
+namespace {
+
+struct Sensor {
+  int32_t id;
+  std::string name;
+  double scale;
+};
+
+/// Fixed-capacity ring of (ts, value) samples, oldest first; ts grows.
+class SampleRing {
+ public:
+  explicit SampleRing(int64_t capacity)
+      : ts_(capacity), value_(capacity), capacity_(capacity) {}
+
+  void Push(int64_t ts, double value) {
+    int64_t slot = (head_ + count_) % capacity_;
+    if (count_ == capacity_) {
+      head_ = (head_ + 1) % capacity_;
+    } else {
+      ++count_;
+    }
+    ts_[slot] = ts;
+    value_[slot] = value;
+  }
+
+  // --- Virtual table source ---
+
+  const char* Schema() const {
+    return "CREATE TABLE x(ts INTEGER, value REAL)";
+  }
+  int64_t Size() const { return count_; }
+  void Column(int64_t row, int32_t col, VtabCell& cell) const {
+    ++column_reads;
+    int64_t slot = (head_ + row) % capacity_;
+    if (col == 0) {
+      cell.Set(ts_[slot]);
+    } else {
+      cell.Set(value_[slot]);
+    }
+  }
+  int32_t KeyColumn() const { return 0; }
+  int64_t Key(int64_t row) const { return ts_[(head_ + row) % capacity_]; }
+
+  mutable int64_t column_reads = 0;
+
+ private:
+  std::vector<int64_t> ts_;
+  std::vector<double> value_;
+  int64_t capacity_;
+  int64_t head_ = 0;
+  int64_t count_ = 0;
+};
+
+}  // namespace
+
+TEST_CASE("Virtual table: container source joins real tables", "[vtab]") {
+  std::vector<Sensor> sensors = {
+      {1, "temp", 0.5}, {2, "humidity", 1.0}, {3, "pressure", 10.0}};
+  auto table = MakeContainerTable(
+      "CREATE TABLE x(id INTEGER, name TEXT, scale REAL)", &sensors,
+      [](const Sensor& s, int32_t col, VtabCell& cell) {
+        switch (col) {
+          case 0: cell.Set(s.id); break;
+          case 1: cell.Set(s.name); break;
+          default: cell.Set(s.scale); break;
+        }
+      });
+
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  REQUIRE(db.CreateVirtualTable("sensors", &table).ok());
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM sensors;") == 3);
+
+  Sqlite3Query q = db.ExecQuery(
+      "SELECT name, scale FROM sensors WHERE id = 2;");
+  REQUIRE(!q.Eof());
+  REQUIRE(std::string(q.GetString(0)) == "humidity");
+  REQUIRE(q.GetDouble(1) == 1.0);
+  q.Finalize();
+
+  // Live view: no copy, changes show up in the next query
+  sensors.push_back({4, "wind", 2.0});
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM sensors;") == 4);
+
+  db.ExecDml("CREATE TABLE readings(sensor INTEGER, raw REAL);");
+  db.Exec("INSERT INTO readings VALUES(?, ?);", 1, 40.0);
+  db.Exec("INSERT INTO readings VALUES(?, ?);", 3, 101.3);
+  db.Exec("INSERT INTO readings VALUES(?, ?);", 3, 99.7);
+  REQUIRE(db.ExecScalar(
+      "SELECT CAST(SUM(r.raw * s.scale) AS INTEGER) FROM readings r "
+      "JOIN sensors s ON s.id = r.sensor;") == 20 + 2010);
+
+  // Read-only
+  Error err;
+  db.ExecDml("DELETE FROM sensors;", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+
+  // Rowid is the container index
+  REQUIRE(db.ExecScalar("SELECT id FROM sensors WHERE rowid = 3;") == 4);
+  REQUIRE(db.ExecScalar(
+      "SELECT COUNT(*) FROM sensors WHERE rowid >= 1 AND rowid < 3;") == 2);
+}
+
+TEST_CASE("Virtual table: key constraints are pushed down", "[vtab]") {
+  SampleRing ring(1000);
+  for (int64_t i = 0; i < 1500; ++i) { ring.Push(i * 10, i * 0.5); }
+  // Oldest 500 samples were overwritten: ts 5000..14990
+
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  REQUIRE(db.CreateVirtualTable("samples", &ring).ok());
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples;") == 1000);
+  REQUIRE(db.ExecScalar("SELECT MIN(ts) FROM samples;") == 5000);
+
+  // Range: only the matching rows are read (plus SQLite's re-check)
+  ring.column_reads = 0;
+  REQUIRE(db.ExecScalar(
+      "SELECT COUNT(*) FROM samples WHERE ts >= 10000 AND ts < 10100;") ==
+      10);
+  REQUIRE(ring.column_reads <= 20);
+
+  ring.column_reads = 0;
+  REQUIRE(db.ExecScalar(
+      "SELECT CAST(value * 2 AS INTEGER) FROM samples WHERE ts = 7770;") ==
+      777);
+  REQUIRE(ring.column_reads <= 3);
+
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts > 14980;") ==
+          1);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts <= 5010;") ==
+          2);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts = 5;") == 0);
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts > 99999;") ==
+          0);
+
+  // Non-integer operand: not narrowed, still correct
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples WHERE ts > 14975.5;") ==
+          2);
+
+  // ORDER BY key is satisfied by the scan order
+  Sqlite3Query q = db.ExecQuery(
+      "SELECT ts FROM samples WHERE ts BETWEEN 6000 AND 6040 ORDER BY ts;");
+  int64_t expect = 6000;
+  int32_t n = 0;
+  for (; !q.Eof(); q.NextRow(), ++n, expect += 10) {
+    REQUIRE(q.GetInt64(0) == expect);
+  }
+  REQUIRE(n == 5);
+  q.Finalize();
+
+  // Join pushes the key lookup per outer row
+  db.ExecDml("CREATE TABLE marks(ts INTEGER);");
+  db.ExecDml("INSERT INTO marks VALUES(5000), (9990), (12345), (14990);");
+  ring.column_reads = 0;
+  REQUIRE(db.ExecScalar(
+      "SELECT COUNT(*) FROM marks m JOIN samples s ON s.ts = m.ts;") == 3);
+  REQUIRE(ring.column_reads <= 12);
+}
+
+TEST_CASE("Virtual table: drop and errors", "[vtab]") {
+  SampleRing ring(8);
+  ring.Push(1, 1.0);
+  Sqlite3Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  REQUIRE(db.CreateVirtualTable("samples", &ring).ok());
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples;") == 1);
+  REQUIRE(db.DropVirtualTable("samples").ok());
+  Error err;
+  db.ExecQuery("SELECT * FROM samples;", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+
+  REQUIRE(db.CreateVirtualTable("samples", &ring).ok());
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM samples;") == 1);
+
+  const SampleRing* none = nullptr;
+  REQUIRE(db.CreateVirtualTable("other", none).code == ErrorCode::kNullParam);
+  REQUIRE(db.CreateVirtualTable(nullptr, &ring).code ==
+          ErrorCode::kNullParam);
+  Sqlite3Db closed;
+  REQUIRE(closed.CreateVirtualTable("samples", &ring).code ==
+          ErrorCode::kNotOpen);
+
+  // Bad schema surfaces when the table is first used
+  std::vector<int32_t> ints = {1, 2};
+  auto bad = MakeContainerTable("NOT SQL", &ints,
+      [](int32_t v, int32_t, VtabCell& cell) { cell.Set(v); });
+  REQUIRE(db.CreateVirtualTable("bad", &bad).ok());
+  err.Clear();
+  db.ExecQuery("SELECT * FROM bad;", &err);
+  REQUIRE(err.code == ErrorCode::kError);
+}
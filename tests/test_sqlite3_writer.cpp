@@ -0,0 +1,274 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Sqlite3Writer (single-writer executor, group commit).
+
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dbpp/sqlite3_writer.hpp"
+
+using namespace dbpp;
+
+static Error StartWriter(Sqlite3Writer& writer, uint32_t max_batch = 256) {
+  Sqlite3WriterOptions opts;
+  opts.path = ":memory:";
+  opts.open.journal_mode = Sqlite3JournalMode::kMemory;  // No WAL in memory
+  opts.max_batch = max_batch;
+  Error err = writer.Start(opts);
+  if (err.ok()) {
+    err = writer.SubmitDml("CREATE TABLE t(id INTEGER UNIQUE);").get().error;
+  }
+  return err;
+}
+
+/// Row count of t, read on the writer thread.
+static int32_t CountRows(Sqlite3Writer& writer) {
+  return writer.Submit([](Sqlite3Db& db, Error*) {
+    return db.ExecScalar("SELECT COUNT(*) FROM t;");
+  }).get().changes;
+}
+
+/// Job that parks the writer thread until `gate` is released, so the jobs
+/// submitted meanwhile are all coalesced into the next batch.
+static std::future<WriteResult> Block(Sqlite3Writer& writer,
+                                      std::shared_future<void> gate) {
+  return writer.Submit([gate](Sqlite3Db&, Error*) {
+    gate.wait();
+    return 0;
+  });
+}
+
+TEST_CASE("Sqlite3Writer: start, submit, stop", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+  REQUIRE(writer.Running());
+
+  WriteResult r = writer.SubmitDml("INSERT INTO t VALUES(1);").get();
+  REQUIRE(r.error.ok());
+  REQUIRE(r.changes == 1);
+  REQUIRE(CountRows(writer) == 1);
+
+  writer.Stop();
+  REQUIRE_FALSE(writer.Running());
+}
+
+TEST_CASE("Sqlite3Writer: start errors", "[writer]") {
+  Sqlite3Writer writer;
+  Sqlite3WriterOptions opts;
+  REQUIRE(writer.Start(opts).code == ErrorCode::kNullParam);
+  opts.path = ":memory:";
+  opts.max_batch = 0;
+  REQUIRE(writer.Start(opts).code == ErrorCode::kRange);
+  opts.max_batch = 4;
+  // The Durable() default asks for WAL, which :memory: cannot use
+  REQUIRE(writer.Start(opts).code == ErrorCode::kError);
+  REQUIRE(!writer.Running());
+  opts.open.journal_mode = Sqlite3JournalMode::kMemory;
+  REQUIRE(writer.Start(opts).ok());
+  REQUIRE(writer.Start(opts).code == ErrorCode::kMisuse);
+}
+
+TEST_CASE("Sqlite3Writer: queued jobs share one transaction", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+
+  std::promise<void> release;
+  auto blocker = Block(writer, release.get_future().share());
+  std::vector<std::future<WriteResult>> results;
+  for (int32_t i = 0; i < 50; ++i) {
+    results.push_back(writer.Submit([i](Sqlite3Db& db, Error* e) {
+      int32_t n = db.Exec("INSERT INTO t VALUES(?);", i);
+      if (n < 0 && e != nullptr) { *e = Error::Make(ErrorCode::kError); }
+      return n;
+    }));
+  }
+  Sqlite3WriterStats before = writer.Stats();
+  release.set_value();
+  REQUIRE(blocker.get().error.ok());
+  for (auto& f : results) { REQUIRE(f.get().error.ok()); }
+
+  Sqlite3WriterStats after = writer.Stats();
+  REQUIRE(after.largest_batch >= 50);
+  REQUIRE(after.batches - before.batches <= 3);
+  REQUIRE(CountRows(writer) == 50);
+}
+
+TEST_CASE("Sqlite3Writer: failing job is rolled back alone", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+
+  std::promise<void> release;
+  auto blocker = Block(writer, release.get_future().share());
+  auto a = writer.SubmitDml("INSERT INTO t VALUES(1);");
+  auto bad = writer.Submit([](Sqlite3Db& db, Error* e) {
+    // First insert lands, second violates UNIQUE: both must roll back.
+    db.ExecDml("INSERT INTO t VALUES(100);", e);
+    return db.ExecDml("INSERT INTO t VALUES(1);", e);
+  });
+  auto b = writer.SubmitDml("INSERT INTO t VALUES(2);");
+  release.set_value();
+
+  REQUIRE(blocker.get().error.ok());
+  REQUIRE(a.get().error.ok());
+  REQUIRE_FALSE(bad.get().error.ok());
+  REQUIRE(b.get().error.ok());
+  REQUIRE(CountRows(writer) == 2);
+  REQUIRE(writer.Stats().failed == 1);
+}
+
+TEST_CASE("Sqlite3Writer: -1 without error is reported", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+  WriteResult r = writer.Submit([](Sqlite3Db&, Error*) { return -1; }).get();
+  REQUIRE_FALSE(r.error.ok());
+}
+
+TEST_CASE("Sqlite3Writer: callback delivery", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+  std::promise<WriteResult> got;
+  writer.Submit(
+      [](Sqlite3Db& db, Error* e) {
+        return db.ExecDml("INSERT INTO t VALUES(7);", e);
+      },
+      [&got](const WriteResult& r) { got.set_value(r); });
+  WriteResult r = got.get_future().get();
+  REQUIRE(r.error.ok());
+  REQUIRE(r.changes == 1);
+}
+
+TEST_CASE("Sqlite3Writer: many producer threads", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer).ok());
+
+  constexpr int32_t kThreads = 4;
+  constexpr int32_t kPerThread = 250;
+  std::atomic<int32_t> failures{0};
+  std::vector<std::thread> threads;
+  for (int32_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&writer, &failures, t] {
+      std::vector<std::future<WriteResult>> mine;
+      for (int32_t i = 0; i < kPerThread; ++i) {
+        int32_t id = t * kPerThread + i;
+        mine.push_back(writer.Submit([id](Sqlite3Db& db, Error*) {
+          return db.Exec("INSERT INTO t VALUES(?);", id);
+        }));
+      }
+      for (auto& f : mine) {
+        if (!f.get().error.ok()) { ++failures; }
+      }
+    });
+  }
+  for (auto& th : threads) { th.join(); }
+
+  REQUIRE(failures.load() == 0);
+  REQUIRE(CountRows(writer) == kThreads * kPerThread);
+  Sqlite3WriterStats s = writer.Stats();
+  REQUIRE(s.jobs >= static_cast<uint64_t>(kThreads * kPerThread));
+  REQUIRE(s.AvgBatch() >= 1.0);
+}
+
+TEST_CASE("Sqlite3Writer: stop drains, later submits fail", "[writer]") {
+  Sqlite3Writer writer;
+  REQUIRE(StartWriter(writer, 8).ok());
+  std::vector<std::future<WriteResult>> results;
+  for (int32_t i = 0; i < 100; ++i) {
+    results.push_back(writer.Submit([i](Sqlite3Db& db, Error*) {
+      return db.Exec("INSERT INTO t VALUES(?);", i);
+    }));
+  }
+  writer.Stop();
+  for (auto& f : results) { REQUIRE(f.get().error.ok()); }
+
+  WriteResult r = writer.SubmitDml("INSERT INTO t VALUES(1000);").get();
+  REQUIRE(r.error.code == ErrorCode::kMisuse);
+}
+
+TEST_CASE("Sqlite3Writer: data is durable in the file", "[writer]") {
+  const char* path = "dbpp_test_writer.db";
+  std::remove(path);
+  {
+    Sqlite3Writer writer;
+    Sqlite3WriterOptions opts;
+    opts.path = path;
+    REQUIRE(writer.Start(opts).ok());
+    writer.SubmitDml("CREATE TABLE t(id INTEGER);");
+    for (int32_t i = 0; i < 20; ++i) {
+      writer.Submit([i](Sqlite3Db& db, Error*) {
+        return db.Exec("INSERT INTO t VALUES(?);", i);
+      });
+    }
+  }  // Destructor drains and stops
+
+  Sqlite3Db reader;
+  REQUIRE(reader.Open(path).ok());
+  REQUIRE(reader.ExecScalar("SELECT COUNT(*) FROM t;") == 20);
+  reader.Close();
+  std::remove(path);
+  std::remove((std::string(path) + "-wal").c_str());
+  std::remove((std::string(path) + "-shm").c_str());
+}
+
+TEST_CASE("Sqlite3Writer: waits out an external write lock", "[writer]") {
+  const char* path = "dbpp_test_writer_busy.db";
+  std::remove(path);
+  Sqlite3Writer writer;
+  Sqlite3WriterOptions opts;
+  opts.path = path;
+  opts.busy.max_retries = 0;  // Fail at once first
+  REQUIRE(writer.Start(opts).ok());
+  REQUIRE(writer.SubmitDml("CREATE TABLE t(id INTEGER);").get().error.ok());
+
+  Sqlite3Db other;
+  REQUIRE(other.Open(path).ok());
+  REQUIRE(other.BeginTransaction(TxnMode::kImmediate).ok());
+  WriteResult r = writer.SubmitDml("INSERT INTO t VALUES(1);").get();
+  REQUIRE(r.error.code == ErrorCode::kBusy);
+  REQUIRE(other.Commit().ok());
+  REQUIRE(writer.SubmitDml("INSERT INTO t VALUES(2);").get().error.ok());
+  writer.Stop();
+
+  opts.busy = Sqlite3BusyPolicy{};  // Wait up to 5 s
+  REQUIRE(writer.Start(opts).ok());
+  REQUIRE(other.BeginTransaction(TxnMode::kImmediate).ok());
+  auto f = writer.SubmitDml("INSERT INTO t VALUES(3);");
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  REQUIRE(other.Commit().ok());
+  REQUIRE(f.get().error.ok());
+  writer.Stop();
+
+  REQUIRE(other.ExecScalar("SELECT COUNT(*) FROM t;") == 2);
+  other.Close();
+  std::remove(path);
+  std::remove((std::string(path) + "-wal").c_str());
+  std::remove((std::string(path) + "-shm").c_str());
+}
+
+TEST_CASE("Sqlite3Writer: delayed batches wake on new jobs", "[writer]") {
+  Sqlite3Writer writer;
+  Sqlite3WriterOptions opts;
+  opts.path = ":memory:";
+  opts.open.journal_mode = Sqlite3JournalMode::kMemory;
+  opts.max_batch = 4;
+  opts.max_batch_delay_us = 200000;
+  REQUIRE(writer.Start(opts).ok());
+  REQUIRE(writer.SubmitDml("CREATE TABLE t(id INTEGER);").get().error.ok());
+
+  // The batch fills before the delay runs out: no 200 ms wait per batch.
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::future<WriteResult>> results;
+  for (int32_t i = 0; i < 4; ++i) {
+    results.push_back(writer.Submit([i](Sqlite3Db& db, Error*) {
+      return db.Exec("INSERT INTO t VALUES(?);", i);
+    }));
+  }
+  for (auto& f : results) { REQUIRE(f.get().error.ok()); }
+  REQUIRE(std::chrono::steady_clock::now() - start <
+          std::chrono::milliseconds(190));
+  REQUIRE(CountRows(writer) == 4);
+}
@@ -0,0 +1,196 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::Transaction<Db> and the transaction modes / savepoints.
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+#include "dbpp/db.hpp"
+
+using namespace dbpp;
+
+static const char* kPath = "dbpp_test_transaction.db";
+
+static void RemoveDb() {
+  std::remove(kPath);
+  std::remove((std::string(kPath) + "-journal").c_str());
+  std::remove((std::string(kPath) + "-wal").c_str());
+  std::remove((std::string(kPath) + "-shm").c_str());
+}
+
+static void OpenDb(Sqlite3Db& db) {
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(x INTEGER);");
+}
+
+static int32_t Count(Sqlite3Db& db) {
+  return db.ExecScalar("SELECT COUNT(*) FROM t;");
+}
+
+TEST_CASE("Transaction: commit and rollback on scope exit",
+          "[transaction]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  {
+    Error err;
+    Transaction<Sqlite3Db> txn(db, TxnMode::kImmediate, &err);
+    REQUIRE(err.ok());
+    REQUIRE(txn.Active());
+    REQUIRE(!txn.Nested());
+    REQUIRE(db.InTransaction());
+    db.ExecDml("INSERT INTO t VALUES(1);");
+    REQUIRE(txn.Commit().ok());
+    REQUIRE(!txn.Active());
+  }
+  REQUIRE(!db.InTransaction());
+  REQUIRE(Count(db) == 1);
+
+  {
+    Transaction<Sqlite3Db> txn(db);
+    db.ExecDml("INSERT INTO t VALUES(2);");
+  }
+  REQUIRE(!db.InTransaction());
+  REQUIRE(Count(db) == 1);
+
+  // Explicit rollback; committing afterwards is misuse
+  Transaction<Sqlite3Db> txn(db, TxnMode::kExclusive);
+  db.ExecDml("INSERT INTO t VALUES(3);");
+  REQUIRE(txn.Rollback().ok());
+  REQUIRE(txn.Commit().code == ErrorCode::kMisuse);
+  REQUIRE(Count(db) == 1);
+}
+
+TEST_CASE("Transaction: nested guards become savepoints", "[transaction]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  {
+    Transaction<Sqlite3Db> outer(db);
+    db.ExecDml("INSERT INTO t VALUES(1);");
+    {
+      Transaction<Sqlite3Db> inner(db);
+      REQUIRE(inner.Nested());
+      REQUIRE(inner.Level() == 1);
+      REQUIRE(db.SavepointDepth() == 1);
+      db.ExecDml("INSERT INTO t VALUES(2);");
+      // Not committed: only the inner work is undone
+    }
+    REQUIRE(db.SavepointDepth() == 0);
+    REQUIRE(db.InTransaction());
+    REQUIRE(Count(db) == 1);
+    {
+      Transaction<Sqlite3Db> inner(db);
+      db.ExecDml("INSERT INTO t VALUES(3);");
+      // The outer guard cannot commit past an open inner one
+      REQUIRE(outer.Commit().code == ErrorCode::kMisuse);
+      REQUIRE(inner.Commit().ok());
+    }
+    REQUIRE(outer.Commit().ok());
+  }
+  REQUIRE(Count(db) == 2);
+
+  // Released savepoints still roll back with the outer transaction
+  {
+    Transaction<Sqlite3Db> outer(db);
+    Transaction<Sqlite3Db> inner(db);
+    db.ExecDml("INSERT INTO t VALUES(4);");
+    REQUIRE(inner.Commit().ok());
+  }
+  REQUIRE(Count(db) == 2);
+}
+
+TEST_CASE("Transaction: deep nesting beyond the statement cache",
+          "[transaction]") {
+  Sqlite3Db db;
+  OpenDb(db);
+  Transaction<Sqlite3Db> outer(db);
+  Transaction<Sqlite3Db> guards[12];
+  for (int32_t i = 0; i < 12; ++i) {
+    REQUIRE(guards[i].Begin(db).ok());
+    REQUIRE(guards[i].Level() == static_cast<uint32_t>(i + 1));
+    db.Exec("INSERT INTO t VALUES(?);", i);
+  }
+  REQUIRE(db.SavepointDepth() == 12);
+  // Undo the innermost 6, keep the rest
+  for (int32_t i = 11; i >= 6; --i) { REQUIRE(guards[i].Rollback().ok()); }
+  for (int32_t i = 5; i >= 0; --i) { REQUIRE(guards[i].Commit().ok()); }
+  REQUIRE(outer.Commit().ok());
+  REQUIRE(Count(db) == 6);
+  REQUIRE(db.ExecScalar("SELECT MAX(x) FROM t;") == 5);
+
+  // Begin/commit statements are prepared once and kept
+  for (int32_t i = 0; i < 100; ++i) {
+    REQUIRE(db.BeginTransaction(TxnMode::kImmediate).ok());
+    REQUIRE(db.Commit().ok());
+  }
+  int32_t prepared = 0;
+  for (sqlite3_stmt* s = sqlite3_next_stmt(db.Handle(), nullptr);
+       s != nullptr; s = sqlite3_next_stmt(db.Handle(), s)) {
+    ++prepared;
+  }
+  REQUIRE(prepared <= 5 + 3 * 8);
+}
+
+TEST_CASE("Transaction: IMMEDIATE takes the write lock up front",
+          "[transaction]") {
+  RemoveDb();
+  Sqlite3Db a;
+  Sqlite3Db b;
+  REQUIRE(a.Open(kPath).ok());
+  REQUIRE(b.Open(kPath).ok());
+  a.ExecDml("CREATE TABLE t(x INTEGER);");
+
+  // Deferred: both read, then the second writer fails in the middle
+  REQUIRE(a.BeginTransaction().ok());
+  REQUIRE(b.BeginTransaction().ok());
+  REQUIRE(a.ExecScalar("SELECT COUNT(*) FROM t;") == 0);
+  REQUIRE(b.ExecScalar("SELECT COUNT(*) FROM t;") == 0);
+  REQUIRE(a.ExecDml("INSERT INTO t VALUES(1);") == 1);
+  REQUIRE(b.ExecDml("INSERT INTO t VALUES(2);") < 0);
+  REQUIRE(b.Rollback().ok());
+  Error err = a.Commit();
+  REQUIRE(err.ok());
+
+  // Immediate: the second writer is refused at BEGIN, before any work
+  Transaction<Sqlite3Db> ta(a, TxnMode::kImmediate, &err);
+  REQUIRE(err.ok());
+  Transaction<Sqlite3Db> tb(b, TxnMode::kImmediate, &err);
+  REQUIRE(err.code == ErrorCode::kBusy);
+  REQUIRE(!tb.Active());
+  REQUIRE(!b.InTransaction());
+  REQUIRE(ta.Commit().ok());
+  REQUIRE(tb.Begin(b, TxnMode::kImmediate).ok());
+  REQUIRE(tb.Commit().ok());
+
+  a.Close();
+  b.Close();
+  RemoveDb();
+}
+
+TEST_CASE("Transaction: Database<Backend> and misuse", "[transaction]") {
+  Db db;
+  REQUIRE(db.Open(":memory:").ok());
+  db.ExecDml("CREATE TABLE t(x INTEGER);");
+  {
+    Transaction<Db> outer(db, TxnMode::kImmediate);
+    Transaction<Db> inner(db);
+    REQUIRE(inner.Nested());
+    db.ExecDml("INSERT INTO t VALUES(1);");
+    REQUIRE(inner.Commit().ok());
+    // Moving a guard keeps it active in the new owner
+    Transaction<Db> moved(std::move(outer));
+    REQUIRE(!outer.Active());
+    REQUIRE(moved.Commit().ok());
+  }
+  REQUIRE(db.ExecScalar("SELECT COUNT(*) FROM t;") == 1);
+
+  REQUIRE(db.ReleaseSavepoint().code == ErrorCode::kMisuse);
+  REQUIRE(db.RollbackToSavepoint().code == ErrorCode::kMisuse);
+  REQUIRE(db.SavepointDepth() == 0);
+
+  Sqlite3Db closed;
+  Error err;
+  Transaction<Sqlite3Db> txn(closed, TxnMode::kDeferred, &err);
+  REQUIRE(err.code == ErrorCode::kNotOpen);
+  REQUIRE(!txn.Active());
+}
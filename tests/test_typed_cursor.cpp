@@ -0,0 +1,160 @@
+// Copyright (c) 2024 liudegui. MIT License.
+// Tests for dbpp::TypedCursor (Sqlite3Query::As and Database::QueryAs).
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+#include "dbpp/db.hpp"
+
+using namespace dbpp;
+
+static Db OpenTestDb() {
+  Db db;
+  db.Open(":memory:");
+  db.ExecDml("CREATE TABLE t(id INTEGER, name TEXT, score REAL);");
+  db.ExecDml("INSERT INTO t VALUES(1, 'Alice', 9.5);");
+  db.ExecDml("INSERT INTO t VALUES(2, 'Bob', NULL);");
+  db.ExecDml("INSERT INTO t VALUES(3, 'Carol', 7.25);");
+  return db;
+}
+
+struct Person {
+  int64_t id;
+  std::string name;
+  double score;
+};
+
+TEST_CASE("TypedCursor: range-for over tuples", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  auto q = db.ExecQuery("SELECT id, name, score FROM t ORDER BY id;");
+
+  Error err;
+  auto rows = q.As<int64_t, TextView, double>(&err);
+  REQUIRE(err.ok());
+  REQUIRE(rows.Valid());
+
+  int64_t id_sum = 0;
+  int32_t count = 0;
+  for (auto row : rows) {
+    id_sum += std::get<0>(row);
+    if (count == 0) {
+      REQUIRE(std::get<1>(row) == TextView("Alice"));
+      REQUIRE(std::get<2>(row) == Catch::Approx(9.5));
+    }
+    ++count;
+  }
+  REQUIRE(count == 3);
+  REQUIRE(id_sum == 6);
+  REQUIRE(q.Eof());
+}
+
+TEST_CASE("TypedCursor: decode into struct", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  auto cursor = db.QueryAs<int64_t, std::string, double>(
+      "SELECT id, name, score FROM t WHERE id = 3;");
+  REQUIRE(cursor.Valid());
+  REQUIRE_FALSE(cursor.Eof());
+
+  Person p = cursor.GetAs<Person>();
+  REQUIRE(p.id == 3);
+  REQUIRE(p.name == "Carol");
+  REQUIRE(p.score == Catch::Approx(7.25));
+}
+
+TEST_CASE("TypedCursor: ForEach and Nullable", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  int32_t nulls = 0;
+  int32_t rows = 0;
+  db.QueryAs<int32_t, Nullable<double>>("SELECT id, score FROM t;")
+      .ForEach([&](int32_t id, Nullable<double> score) {
+        ++rows;
+        if (score.is_null) {
+          REQUIRE(id == 2);
+          ++nulls;
+        }
+      });
+  REQUIRE(rows == 3);
+  REQUIRE(nulls == 1);
+}
+
+TEST_CASE("TypedCursor: column count mismatch", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  Error err;
+  auto cursor = db.QueryAs<int64_t, TextView>("SELECT id FROM t;", &err);
+  REQUIRE_FALSE(cursor.Valid());
+  REQUIRE(cursor.Eof());
+  REQUIRE(err.code == ErrorCode::kMismatch);
+
+  int32_t count = 0;
+  for (auto row : cursor) {
+    (void)row;
+    ++count;
+  }
+  REQUIRE(count == 0);
+}
+
+TEST_CASE("TypedCursor: column type mismatch", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  Error err;
+  auto cursor = db.QueryAs<int64_t, int64_t>(
+      "SELECT id, name FROM t ORDER BY id;", &err);
+  REQUIRE_FALSE(cursor.Valid());
+  REQUIRE(err.code == ErrorCode::kMismatch);
+  REQUIRE(std::strstr(err.message, "column 1") != nullptr);
+
+  // Integers widen to double
+  err.Clear();
+  auto widened = db.QueryAs<double>("SELECT id FROM t;", &err);
+  REQUIRE(widened.Valid());
+}
+
+TEST_CASE("TypedCursor: query error keeps original message",
+          "[typed_cursor]") {
+  auto db = OpenTestDb();
+  Error err;
+  auto cursor = db.QueryAs<int32_t>("SELECT * FROM nonexistent;", &err);
+  REQUIRE_FALSE(cursor.Valid());
+  REQUIRE(err.code == ErrorCode::kError);
+}
+
+TEST_CASE("TypedCursor: a failed step is reported", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  // abs() overflows on the third row
+  const char* sql = "SELECT abs(column1) FROM "
+                    "(VALUES(1), (2), (-9223372036854775807 - 1));";
+  auto cursor = db.QueryAs<int64_t>(sql);
+  int64_t sum = 0;
+  for (auto row : cursor) { sum += std::get<0>(row); }
+  REQUIRE(sum == 3);
+  REQUIRE(cursor.ToError().code == ErrorCode::kError);
+
+  int32_t rows = 0;
+  Error err = db.QueryAs<int64_t>(sql).ForEach([&](int64_t) { ++rows; });
+  REQUIRE(rows == 2);
+  REQUIRE(err.code == ErrorCode::kError);
+  REQUIRE(db.QueryAs<int64_t>("SELECT id FROM t;").ForEach(
+              [](int64_t) {}).ok());
+}
+
+TEST_CASE("TypedCursor: empty result", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  auto cursor = db.QueryAs<int64_t, const char*, BlobView>(
+      "SELECT id, name, score FROM t WHERE id < 0;");
+  REQUIRE(cursor.Valid());
+  REQUIRE(cursor.Eof());
+}
+
+TEST_CASE("TypedCursor: cursor from prepared statement", "[typed_cursor]") {
+  auto db = OpenTestDb();
+  auto stmt = db.CompileStatement("SELECT name FROM t WHERE id > ?;");
+  stmt.Bind(1, 1);
+  auto q = stmt.ExecQuery();
+  std::string names;
+  for (auto row : q.As<const char*>()) {
+    names += std::get<0>(row);
+  }
+  REQUIRE(names.size() == std::strlen("BobCarol"));
+}